@@ -64,4 +64,11 @@
  */
 #define MAX_EPS_AUTH_VECTORS          1
 
+/* MAX_EPS_AUTH_VECTORS is the number of vectors held in the EMM context. The MME may still request a batch of
+ * vectors in one Authentication-Information-Request (TS 29.272 Number-Of-Requested-Vectors, at most 5 honored by
+ * the HSS), unused vectors are then kept in order in the NAS authentication vector cache (emm_auth_vector_cache.h)
+ * and handed to the EMM context one at a time.
+ */
+#define MAX_EPS_AUTH_VECTORS_PER_REQUEST 5
+
 #endif /* FILE_3GPP_33_401_SEEN */
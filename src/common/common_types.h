@@ -329,7 +329,7 @@ typedef struct {
 
 typedef struct authentication_info_s {
   uint8_t         nb_of_vectors;
-  eutran_vector_t eutran_vector[MAX_EPS_AUTH_VECTORS];
+  eutran_vector_t eutran_vector[MAX_EPS_AUTH_VECTORS_PER_REQUEST];
 } authentication_info_t;
 
 typedef enum {
@@ -49,6 +49,7 @@
 #include "assertions.h"
 #include "intertask_interface.h"
 #include "intertask_interface_dump.h"
+#include "itti_free_defined_msg.h"
 
 #include "memory_pools.h"
 
@@ -82,6 +83,9 @@ const int                               itti_debug = ITTI_DEBUG_ISSUES | ITTI_DE
 /* Global message size */
 #define MESSAGE_SIZE(mESSAGEiD) (sizeof(MessageHeader) + itti_desc.messages_info[mESSAGEiD].size)
 
+/* Size of the HIGH and LOW priority class queues relatively to the task queue size */
+#define ITTI_QUEUE_MINOR_CLASS_DIVIDER 4
+
 #define VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME(...)
 #define VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME(...)
 #define VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE(...)
@@ -90,14 +94,6 @@ typedef volatile enum task_state_s {
   TASK_STATE_NOT_CONFIGURED, TASK_STATE_STARTING, TASK_STATE_READY, TASK_STATE_ENDED, TASK_STATE_MAX,
 } task_state_t;
 
-/* This list acts as a FIFO of messages received by tasks (RRC, NAS, ...) */
-typedef struct message_list_s {
-  MessageDef                             *msg;  ///< Pointer to the message
-
-  message_number_t                        message_number;       ///< Unique message number
-  uint32_t                                message_priority;     ///< Message priority
-} message_list_t;
-
 typedef struct thread_desc_s {
   /*
    * pthread associated with the thread
@@ -140,21 +136,39 @@ typedef struct thread_desc_s {
    * Flag to mark real time thread
    */
   unsigned                                real_time;
+  //#endif
 
   /*
-   * Counter to indicate from RTAI threads that messages are pending for the thread
+   * Number of messages enqueued for the thread and not yet dequeued.
+   * The task event fd is only written on the 0 -> 1 transition of this
+   * counter, the receiver drains the queue without any syscall while it is
+   * positive. It may transiently be negative when a message is dequeued
+   * before its sender incremented the counter.
    */
-  unsigned                                messages_pending;
-  //#endif
+  volatile int32_t                        messages_pending;
 } thread_desc_t;
 
+/* Classes of priority of the messages queued for a task, the queue of a
+   class is always drained before the queues of the lower classes.
+   Messages are only ordered within a class: a receiver handling a message
+   which must not overtake the lower classes (e.g. an association close) first
+   drains them with itti_receive_lower_priority_msgs().
+   The MED class carries the bulk of the traffic, the other ones are smaller.
+*/
+typedef enum queue_priority_class_e {
+  QUEUE_PRIORITY_CLASS_HIGH = 0,  ///< MESSAGE_PRIORITY_MED_PLUS and above (termination, logs, timers, eNB life cycle)
+  QUEUE_PRIORITY_CLASS_MED,       ///< MESSAGE_PRIORITY_MED_LEAST and above (UE signalling)
+  QUEUE_PRIORITY_CLASS_LOW,       ///< Below MESSAGE_PRIORITY_MED_LEAST
+  QUEUE_PRIORITY_CLASS_MAX,
+} queue_priority_class_t;
+
 typedef struct task_desc_s {
   /*
-   * Queue of messages belonging to the task
+   * Queues of messages belonging to the task, one per priority class
    */
-  struct lfds710_queue_bmm_state         message_queue
+  struct lfds710_queue_bmm_state         message_queue[QUEUE_PRIORITY_CLASS_MAX]
           __attribute__ ((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
-  struct lfds710_queue_bmm_element      *qbmme;
+  struct lfds710_queue_bmm_element      *qbmme[QUEUE_PRIORITY_CLASS_MAX];
 } task_desc_t;
 
 typedef struct itti_desc_s {
@@ -185,6 +199,11 @@ typedef struct itti_desc_s {
   volatile int                            wait_tasks;
 
   memory_pools_handle_t                   memory_pools_handle;
+  /*
+   * Allocations failed since the last successful one, the pools statistics
+   * are only dumped for the first failure of an exhaustion episode
+   */
+  volatile uint32_t                       memory_pools_failures;
 
   uint64_t                                vcd_poll_msg;
   uint64_t                                vcd_receive_msg;
@@ -193,8 +212,13 @@ typedef struct itti_desc_s {
 
 static itti_desc_t                      itti_desc;
 
-void                                   *
-itti_malloc (
+static int itti_enqueue_msg (task_id_t destination_task_id, instance_t instance, MessageDef * message);
+
+/*
+ * Allocate from the memory pools, NULL when they can not grow anymore
+ */
+static void                            *
+itti_try_malloc (
   task_id_t origin_task_id,
   task_id_t destination_task_id,
   ssize_t size)
@@ -204,11 +228,32 @@ itti_malloc (
   ptr = memory_pools_allocate (itti_desc.memory_pools_handle, size, origin_task_id, destination_task_id);
 
   if (ptr == NULL) {
-    char                                   *statistics = memory_pools_statistics (itti_desc.memory_pools_handle);
+    if (__sync_fetch_and_add (&itti_desc.memory_pools_failures, 1) == 0) {
+      char                                   *statistics = memory_pools_statistics (itti_desc.memory_pools_handle);
 
-    OAILOG_ERROR (LOG_ITTI, " Memory pools statistics:\n%s", statistics);
-    free_wrapper ((void**)&statistics);
+      OAILOG_ERROR (LOG_ITTI, " Memory allocation of %d bytes failed (%d -> %d)!\n", (int)size, origin_task_id, destination_task_id);
+      OAILOG_ERROR (LOG_ITTI, " Memory pools statistics:\n%s", statistics);
+      free_wrapper ((void**)&statistics);
+    }
+  } else if (itti_desc.memory_pools_failures) {
+    uint32_t                                failures = __sync_lock_test_and_set (&itti_desc.memory_pools_failures, 0);
+
+    if (failures) {
+      OAILOG_WARNING (LOG_ITTI, " Memory pools available again, %u allocations failed\n", failures);
+    }
   }
+  return ptr;
+}
+
+void                                   *
+itti_malloc (
+  task_id_t origin_task_id,
+  task_id_t destination_task_id,
+  ssize_t size)
+{
+  void                                   *ptr = NULL;
+
+  ptr = itti_try_malloc (origin_task_id, destination_task_id, size);
   AssertFatal (ptr != NULL, "Memory allocation of %d bytes failed (%d -> %d)!\n", (int)size, origin_task_id, destination_task_id);
   return ptr;
 }
@@ -247,6 +292,35 @@ itti_get_message_priority (
   return (itti_desc.messages_info[message_id].priority);
 }
 
+static inline                           queue_priority_class_t
+itti_get_queue_priority_class (
+  uint32_t message_priority)
+{
+  if (message_priority >= MESSAGE_PRIORITY_MED_PLUS) {
+    return QUEUE_PRIORITY_CLASS_HIGH;
+  } else if (message_priority >= MESSAGE_PRIORITY_MED_LEAST) {
+    return QUEUE_PRIORITY_CLASS_MED;
+  }
+  return QUEUE_PRIORITY_CLASS_LOW;
+}
+
+/*
+ * The MED class carries the bulk of the traffic and gets the configured queue
+ * size, the HIGH and LOW classes only a fraction of it (still a power of 2).
+ */
+static inline unsigned int
+itti_get_queue_class_size (
+  task_id_t task_id,
+  queue_priority_class_t prio_class)
+{
+  const unsigned int                      queue_size = itti_desc.tasks_info[task_id].queue_size;
+
+  if ((prio_class == QUEUE_PRIORITY_CLASS_MED) || (queue_size < (2 * ITTI_QUEUE_MINOR_CLASS_DIVIDER))) {
+    return queue_size;
+  }
+  return queue_size / ITTI_QUEUE_MINOR_CLASS_DIVIDER;
+}
+
 const char                             *
 itti_get_message_name (
   MessagesIds message_id)
@@ -330,11 +404,21 @@ itti_send_broadcast_message (
       if (itti_desc.threads[thread_id].task_state == TASK_STATE_READY) {
         size_t                                  size = sizeof (MessageHeader) + message_p->ittiMsgHeader.ittiMsgSize;
 
-        new_message_p = itti_malloc (origin_task_id, destination_task_id, size);
-        AssertFatal (new_message_p != NULL, "New message allocation failed!\n");
+        new_message_p = itti_try_malloc (origin_task_id, destination_task_id, size);
+
+        if (new_message_p == NULL) {
+          ret = -1;
+          continue;
+        }
         memcpy (new_message_p, message_p, size);
-        result = itti_send_msg_to_task (destination_task_id, INSTANCE_DEFAULT, new_message_p);
-        AssertFatal (result >= 0, "Failed to send message %d to thread %d (task %d)!\n", message_p->ittiMsgHeader.messageId, thread_id, destination_task_id);
+        /*
+         * Copies share the content of the broadcast message, only the copy is released
+         */
+        if (itti_enqueue_msg (destination_task_id, INSTANCE_DEFAULT, new_message_p) < 0) {
+          ITTI_DEBUG (ITTI_DEBUG_ISSUES, " Failed to broadcast message %d to thread %d (task %d)!\n", message_p->ittiMsgHeader.messageId, thread_id, destination_task_id);
+          itti_free (origin_task_id, new_message_p);
+          ret = -1;
+        }
       }
     }
   }
@@ -344,11 +428,12 @@ itti_send_broadcast_message (
   return ret;
 }
 
-MessageDef                             *
-itti_alloc_new_message_sized (
+static MessageDef                      *
+itti_new_message (
   task_id_t origin_task_id,
   MessagesIds message_id,
-  MessageHeaderSize size)
+  MessageHeaderSize size,
+  const bool may_fail)
 {
   MessageDef                             *temp = NULL;
 
@@ -362,7 +447,16 @@ itti_alloc_new_message_sized (
     origin_task_id = itti_get_current_task_id ();
   }
 
-  temp = itti_malloc (origin_task_id, TASK_UNKNOWN, sizeof (MessageHeader) + size);
+  if (may_fail) {
+    temp = itti_try_malloc (origin_task_id, TASK_UNKNOWN, sizeof (MessageHeader) + size);
+
+    if (temp == NULL) {
+      VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_ALLOC_MSG, 0);
+      return NULL;
+    }
+  } else {
+    temp = itti_malloc (origin_task_id, TASK_UNKNOWN, sizeof (MessageHeader) + size);
+  }
 
   // better to do it here than in client code
   memset(&temp->ittiMsg, 0, size);
@@ -374,29 +468,48 @@ itti_alloc_new_message_sized (
   return temp;
 }
 
+MessageDef                             *
+itti_alloc_new_message_sized (
+  task_id_t origin_task_id,
+  MessagesIds message_id,
+  MessageHeaderSize size)
+{
+  return itti_new_message (origin_task_id, message_id, size, false);
+}
+
 MessageDef                             *
 itti_alloc_new_message (
   task_id_t origin_task_id,
   MessagesIds message_id)
 {
-  return itti_alloc_new_message_sized (origin_task_id, message_id, itti_desc.messages_info[message_id].size);
+  return itti_new_message (origin_task_id, message_id, itti_desc.messages_info[message_id].size, false);
 }
 
-int
-itti_send_msg_to_task (
+MessageDef                             *
+itti_try_alloc_new_message (
+  task_id_t origin_task_id,
+  MessagesIds message_id)
+{
+  return itti_new_message (origin_task_id, message_id, itti_desc.messages_info[message_id].size, true);
+}
+
+/*
+ * Enqueue a message in the queue of its destination task. When the message can
+ * not be queued (ended destination task, full queue) -1 is returned and the
+ * message is left to the caller.
+ */
+static int
+itti_enqueue_msg (
   task_id_t destination_task_id,
   instance_t instance,
   MessageDef * message)
 {
   thread_id_t                             destination_thread_id;
   task_id_t                               origin_task_id;
-  message_list_t                         *new;
   uint32_t                                priority;
   message_number_t                        message_number;
   uint32_t                                message_id;
 
-  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_or_and_fetch (&itti_desc.vcd_send_msg, 1L << destination_task_id));
-  AssertFatal (message != NULL, "Message is NULL!\n");
   AssertFatal (destination_task_id < itti_desc.task_max, "Destination task id (%d) is out of range (%d)\n", destination_task_id, itti_desc.task_max);
   destination_thread_id = TASK_GET_THREAD_ID (destination_task_id);
   message->ittiMsgHeader.destinationTaskId = destination_task_id;
@@ -419,7 +532,7 @@ itti_send_msg_to_task (
     if (itti_desc.threads[destination_thread_id].task_state == TASK_STATE_ENDED) {
       ITTI_DEBUG (ITTI_DEBUG_ISSUES, " Message %s, number %lu with priority %d can not be sent from %s to queue (%u:%s), ended destination task!\n",
                   itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
-      itti_free (origin_task_id, message); // In case of issues free the memory allocated for message
+      return -1;
     } else {
       /*
        * We cannot send a message if the task is not running
@@ -428,25 +541,27 @@ itti_send_msg_to_task (
                    "Task %s Cannot send message %s (%d) to thread %d, it is not in ready state (%d)!\n",
                    itti_get_task_name (origin_task_id), itti_desc.messages_info[message_id].name, message_id, destination_thread_id, itti_desc.threads[destination_thread_id].task_state);
       /*
-       * Allocate new list element
-       */
-      new = (message_list_t *) itti_malloc (origin_task_id, destination_task_id, sizeof (struct message_list_s));
-      /*
-       * Fill in members
+       * The message itself is queued, its header carries number and priority
        */
-      new->msg = message;
-      new->message_number = message_number;
-      new->message_priority = priority;
+      message->ittiMsgHeader.messageNumber = message_number;
+      message->ittiMsgHeader.messagePriority = priority;
       /*
        * Enqueue message in destination task queue
        */
-      lfds710_queue_bmm_enqueue (&itti_desc.tasks[destination_task_id].message_queue, NULL, new);
+      if (lfds710_queue_bmm_enqueue (&itti_desc.tasks[destination_task_id].message_queue[itti_get_queue_priority_class (priority)], NULL, message) == 0) {
+        ITTI_DEBUG (ITTI_DEBUG_ISSUES, " Message %s, number %lu with priority %d can not be sent from %s to queue (%u:%s), queue full!\n",
+                    itti_desc.messages_info[message_id].name, message_number, priority, itti_get_task_name (origin_task_id), destination_task_id, itti_get_task_name (destination_task_id));
+        return -1;
+      }
       VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_OUT);
       {
         /*
-         * Only use event fd for tasks, subtasks will pool the queue
+         * Only use event fd for tasks, subtasks will pool the queue.
+         * The receiver is woken up only if it may be sleeping, i.e. if the queue
+         * was seen empty, following messages are drained in the same wakeup.
          */
-        if (TASK_GET_PARENT_TASK_ID (destination_task_id) == TASK_UNKNOWN) {
+        if ((TASK_GET_PARENT_TASK_ID (destination_task_id) == TASK_UNKNOWN) &&
+            (__sync_fetch_and_add (&itti_desc.threads[destination_thread_id].messages_pending, 1) == 0)) {
           ssize_t                                 write_ret;
           eventfd_t                               sem_counter = 1;
 
@@ -469,9 +584,33 @@ itti_send_msg_to_task (
 
     AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
   }
+  return 0;
+}
+
+int
+itti_send_msg_to_task (
+  task_id_t destination_task_id,
+  instance_t instance,
+  MessageDef * message)
+{
+  int                                     result = 0;
 
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_or_and_fetch (&itti_desc.vcd_send_msg, 1L << destination_task_id));
+  if (message == NULL) {
+    /*
+     * itti_try_alloc_new_message() failed (memory pools exhausted), let the sender back off
+     */
+    ITTI_DEBUG (ITTI_DEBUG_ISSUES, " NULL message can not be sent to task %s!\n", itti_get_task_name (destination_task_id));
+    result = -1;
+  } else if ((result = itti_enqueue_msg (destination_task_id, instance, message)) < 0) {
+    /*
+     * The message is not delivered: release it with what it carries (payloads moved in by the sender)
+     */
+    itti_free_msg_content (message);
+    itti_free (ITTI_MSG_ORIGIN_ID (message), message);
+  }
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_SEND_MSG, __sync_and_and_fetch (&itti_desc.vcd_send_msg, ~(1L << destination_task_id)));
-  return 0;
+  return result;
 }
 
 void
@@ -544,85 +683,136 @@ itti_get_events (
   return itti_desc.threads[thread_id].epoll_nb_events;
 }
 
-static inline void
-itti_receive_msg_internal_event_fd (
+static inline int
+itti_dequeue_msgs (
+  task_id_t task_id,
+  queue_priority_class_t first_prio_class,
+  MessageDef ** received_msgs,
+  int max_msgs)
+{
+  thread_id_t                             thread_id = TASK_GET_THREAD_ID (task_id);
+  MessageDef                             *message = NULL;
+  queue_priority_class_t                  prio_class = first_prio_class;
+  int                                     nb_msgs = 0;
+
+  /*
+   * Highest priority class first, a lower class is only visited once the
+   * upper ones are empty.
+   */
+  for (prio_class = first_prio_class; (prio_class < QUEUE_PRIORITY_CLASS_MAX) && (nb_msgs < max_msgs); prio_class++) {
+    while ((nb_msgs < max_msgs) && (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue[prio_class], NULL, (void **)&message) == 1)) {
+      AssertFatal (message != NULL, "Message from message queue is NULL!\n");
+      received_msgs[nb_msgs++] = message;
+    }
+  }
+
+  if ((nb_msgs > 0) && (TASK_GET_PARENT_TASK_ID (task_id) == TASK_UNKNOWN)) {
+    __sync_sub_and_fetch (&itti_desc.threads[thread_id].messages_pending, nb_msgs);
+  }
+  return nb_msgs;
+}
+
+static inline int
+itti_receive_msgs_internal_event_fd (
   task_id_t task_id,
   uint8_t polling,
-  MessageDef ** received_msg)
+  MessageDef ** received_msgs,
+  int max_msgs)
 {
   thread_id_t                             thread_id;
   int                                     epoll_ret = 0;
   int                                     epoll_timeout = 0;
+  int                                     nb_msgs = 0;
+  int                                     nb_fd_events = 0;
+  bool                                    event_fd_set = false;
   int                                     i;
 
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
-  AssertFatal (received_msg != NULL, "Received message is NULL!\n");
+  AssertFatal (received_msgs != NULL, "Received message is NULL!\n");
+  AssertFatal (max_msgs > 0, "Invalid number of messages to receive (%d)!\n", max_msgs);
   thread_id = TASK_GET_THREAD_ID (task_id);
-  *received_msg = NULL;
+  received_msgs[0] = NULL;
 
-  if (polling) {
-    /*
-     * In polling mode we set the timeout to 0 causing epoll_wait to return
-     * * * immediately.
-     */
-    epoll_timeout = 0;
-  } else {
-    /*
-     * timeout = -1 causes the epoll_wait to wait indefinitely.
-     */
-    epoll_timeout = -1;
-  }
+  while (1) {
+    itti_desc.threads[thread_id].epoll_nb_events = 0;
 
-  do {
-    epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
-  } while (epoll_ret < 0 && errno == EINTR);
+    if (itti_desc.threads[thread_id].messages_pending > 0) {
+      /*
+       * Messages are already announced for this task, no need to sleep.
+       */
+      nb_msgs = itti_dequeue_msgs (task_id, QUEUE_PRIORITY_CLASS_HIGH, received_msgs, max_msgs);
 
-  if (epoll_ret < 0) {
-    AssertFatal (0, "epoll_wait failed for task %s: %s!\n", itti_get_task_name (task_id), strerror (errno));
-  }
+      if (itti_desc.threads[thread_id].nb_events > 1) {
+        /*
+         * Do not starve the other fds monitored by the task
+         */
+        epoll_timeout = 0;
+      } else if (nb_msgs > 0) {
+        return nb_msgs;
+      } else {
+        /*
+         * A concurrent enqueue is not yet visible, retry.
+         */
+        continue;
+      }
+    } else if (polling) {
+      /*
+       * In polling mode we set the timeout to 0 causing epoll_wait to return
+       * * * immediately.
+       */
+      epoll_timeout = 0;
+    } else {
+      /*
+       * timeout = -1 causes the epoll_wait to wait indefinitely.
+       */
+      epoll_timeout = -1;
+    }
 
-  if (epoll_ret == 0 && polling) {
-    /*
-     * No data to read -> return
-     */
-    return;
-  }
+    do {
+      epoll_ret = epoll_wait (itti_desc.threads[thread_id].epoll_fd, itti_desc.threads[thread_id].events, itti_desc.threads[thread_id].nb_events, epoll_timeout);
+    } while (epoll_ret < 0 && errno == EINTR);
 
-  itti_desc.threads[thread_id].epoll_nb_events = epoll_ret;
+    if (epoll_ret < 0) {
+      AssertFatal (0, "epoll_wait failed for task %s: %s!\n", itti_get_task_name (task_id), strerror (errno));
+    }
 
-  for (i = 0; i < epoll_ret; i++) {
-    /*
-     * Check if there is an event for ITTI for the event fd
-     */
-    if ((itti_desc.threads[thread_id].events[i].events & EPOLLIN) && (itti_desc.threads[thread_id].events[i].data.fd == itti_desc.threads[thread_id].task_event_fd)) {
-      struct message_list_s                  *message = NULL;
-      eventfd_t                               sem_counter;
-      ssize_t                                 read_ret;
-      int                                     result;
+    itti_desc.threads[thread_id].epoll_nb_events = epoll_ret;
+    nb_fd_events = 0;
+    event_fd_set = false;
 
+    for (i = 0; i < epoll_ret; i++) {
       /*
-       * Read will always return 1
+       * Check if there is an event for ITTI for the event fd
        */
-      read_ret = read (itti_desc.threads[thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
-      AssertFatal (read_ret == sizeof (sem_counter), "Read from task message FD (%d) failed (%d/%d)!\n", thread_id, (int)read_ret, (int)sizeof (sem_counter));
+      if ((itti_desc.threads[thread_id].events[i].events & EPOLLIN) && (itti_desc.threads[thread_id].events[i].data.fd == itti_desc.threads[thread_id].task_event_fd)) {
+        eventfd_t                               sem_counter;
+        ssize_t                                 read_ret;
 
-      if (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue, NULL, (void **)&message) == 0) {
         /*
-         * No element in list -> this should not happen
+         * Read resets the event fd counter whatever the number of writes
          */
-        AssertFatal (0, "No message in queue for task %d while there are %d events and some for the messages queue!\n", task_id, epoll_ret);
+        read_ret = read (itti_desc.threads[thread_id].task_event_fd, &sem_counter, sizeof (sem_counter));
+        AssertFatal (read_ret == sizeof (sem_counter), "Read from task message FD (%d) failed (%d/%d)!\n", thread_id, (int)read_ret, (int)sizeof (sem_counter));
+        /*
+         * Mark that the event has been processed
+         */
+        itti_desc.threads[thread_id].events[i].events &= ~EPOLLIN;
+        event_fd_set = true;
+      } else {
+        nb_fd_events++;
       }
+    }
 
-      AssertFatal (message != NULL, "Message from message queue is NULL!\n");
-      *received_msg = message->msg;
-      result = itti_free (ITTI_MSG_ORIGIN_ID (message->msg), message);
-      AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
-      /*
-       * Mark that the event has been processed
-       */
-      itti_desc.threads[thread_id].events[i].events &= ~EPOLLIN;
-      return;
+    if ((nb_msgs == 0) && (event_fd_set)) {
+      nb_msgs = itti_dequeue_msgs (task_id, QUEUE_PRIORITY_CLASS_HIGH, received_msgs, max_msgs);
+    }
+
+    if ((nb_msgs > 0) || (nb_fd_events > 0) || (polling)) {
+      return nb_msgs;
     }
+    /*
+     * Spurious wakeup (messages already drained in a previous call), wait again
+     */
   }
 }
 
@@ -632,10 +822,24 @@ itti_receive_msg (
   MessageDef ** received_msg)
 {
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_and_and_fetch (&itti_desc.vcd_receive_msg, ~(1L << task_id)));
-  itti_receive_msg_internal_event_fd (task_id, 0, received_msg);
+  itti_receive_msgs_internal_event_fd (task_id, 0, received_msg, 1);
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_or_and_fetch (&itti_desc.vcd_receive_msg, 1L << task_id));
 }
 
+int
+itti_receive_msgs (
+  task_id_t task_id,
+  MessageDef ** received_msgs,
+  int max_msgs)
+{
+  int                                     nb_msgs = 0;
+
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_and_and_fetch (&itti_desc.vcd_receive_msg, ~(1L << task_id)));
+  nb_msgs = itti_receive_msgs_internal_event_fd (task_id, 0, received_msgs, max_msgs);
+  VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_or_and_fetch (&itti_desc.vcd_receive_msg, 1L << task_id));
+  return nb_msgs;
+}
+
 void
 itti_poll_msg (
   task_id_t task_id,
@@ -644,17 +848,7 @@ itti_poll_msg (
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
   *received_msg = NULL;
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_or_and_fetch (&itti_desc.vcd_poll_msg, 1L << task_id));
-  {
-    struct message_list_s                  *message;
-
-    if (lfds710_queue_bmm_dequeue (&itti_desc.tasks[task_id].message_queue, NULL, (void **)&message) == 1) {
-      int                                     result;
-
-      *received_msg = message->msg;
-      result = itti_free (ITTI_MSG_ORIGIN_ID (*received_msg), message);
-      AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
-    }
-  }
+  itti_dequeue_msgs (task_id, QUEUE_PRIORITY_CLASS_HIGH, received_msg, 1);
 
   if (*received_msg == NULL) {
     ITTI_DEBUG (ITTI_DEBUG_POLL, " No message in queue[(%u:%s)]\n", task_id, itti_get_task_name (task_id));
@@ -662,6 +856,25 @@ itti_poll_msg (
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_and_and_fetch (&itti_desc.vcd_poll_msg, ~(1L << task_id)));
 }
 
+int
+itti_receive_lower_priority_msgs (
+  task_id_t task_id,
+  MessagesIds message_id,
+  MessageDef ** received_msgs,
+  int max_msgs)
+{
+  queue_priority_class_t                  prio_class = itti_get_queue_priority_class (itti_get_message_priority (message_id));
+
+  AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
+  AssertFatal (received_msgs != NULL, "Received message is NULL!\n");
+  AssertFatal (max_msgs > 0, "Invalid number of messages to receive (%d)!\n", max_msgs);
+
+  if (prio_class + 1 >= QUEUE_PRIORITY_CLASS_MAX) {
+    return 0;
+  }
+  return itti_dequeue_msgs (task_id, prio_class + 1, received_msgs, max_msgs);
+}
+
 int
 itti_create_task (
   task_id_t task_id,
@@ -819,8 +1032,12 @@ itti_init (
     ITTI_DEBUG (ITTI_DEBUG_INIT, " Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
     printf (" Creating queue of message of size %u\n", itti_desc.tasks_info[task_id].queue_size);
 
-    itti_desc.tasks[task_id].qbmme = calloc(itti_desc.tasks_info[task_id].queue_size, sizeof(struct lfds710_queue_bmm_element));
-    lfds710_queue_bmm_init_valid_on_current_logical_core( &itti_desc.tasks[task_id].message_queue, itti_desc.tasks[task_id].qbmme, itti_desc.tasks_info[task_id].queue_size, NULL );
+    for (queue_priority_class_t prio_class = QUEUE_PRIORITY_CLASS_HIGH; prio_class < QUEUE_PRIORITY_CLASS_MAX; prio_class++) {
+      const unsigned int                      queue_size = itti_get_queue_class_size (task_id, prio_class);
+
+      itti_desc.tasks[task_id].qbmme[prio_class] = calloc(queue_size, sizeof(struct lfds710_queue_bmm_element));
+      lfds710_queue_bmm_init_valid_on_current_logical_core( &itti_desc.tasks[task_id].message_queue[prio_class], itti_desc.tasks[task_id].qbmme[prio_class], queue_size, NULL );
+    }
   }
 
   /*
@@ -837,7 +1054,11 @@ itti_init (
       AssertFatal (0, "Failed to create new epoll fd: %s!\n", strerror (errno));
     }
 
-    itti_desc.threads[thread_id].task_event_fd = eventfd (0, EFD_SEMAPHORE);
+    /*
+     * Not a semaphore: one read consumes all the wakeups of a burst
+     */
+    itti_desc.threads[thread_id].messages_pending = 0;
+    itti_desc.threads[thread_id].task_event_fd = eventfd (0, 0);
 
     if (itti_desc.threads[thread_id].task_event_fd == -1) {
       /*
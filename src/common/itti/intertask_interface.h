@@ -54,10 +54,6 @@
 #define ITTI_MSG_ORIGIN_NAME(mSGpTR)        itti_get_task_name(ITTI_MSG_ORIGIN_ID(mSGpTR))
 #define ITTI_MSG_DESTINATION_NAME(mSGpTR)   itti_get_task_name(ITTI_MSG_DESTINATION_ID(mSGpTR))
 
-/* Make the message number platform specific */
-typedef unsigned long message_number_t;
-#define MESSAGE_NUMBER_SIZE (sizeof(unsigned long))
-
 typedef enum message_priorities_e {
   MESSAGE_PRIORITY_MAX       = 100,
   MESSAGE_PRIORITY_MAX_LEAST = 85,
@@ -144,12 +140,34 @@ int itti_get_events(task_id_t task_id, struct epoll_event **events);
  **/
 void itti_receive_msg(task_id_t task_id, MessageDef **received_msg);
 
+/** \brief Retrieves up to max_msgs messages in the queue associated to task_id.
+ * If the queue is empty, the thread is blocked till a new message arrives or
+ * till an event occurs on another fd monitored by the task.
+ \param task_id Task ID of the receiving task
+ \param received_msgs Array of at least max_msgs message pointers
+ \param max_msgs Maximum number of messages to retrieve
+ @returns the number of messages stored in received_msgs
+ **/
+int itti_receive_msgs(task_id_t task_id, MessageDef **received_msgs, int max_msgs);
+
 /** \brief Try to retrieves a message in the queue associated to task_id.
  \param task_id Task ID of the receiving task
  \param received_msg Pointer to the allocated message
  **/
 void itti_poll_msg(task_id_t task_id, MessageDef **received_msg);
 
+/** \brief Retrieves without blocking up to max_msgs messages queued for task_id
+ * with a priority class lower than the one of message_id, in their queuing
+ * order. Used to handle the messages which were queued before a higher
+ * priority message that must not overtake them.
+ \param task_id Task ID of the receiving task
+ \param message_id Message whose priority class bounds the retrieved messages
+ \param received_msgs Array of at least max_msgs message pointers
+ \param max_msgs Maximum number of messages to retrieve
+ @returns the number of messages stored in received_msgs
+ **/
+int itti_receive_lower_priority_msgs(task_id_t task_id, MessagesIds message_id, MessageDef **received_msgs, int max_msgs);
+
 /** \brief Start thread associated to the task
  * \param task_id task to start
  * \param start_routine entry point for the task
@@ -216,6 +234,16 @@ MessageDef *itti_alloc_new_message_sized(
   MessagesIds       message_id,
   MessageHeaderSize size);
 
+/** \brief Alloc and memset(0) a new itti message, without aborting when the
+ * memory pools are exhausted: for senders which can back off.
+ * \param origin_task_id Task ID of the sending task
+ * \param message_id Message ID
+ * @returns NULL if the memory pools are exhausted or newly allocated mesage ref
+ **/
+MessageDef *itti_try_alloc_new_message(
+  task_id_t         origin_task_id,
+  MessagesIds       message_id);
+
 /** \brief handle signals and wait for all threads to join when the process complete.
  * This function should be called from the main thread after having created all ITTI tasks.
  **/
@@ -117,6 +117,10 @@ typedef union msg_s {
 
 typedef uint16_t MessageHeaderSize;
 
+/* Make the message number platform specific */
+typedef unsigned long message_number_t;
+#define MESSAGE_NUMBER_SIZE (sizeof(unsigned long))
+
 typedef struct itti_lte_time_s {
   struct timeval time;
 } itti_lte_time_t;
@@ -133,6 +137,9 @@ typedef struct MessageHeader_s {
 
   MessageHeaderSize ittiMsgSize;         /**< Message size (not including header size) */
 
+  uint32_t         messagePriority; /**< Message priority, set by ITTI when the message is sent */
+  message_number_t messageNumber;   /**< Unique message number, set by ITTI when the message is sent */
+
   itti_lte_time_t lte_time;       /**< Reference LTE time */
 } MessageHeader;
 
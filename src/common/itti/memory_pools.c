@@ -27,6 +27,14 @@
  * either expressed or implied, of the FreeBSD Project.
  */
 
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <pthread.h>
+
+#include "liblfds710.h"
+
 #include "assertions.h"
 #include "memory_pools.h"
 #include "dynamic_memory_check.h"
@@ -50,28 +58,17 @@ uint64_t                                vcd_mp_free;
 
 #define MEMORY_POOL_ITEM_INFO_NUMBER    2
 
-/*------------------------------------------------------------------------------*/
-typedef int32_t                         items_group_position_t;
-typedef int32_t                         items_group_index_t;
-
-typedef union items_group_positions_u {
-  uint64_t                                all;
-  struct {
-    items_group_position_t                  put;
-    items_group_position_t                  get;
-  } ind;
-} items_group_positions_t;
-
-typedef struct items_group_s {
-  items_group_position_t                  number_plus_one;
-  volatile uint32_t                       minimum;
-  volatile items_group_positions_t        positions;
-  volatile items_group_index_t           *indexes;
-} items_group_t;
+#define MAX_POOLS_NUMBER                20
 
-/*------------------------------------------------------------------------------*/
-static const items_group_position_t     ITEMS_GROUP_POSITION_INVALID = -1;
-static const items_group_index_t        ITEMS_GROUP_INDEX_INVALID = -1;
+/* Maximum number of chunks a pool can grow to, a chunk holds the initial
+   number of items of the pool. */
+#define MEMORY_POOL_MAX_CHUNKS_NUMBER   64
+
+/* Per thread cache of free items, per pool. When empty, the cache is refilled
+   with MEMORY_POOL_CACHE_BATCH items from the pool free stack, when full
+   MEMORY_POOL_CACHE_BATCH items are given back to the pool free stack. */
+#define MEMORY_POOL_CACHE_SIZE          64
+#define MEMORY_POOL_CACHE_BATCH         32
 
 /*------------------------------------------------------------------------------*/
 typedef uint32_t                        pool_item_start_mark_t;
@@ -87,6 +84,8 @@ typedef uint8_t                         pool_id_t;
 typedef uint8_t                         item_status_t;
 
 typedef struct memory_pool_item_start_s {
+  struct lfds710_stack_element            se;   ///< Link in the pool free stack, only meaningful while the item is free
+
   pool_item_start_mark_t                  start_mark;
 
   pool_id_t                               pool_id;
@@ -105,15 +104,50 @@ typedef struct memory_pool_item_s {
 } memory_pool_item_t;
 
 typedef struct memory_pool_s {
+  /*
+   * Free items of the pool not held by a thread cache
+   */
+  struct lfds710_stack_state              free_items
+          __attribute__ ((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
+
   pool_start_mark_t                       start_mark;
 
   pool_id_t                               pool_id;
   uint32_t                                item_data_number;
   uint32_t                                pool_item_size;
-  items_group_t                           items_group_free;
-  memory_pool_item_t                     *items;
+  uint32_t                                chunk_items_number;
+
+  /*
+   * Growth of the pool, serialized by grow_mutex (the allocation path only
+   * takes it when the free stack is empty).
+   */
+  pthread_mutex_t                         grow_mutex;
+  volatile uint32_t                       chunks_number;
+  memory_pool_item_t                     *chunks[MEMORY_POOL_MAX_CHUNKS_NUMBER];
+
+  /*
+   * Counters of threads without cache (or exited threads)
+   */
+  volatile uint64_t                       allocations;
+  volatile uint64_t                       frees;
+  volatile uint64_t                       failures;
 } memory_pool_t;
 
+typedef struct memory_pool_cache_s {
+  uint32_t                                count;
+  uint64_t                                allocations;
+  uint64_t                                frees;
+  memory_pool_item_t                     *items[MEMORY_POOL_CACHE_SIZE];
+} memory_pool_cache_t;
+
+struct memory_pools_s;
+
+typedef struct memory_pools_cache_s {
+  struct memory_pools_s                  *memory_pools;
+  struct memory_pools_cache_s            *next;
+  struct memory_pools_cache_s            *previous;
+  memory_pool_cache_t                     pools[0];
+} memory_pools_cache_t;
 
 typedef struct memory_pools_s {
   pools_start_mark_t                      start_mark;
@@ -121,10 +155,20 @@ typedef struct memory_pools_s {
   uint32_t                                pools_number;
   uint32_t                                pools_defined;
   memory_pool_t                          *pools;
+  /*
+   * Pools ids sorted by increasing item size
+   */
+  pool_id_t                               pools_by_size[MAX_POOLS_NUMBER];
+
+  /*
+   * Thread caches, the list is only walked for statistics
+   */
+  pthread_key_t                           caches_key;
+  pthread_mutex_t                         caches_mutex;
+  memory_pools_cache_t                   *caches;
 } memory_pools_t;
 
 //------------------------------------------------------------------------------
-static const uint32_t                   MAX_POOLS_NUMBER = 20;
 static const uint32_t                   MAX_POOL_ITEMS_NUMBER = 200 * 1000;
 static const uint32_t                   MAX_POOL_ITEM_SIZE = 100 * 1000;
 
@@ -138,121 +182,8 @@ static const pool_start_mark_t          POOL_START_MARK = CHARS_TO_UINT32 ('P',
 
 static const pools_start_mark_t         POOLS_START_MARK = CHARS_TO_UINT32 ('P', 'S', 's', 't');
 
-/*------------------------------------------------------------------------------*/
-static inline                           uint32_t
-items_group_number_items (
-  items_group_t * items_group)
-{
-  return items_group->number_plus_one - 1;
-}
-
-//------------------------------------------------------------------------------
-static inline                           uint32_t
-items_group_free_items (
-  items_group_t * items_group)
-{
-  items_group_positions_t                 positions;
-  uint32_t                                free_items;
-
-  positions.all = items_group->positions.all;
-  free_items = items_group->number_plus_one + positions.ind.put - positions.ind.get;
-  free_items %= items_group->number_plus_one;
-  return free_items;
-}
-
-//------------------------------------------------------------------------------
-static inline                           items_group_index_t
-items_group_get_free_item (
-  items_group_t * items_group)
-{
-  items_group_position_t                  get_raw;
-  items_group_position_t                  put;
-  items_group_position_t                  get;
-  items_group_position_t                  free_items;
-  items_group_index_t                     index = ITEMS_GROUP_INDEX_INVALID;
-
-  /*
-   * Get current put position
-   */
-  put = items_group->positions.ind.put % items_group->number_plus_one;
-  /*
-   * Get current get position and increase it
-   */
-  get_raw = __sync_fetch_and_add (&items_group->positions.ind.get, 1);
-  get = get_raw % items_group->number_plus_one;
-
-  if (put == get) {
-    /*
-     * No more item free, restore previous position
-     */
-    __sync_fetch_and_sub (&items_group->positions.ind.get, 1);
-  } else {
-    /*
-     * Get index at current get position
-     */
-    index = items_group->indexes[get];
-
-    if (index <= ITEMS_GROUP_INDEX_INVALID) {
-      /*
-       * Index has not yet been completely freed, restore previous get position
-       */
-      __sync_fetch_and_sub (&items_group->positions.ind.get, 1);
-    } else {
-      if (get_raw == items_group->number_plus_one) {
-        /*
-         * Wrap get position
-         */
-        __sync_fetch_and_sub (&items_group->positions.ind.get, items_group->number_plus_one);
-      }
-
-      free_items = items_group_free_items (items_group);
-
-      /*
-       * Updates minimum free items if needed
-       */
-      while (items_group->minimum > free_items) {
-        items_group->minimum = free_items;
-      }
-
-      /*
-       * Clear index at current get position to indicate that item is free
-       */
-      items_group->indexes[get] = ITEMS_GROUP_INDEX_INVALID;
-    }
-  }
-
-  return (index);
-}
-
-//------------------------------------------------------------------------------
-static inline int
-items_group_put_free_item (
-  items_group_t * items_group,
-  items_group_index_t index)
-{
-  items_group_position_t                  put_raw;
-  items_group_position_t                  put;
-
-  /*
-   * Get current put position and increase it
-   */
-  put_raw = __sync_fetch_and_add (&items_group->positions.ind.put, 1);
-  put = put_raw % items_group->number_plus_one;
-
-  if (put_raw == items_group->number_plus_one) {
-    /*
-     * Wrap position
-     */
-    __sync_fetch_and_sub (&items_group->positions.ind.put, items_group->number_plus_one);
-  }
-
-  AssertError (items_group->indexes[put] <= ITEMS_GROUP_INDEX_INVALID, return (EXIT_FAILURE), "Index at current put position (%d) is not marked as free (%d)!\n", put, items_group->number_plus_one);
-  /*
-   * Save freed item index at current put position
-   */
-  items_group->indexes[put] = index;
-  return (EXIT_SUCCESS);
-}
+/* Cache of the calling thread, only for one memory pools set (the first one used by the thread) */
+static __thread memory_pools_cache_t   *memory_pools_thread_cache = NULL;
 
 //------------------------------------------------------------------------------
 static inline memory_pools_t           *
@@ -288,7 +219,6 @@ memory_pool_item_from_handler (
   /*
    * Sanity check on passed handle
    */
-  //AssertError (memory_pool_item->start.start_mark == POOL_ITEM_START_MARK, memory_pool_item = NULL, "Handle %p is not a valid memory pool item handle, start mark is missing!\n", memory_pool_item);
   AssertFatal (memory_pool_item->start.start_mark == POOL_ITEM_START_MARK, "Handle %p is not a valid memory pool item handle, start mark is missing!\n", memory_pool_item);
   return (memory_pool_item);
 }
@@ -296,16 +226,189 @@ memory_pool_item_from_handler (
 //------------------------------------------------------------------------------
 static inline memory_pool_item_t       *
 memory_pool_item_from_index (
+  memory_pool_item_t * chunk,
   memory_pool_t * memory_pool,
-  items_group_index_t index)
+  uint32_t index)
 {
   void                                   *address;
 
-  address = (void *)memory_pool->items;
+  address = (void *)chunk;
   address += index * memory_pool->pool_item_size;
   return (address);
 }
 
+//------------------------------------------------------------------------------
+static inline void
+memory_pool_push_free_item (
+  memory_pool_t * memory_pool,
+  memory_pool_item_t * memory_pool_item)
+{
+  LFDS710_STACK_SET_VALUE_IN_ELEMENT (memory_pool_item->start.se, memory_pool_item);
+  lfds710_stack_push (&memory_pool->free_items, &memory_pool_item->start.se);
+}
+
+//------------------------------------------------------------------------------
+static inline memory_pool_item_t       *
+memory_pool_pop_free_item (
+  memory_pool_t * memory_pool)
+{
+  struct lfds710_stack_element           *se = NULL;
+
+  if (lfds710_stack_pop (&memory_pool->free_items, &se) == 0) {
+    return NULL;
+  }
+  return LFDS710_STACK_GET_VALUE_FROM_ELEMENT (*se);
+}
+
+//------------------------------------------------------------------------------
+// Add a chunk of items to the pool, unless another thread already did it
+// since the caller saw chunks_number.
+// Returns 0 if new items may be available, -1 if the pool can not grow.
+static int
+memory_pool_grow (
+  memory_pool_t * memory_pool,
+  uint32_t chunks_number)
+{
+  memory_pool_item_t                     *chunk = NULL;
+  memory_pool_item_t                     *memory_pool_item = NULL;
+  uint32_t                                item_index = 0;
+  int                                     rc = 0;
+
+  pthread_mutex_lock (&memory_pool->grow_mutex);
+
+  if (memory_pool->chunks_number == chunks_number) {
+    if (chunks_number >= MEMORY_POOL_MAX_CHUNKS_NUMBER) {
+      rc = -1;
+    } else {
+      chunk = calloc (memory_pool->chunk_items_number, memory_pool->pool_item_size);
+
+      if (chunk == NULL) {
+        rc = -1;
+      } else {
+        for (item_index = 0; item_index < memory_pool->chunk_items_number; item_index++) {
+          memory_pool_item = memory_pool_item_from_index (chunk, memory_pool, item_index);
+          memory_pool_item->start.start_mark = POOL_ITEM_START_MARK;
+          memory_pool_item->start.pool_id = memory_pool->pool_id;
+          memory_pool_item->start.item_status = ITEM_STATUS_FREE;
+          memory_pool_item->data[memory_pool->item_data_number] = POOL_ITEM_END_MARK;
+          memory_pool_push_free_item (memory_pool, memory_pool_item);
+        }
+        memory_pool->chunks[chunks_number] = chunk;
+        __sync_synchronize ();
+        memory_pool->chunks_number = chunks_number + 1;
+        MP_DEBUG (" Grow  [%2u] chunk %u, %u items\n", memory_pool->pool_id, chunks_number, memory_pool->chunk_items_number);
+      }
+    }
+  }
+
+  pthread_mutex_unlock (&memory_pool->grow_mutex);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static void
+memory_pools_cache_release (
+  void *args)
+{
+  memory_pools_cache_t                   *cache = (memory_pools_cache_t *) args;
+  memory_pools_t                         *memory_pools = cache->memory_pools;
+  pool_id_t                               pool;
+
+  /*
+   * Thread is exiting: give back cached items and keep its counters
+   */
+  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
+    while (cache->pools[pool].count > 0) {
+      memory_pool_push_free_item (&memory_pools->pools[pool], cache->pools[pool].items[--cache->pools[pool].count]);
+    }
+    __sync_fetch_and_add (&memory_pools->pools[pool].allocations, cache->pools[pool].allocations);
+    __sync_fetch_and_add (&memory_pools->pools[pool].frees, cache->pools[pool].frees);
+  }
+
+  pthread_mutex_lock (&memory_pools->caches_mutex);
+  if (cache->previous) {
+    cache->previous->next = cache->next;
+  } else {
+    memory_pools->caches = cache->next;
+  }
+  if (cache->next) {
+    cache->next->previous = cache->previous;
+  }
+  pthread_mutex_unlock (&memory_pools->caches_mutex);
+
+  if (memory_pools_thread_cache == cache) {
+    memory_pools_thread_cache = NULL;
+  }
+  free_wrapper ((void **)&cache);
+}
+
+//------------------------------------------------------------------------------
+static inline memory_pools_cache_t     *
+memory_pools_get_thread_cache (
+  memory_pools_t * memory_pools)
+{
+  memory_pools_cache_t                   *cache = memory_pools_thread_cache;
+
+  if (cache == NULL) {
+    cache = calloc (1, sizeof (memory_pools_cache_t) + memory_pools->pools_number * sizeof (memory_pool_cache_t));
+
+    if (cache == NULL) {
+      return NULL;
+    }
+    LFDS710_MISC_MAKE_VALID_ON_CURRENT_LOGICAL_CORE_INITS_COMPLETED_BEFORE_NOW_ON_ANY_OTHER_LOGICAL_CORE;
+    cache->memory_pools = memory_pools;
+    pthread_mutex_lock (&memory_pools->caches_mutex);
+    cache->next = memory_pools->caches;
+    if (cache->next) {
+      cache->next->previous = cache;
+    }
+    memory_pools->caches = cache;
+    pthread_mutex_unlock (&memory_pools->caches_mutex);
+    pthread_setspecific (memory_pools->caches_key, cache);
+    memory_pools_thread_cache = cache;
+  }
+
+  if (cache->memory_pools != memory_pools) {
+    return NULL;
+  }
+  return cache;
+}
+
+//------------------------------------------------------------------------------
+static inline memory_pool_item_t       *
+memory_pool_get_free_item (
+  memory_pool_t * memory_pool,
+  memory_pool_cache_t * cache)
+{
+  memory_pool_item_t                     *memory_pool_item = NULL;
+  uint32_t                                chunks_number = 0;
+
+  if ((cache) && (cache->count > 0)) {
+    return cache->items[--cache->count];
+  }
+
+  do {
+    chunks_number = memory_pool->chunks_number;
+    memory_pool_item = memory_pool_pop_free_item (memory_pool);
+
+    if (memory_pool_item) {
+      /*
+       * Refill the thread cache, next allocations will not touch the shared stack
+       */
+      if (cache) {
+        memory_pool_item_t                     *cached_item = NULL;
+
+        while ((cache->count < MEMORY_POOL_CACHE_BATCH) && ((cached_item = memory_pool_pop_free_item (memory_pool)) != NULL)) {
+          cache->items[cache->count++] = cached_item;
+        }
+      }
+      return memory_pool_item;
+    }
+  } while (memory_pool_grow (memory_pool, chunks_number) == 0);
+
+  return NULL;
+}
+
 //------------------------------------------------------------------------------
 memory_pools_handle_t memory_pools_create (uint32_t pools_number)
 {
@@ -316,7 +419,7 @@ memory_pools_handle_t memory_pools_create (uint32_t pools_number)
   /*
    * Allocate memory_pools
    */
-  memory_pools = malloc (sizeof (memory_pools_t));
+  memory_pools = calloc (1, sizeof (memory_pools_t));
   AssertFatal (memory_pools != NULL, "Memory pools structure allocation failed!\n");
   /*
    * Initialize memory_pools
@@ -325,11 +428,14 @@ memory_pools_handle_t memory_pools_create (uint32_t pools_number)
     memory_pools->start_mark = POOLS_START_MARK;
     memory_pools->pools_number = pools_number;
     memory_pools->pools_defined = 0;
+    pthread_mutex_init (&memory_pools->caches_mutex, NULL);
+    AssertFatal (pthread_key_create (&memory_pools->caches_key, memory_pools_cache_release) == 0, "Memory pools cache key creation failed!\n");
     /*
      * Allocate pools
      */
-    memory_pools->pools = calloc (pools_number, sizeof (memory_pool_t));
+    memory_pools->pools = memalign (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES, pools_number * sizeof (memory_pool_t));
     AssertFatal (memory_pools->pools != NULL, "Memory pools allocation failed!\n");
+    memset (memory_pools->pools, 0, pools_number * sizeof (memory_pool_t));
 
     /*
      * Initialize pools
@@ -347,34 +453,45 @@ memory_pools_statistics (
   memory_pools_handle_t memory_pools_handle)
 {
   memory_pools_t                         *memory_pools;
+  memory_pools_cache_t                   *cache;
   pool_id_t                               pool;
   char                                   *statistics;
   int                                     printed_chars;
   uint32_t                                allocated_pool_memory;
   uint32_t                                allocated_pools_memory = 0;
-  items_group_t                          *items_group;
   uint32_t                                pool_items_size;
+  uint32_t                                pool_items_number;
+  uint64_t                                allocations;
+  uint64_t                                frees;
 
   /*
    * Recover memory_pools
    */
   memory_pools = memory_pools_from_handler (memory_pools_handle);
   AssertFatal (memory_pools != NULL, "Failed to retrieve memory pool for handle %p!\n", memory_pools_handle);
-  statistics = malloc (memory_pools->pools_defined * 200);
-  printed_chars = sprintf (&statistics[0], "Pool:   size, number, minimum,   free, address space and memory used in Kbytes\n");
+  statistics = malloc ((memory_pools->pools_defined + 2) * 200);
+  printed_chars = sprintf (&statistics[0], "Pool:   size, number, chunks,  in use,       allocations, failures, memory used in Kbytes\n");
 
+  pthread_mutex_lock (&memory_pools->caches_mutex);
   for (pool = 0; pool < memory_pools->pools_defined; pool++) {
-    items_group = &memory_pools->pools[pool].items_group_free;
-    allocated_pool_memory = items_group_number_items (items_group) * memory_pools->pools[pool].pool_item_size;
+    pool_items_number = memory_pools->pools[pool].chunks_number * memory_pools->pools[pool].chunk_items_number;
+    allocated_pool_memory = pool_items_number * memory_pools->pools[pool].pool_item_size;
     allocated_pools_memory += allocated_pool_memory;
     pool_items_size = memory_pools->pools[pool].item_data_number * sizeof (memory_pool_data_t);
-    printed_chars += sprintf (&statistics[printed_chars], "  %2u: %6u, %6u,  %6u, %6u, [%p-%p] %6u\n",
-                              pool, pool_items_size,
-                              items_group_number_items (items_group),
-                              items_group->minimum, items_group_free_items (items_group), memory_pools->pools[pool].items, ((void *)memory_pools->pools[pool].items) + allocated_pool_memory, allocated_pool_memory / (1024));
+    allocations = memory_pools->pools[pool].allocations;
+    frees = memory_pools->pools[pool].frees;
+
+    for (cache = memory_pools->caches; cache; cache = cache->next) {
+      allocations += cache->pools[pool].allocations;
+      frees += cache->pools[pool].frees;
+    }
+    printed_chars += sprintf (&statistics[printed_chars], "  %2u: %6u, %6u,     %2u, %7" PRIu64 ", %17" PRIu64 ", %8" PRIu64 ", %6u\n",
+                              pool, pool_items_size, pool_items_number, memory_pools->pools[pool].chunks_number,
+                              allocations - frees, allocations, memory_pools->pools[pool].failures, allocated_pool_memory / (1024));
   }
+  pthread_mutex_unlock (&memory_pools->caches_mutex);
 
-  printed_chars = sprintf (&statistics[printed_chars], "Pools memory %u Kbytes\n", allocated_pools_memory / (1024));
+  printed_chars += sprintf (&statistics[printed_chars], "Pools memory %u Kbytes\n", allocated_pools_memory / (1024));
   return (statistics);
 }
 
@@ -388,10 +505,10 @@ memory_pools_add_pool (
   memory_pools_t                         *memory_pools;
   memory_pool_t                          *memory_pool;
   pool_id_t                               pool;
-  items_group_index_t                     item_index;
-  memory_pool_item_t                     *memory_pool_item;
+  int                                     position;
 
   AssertFatal (pool_items_number <= MAX_POOL_ITEMS_NUMBER, "Too many items for a memory pool (%u/%d)!\n", pool_items_number, MAX_POOL_ITEMS_NUMBER);    /* Limit to a reasonable number of items */
+  AssertFatal (pool_items_number > 0, "A memory pool must have items!\n");
   AssertFatal (pool_item_size <= MAX_POOL_ITEM_SIZE, "Item size is too big for memory pool items (%u/%d)!\n", pool_item_size, MAX_POOL_ITEM_SIZE);      /* Limit to a reasonable item size */
   /*
    * Recover memory_pools
@@ -416,45 +533,31 @@ memory_pools_add_pool (
      * Item size in memory_pool_data_t items by excess
      */
     memory_pool->item_data_number = (pool_item_size + sizeof (memory_pool_data_t) - 1) / sizeof (memory_pool_data_t);
-    memory_pool->pool_item_size = (memory_pool->item_data_number * sizeof (memory_pool_data_t)) + sizeof (memory_pool_item_t);
-    memory_pool->items_group_free.number_plus_one = pool_items_number + 1;
-    memory_pool->items_group_free.minimum = pool_items_number;
-    memory_pool->items_group_free.positions.ind.put = pool_items_number;
-    memory_pool->items_group_free.positions.ind.get = 0;
-    /*
-     * Allocate free indexes
-     */
-    memory_pool->items_group_free.indexes = malloc (memory_pool->items_group_free.number_plus_one * sizeof (items_group_index_t));
-    AssertFatal (memory_pool->items_group_free.indexes != NULL, "Memory pool indexes allocation failed!\n");
-
-    /*
-     * Initialize free indexes
-     */
-    for (item_index = 0; item_index < pool_items_number; item_index++) {
-      memory_pool->items_group_free.indexes[item_index] = item_index;
-    }
-
     /*
-     * Last index is not allocated
+     * Keep items aligned on the free stack link
      */
-    memory_pool->items_group_free.indexes[item_index] = ITEMS_GROUP_INDEX_INVALID;
+    memory_pool->pool_item_size = (memory_pool->item_data_number * sizeof (memory_pool_data_t)) + sizeof (memory_pool_item_t);
+    memory_pool->pool_item_size = (memory_pool->pool_item_size + sizeof (void *) - 1) & ~(sizeof (void *) - 1);
+    memory_pool->chunk_items_number = pool_items_number;
+    memory_pool->chunks_number = 0;
+    pthread_mutex_init (&memory_pool->grow_mutex, NULL);
+    lfds710_stack_init_valid_on_current_logical_core (&memory_pool->free_items, NULL);
     /*
-     * Allocate items
+     * Pre-allocate the first chunk
      */
-    memory_pool->items = calloc (pool_items_number, memory_pool->pool_item_size);
-    AssertFatal (memory_pool->items != NULL, "Memory pool items allocation failed!\n");
+    AssertFatal (memory_pool_grow (memory_pool, 0) == 0, "Memory pool items allocation failed!\n");
+  }
 
-    /*
-     * Initialize items
-     */
-    for (item_index = 0; item_index < pool_items_number; item_index++) {
-      memory_pool_item = memory_pool_item_from_index (memory_pool, item_index);
-      memory_pool_item->start.start_mark = POOL_ITEM_START_MARK;
-      memory_pool_item->start.pool_id = pool;
-      memory_pool_item->start.item_status = ITEM_STATUS_FREE;
-      memory_pool_item->data[memory_pool->item_data_number] = POOL_ITEM_END_MARK;
+  /*
+   * Insert the pool in the size ordered pool list
+   */
+  for (position = memory_pools->pools_defined; position > 0; position--) {
+    if (memory_pools->pools[memory_pools->pools_by_size[position - 1]].item_data_number <= memory_pool->item_data_number) {
+      break;
     }
+    memory_pools->pools_by_size[position] = memory_pools->pools_by_size[position - 1];
   }
+  memory_pools->pools_by_size[position] = pool;
   memory_pools->pools_defined++;
   return (0);
 }
@@ -468,21 +571,26 @@ memory_pools_allocate (
   uint16_t info_1)
 {
   memory_pools_t                         *memory_pools;
-  memory_pool_item_t                     *memory_pool_item;
+  memory_pools_cache_t                   *cache;
+  memory_pool_item_t                     *memory_pool_item = NULL;
   memory_pool_item_handle_t               memory_pool_item_handle = NULL;
-  pool_id_t                               pool;
-  items_group_index_t                     item_index = ITEMS_GROUP_INDEX_INVALID;
+  pool_id_t                               pool = 0;
+  uint32_t                                position;
 
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_MP_ALLOC, __sync_or_and_fetch (&vcd_mp_alloc, 1L << info_0));
   /*
    * Recover memory_pools
    */
   memory_pools = memory_pools_from_handler (memory_pools_handle);
-  AssertError (memory_pools != NULL, {
-               }
-               , "Failed to retrieve memory pool for handle %p!\n", memory_pools_handle);
+  AssertError (memory_pools != NULL, return NULL, "Failed to retrieve memory pool for handle %p!\n", memory_pools_handle);
+  cache = memory_pools_get_thread_cache (memory_pools);
+
+  /*
+   * Smallest size class first, a bigger one is only used if a class can not grow anymore
+   */
+  for (position = 0; position < memory_pools->pools_defined; position++) {
+    pool = memory_pools->pools_by_size[position];
 
-  for (pool = 0; pool < memory_pools->pools_defined; pool++) {
     if ((memory_pools->pools[pool].item_data_number * sizeof (memory_pool_data_t)) < item_size) {
       /*
        * This memory pool has too small items, skip it
@@ -490,38 +598,33 @@ memory_pools_allocate (
       continue;
     }
 
-    item_index = items_group_get_free_item (&memory_pools->pools[pool].items_group_free);
+    memory_pool_item = memory_pool_get_free_item (&memory_pools->pools[pool], (cache) ? &cache->pools[pool] : NULL);
 
-    if (item_index <= ITEMS_GROUP_INDEX_INVALID) {
-      /*
-       * Allocation failed, skip this pool
-       */
-      continue;
-    } else {
-      /*
-       * Allocation succeed, exit searching loop
-       */
+    if (memory_pool_item) {
       break;
     }
+    __sync_fetch_and_add (&memory_pools->pools[pool].failures, 1);
   }
 
-  if (item_index > ITEMS_GROUP_INDEX_INVALID) {
-    /*
-     * Convert item index into memory_pool_item address
-     */
-    memory_pool_item = memory_pool_item_from_index (&memory_pools->pools[pool], item_index);
+  if (memory_pool_item) {
     /*
      * Sanity check on item status, must be free
      */
-    AssertFatal (memory_pool_item->start.item_status == ITEM_STATUS_FREE, "Item status is not set to free (%d) in pool %u, item %d!\n", memory_pool_item->start.item_status, pool, item_index);
+    AssertFatal (memory_pool_item->start.item_status == ITEM_STATUS_FREE, "Item status is not set to free (%d) in pool %u!\n", memory_pool_item->start.item_status, pool);
     memory_pool_item->start.item_status = ITEM_STATUS_ALLOCATED;
     memory_pool_item->start.info[0] = info_0;
     memory_pool_item->start.info[1] = info_1;
     memory_pool_item_handle = memory_pool_item->data;
-    MP_DEBUG (" Alloc [%2u][%6d]{%6d}, %3u %3u, %6u, %p, %p, %p\n",
-              pool, item_index, items_group_free_items (&memory_pools->pools[pool].items_group_free), info_0, info_1, item_size, memory_pools->pools[pool].items, memory_pool_item, memory_pool_item_handle);
+
+    if (cache) {
+      cache->pools[pool].allocations++;
+    } else {
+      __sync_fetch_and_add (&memory_pools->pools[pool].allocations, 1);
+    }
+    MP_DEBUG (" Alloc [%2u]{%6u}, %3u %3u, %6u, %p, %p\n",
+              pool, memory_pools->pools[pool].chunks_number, info_0, info_1, item_size, memory_pool_item, memory_pool_item_handle);
   } else {
-    MP_DEBUG (" Alloc [--][------]{------}, %3u %3u, %6u, failed!\n", info_0, info_1, item_size);
+    MP_DEBUG (" Alloc [--]{------}, %3u %3u, %6u, failed!\n", info_0, info_1, item_size);
   }
 
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_MP_ALLOC, __sync_and_and_fetch (&vcd_mp_alloc, ~(1L << info_0)));
@@ -536,13 +639,12 @@ memory_pools_free (
   uint16_t info_0)
 {
   memory_pools_t                         *memory_pools;
+  memory_pools_cache_t                   *cache;
+  memory_pool_cache_t                    *pool_cache;
   memory_pool_item_t                     *memory_pool_item;
   pool_id_t                               pool;
-  items_group_index_t                     item_index;
   uint32_t                                item_size;
-  uint32_t                                pool_item_size;
   uint16_t                                info_1;
-  int                                     result;
 
   /*
    * Recover memory_pools
@@ -562,32 +664,38 @@ memory_pools_free (
   pool = memory_pool_item->start.pool_id;
   AssertFatal (pool < memory_pools->pools_defined, "Pool index is invalid (%u/%u)!\n", pool, memory_pools->pools_defined);
   item_size = memory_pools->pools[pool].item_data_number;
-  pool_item_size = memory_pools->pools[pool].pool_item_size;
-  item_index = (((void *)memory_pool_item) - ((void *)memory_pools->pools[pool].items)) / pool_item_size;
-  MP_DEBUG (" Free  [%2u][%6d]{%6d}, %3u %3u,         %p, %p, %p, %u\n",
-            pool, item_index,
-            items_group_free_items (&memory_pools->pools[pool].items_group_free),
-            memory_pool_item->start.info[0], info_1, memory_pool_item_handle, memory_pool_item, memory_pools->pools[pool].items, ((uint32_t) (item_size * sizeof (memory_pool_data_t))));
-  /*
-   * Sanity check on calculated item index
-   */
-  AssertFatal (memory_pool_item == memory_pool_item_from_index (&memory_pools->pools[pool], item_index),
-               "Incorrect memory pool item address (%p, %p) for pool %u, item %d!\n", memory_pool_item, memory_pool_item_from_index (&memory_pools->pools[pool], item_index), pool, item_index);
+  MP_DEBUG (" Free  [%2u], %3u %3u,         %p, %p, %u\n",
+            pool, memory_pool_item->start.info[0], info_1, memory_pool_item_handle, memory_pool_item, ((uint32_t) (item_size * sizeof (memory_pool_data_t))));
   /*
    * Sanity check on end marker, must still be present (no write overflow)
    */
-  AssertFatal (memory_pool_item->data[item_size] == POOL_ITEM_END_MARK, "Memory pool item is corrupted, end mark is not present for pool %u, item %d!\n", pool, item_index);
+  AssertFatal (memory_pool_item->data[item_size] == POOL_ITEM_END_MARK, "Memory pool item is corrupted, end mark is not present for pool %u, item %p!\n", pool, memory_pool_item);
   /*
    * Sanity check on item status, must be allocated
    */
-  AssertFatal (memory_pool_item->start.item_status == ITEM_STATUS_ALLOCATED, "Trying to free a non allocated (%x) memory pool item (pool %u, item %d)!\n", memory_pool_item->start.item_status, pool, item_index);
+  AssertFatal (memory_pool_item->start.item_status == ITEM_STATUS_ALLOCATED, "Trying to free a non allocated (%x) memory pool item (pool %u, item %p)!\n", memory_pool_item->start.item_status, pool, memory_pool_item);
   memory_pool_item->start.item_status = ITEM_STATUS_FREE;
-  result = items_group_put_free_item (&memory_pools->pools[pool].items_group_free, item_index);
-  AssertError (result == EXIT_SUCCESS, {
-               }
-               , "Failed to free memory pool item (pool %u, item %d)!\n", pool, item_index);
+  cache = memory_pools_get_thread_cache (memory_pools);
+
+  if (cache) {
+    pool_cache = &cache->pools[pool];
+
+    if (pool_cache->count == MEMORY_POOL_CACHE_SIZE) {
+      /*
+       * Cache full, give a batch back to the pool
+       */
+      while (pool_cache->count > (MEMORY_POOL_CACHE_SIZE - MEMORY_POOL_CACHE_BATCH)) {
+        memory_pool_push_free_item (&memory_pools->pools[pool], pool_cache->items[--pool_cache->count]);
+      }
+    }
+    pool_cache->items[pool_cache->count++] = memory_pool_item;
+    pool_cache->frees++;
+  } else {
+    memory_pool_push_free_item (&memory_pools->pools[pool], memory_pool_item);
+    __sync_fetch_and_add (&memory_pools->pools[pool].frees, 1);
+  }
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_MP_FREE, __sync_and_and_fetch (&vcd_mp_free, ~(1L << info_1)));
-  return (result);
+  return (EXIT_SUCCESS);
 }
 
 //------------------------------------------------------------------------------
@@ -601,9 +709,7 @@ memory_pools_set_info (
   memory_pools_t                         *memory_pools;
   memory_pool_item_t                     *memory_pool_item;
   pool_id_t                               pool;
-  items_group_index_t                     item_index;
   uint32_t                                item_size;
-  uint32_t                                pool_item_size;
 
   AssertFatal (index < MEMORY_POOL_ITEM_INFO_NUMBER, "Incorrect info index (%d/%d)!\n", index, MEMORY_POOL_ITEM_INFO_NUMBER);
   /*
@@ -631,24 +737,15 @@ memory_pools_set_info (
     pool = memory_pool_item->start.pool_id;
     AssertFatal (pool < memory_pools->pools_defined, "Pool index is invalid (%u/%u)!\n", pool, memory_pools->pools_defined);
     item_size = memory_pools->pools[pool].item_data_number;
-    pool_item_size = memory_pools->pools[pool].pool_item_size;
-    item_index = (((void *)memory_pool_item) - ((void *)memory_pools->pools[pool].items)) / pool_item_size;
-    MP_DEBUG (" Info  [%2u][%6d]{%6d}, %3u %3u,         %p, %p, %p, %u\n",
-              pool, item_index,
-              items_group_free_items (&memory_pools->pools[pool].items_group_free),
-              memory_pool_item->start.info[0], memory_pool_item->start.info[1], memory_pool_item_handle, memory_pool_item, memory_pools->pools[pool].items, ((uint32_t) (item_size * sizeof (memory_pool_data_t))));
-    /*
-     * Sanity check on calculated item index
-     */
-    AssertFatal (memory_pool_item == memory_pool_item_from_index (&memory_pools->pools[pool], item_index),
-                 "Incorrect memory pool item address (%p, %p) for pool %u, item %d!\n", memory_pool_item, memory_pool_item_from_index (&memory_pools->pools[pool], item_index), pool, item_index);
+    MP_DEBUG (" Info  [%2u], %3u %3u,         %p, %p, %u\n",
+              pool, memory_pool_item->start.info[0], memory_pool_item->start.info[1], memory_pool_item_handle, memory_pool_item, ((uint32_t) (item_size * sizeof (memory_pool_data_t))));
     /*
      * Sanity check on end marker, must still be present (no write overflow)
      */
-    AssertFatal (memory_pool_item->data[item_size] == POOL_ITEM_END_MARK, "Memory pool item is corrupted, end mark is not present for pool %u, item %d!\n", pool, item_index);
+    AssertFatal (memory_pool_item->data[item_size] == POOL_ITEM_END_MARK, "Memory pool item is corrupted, end mark is not present for pool %u, item %p!\n", pool, memory_pool_item);
     /*
      * Sanity check on item status, must be allocated
      */
-    AssertFatal (memory_pool_item->start.item_status == ITEM_STATUS_ALLOCATED, "Trying to free a non allocated (%x) memory pool item (pool %u, item %d)\n", memory_pool_item->start.item_status, pool, item_index);
+    AssertFatal (memory_pool_item->start.item_status == ITEM_STATUS_ALLOCATED, "Trying to free a non allocated (%x) memory pool item (pool %u, item %p)\n", memory_pool_item->start.item_status, pool, memory_pool_item);
   }
 }
@@ -41,6 +41,10 @@ char *memory_pools_statistics(memory_pools_handle_t memory_pools_handle);
 
 int memory_pools_add_pool (memory_pools_handle_t memory_pools_handle, uint32_t pool_items_number, uint32_t pool_item_size);
 
+/* Pools are size classes: an item is taken from the smallest pool able to hold
+ * item_size, through a per thread cache. An empty pool grows by chunks of its
+ * initial number of items; NULL is returned only when no suitable pool can
+ * provide an item anymore, the caller has to back off. */
 memory_pool_item_handle_t memory_pools_allocate (memory_pools_handle_t memory_pools_handle, uint32_t item_size, uint16_t info_0, uint16_t info_1);
 
 int memory_pools_free (memory_pools_handle_t memory_pools_handle, memory_pool_item_handle_t memory_pool_item_handle, uint16_t info_0);
@@ -72,11 +72,10 @@ signal_mask (
 {
   /*
    * We set the signal mask to avoid threads other than the main thread
-   * * * to receive the timer signal. Note that threads created will inherit this
+   * * * to receive the signals. Note that threads created will inherit this
    * * * configuration.
    */
   sigemptyset (&set);
-  sigaddset (&set, SIGTIMER);
   sigaddset (&set, SIGUSR1);
   sigaddset (&set, SIGABRT);
   sigaddset (&set, SIGSEGV);
@@ -98,7 +97,6 @@ signal_handle (
   siginfo_t                               info;
 
   sigemptyset (&set);
-  sigaddset (&set, SIGTIMER);
   sigaddset (&set, SIGUSR1);
   sigaddset (&set, SIGABRT);
   sigaddset (&set, SIGSEGV);
@@ -121,37 +119,29 @@ signal_handle (
   //printf("Received signal %d\n", info.si_signo);
 
   /*
-   * Real-time signals are non constant and are therefore not suitable for
-   * * * use in switch.
+   * Dispatch the signal to sub-handlers
    */
-  if (info.si_signo == SIGTIMER) {
-    timer_handle_signal (&info);
-  } else {
-    /*
-     * Dispatch the signal to sub-handlers
-     */
-    switch (info.si_signo) {
-    case SIGUSR1:
-      SIG_DEBUG ("Received SIGUSR1\n");
-      *end = 1;
-      break;
-
-    case SIGSEGV:              /* Fall through */
-    case SIGABRT:
-      SIG_DEBUG ("Received SIGABORT\n");
-      backtrace_handle_signal (&info);
-      break;
-
-    case SIGINT:
-      printf ("Received SIGINT\n");
-      itti_send_terminate_message (TASK_UNKNOWN);
-      *end = 1;
-      break;
-
-    default:
-      SIG_ERROR ("Received unknown signal %d\n", info.si_signo);
-      break;
-    }
+  switch (info.si_signo) {
+  case SIGUSR1:
+    SIG_DEBUG ("Received SIGUSR1\n");
+    *end = 1;
+    break;
+
+  case SIGSEGV:              /* Fall through */
+  case SIGABRT:
+    SIG_DEBUG ("Received SIGABORT\n");
+    backtrace_handle_signal (&info);
+    break;
+
+  case SIGINT:
+    printf ("Received SIGINT\n");
+    itti_send_terminate_message (TASK_UNKNOWN);
+    *end = 1;
+    break;
+
+  default:
+    SIG_ERROR ("Received unknown signal %d\n", info.si_signo);
+    break;
   }
 
   return 0;
@@ -27,6 +27,22 @@
  * either expressed or implied, of the FreeBSD Project.
  */
 
+/*
+ * ITTI timers are kept in a hierarchical timing wheel driven by a single
+ * timerfd, instead of one POSIX timer (and one signal) per timer:
+ *  - level 0 has TIMER_WHEEL_ROOT_SLOTS slots of one tick,
+ *  - each of the TIMER_WHEEL_LEVELS - 1 upper levels has TIMER_WHEEL_LEVEL_SLOTS
+ *    slots covering a whole turn of the level below; its timers are cascaded
+ *    down when the lower level wraps.
+ * Timers are elements of a growing array, linked by index in their slot, the
+ * timer id encodes the element index and a generation so that starting and
+ * stopping a timer are O(1) and a stale id never matches a reused element.
+ * The timerfd ticks only while timers are pending, a dedicated thread advances
+ * the wheel and sends TIMER_HAS_EXPIRED to the requesting tasks. An expiry the
+ * destination task can not queue (full queue, exhausted memory pools) is kept
+ * and sent again with the next tick.
+ */
+
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -34,103 +50,438 @@
 #include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
-#include <signal.h>
 #include <time.h>
 #include <errno.h>
+#include <sys/timerfd.h>
 
 #include "bstrlib.h"
 
 #include "intertask_interface.h"
 #include "timer.h"
 #include "log.h"
-#include "queue.h"
 #include "dynamic_memory_check.h"
 #include "assertions.h"
 
+/* Wheel resolution, timers are rounded up to the next tick */
+#define TIMER_WHEEL_TICK_US             10000
+
+#define TIMER_WHEEL_ROOT_BITS           8
+#define TIMER_WHEEL_LEVEL_BITS          6
+#define TIMER_WHEEL_LEVELS              5
+#define TIMER_WHEEL_ROOT_SLOTS          (1 << TIMER_WHEEL_ROOT_BITS)
+#define TIMER_WHEEL_LEVEL_SLOTS         (1 << TIMER_WHEEL_LEVEL_BITS)
+#define TIMER_WHEEL_SLOTS               (TIMER_WHEEL_ROOT_SLOTS + ((TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LEVEL_SLOTS))
+/* Longest delay the wheel can hold, longer ones are clamped and re-queued on expiry */
+#define TIMER_WHEEL_MAX_TICKS           ((1ULL << (TIMER_WHEEL_ROOT_BITS + ((TIMER_WHEEL_LEVELS - 1) * TIMER_WHEEL_LEVEL_BITS))) - 1)
 
-int                                     timer_handle_signal (
-  siginfo_t * info);
+#define TIMER_ELM_INITIAL_NUMBER        1024
+#define TIMER_EXPIRY_INITIAL_NUMBER     256
+#define TIMER_ELM_NONE                  UINT32_MAX
+#define TIMER_SLOT_NONE                 UINT16_MAX
+
+#define TIMER_ID_INDEX_MASK             0xffffffffUL
+#define TIMER_ID(eLMiNDEX, gENERATION)  ((long)((((unsigned long)(gENERATION)) << 32) | ((unsigned long)(eLMiNDEX) + 1)))
 
 struct timer_elm_s {
   task_id_t                               task_id;      ///< Task ID which has requested the timer
   int32_t                                 instance;     ///< Instance of the task which has requested the timer
-  timer_t                                 timer;        ///< Unique timer id
-  timer_type_t                            type; ///< Timer type
+  timer_type_t                            type;         ///< Timer type
   void                                   *timer_arg;    ///< Optional argument that will be passed when timer expires
-                                          STAILQ_ENTRY (
-  timer_elm_s)                            entries;      ///< Pointer to next element
+  uint64_t                                expires;      ///< Expiry tick
+  uint64_t                                deadline;     ///< Requested expiry tick (differs from expires only for clamped delays)
+  uint64_t                                interval;     ///< Period in ticks
+  uint32_t                                generation;   ///< Incremented each time the element is released
+  uint32_t                                next;         ///< Next element in slot or in free list
+  uint32_t                                previous;     ///< Previous element in slot
+  uint16_t                                slot;         ///< Wheel slot, TIMER_SLOT_NONE if not armed
 };
 
+/* Expiry not yet delivered to its task */
+typedef struct timer_expiry_s {
+  task_id_t                               task_id;
+  int32_t                                 instance;
+  long                                    timer_id;
+  void                                   *timer_arg;
+} timer_expiry_t;
+
 typedef struct timer_desc_s {
-  STAILQ_HEAD (
-  timer_list_head,
-  timer_elm_s) timer_queue;
   pthread_mutex_t                         timer_list_mutex;
-  struct timespec                         timeout;
+  struct timer_elm_s                     *elms;
+  uint32_t                                elms_number;
+  uint32_t                                free_elm;
+  uint32_t                                slots[TIMER_WHEEL_SLOTS];
+  uint64_t                                current_tick;         ///< Next tick to be processed by the wheel
+  uint32_t                                armed_timers;
+  /*
+   * Expiries to send again, only accessed by the timer thread
+   */
+  timer_expiry_t                         *pending_expiries;
+  uint32_t                                nb_pending_expiries;
+  uint32_t                                pending_expiries_size;
+  int                                     timer_fd;
+  bool                                    timer_fd_armed;
+  struct timespec                         start_time;
+  pthread_t                               thread;
 } timer_desc_t;
 
 static timer_desc_t                     timer_desc;
 
-#define TIMER_SEARCH(vAR, tIMERfIELD, tIMERvALUE, tIMERqUEUE)   \
-  do {                                                            \
-    STAILQ_FOREACH(vAR, tIMERqUEUE, entries) {                  \
-      if (((vAR)->tIMERfIELD == tIMERvALUE))                  \
-        break;                                              \
-    }                                                           \
-  } while(0)
+static uint64_t
+timer_get_tick (
+  void)
+{
+  struct timespec                         now;
+  uint64_t                                elapsed_us;
 
-int
-timer_handle_signal (
-  siginfo_t * info)
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  elapsed_us = ((uint64_t) (now.tv_sec - timer_desc.start_time.tv_sec) * 1000000) + ((int64_t) now.tv_nsec - timer_desc.start_time.tv_nsec) / 1000;
+  return elapsed_us / TIMER_WHEEL_TICK_US;
+}
+
+static void
+timer_arm_fd (
+  bool arm)
+{
+  struct itimerspec                       its;
+
+  if (arm == timer_desc.timer_fd_armed) {
+    return;
+  }
+
+  memset (&its, 0, sizeof (its));
+
+  if (arm) {
+    its.it_value.tv_nsec = TIMER_WHEEL_TICK_US * 1000;
+    its.it_interval.tv_nsec = TIMER_WHEEL_TICK_US * 1000;
+  }
+
+  if (timerfd_settime (timer_desc.timer_fd, 0, &its, NULL) < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to %s timer fd: (%s:%d)\n", arm ? "arm" : "disarm", strerror (errno), errno);
+    return;
+  }
+
+  timer_desc.timer_fd_armed = arm;
+}
+
+/*
+ * Put an element in the wheel slot matching its expiry tick.
+ * Must be called with timer_list_mutex locked.
+ */
+static void
+timer_wheel_insert (
+  uint32_t elm_index)
+{
+  struct timer_elm_s                     *timer_p = &timer_desc.elms[elm_index];
+  uint64_t                                expires = timer_p->expires;
+  uint64_t                                delta;
+  uint32_t                                slot;
+  int                                     level;
+
+  if (expires < timer_desc.current_tick) {
+    /*
+     * Already expired, process it with the next tick
+     */
+    expires = timer_desc.current_tick;
+  }
+
+  delta = expires - timer_desc.current_tick;
+
+  if (delta > TIMER_WHEEL_MAX_TICKS) {
+    delta = TIMER_WHEEL_MAX_TICKS;
+    expires = timer_desc.current_tick + delta;
+    timer_p->expires = expires;
+  }
+
+  if (delta < TIMER_WHEEL_ROOT_SLOTS) {
+    slot = expires & (TIMER_WHEEL_ROOT_SLOTS - 1);
+  } else {
+    for (level = 1; level < TIMER_WHEEL_LEVELS - 1; level++) {
+      if (delta < (1ULL << (TIMER_WHEEL_ROOT_BITS + (level * TIMER_WHEEL_LEVEL_BITS)))) {
+        break;
+      }
+    }
+
+    slot = TIMER_WHEEL_ROOT_SLOTS + ((level - 1) * TIMER_WHEEL_LEVEL_SLOTS) +
+      ((expires >> (TIMER_WHEEL_ROOT_BITS + ((level - 1) * TIMER_WHEEL_LEVEL_BITS))) & (TIMER_WHEEL_LEVEL_SLOTS - 1));
+  }
+
+  timer_p->slot = slot;
+  timer_p->previous = TIMER_ELM_NONE;
+  timer_p->next = timer_desc.slots[slot];
+
+  if (timer_p->next != TIMER_ELM_NONE) {
+    timer_desc.elms[timer_p->next].previous = elm_index;
+  }
+
+  timer_desc.slots[slot] = elm_index;
+}
+
+/*
+ * Unlink an element from its wheel slot.
+ * Must be called with timer_list_mutex locked.
+ */
+static void
+timer_wheel_unlink (
+  uint32_t elm_index)
+{
+  struct timer_elm_s                     *timer_p = &timer_desc.elms[elm_index];
+
+  if (timer_p->previous != TIMER_ELM_NONE) {
+    timer_desc.elms[timer_p->previous].next = timer_p->next;
+  } else {
+    timer_desc.slots[timer_p->slot] = timer_p->next;
+  }
+
+  if (timer_p->next != TIMER_ELM_NONE) {
+    timer_desc.elms[timer_p->next].previous = timer_p->previous;
+  }
+
+  timer_p->slot = TIMER_SLOT_NONE;
+}
+
+/*
+ * Give back an element to the free list, its id becomes stale.
+ * Must be called with timer_list_mutex locked.
+ */
+static void
+timer_elm_release (
+  uint32_t elm_index)
+{
+  struct timer_elm_s                     *timer_p = &timer_desc.elms[elm_index];
+
+  timer_p->generation = (timer_p->generation + 1) & 0x7fffffff;
+  timer_p->timer_arg = NULL;
+  timer_p->next = timer_desc.free_elm;
+  timer_desc.free_elm = elm_index;
+  timer_desc.armed_timers--;
+}
+
+/*
+ * Re-insert the timers of an upper level slot, returns the index of the slot
+ * in its level so that the caller can continue cascading when it is 0.
+ * Must be called with timer_list_mutex locked.
+ */
+static uint32_t
+timer_wheel_cascade (
+  int level)
+{
+  uint32_t                                index;
+  uint32_t                                slot;
+  uint32_t                                elm_index;
+  uint32_t                                next;
+
+  index = (timer_desc.current_tick >> (TIMER_WHEEL_ROOT_BITS + ((level - 1) * TIMER_WHEEL_LEVEL_BITS))) & (TIMER_WHEEL_LEVEL_SLOTS - 1);
+  slot = TIMER_WHEEL_ROOT_SLOTS + ((level - 1) * TIMER_WHEEL_LEVEL_SLOTS) + index;
+  elm_index = timer_desc.slots[slot];
+  timer_desc.slots[slot] = TIMER_ELM_NONE;
+
+  while (elm_index != TIMER_ELM_NONE) {
+    next = timer_desc.elms[elm_index].next;
+    timer_wheel_insert (elm_index);
+    elm_index = next;
+  }
+
+  return index;
+}
+
+/*
+ * Send TIMER_HAS_EXPIRED to the task which started the timer, -1 if the
+ * message can not be allocated or queued.
+ */
+static int
+timer_send_expiry (
+  task_id_t task_id,
+  int32_t instance,
+  long timer_id,
+  void *timer_arg)
 {
-  struct timer_elm_s                     *timer_p;
   MessageDef                             *message_p;
-  timer_has_expired_t                    *timer_expired_p;
-  task_id_t                               task_id;
-  int32_t                                 instance;
 
-  /*
-   * Get back pointer to timer list element
-   */
-  timer_p = (struct timer_elm_s *)info->si_ptr;
-  // LG: To many traces for msc timer:
-  // TMR_DEBUG("Timer with id 0x%lx has expired", (long)timer_p->timer);
-  task_id = timer_p->task_id;
-  instance = timer_p->instance;
-  message_p = itti_alloc_new_message (TASK_TIMER, TIMER_HAS_EXPIRED);
-  timer_expired_p = &message_p->ittiMsg.timer_has_expired;
-  timer_expired_p->timer_id = (long)timer_p->timer;
-  timer_expired_p->arg = timer_p->timer_arg;
+  message_p = itti_try_alloc_new_message (TASK_TIMER, TIMER_HAS_EXPIRED);
 
-  /*
-   * Timer is a one shot timer, remove it
-   */
-  if (timer_p->type == TIMER_ONE_SHOT) {
-    //         if (timer_delete(timer_p->timer) < 0) {
-    //             TMR_DEBUG("Failed to delete timer 0x%lx", (long)timer_p->timer);
-    //         }
-    //         TMR_DEBUG("Removed timer 0x%lx", (long)timer_p->timer);
-    //         pthread_mutex_lock(&timer_desc.timer_list_mutex);
-    //         STAILQ_REMOVE(&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
-    //         pthread_mutex_unlock(&timer_desc.timer_list_mutex);
-    //         free_wrapper(timer_p);
-    //         timer_p = NULL;
-    // timer_arg saved in TIMER_HAS_EXPIRED msg
-    if (timer_remove ((long)timer_p->timer, NULL) != 0) {
-      OAILOG_DEBUG (LOG_ITTI, "Failed to delete timer 0x%lx\n", (long)timer_p->timer);
+  if (message_p) {
+    message_p->ittiMsg.timer_has_expired.timer_id = timer_id;
+    message_p->ittiMsg.timer_has_expired.arg = timer_arg;
+  }
+  // releases the message when it is not queued
+  return itti_send_msg_to_task (task_id, instance, message_p);
+}
+
+/*
+ * Keep an expiry that could not be sent, it is sent again with the next tick.
+ * Only called by the timer thread.
+ */
+static void
+timer_defer_expiry (
+  task_id_t task_id,
+  int32_t instance,
+  long timer_id,
+  void *timer_arg)
+{
+  if (timer_desc.nb_pending_expiries == timer_desc.pending_expiries_size) {
+    uint32_t                                pending_expiries_size = timer_desc.pending_expiries_size ? timer_desc.pending_expiries_size * 2 : TIMER_EXPIRY_INITIAL_NUMBER;
+    timer_expiry_t                         *pending_expiries = realloc (timer_desc.pending_expiries, pending_expiries_size * sizeof (timer_expiry_t));
+
+    if (pending_expiries == NULL) {
+      OAILOG_ERROR (LOG_ITTI, "Failed to keep expiry of timer 0x%lx for task %u, expiry lost\n", timer_id, task_id);
+      return;
     }
+
+    timer_desc.pending_expiries = pending_expiries;
+    timer_desc.pending_expiries_size = pending_expiries_size;
+  }
+
+  if (timer_desc.nb_pending_expiries == 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to send TIMER_HAS_EXPIRED for timer 0x%lx to task %u, expiries are sent again with the next tick\n", timer_id, task_id);
+  }
+
+  timer_desc.pending_expiries[timer_desc.nb_pending_expiries].task_id = task_id;
+  timer_desc.pending_expiries[timer_desc.nb_pending_expiries].instance = instance;
+  timer_desc.pending_expiries[timer_desc.nb_pending_expiries].timer_id = timer_id;
+  timer_desc.pending_expiries[timer_desc.nb_pending_expiries].timer_arg = timer_arg;
+  timer_desc.nb_pending_expiries++;
+}
+
+static void
+timer_expire (
+  uint32_t elm_index)
+{
+  struct timer_elm_s                     *timer_p = &timer_desc.elms[elm_index];
+  task_id_t                               task_id = timer_p->task_id;
+  int32_t                                 instance = timer_p->instance;
+  long                                    timer_id = TIMER_ID (elm_index, timer_p->generation);
+  void                                   *timer_arg = timer_p->timer_arg;
+
+  if (timer_p->expires < timer_p->deadline) {
+    /*
+     * Delay was longer than the wheel, wait for the remaining part
+     */
+    timer_p->expires = timer_p->deadline;
+    timer_wheel_insert (elm_index);
+    return;
+  }
+
+  if (timer_p->type == TIMER_PERIODIC) {
+    timer_p->deadline += timer_p->interval;
+    timer_p->expires = timer_p->deadline;
+    timer_wheel_insert (elm_index);
+  } else {
+    /*
+     * Timer is a one shot timer, remove it, timer_arg is given back in TIMER_HAS_EXPIRED msg
+     */
+    timer_elm_release (elm_index);
   }
 
   /*
-   * Notify task of timer expiry
+   * Notify task of timer expiry, without holding the timer lock
    */
-  if (itti_send_msg_to_task (task_id, instance, message_p) < 0) {
-    OAILOG_DEBUG (LOG_ITTI, "Failed to send msg TIMER_HAS_EXPIRED to task %u\n", task_id);
-    itti_free (TASK_TIMER, message_p);
-    return -1;
+  pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+
+  if (timer_send_expiry (task_id, instance, timer_id, timer_arg) < 0) {
+    timer_defer_expiry (task_id, instance, timer_id, timer_arg);
   }
 
-  return 0;
+  pthread_mutex_lock (&timer_desc.timer_list_mutex);
+}
+
+/*
+ * Send again the expiries that could not be delivered, in their expiry order.
+ * Must be called with timer_list_mutex locked.
+ */
+static void
+timer_send_pending_expiries (
+  void)
+{
+  uint32_t                                nb_pending_expiries = 0;
+  uint32_t                                i;
+
+  if (timer_desc.nb_pending_expiries == 0) {
+    return;
+  }
+
+  pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+
+  for (i = 0; i < timer_desc.nb_pending_expiries; i++) {
+    timer_expiry_t                         *expiry_p = &timer_desc.pending_expiries[i];
+
+    if (timer_send_expiry (expiry_p->task_id, expiry_p->instance, expiry_p->timer_id, expiry_p->timer_arg) < 0) {
+      timer_desc.pending_expiries[nb_pending_expiries++] = *expiry_p;
+    }
+  }
+
+  timer_desc.nb_pending_expiries = nb_pending_expiries;
+  pthread_mutex_lock (&timer_desc.timer_list_mutex);
+}
+
+/*
+ * Process all ticks up to now.
+ * Must be called with timer_list_mutex locked.
+ */
+static void
+timer_wheel_run (
+  uint64_t now)
+{
+  uint32_t                                index;
+  uint32_t                                elm_index;
+  int                                     level;
+
+  // the expiries of the previous ticks first
+  timer_send_pending_expiries ();
+
+  while (timer_desc.current_tick <= now) {
+    index = timer_desc.current_tick & (TIMER_WHEEL_ROOT_SLOTS - 1);
+
+    if (index == 0) {
+      for (level = 1; level < TIMER_WHEEL_LEVELS; level++) {
+        if (timer_wheel_cascade (level) != 0) {
+          break;
+        }
+      }
+    }
+
+    /*
+     * Expired timers are unlinked one by one since the slot may change while
+     * the lock is released to send the expiry message
+     */
+    while ((elm_index = timer_desc.slots[index]) != TIMER_ELM_NONE) {
+      timer_wheel_unlink (elm_index);
+      timer_expire (elm_index);
+    }
+
+    timer_desc.current_tick++;
+  }
+}
+
+static void                            *
+timer_thread (
+  __attribute__ ((unused)) void *args_p)
+{
+  uint64_t                                expirations;
+  ssize_t                                 read_ret;
+
+  while (1) {
+    read_ret = read (timer_desc.timer_fd, &expirations, sizeof (expirations));
+
+    if (read_ret != sizeof (expirations)) {
+      if ((read_ret < 0) && (errno == EINTR)) {
+        continue;
+      }
+
+      OAILOG_ERROR (LOG_ITTI, "Failed to read timer fd: (%s:%d)\n", strerror (errno), errno);
+      break;
+    }
+
+    pthread_mutex_lock (&timer_desc.timer_list_mutex);
+    timer_wheel_run (timer_get_tick ());
+
+    if ((timer_desc.armed_timers == 0) && (timer_desc.nb_pending_expiries == 0)) {
+      timer_arm_fd (false);
+    }
+
+    pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+  }
+
+  return NULL;
 }
 
 int
@@ -143,10 +494,10 @@ timer_setup (
   void *timer_arg,
   long *timer_id)
 {
-  struct sigevent                         se;
-  struct itimerspec                       its;
   struct timer_elm_s                     *timer_p;
-  timer_t                                 timer;
+  uint32_t                                elm_index;
+  uint64_t                                interval;
+  uint64_t                                now;
 
   if (timer_id == NULL) {
     return -1;
@@ -154,86 +505,90 @@ timer_setup (
 
   AssertFatal (type < TIMER_TYPE_MAX, "Invalid timer type (%d/%d)!\n", type, TIMER_TYPE_MAX);
   /*
-   * Allocate new timer list element
+   * Interval in ticks, rounded up
    */
-  timer_p = malloc (sizeof (struct timer_elm_s));
+  interval = (((uint64_t) interval_sec * 1000000) + interval_us + TIMER_WHEEL_TICK_US - 1) / TIMER_WHEEL_TICK_US;
 
-  if (timer_p == NULL) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to create new timer element\n");
-    return -1;
+  if (interval == 0) {
+    interval = 1;
   }
 
-  memset (&timer, 0, sizeof (timer_t));
-  memset (&se, 0, sizeof (struct sigevent));
-  timer_p->task_id = task_id;
-  timer_p->instance = instance;
-  timer_p->type = type;
-  timer_p->timer_arg = timer_arg;
-  /*
-   * Setting up alarm
-   */
-  /*
-   * Set and enable alarm
-   */
-  se.sigev_notify = SIGEV_SIGNAL;
-  se.sigev_signo = SIGTIMER;
-  se.sigev_value.sival_ptr = timer_p;
+  now = timer_get_tick ();
+  pthread_mutex_lock (&timer_desc.timer_list_mutex);
 
-  /*
-   * At the timer creation, the timer structure will be filled in with timer_id,
-   * * * which is unique for this process. This id is allocated by kernel and the
-   * * * value might be used to distinguish timers.
-   */
-  if (timer_create (CLOCK_REALTIME, &se, &timer) < 0) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to create timer: (%s:%d)\n", strerror (errno), errno);
-    free_wrapper ((void**)&timer_p);
-    return -1;
+  if (timer_desc.free_elm == TIMER_ELM_NONE) {
+    /*
+     * Grow the element array, elements are linked by index so they can move
+     */
+    uint32_t                                elms_number = timer_desc.elms_number * 2;
+    struct timer_elm_s                     *elms = realloc (timer_desc.elms, elms_number * sizeof (struct timer_elm_s));
+
+    if (elms == NULL) {
+      pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+      OAILOG_ERROR (LOG_ITTI, "Failed to create new timer element\n");
+      return -1;
+    }
+
+    memset (&elms[timer_desc.elms_number], 0, (elms_number - timer_desc.elms_number) * sizeof (struct timer_elm_s));
+
+    for (elm_index = timer_desc.elms_number; elm_index < elms_number; elm_index++) {
+      elms[elm_index].slot = TIMER_SLOT_NONE;
+      elms[elm_index].next = (elm_index + 1 < elms_number) ? elm_index + 1 : TIMER_ELM_NONE;
+    }
+
+    timer_desc.elms = elms;
+    timer_desc.free_elm = timer_desc.elms_number;
+    timer_desc.elms_number = elms_number;
   }
 
-  /*
-   * Fill in the first expiration value.
-   */
-  its.it_value.tv_sec = interval_sec;
-  its.it_value.tv_nsec = interval_us * 1000;
+  elm_index = timer_desc.free_elm;
+  timer_p = &timer_desc.elms[elm_index];
+  timer_desc.free_elm = timer_p->next;
 
-  if (type == TIMER_PERIODIC) {
+  if (timer_desc.armed_timers++ == 0) {
     /*
-     * Asked for periodic timer. We set the interval time
+     * Wheel was idle, no need to replay the ticks elapsed since
      */
-    its.it_interval.tv_sec = interval_sec;
-    its.it_interval.tv_nsec = interval_us * 1000;
-  } else {
-    /*
-     * Asked for one-shot timer. Do not set the interval field
-     */
-    its.it_interval.tv_sec = 0;
-    its.it_interval.tv_nsec = 0;
+    if (timer_desc.current_tick < now) {
+      timer_desc.current_tick = now;
+    }
+
+    timer_arm_fd (true);
   }
 
-  timer_settime (timer, 0, &its, NULL);
+  timer_p->task_id = task_id;
+  timer_p->instance = instance;
+  timer_p->type = type;
+  timer_p->timer_arg = timer_arg;
+  timer_p->interval = interval;
+  timer_p->deadline = now + interval;
+  timer_p->expires = timer_p->deadline;
+  timer_wheel_insert (elm_index);
   /*
    * Simply set the timer_id argument. so it can be used by caller
    */
-  *timer_id = (long)timer;
-  OAILOG_DEBUG (LOG_ITTI, "Requesting new %s timer with id 0x%lx that expires within " "%d sec and %d usec\n", type == TIMER_PERIODIC ? "periodic" : "single shot", *timer_id, interval_sec, interval_us);
-  timer_p->timer = timer;
-  /*
-   * Lock the queue and insert the timer at the tail
-   */
-  pthread_mutex_lock (&timer_desc.timer_list_mutex);
-  STAILQ_INSERT_TAIL (&timer_desc.timer_queue, timer_p, entries);
+  *timer_id = TIMER_ID (elm_index, timer_p->generation);
   pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+  OAILOG_DEBUG (LOG_ITTI, "Requesting new %s timer with id 0x%lx that expires within " "%d sec and %d usec\n", type == TIMER_PERIODIC ? "periodic" : "single shot", *timer_id, interval_sec, interval_us);
   return 0;
 }
 
 int timer_remove (long timer_id, void ** arg)
 {
-  int                                     rc = 0;
-  struct timer_elm_s                     *timer_p;
+  struct timer_elm_s                     *timer_p = NULL;
+  uint32_t                                elm_index;
 
   OAILOG_DEBUG (LOG_ITTI, "Removing timer 0x%lx\n", timer_id);
+  elm_index = (uint32_t) (((unsigned long)timer_id & TIMER_ID_INDEX_MASK) - 1);
   pthread_mutex_lock (&timer_desc.timer_list_mutex);
-  TIMER_SEARCH (timer_p, timer, ((timer_t) timer_id), &timer_desc.timer_queue);
+
+  if ((timer_id > 0) && (elm_index < timer_desc.elms_number)) {
+    timer_p = &timer_desc.elms[elm_index];
+
+    if ((timer_p->slot == TIMER_SLOT_NONE) || (TIMER_ID (elm_index, timer_p->generation) != timer_id)) {
+      timer_p = NULL;
+    }
+  }
 
   /*
    * We didn't find the timer in list
@@ -245,29 +600,56 @@ int timer_remove (long timer_id, void ** arg)
     return -1;
   }
 
-  STAILQ_REMOVE (&timer_desc.timer_queue, timer_p, timer_elm_s, entries);
-  pthread_mutex_unlock (&timer_desc.timer_list_mutex);
-
   // let user of API get back arg that can be an allocated memory (memory leak).
-
   if (arg) *arg = timer_p->timer_arg;
-  if (timer_delete (timer_p->timer) < 0) {
-    OAILOG_ERROR (LOG_ITTI, "Failed to delete timer 0x%lx\n", (long)timer_p->timer);
-    rc = -1;
-  }
 
-  free_wrapper ((void**)&timer_p);
-  return rc;
+  timer_wheel_unlink (elm_index);
+  timer_elm_release (elm_index);
+  pthread_mutex_unlock (&timer_desc.timer_list_mutex);
+  return 0;
 }
 
 int
 timer_init (
   void)
 {
+  uint32_t                                elm_index;
+
   OAILOG_DEBUG (LOG_ITTI, "Initializing TIMER task interface\n");
   memset (&timer_desc, 0, sizeof (timer_desc_t));
-  STAILQ_INIT (&timer_desc.timer_queue);
   pthread_mutex_init (&timer_desc.timer_list_mutex, NULL);
+  clock_gettime (CLOCK_MONOTONIC, &timer_desc.start_time);
+
+  for (elm_index = 0; elm_index < TIMER_WHEEL_SLOTS; elm_index++) {
+    timer_desc.slots[elm_index] = TIMER_ELM_NONE;
+  }
+
+  timer_desc.elms_number = TIMER_ELM_INITIAL_NUMBER;
+  timer_desc.elms = calloc (timer_desc.elms_number, sizeof (struct timer_elm_s));
+
+  if (timer_desc.elms == NULL) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to allocate timer elements\n");
+    return -1;
+  }
+
+  for (elm_index = 0; elm_index < timer_desc.elms_number; elm_index++) {
+    timer_desc.elms[elm_index].slot = TIMER_SLOT_NONE;
+    timer_desc.elms[elm_index].next = (elm_index + 1 < timer_desc.elms_number) ? elm_index + 1 : TIMER_ELM_NONE;
+  }
+
+  timer_desc.free_elm = 0;
+  timer_desc.timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+  if (timer_desc.timer_fd < 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to create timer fd: (%s:%d)\n", strerror (errno), errno);
+    return -1;
+  }
+
+  if (pthread_create (&timer_desc.thread, NULL, timer_thread, NULL) != 0) {
+    OAILOG_ERROR (LOG_ITTI, "Failed to create timer thread\n");
+    return -1;
+  }
+
   OAILOG_DEBUG (LOG_ITTI, "Initializing TIMER task interface: DONE\n");
   return 0;
 }
@@ -30,18 +30,12 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
-#include <signal.h>
-
-#define SIGTIMER SIGRTMIN
-
 typedef enum timer_type_s {
   TIMER_PERIODIC,
   TIMER_ONE_SHOT,
   TIMER_TYPE_MAX,
 } timer_type_t;
 
-int timer_handle_signal(siginfo_t *info);
-
 /** \brief Request a new timer
  *  \param interval_sec timer interval in seconds
  *  \param interval_us  timer interval in micro seconds
@@ -68,7 +62,7 @@ int timer_setup(
 int timer_remove (long timer_id, void ** arg);
 #define timer_stop timer_remove
 
-/** \brief Initialize timer task and its API
+/** \brief Initialize timer task and its API, timers expire in a dedicated thread
  *  \param mme_config MME common configuration
  *  @returns -1 on failure, 0 otherwise
  **/
@@ -28,4 +28,5 @@
  */
 
 
+// May overtake the signalling which stops the timer: the receivers check the timer id of an expiry
 MESSAGE_DEF(TIMER_HAS_EXPIRED, MESSAGE_PRIORITY_MED_PLUS, timer_has_expired_t, timer_has_expired)
@@ -63,6 +63,7 @@ typedef struct sctp_data_req_s {
   sctp_assoc_id_t  assoc_id;
   sctp_stream_id_t stream;
   uint32_t         mme_ue_s1ap_id; // for helping data_rej
+  uint64_t         req_time_ns;    ///< CLOCK_MONOTONIC time the request was queued, 0 if not set, for the send latency
 } sctp_data_req_t;
 
 typedef struct sctp_data_ind_s {
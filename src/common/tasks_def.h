@@ -37,12 +37,30 @@ TASK_DEF(TASK_GTPV1_U,  TASK_PRIORITY_MED, 256)
 TASK_DEF(TASK_FW_IP,    TASK_PRIORITY_MED, 256)
 /// MME Applicative task
 TASK_DEF(TASK_MME_APP,  TASK_PRIORITY_MED, 256)
+/// MME Applicative worker tasks, TASK_MME_APP dispatches each UE to one of them
+TASK_DEF(TASK_MME_APP_WORKER_0, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_MME_APP_WORKER_1, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_MME_APP_WORKER_2, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_MME_APP_WORKER_3, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_MME_APP_WORKER_4, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_MME_APP_WORKER_5, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_MME_APP_WORKER_6, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_MME_APP_WORKER_7, TASK_PRIORITY_MED, 256)
 /// NAS task
 TASK_DEF(TASK_NAS_MME,  TASK_PRIORITY_MED, 256)
 /// S11 task
 TASK_DEF(TASK_S11,      TASK_PRIORITY_MED, 256)
 /// S1AP task
 TASK_DEF(TASK_S1AP,     TASK_PRIORITY_MED, 256)
+/// S1AP worker tasks, TASK_S1AP dispatches each eNB association to one of them
+TASK_DEF(TASK_S1AP_WORKER_0, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_S1AP_WORKER_1, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_S1AP_WORKER_2, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_S1AP_WORKER_3, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_S1AP_WORKER_4, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_S1AP_WORKER_5, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_S1AP_WORKER_6, TASK_PRIORITY_MED, 256)
+TASK_DEF(TASK_S1AP_WORKER_7, TASK_PRIORITY_MED, 256)
 /// S6a task
 TASK_DEF(TASK_S6A,      TASK_PRIORITY_MED, 256)
 /// SCTP task
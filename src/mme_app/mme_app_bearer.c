@@ -61,7 +61,6 @@
 
 
 //----------------------------------------------------------------------------
-static bool mme_app_construct_guti(const plmn_t * const plmn_p, const s_tmsi_t * const s_tmsi_p,  guti_t * const guti_p);
 static void notify_s1ap_new_ue_mme_s1ap_id_association (struct ue_mm_context_s *ue_context_p);
 
 
@@ -197,9 +196,10 @@ mme_app_handle_conn_est_cnf (
   /* Start timer to wait for Initial UE Context Response from eNB
    * If timer expires treat this as failure of ongoing procedure and abort corresponding NAS procedure such as ATTACH
    * or SERVICE REQUEST. Send UE context release command to eNB
+   * The UE id is passed by value, the expiry is routed while the UE context may be released
    */
   if (timer_setup (ue_context_p->initial_context_setup_rsp_timer.sec, 0, 
-                TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *) &(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->initial_context_setup_rsp_timer.id)) < 0) { 
+                TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id, &(ue_context_p->initial_context_setup_rsp_timer.id)) < 0) { 
     OAILOG_ERROR (LOG_MME_APP, "Failed to start initial context setup response timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
     ue_context_p->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
   } else {
@@ -255,7 +255,7 @@ mme_app_handle_initial_ue_message (
              */
 
             OAILOG_ERROR (LOG_MME_APP, "MME_APP_INITAIL_UE_MESSAGE.ERROR***** enb_s1ap_id_key %ld has valid value.\n" ,ue_context_p->enb_s1ap_id_key);
-            hashtable_uint64_ts_remove (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key);
+            hashtable_oa_ts_free (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key);
             ue_context_p->enb_s1ap_id_key = INVALID_ENB_UE_S1AP_ID_KEY;
           }
           // Update MME UE context with new enb_ue_s1ap_id
@@ -416,7 +416,7 @@ mme_app_handle_delete_session_rsp (
     OAILOG_WARNING (LOG_MME_APP, "We didn't find this teid in list of UE: %08x\n", delete_sess_resp_pP->teid);
     OAILOG_FUNC_OUT (LOG_MME_APP);
   }
-  hashtable_uint64_ts_remove(mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl,
+  hashtable_oa_ts_free(mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl,
                       (const hash_key_t) ue_context_p->mme_teid_s11);
   ue_context_p->mme_teid_s11 = 0;
 
@@ -941,7 +941,7 @@ mme_app_handle_mobile_reachability_timer_expiry (struct ue_mm_context_s *ue_cont
   OAILOG_INFO (LOG_MME_APP, "Expired- Mobile Reachability Timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
   // Start Implicit Detach timer 
   if (timer_setup (ue_context_p->implicit_detach_timer.sec, 0, 
-                TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->implicit_detach_timer.id)) < 0) { 
+                TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id, &(ue_context_p->implicit_detach_timer.id)) < 0) { 
     OAILOG_ERROR (LOG_MME_APP, "Failed to start Implicit Detach timer for UE id  %d \n", ue_context_p->mme_ue_s1ap_id);
     ue_context_p->implicit_detach_timer.id = MME_APP_TIMER_INACTIVE_ID;
   } else {
@@ -1045,7 +1045,7 @@ mme_app_handle_initial_context_setup_failure (
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
 //------------------------------------------------------------------------------
-static bool mme_app_construct_guti(const plmn_t * const plmn_p, const s_tmsi_t * const s_tmsi_p,  guti_t * const guti_p)
+bool mme_app_construct_guti(const plmn_t * const plmn_p, const s_tmsi_t * const s_tmsi_p,  guti_t * const guti_p)
 {
   /*
    * This is a helper function to construct GUTI from S-TMSI. It uses PLMN id and MME Group Id of the serving MME for
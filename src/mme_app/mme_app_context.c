@@ -40,6 +40,7 @@
 
 #include "gcc_diag.h"
 #include "dynamic_memory_check.h"
+#include "epoch.h"
 #include "assertions.h"
 #include "log.h"
 #include "msc.h"
@@ -106,12 +107,25 @@ int unlock_ue_contexts(ue_mm_context_t * const ue_mm_context) {
   }
   return rc;
 }
+//------------------------------------------------------------------------------
+// epoch_defer_free() callback, UE contexts are allocated from the UE context slab
+static void mme_app_ue_context_release (void **ue_context_pp)
+{
+  pthread_mutex_destroy (&((ue_mm_context_t *)*ue_context_pp)->recmutex);
+  slab_free (mme_app_desc.mme_ue_contexts.ue_context_slab, *ue_context_pp);
+  *ue_context_pp = NULL;
+}
+
 //------------------------------------------------------------------------------
 // warning: lock the UE context
 ue_mm_context_t *mme_create_new_ue_context (void)
 {
-  ue_mm_context_t                           *new_p = calloc (1, sizeof (ue_mm_context_t));
+  ue_mm_context_t                           *new_p = slab_alloc (mme_app_desc.mme_ue_contexts.ue_context_slab);
   pthread_mutexattr_t mutexattr = {0};
+  if (!new_p) {
+    OAILOG_ERROR (LOG_MME_APP, "Cannot create UE context, out of memory\n");
+    return NULL;
+  }
   int rc = pthread_mutexattr_init(&mutexattr);
   if (rc) {
     OAILOG_ERROR (LOG_MME_APP, "Cannot create UE context, failed to init mutex attribute: %s\n", strerror(rc));
@@ -211,20 +225,265 @@ void mme_app_ue_context_free_content (ue_mm_context_t * const ue_context_p)
 }
 
 //------------------------------------------------------------------------------
-ue_mm_context_t                           *
-mme_ue_context_exists_enb_ue_s1ap_id (
+/*
+   Key of the GUTI collection: M-TMSI, MME code and MME group id are kept as is
+   (unique among the GUTIs allocated by this MME), the PLMN is folded on 8 bits.
+   GUTIs of other PLMNs may share a key, they are then indexed by the full GUTI
+   in the collision collection.
+*/
+static inline hash_key_t mme_app_guti_key (const guti_t * const guti_p)
+{
+  const plmn_t                           *plmn = &guti_p->gummei.plmn;
+  uint32_t                                plmn24 = (plmn->mcc_digit1 << 20) | (plmn->mcc_digit2 << 16) | (plmn->mcc_digit3 << 12) |
+                                                   (plmn->mnc_digit1 << 8)  | (plmn->mnc_digit2 << 4)  | plmn->mnc_digit3;
+  uint8_t                                 plmn8 = (uint8_t)(plmn24 ^ (plmn24 >> 8) ^ (plmn24 >> 16));
+
+  return ((hash_key_t)plmn8 << 56) | ((hash_key_t)guti_p->gummei.mme_gid << 40) |
+         ((hash_key_t)guti_p->gummei.mme_code << 32) | (hash_key_t)guti_p->m_tmsi;
+}
+
+//------------------------------------------------------------------------------
+static inline bool mme_app_guti_is_equal (const guti_t * const guti1_p, const guti_t * const guti2_p)
+{
+  return ((guti1_p->m_tmsi == guti2_p->m_tmsi)
+      && (guti1_p->gummei.mme_code == guti2_p->gummei.mme_code)
+      && (guti1_p->gummei.mme_gid == guti2_p->gummei.mme_gid)
+      && (guti1_p->gummei.plmn.mcc_digit1 == guti2_p->gummei.plmn.mcc_digit1)
+      && (guti1_p->gummei.plmn.mcc_digit2 == guti2_p->gummei.plmn.mcc_digit2)
+      && (guti1_p->gummei.plmn.mcc_digit3 == guti2_p->gummei.plmn.mcc_digit3)
+      && (guti1_p->gummei.plmn.mnc_digit1 == guti2_p->gummei.plmn.mnc_digit1)
+      && (guti1_p->gummei.plmn.mnc_digit2 == guti2_p->gummei.plmn.mnc_digit2)
+      && (guti1_p->gummei.plmn.mnc_digit3 == guti2_p->gummei.plmn.mnc_digit3));
+}
+
+//------------------------------------------------------------------------------
+/*
+   Resolve a key of one of the UE collections to the locked UE context.
+   Lookups do not lock the collections. The UE context found may be removed
+   concurrently: its memory stays valid until the end of the epoch read
+   section, and once its mutex is acquired a removed context is not returned.
+*/
+static ue_mm_context_t *mme_app_ue_index_get (
+  hash_table_oa_ts_t * const htbl,
+  const hash_key_t key)
+{
+  ue_mm_context_t                        *ue_context_p = NULL;
+
+  epoch_read_lock ();
+  hashtable_oa_ts_get (htbl, key, (void **)&ue_context_p);
+  if (ue_context_p) {
+    lock_ue_contexts(ue_context_p);
+    if (ue_context_p->is_removed) {
+      unlock_ue_contexts(ue_context_p);
+      ue_context_p = NULL;
+    }
+  }
+  epoch_read_unlock ();
+  return ue_context_p;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Remove a key from a UE collection only if it still designates this UE.
+*/
+static hashtable_rc_t mme_app_ue_index_remove (
+  hash_table_oa_ts_t * const htbl,
+  const hash_key_t key,
+  const ue_mm_context_t * const ue_context_p)
+{
+  hashtable_rc_t                          h_rc = HASH_TABLE_OK;
+  void                                   *data = NULL;
+
+  h_rc = hashtable_oa_ts_get (htbl, key, &data);
+
+  if ((HASH_TABLE_OK == h_rc) && (data == ue_context_p)) {
+    h_rc = hashtable_oa_ts_remove (htbl, key, &data);
+  } else if (HASH_TABLE_OK == h_rc) {
+    h_rc = HASH_TABLE_KEY_NOT_EXISTS;
+  }
+  return h_rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Move the UE from old_key to new_key in a UE collection, invalid_key means
+   not indexed. The collection is not modified if the UE is already indexed
+   by new_key.
+*/
+static hashtable_rc_t mme_app_ue_index_rekey (
+  hash_table_oa_ts_t * const htbl,
+  const hash_key_t old_key,
+  const hash_key_t new_key,
+  const hash_key_t invalid_key,
+  ue_mm_context_t * const ue_context_p)
+{
+  void                                   *data = NULL;
+
+  if (old_key == new_key) {
+    if ((invalid_key == new_key) ||
+        ((HASH_TABLE_OK == hashtable_oa_ts_get (htbl, new_key, &data)) && (data == ue_context_p))) {
+      return HASH_TABLE_OK;
+    }
+  } else if (invalid_key != old_key) {
+    mme_app_ue_index_remove (htbl, old_key, ue_context_p);
+  }
+
+  if (invalid_key == new_key) {
+    return HASH_TABLE_OK;
+  }
+  return hashtable_oa_ts_insert (htbl, new_key, (void *)ue_context_p);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Key of the GUTI collision collection: the full GUTI, copied field by field
+   so that padding bytes do not take part in the comparison of the keys.
+*/
+static inline void mme_app_guti_collision_key (guti_t * const key_p, const guti_t * const guti_p)
+{
+  memset (key_p, 0, sizeof (*key_p));
+  key_p->gummei.plmn.mcc_digit1 = guti_p->gummei.plmn.mcc_digit1;
+  key_p->gummei.plmn.mcc_digit2 = guti_p->gummei.plmn.mcc_digit2;
+  key_p->gummei.plmn.mcc_digit3 = guti_p->gummei.plmn.mcc_digit3;
+  key_p->gummei.plmn.mnc_digit1 = guti_p->gummei.plmn.mnc_digit1;
+  key_p->gummei.plmn.mnc_digit2 = guti_p->gummei.plmn.mnc_digit2;
+  key_p->gummei.plmn.mnc_digit3 = guti_p->gummei.plmn.mnc_digit3;
+  key_p->gummei.mme_gid = guti_p->gummei.mme_gid;
+  key_p->gummei.mme_code = guti_p->gummei.mme_code;
+  key_p->m_tmsi = guti_p->m_tmsi;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Resolve a GUTI to its UE context, not locked. The UE found by the 64 bit key
+   must hold the GUTI, otherwise the GUTI may have been indexed in the collision
+   collection because its key was already taken by another UE.
+   Must be called in an epoch read section.
+*/
+static ue_mm_context_t *mme_app_guti_index_find (
+  const mme_ue_context_t * const mme_ue_context_p,
+  const guti_t * const guti_p)
+{
+  ue_mm_context_t                        *ue_context_p = NULL;
+  guti_t                                  key;
+
+  hashtable_oa_ts_get (mme_ue_context_p->guti_ue_context_htbl, mme_app_guti_key (guti_p), (void **)&ue_context_p);
+  if ((ue_context_p) && (mme_app_guti_is_equal (&ue_context_p->emm_context._guti, guti_p))) {
+    return ue_context_p;
+  }
+  ue_context_p = NULL;
+  if (__atomic_load_n (&mme_ue_context_p->nb_guti_collisions, __ATOMIC_ACQUIRE)) {
+    mme_app_guti_collision_key (&key, guti_p);
+    obj_hashtable_ts_get (mme_ue_context_p->guti_collision_ue_context_htbl, (const void *)&key, sizeof (key), (void **)&ue_context_p);
+  }
+  return ue_context_p;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Index the UE by its GUTI. If the 64 bit key of the GUTI designates another
+   UE holding another GUTI, the UE is indexed by the full GUTI in the collision
+   collection instead of replacing the other UE.
+   Must be called with guti_lock held.
+*/
+static hashtable_rc_t mme_app_guti_index_insert (
   mme_ue_context_t * const mme_ue_context_p,
-  const enb_s1ap_id_key_t enb_key)
+  const guti_t * const guti_p,
+  ue_mm_context_t * const ue_context_p)
 {
   hashtable_rc_t                          h_rc = HASH_TABLE_OK;
-  uint64_t                                mme_ue_s1ap_id64 = 0;
-  
-  hashtable_uint64_ts_get (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)enb_key, &mme_ue_s1ap_id64);
-  
+  ue_mm_context_t                        *other_p = NULL;
+  void                                   *data = NULL;
+  guti_t                                  key;
+  bool                                    collision = false;
+
+  epoch_read_lock ();
+  hashtable_oa_ts_get (mme_ue_context_p->guti_ue_context_htbl, mme_app_guti_key (guti_p), (void **)&other_p);
+  collision = (other_p) && (other_p != ue_context_p) && (!mme_app_guti_is_equal (&other_p->emm_context._guti, guti_p));
+  epoch_read_unlock ();
+
+  if (!collision) {
+    return hashtable_oa_ts_insert (mme_ue_context_p->guti_ue_context_htbl, mme_app_guti_key (guti_p), (void *)ue_context_p);
+  }
+
+  mme_app_guti_collision_key (&key, guti_p);
+  // the collection does not compare keys on insert
+  if (HASH_TABLE_OK == obj_hashtable_ts_remove (mme_ue_context_p->guti_collision_ue_context_htbl, (const void *)&key, sizeof (key), &data)) {
+    __atomic_sub_fetch (&mme_ue_context_p->nb_guti_collisions, 1, __ATOMIC_RELEASE);
+  }
+  h_rc = obj_hashtable_ts_insert (mme_ue_context_p->guti_collision_ue_context_htbl, (const void *)&key, sizeof (key), (void *)ue_context_p);
   if (HASH_TABLE_OK == h_rc) {
-    return mme_ue_context_exists_mme_ue_s1ap_id (mme_ue_context_p, (mme_ue_s1ap_id_t) mme_ue_s1ap_id64);
+    __atomic_add_fetch (&mme_ue_context_p->nb_guti_collisions, 1, __ATOMIC_RELEASE);
+    OAILOG_DEBUG (LOG_MME_APP, "GUTI " GUTI_FMT " shares its key with the GUTI of another UE\n", GUTI_ARG(guti_p));
+  }
+  return h_rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Remove a GUTI from the GUTI collections only if it still designates this UE.
+   Must be called with guti_lock held.
+*/
+static hashtable_rc_t mme_app_guti_index_remove (
+  mme_ue_context_t * const mme_ue_context_p,
+  const guti_t * const guti_p,
+  const ue_mm_context_t * const ue_context_p)
+{
+  hashtable_rc_t                          h_rc = HASH_TABLE_OK;
+  void                                   *data = NULL;
+  guti_t                                  key;
+
+  h_rc = mme_app_ue_index_remove (mme_ue_context_p->guti_ue_context_htbl, mme_app_guti_key (guti_p), ue_context_p);
+  if ((HASH_TABLE_OK != h_rc) && (__atomic_load_n (&mme_ue_context_p->nb_guti_collisions, __ATOMIC_RELAXED))) {
+    mme_app_guti_collision_key (&key, guti_p);
+    if ((HASH_TABLE_OK == obj_hashtable_ts_get (mme_ue_context_p->guti_collision_ue_context_htbl, (const void *)&key, sizeof (key), &data)) &&
+        (data == ue_context_p)) {
+      h_rc = obj_hashtable_ts_remove (mme_ue_context_p->guti_collision_ue_context_htbl, (const void *)&key, sizeof (key), &data);
+      if (HASH_TABLE_OK == h_rc) {
+        __atomic_sub_fetch (&mme_ue_context_p->nb_guti_collisions, 1, __ATOMIC_RELEASE);
+      }
+    }
   }
-  return NULL;
+  return h_rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Move the UE from old_guti_p to new_guti_p in the GUTI collections, an all
+   zero GUTI is not indexed.
+*/
+static hashtable_rc_t mme_app_guti_index_rekey (
+  mme_ue_context_t * const mme_ue_context_p,
+  const guti_t * const old_guti_p,
+  const guti_t * const new_guti_p,
+  ue_mm_context_t * const ue_context_p)
+{
+  hashtable_rc_t                          h_rc = HASH_TABLE_OK;
+  bool                                    indexed = false;
+
+  pthread_mutex_lock (&mme_ue_context_p->guti_lock);
+  if (mme_app_guti_is_equal (old_guti_p, new_guti_p)) {
+    epoch_read_lock ();
+    indexed = (mme_app_guti_index_find (mme_ue_context_p, new_guti_p) == ue_context_p);
+    epoch_read_unlock ();
+  } else if (mme_app_guti_key (old_guti_p)) {
+    mme_app_guti_index_remove (mme_ue_context_p, old_guti_p, ue_context_p);
+  }
+
+  if ((!indexed) && (mme_app_guti_key (new_guti_p))) {
+    h_rc = mme_app_guti_index_insert (mme_ue_context_p, new_guti_p, ue_context_p);
+  }
+  pthread_mutex_unlock (&mme_ue_context_p->guti_lock);
+  return h_rc;
+}
+
+//------------------------------------------------------------------------------
+ue_mm_context_t                           *
+mme_ue_context_exists_enb_ue_s1ap_id (
+  mme_ue_context_t * const mme_ue_context_p,
+  const enb_s1ap_id_key_t enb_key)
+{
+  return mme_app_ue_index_get (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)enb_key);
 }
 
 //------------------------------------------------------------------------------
@@ -235,9 +494,8 @@ mme_ue_context_exists_mme_ue_s1ap_id (
 {
   struct ue_mm_context_s                    *ue_context_p = NULL;
 
-  hashtable_ts_get (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)mme_ue_s1ap_id, (void **)&ue_context_p);
+  ue_context_p = mme_app_ue_index_get (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)mme_ue_s1ap_id);
   if (ue_context_p) {
-    lock_ue_contexts(ue_context_p);
     OAILOG_TRACE (LOG_MME_APP, "UE  " MME_UE_S1AP_ID_FMT " fetched MM state %s, ECM state %s\n ",mme_ue_s1ap_id,
         (ue_context_p->mm_state == UE_UNREGISTERED) ? "UE_UNREGISTERED":(ue_context_p->mm_state == UE_REGISTERED) ? "UE_REGISTERED":"UNKNOWN",
         (ue_context_p->ecm_state == ECM_IDLE) ? "ECM_IDLE":(ue_context_p->ecm_state == ECM_CONNECTED) ? "ECM_CONNECTED":"UNKNOWN");
@@ -251,16 +509,7 @@ mme_ue_context_exists_imsi (
   mme_ue_context_t * const mme_ue_context_p,
   const imsi64_t imsi)
 {
-  hashtable_rc_t                          h_rc = HASH_TABLE_OK;
-  uint64_t                                mme_ue_s1ap_id64 = 0;
-
-  h_rc = hashtable_uint64_ts_get (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)imsi, &mme_ue_s1ap_id64);
-
-  if (HASH_TABLE_OK == h_rc) {
-    return mme_ue_context_exists_mme_ue_s1ap_id (mme_ue_context_p, (mme_ue_s1ap_id_t)mme_ue_s1ap_id64);
-  }
-
-  return NULL;
+  return mme_app_ue_index_get (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)imsi);
 }
 
 //------------------------------------------------------------------------------
@@ -269,15 +518,7 @@ mme_ue_context_exists_s11_teid (
   mme_ue_context_t * const mme_ue_context_p,
   const s11_teid_t teid)
 {
-  hashtable_rc_t                          h_rc = HASH_TABLE_OK;
-  uint64_t                                mme_ue_s1ap_id64 = 0;
-
-  h_rc = hashtable_uint64_ts_get (mme_ue_context_p->tun11_ue_context_htbl, (const hash_key_t)teid, &mme_ue_s1ap_id64);
-
-  if (HASH_TABLE_OK == h_rc) {
-    return mme_ue_context_exists_mme_ue_s1ap_id (mme_ue_context_p, (mme_ue_s1ap_id_t)mme_ue_s1ap_id64);
-  }
-  return NULL;
+  return mme_app_ue_index_get (mme_ue_context_p->tun11_ue_context_htbl, (const hash_key_t)teid);
 }
 
 //------------------------------------------------------------------------------
@@ -286,16 +527,87 @@ mme_ue_context_exists_guti (
   mme_ue_context_t * const mme_ue_context_p,
   const guti_t * const guti_p)
 {
-  hashtable_rc_t                          h_rc = HASH_TABLE_OK;
-  uint64_t                                mme_ue_s1ap_id64 = 0;
+  ue_mm_context_t                        *ue_context_p = NULL;
 
-  h_rc = obj_hashtable_uint64_ts_get (mme_ue_context_p->guti_ue_context_htbl, (const void *)guti_p, sizeof (*guti_p), &mme_ue_s1ap_id64);
+  epoch_read_lock ();
+  ue_context_p = mme_app_guti_index_find (mme_ue_context_p, guti_p);
+  if (ue_context_p) {
+    lock_ue_contexts(ue_context_p);
+    // the GUTI may have been reallocated before the UE context was locked
+    if ((ue_context_p->is_removed) || (!mme_app_guti_is_equal (&ue_context_p->emm_context._guti, guti_p))) {
+      unlock_ue_contexts(ue_context_p);
+      ue_context_p = NULL;
+    }
+  }
+  epoch_read_unlock ();
+  return ue_context_p;
+}
 
-  if (HASH_TABLE_OK == h_rc) {
-    return mme_ue_context_exists_mme_ue_s1ap_id (mme_ue_context_p, (mme_ue_s1ap_id_t)mme_ue_s1ap_id64);
+//------------------------------------------------------------------------------
+/*
+   Resolve a key of one of the UE collections to the mme_ue_s1ap_id of the UE,
+   without taking the UE mutex: used to route messages, a context being
+   removed or rekeyed concurrently is handled by the task it is routed to.
+*/
+static mme_ue_s1ap_id_t mme_app_ue_index_get_mme_ue_s1ap_id (
+  hash_table_oa_ts_t * const htbl,
+  const hash_key_t key)
+{
+  ue_mm_context_t                        *ue_context_p = NULL;
+  mme_ue_s1ap_id_t                        mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+
+  epoch_read_lock ();
+  hashtable_oa_ts_get (htbl, key, (void **)&ue_context_p);
+  if ((ue_context_p) && (!ue_context_p->is_removed)) {
+    mme_ue_s1ap_id = ue_context_p->mme_ue_s1ap_id;
   }
+  epoch_read_unlock ();
+  return mme_ue_s1ap_id;
+}
+
+//------------------------------------------------------------------------------
+mme_ue_s1ap_id_t
+mme_ue_context_get_mme_ue_s1ap_id_imsi (
+  mme_ue_context_t * const mme_ue_context_p,
+  const imsi64_t imsi)
+{
+  return mme_app_ue_index_get_mme_ue_s1ap_id (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)imsi);
+}
+
+//------------------------------------------------------------------------------
+mme_ue_s1ap_id_t
+mme_ue_context_get_mme_ue_s1ap_id_s11_teid (
+  mme_ue_context_t * const mme_ue_context_p,
+  const s11_teid_t teid)
+{
+  return mme_app_ue_index_get_mme_ue_s1ap_id (mme_ue_context_p->tun11_ue_context_htbl, (const hash_key_t)teid);
+}
+
+//------------------------------------------------------------------------------
+mme_ue_s1ap_id_t
+mme_ue_context_get_mme_ue_s1ap_id_enb_ue_s1ap_id (
+  mme_ue_context_t * const mme_ue_context_p,
+  const enb_s1ap_id_key_t enb_key)
+{
+  return mme_app_ue_index_get_mme_ue_s1ap_id (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)enb_key);
+}
+
+//------------------------------------------------------------------------------
+mme_ue_s1ap_id_t
+mme_ue_context_get_mme_ue_s1ap_id_guti (
+  mme_ue_context_t * const mme_ue_context_p,
+  const guti_t * const guti_p)
+{
+  ue_mm_context_t                        *ue_context_p = NULL;
+  mme_ue_s1ap_id_t                        mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
 
-  return NULL;
+  epoch_read_lock ();
+  ue_context_p = mme_app_guti_index_find (mme_ue_context_p, guti_p);
+  if ((ue_context_p) && (!ue_context_p->is_removed)) {
+    mme_ue_s1ap_id = ue_context_p->mme_ue_s1ap_id;
+  }
+  epoch_read_unlock ();
+  return mme_ue_s1ap_id;
 }
 
 //------------------------------------------------------------------------------
@@ -338,7 +650,7 @@ mme_ue_context_notified_new_ue_s1ap_id_association (
     if (ue_context_p->enb_s1ap_id_key == enb_key) { // useless
       if (INVALID_MME_UE_S1AP_ID == ue_context_p->mme_ue_s1ap_id) {
         // new insertion of mme_ue_s1ap_id, not a change in the id
-        h_rc = hashtable_ts_insert (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)mme_ue_s1ap_id, (void *)ue_context_p);
+        h_rc = hashtable_oa_ts_insert (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)mme_ue_s1ap_id, (void *)ue_context_p);
         if (HASH_TABLE_OK == h_rc) {
           ue_context_p->mme_ue_s1ap_id = mme_ue_s1ap_id;
           OAILOG_DEBUG (LOG_MME_APP,
@@ -359,6 +671,10 @@ mme_ue_context_notified_new_ue_s1ap_id_association (
   OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
 }
 //------------------------------------------------------------------------------
+/*
+   In place rekey: only the collections whose key changed are modified, the
+   UE context itself stays where it is.
+*/
 void
 mme_ue_context_update_coll_keys (
   mme_ue_context_t * const mme_ue_context_p,
@@ -379,42 +695,32 @@ mme_ue_context_update_coll_keys (
   OAILOG_TRACE (LOG_MME_APP, "Update ue context %p updated_enb_ue_s1ap_id_key %ld updated_mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " updated_IMSI " IMSI_64_FMT " updated_GUTI " GUTI_FMT "\n",
             ue_context_p, enb_s1ap_id_key, mme_ue_s1ap_id, imsi, GUTI_ARG(guti_p));
 
-  if ((INVALID_ENB_UE_S1AP_ID_KEY != enb_s1ap_id_key) && (ue_context_p->enb_s1ap_id_key != enb_s1ap_id_key)) {
-      // new insertion of enb_ue_s1ap_id_key,
-      h_rc = hashtable_uint64_ts_remove (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key);
-      h_rc = hashtable_uint64_ts_insert (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)enb_s1ap_id_key, mme_ue_s1ap_id);
+  if (INVALID_ENB_UE_S1AP_ID_KEY != enb_s1ap_id_key) {
+    h_rc = mme_app_ue_index_rekey (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
+        (const hash_key_t)ue_context_p->enb_s1ap_id_key, (const hash_key_t)enb_s1ap_id_key, (const hash_key_t)INVALID_ENB_UE_S1AP_ID_KEY, ue_context_p);
 
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_ERROR (LOG_MME_APP,
-            "Error could not update this ue context %p enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " %s\n",
-            ue_context_p, ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, hashtable_rc_code2string(h_rc));
-      }
-      ue_context_p->enb_s1ap_id_key = enb_s1ap_id_key;
+    if (HASH_TABLE_OK != h_rc) {
+      OAILOG_ERROR (LOG_MME_APP,
+          "Error could not update this ue context %p enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " %s\n",
+          ue_context_p, ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, hashtable_rc_code2string(h_rc));
     }
-
+    ue_context_p->enb_s1ap_id_key = enb_s1ap_id_key;
+  }
 
   if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
-    if (ue_context_p->mme_ue_s1ap_id != mme_ue_s1ap_id) {
-
-      // new insertion of mme_ue_s1ap_id, not a change in the id
-      h_rc = hashtable_ts_remove (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->mme_ue_s1ap_id,  (void **)&ue_context_p);
-      h_rc = hashtable_ts_insert (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)mme_ue_s1ap_id, (void *)ue_context_p);
+    h_rc = mme_app_ue_index_rekey (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
+        (const hash_key_t)ue_context_p->mme_ue_s1ap_id, (const hash_key_t)mme_ue_s1ap_id, (const hash_key_t)INVALID_MME_UE_S1AP_ID, ue_context_p);
 
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_ERROR (LOG_MME_APP,
-            "Error could not update this ue context %p enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " %s\n",
-            ue_context_p, ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, hashtable_rc_code2string(h_rc));
-      }
-      ue_context_p->mme_ue_s1ap_id = mme_ue_s1ap_id;
+    if (HASH_TABLE_OK != h_rc) {
+      OAILOG_ERROR (LOG_MME_APP,
+          "Error could not update this ue context %p enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " %s\n",
+          ue_context_p, ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, hashtable_rc_code2string(h_rc));
     }
+    ue_context_p->mme_ue_s1ap_id = mme_ue_s1ap_id;
   }
 
-  h_rc = hashtable_uint64_ts_remove (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)ue_context_p->emm_context._imsi64);
-  if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
-    h_rc = hashtable_uint64_ts_insert (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)imsi, mme_ue_s1ap_id);
-  } else {
-    h_rc = HASH_TABLE_KEY_NOT_EXISTS;
-  }
+  h_rc = mme_app_ue_index_rekey (mme_ue_context_p->imsi_ue_context_htbl,
+      (const hash_key_t)ue_context_p->emm_context._imsi64, (const hash_key_t)imsi, (const hash_key_t)INVALID_IMSI64, ue_context_p);
   if (HASH_TABLE_OK != h_rc) {
     OAILOG_TRACE (LOG_MME_APP,
         "Error could not update this ue context %p enb_ue_s1ap_ue_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " imsi " IMSI_64_FMT ": %s\n",
@@ -422,14 +728,8 @@ mme_ue_context_update_coll_keys (
   }
   ue_context_p->emm_context._imsi64 = imsi;
 
-
-  h_rc = hashtable_uint64_ts_remove (mme_ue_context_p->tun11_ue_context_htbl, (const hash_key_t)ue_context_p->mme_teid_s11);
-  if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
-    h_rc = hashtable_uint64_ts_insert (mme_ue_context_p->tun11_ue_context_htbl, (const hash_key_t)mme_teid_s11, (uint64_t)mme_ue_s1ap_id);
-  } else {
-    h_rc = HASH_TABLE_KEY_NOT_EXISTS;
-  }
-
+  h_rc = mme_app_ue_index_rekey (mme_ue_context_p->tun11_ue_context_htbl,
+      (const hash_key_t)ue_context_p->mme_teid_s11, (const hash_key_t)mme_teid_s11, (const hash_key_t)0, ue_context_p);
   if (HASH_TABLE_OK != h_rc) {
     OAILOG_TRACE (LOG_MME_APP,
         "Error could not update this ue context %p enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " mme_teid_s11 " TEID_FMT " : %s\n",
@@ -437,30 +737,14 @@ mme_ue_context_update_coll_keys (
   }
   ue_context_p->mme_teid_s11 = mme_teid_s11;
 
-
   if (guti_p) {
-    if ((guti_p->gummei.mme_code != ue_context_p->emm_context._guti.gummei.mme_code)
-      || (guti_p->gummei.mme_gid != ue_context_p->emm_context._guti.gummei.mme_gid)
-      || (guti_p->m_tmsi != ue_context_p->emm_context._guti.m_tmsi)
-      || (guti_p->gummei.plmn.mcc_digit1 != ue_context_p->emm_context._guti.gummei.plmn.mcc_digit1)
-      || (guti_p->gummei.plmn.mcc_digit2 != ue_context_p->emm_context._guti.gummei.plmn.mcc_digit2)
-      || (guti_p->gummei.plmn.mcc_digit3 != ue_context_p->emm_context._guti.gummei.plmn.mcc_digit3)
-      || (ue_context_p->mme_ue_s1ap_id != mme_ue_s1ap_id)) {
-
-      // may check guti_p with a kind of instanceof()?
-      h_rc = obj_hashtable_uint64_ts_remove (mme_ue_context_p->guti_ue_context_htbl, &ue_context_p->emm_context._guti, sizeof (*guti_p));
-      if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
-        h_rc = obj_hashtable_uint64_ts_insert (mme_ue_context_p->guti_ue_context_htbl, (const void *const)guti_p, sizeof (*guti_p), (uint64_t)mme_ue_s1ap_id);
-      } else {
-        h_rc = HASH_TABLE_KEY_NOT_EXISTS;
-      }
-
-      if (HASH_TABLE_OK != h_rc) {
-        OAILOG_TRACE (LOG_MME_APP, "Error could not update this ue context %p enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " guti " GUTI_FMT " %s\n",
-            ue_context_p, ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, GUTI_ARG(guti_p), hashtable_rc_code2string(h_rc));
-      }
-      ue_context_p->emm_context._guti = *guti_p;
+    // an all zero GUTI is not indexed
+    h_rc = mme_app_guti_index_rekey (mme_ue_context_p, &ue_context_p->emm_context._guti, guti_p, ue_context_p);
+    if (HASH_TABLE_OK != h_rc) {
+      OAILOG_TRACE (LOG_MME_APP, "Error could not update this ue context %p enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " guti " GUTI_FMT " %s\n",
+          ue_context_p, ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, GUTI_ARG(guti_p), hashtable_rc_code2string(h_rc));
     }
+    ue_context_p->emm_context._guti = *guti_p;
   }
   OAILOG_FUNC_OUT(LOG_MME_APP);
 }
@@ -471,24 +755,28 @@ void mme_ue_context_dump_coll_keys(void)
   bstring tmp = bfromcstr(" ");
   btrunc(tmp, 0);
 
-  hashtable_uint64_ts_dump_content (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl, tmp);
+  hashtable_oa_ts_dump_content (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl, tmp);
   OAILOG_TRACE (LOG_MME_APP,"imsi_ue_context_htbl %s\n", bdata(tmp));
 
   btrunc(tmp, 0);
-  hashtable_uint64_ts_dump_content (mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl, tmp);
+  hashtable_oa_ts_dump_content (mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl, tmp);
   OAILOG_TRACE (LOG_MME_APP,"tun11_ue_context_htbl %s\n", bdata(tmp));
 
   btrunc(tmp, 0);
-  hashtable_ts_dump_content (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, tmp);
+  hashtable_oa_ts_dump_content (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl, tmp);
   OAILOG_TRACE (LOG_MME_APP,"mme_ue_s1ap_id_ue_context_htbl %s\n", bdata(tmp));
 
   btrunc(tmp, 0);
-  hashtable_uint64_ts_dump_content (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl, tmp);
+  hashtable_oa_ts_dump_content (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl, tmp);
   OAILOG_TRACE (LOG_MME_APP,"enb_ue_s1ap_id_ue_context_htbl %s\n", bdata(tmp));
 
   btrunc(tmp, 0);
-  obj_hashtable_uint64_ts_dump_content (mme_app_desc.mme_ue_contexts.guti_ue_context_htbl, tmp);
+  hashtable_oa_ts_dump_content (mme_app_desc.mme_ue_contexts.guti_ue_context_htbl, tmp);
   OAILOG_TRACE (LOG_MME_APP,"guti_ue_context_htbl %s", bdata(tmp));
+
+  btrunc(tmp, 0);
+  obj_hashtable_ts_dump_content (mme_app_desc.mme_ue_contexts.guti_collision_ue_context_htbl, tmp);
+  OAILOG_TRACE (LOG_MME_APP,"guti_collision_ue_context_htbl %s", bdata(tmp));
 }
 
 //------------------------------------------------------------------------------
@@ -505,14 +793,14 @@ mme_insert_ue_context (
 
 
   // filled ENB UE S1AP ID
-  h_rc = hashtable_uint64_ts_is_key_exists (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key);
+  h_rc = hashtable_oa_ts_is_key_exists (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key);
   if (HASH_TABLE_OK == h_rc) {
     OAILOG_DEBUG (LOG_MME_APP, "This ue context %p already exists enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT "\n",
         ue_context_p, ue_context_p->enb_ue_s1ap_id);
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
-  h_rc = hashtable_uint64_ts_insert (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
-                             (const hash_key_t)ue_context_p->enb_s1ap_id_key, ue_context_p->mme_ue_s1ap_id);
+  h_rc = hashtable_oa_ts_insert (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl,
+                             (const hash_key_t)ue_context_p->enb_s1ap_id_key, (void *)ue_context_p);
 
   if (HASH_TABLE_OK != h_rc) {
     OAILOG_DEBUG (LOG_MME_APP, "Error could not register this ue context %p enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " ue_id 0x%x\n",
@@ -521,7 +809,7 @@ mme_insert_ue_context (
   }
 
   if (INVALID_MME_UE_S1AP_ID != ue_context_p->mme_ue_s1ap_id) {
-    h_rc = hashtable_ts_is_key_exists (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->mme_ue_s1ap_id);
+    h_rc = hashtable_oa_ts_is_key_exists (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->mme_ue_s1ap_id);
 
     if (HASH_TABLE_OK == h_rc) {
       OAILOG_DEBUG (LOG_MME_APP, "This ue context %p already exists mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n",
@@ -529,7 +817,7 @@ mme_insert_ue_context (
       OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
     }
 
-    h_rc = hashtable_ts_insert (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
+    h_rc = hashtable_oa_ts_insert (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl,
                                 (const hash_key_t)ue_context_p->mme_ue_s1ap_id,
                                 (void *)ue_context_p);
 
@@ -541,9 +829,9 @@ mme_insert_ue_context (
 
     // filled IMSI
     if (ue_context_p->emm_context._imsi64) {
-      h_rc = hashtable_uint64_ts_insert (mme_ue_context_p->imsi_ue_context_htbl,
+      h_rc = hashtable_oa_ts_insert (mme_ue_context_p->imsi_ue_context_htbl,
                                   (const hash_key_t)ue_context_p->emm_context._imsi64,
-                                  ue_context_p->mme_ue_s1ap_id);
+                                  (void *)ue_context_p);
 
       if (HASH_TABLE_OK != h_rc) {
         OAILOG_DEBUG (LOG_MME_APP, "Error could not register this ue context %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " imsi " IMSI_64_FMT "\n",
@@ -554,9 +842,9 @@ mme_insert_ue_context (
 
     // filled S11 tun id
     if (ue_context_p->mme_teid_s11) {
-      h_rc = hashtable_uint64_ts_insert (mme_ue_context_p->tun11_ue_context_htbl,
+      h_rc = hashtable_oa_ts_insert (mme_ue_context_p->tun11_ue_context_htbl,
                                  (const hash_key_t)ue_context_p->mme_teid_s11,
-                                 ue_context_p->mme_ue_s1ap_id);
+                                 (void *)ue_context_p);
 
       if (HASH_TABLE_OK != h_rc) {
         OAILOG_DEBUG (LOG_MME_APP, "Error could not register this ue context %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " mme_teid_s11 " TEID_FMT "\n",
@@ -570,10 +858,9 @@ mme_insert_ue_context (
         (0 != ue_context_p->emm_context._guti.gummei.plmn.mcc_digit2)
         || (0 != ue_context_p->emm_context._guti.gummei.plmn.mcc_digit3)) {
 
-      h_rc = obj_hashtable_uint64_ts_insert (mme_ue_context_p->guti_ue_context_htbl,
-                                     (const void *const)&ue_context_p->emm_context._guti,
-                                     sizeof (ue_context_p->emm_context._guti),
-                                     ue_context_p->mme_ue_s1ap_id);
+      pthread_mutex_lock (&mme_ue_context_p->guti_lock);
+      h_rc = mme_app_guti_index_insert (mme_ue_context_p, &ue_context_p->emm_context._guti, (ue_mm_context_t *)ue_context_p);
+      pthread_mutex_unlock (&mme_ue_context_p->guti_lock);
 
       if (HASH_TABLE_OK != h_rc) {
         OAILOG_DEBUG (LOG_MME_APP, "Error could not register this ue context %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " guti "GUTI_FMT"\n",
@@ -611,21 +898,21 @@ void mme_remove_ue_context (
   
     // IMSI
     if (ue_context_p->emm_context._imsi64) {
-      hash_rc = hashtable_uint64_ts_remove (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)ue_context_p->emm_context._imsi64);
+      hash_rc = mme_app_ue_index_remove (mme_ue_context_p->imsi_ue_context_htbl, (const hash_key_t)ue_context_p->emm_context._imsi64, ue_context_p);
       if (HASH_TABLE_OK != hash_rc)
         OAILOG_DEBUG(LOG_MME_APP, "UE context enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ", IMSI " IMSI_64_FMT "  not in IMSI collection\n",
             ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, ue_context_p->emm_context._imsi64);
     }
 
     // eNB UE S1P UE ID
-    hash_rc = hashtable_uint64_ts_remove (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key);
+    hash_rc = mme_app_ue_index_remove (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key, ue_context_p);
     if (HASH_TABLE_OK != hash_rc)
       OAILOG_DEBUG(LOG_MME_APP, "UE context enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ", ENB_UE_S1AP_ID not ENB_UE_S1AP_ID collection",
         ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id);
 
     // filled S11 tun id
     if (ue_context_p->mme_teid_s11) {
-      hash_rc = hashtable_uint64_ts_remove (mme_ue_context_p->tun11_ue_context_htbl, (const hash_key_t)ue_context_p->mme_teid_s11);
+      hash_rc = mme_app_ue_index_remove (mme_ue_context_p->tun11_ue_context_htbl, (const hash_key_t)ue_context_p->mme_teid_s11, ue_context_p);
       if (HASH_TABLE_OK != hash_rc)
         OAILOG_DEBUG(LOG_MME_APP, "UE context enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ", MME S11 TEID  " TEID_FMT "  not in S11 collection\n",
             ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, ue_context_p->mme_teid_s11);
@@ -633,7 +920,9 @@ void mme_remove_ue_context (
     // filled guti
     if ((ue_context_p->emm_context._guti.gummei.mme_code) || (ue_context_p->emm_context._guti.gummei.mme_gid) || (ue_context_p->emm_context._guti.m_tmsi) ||
         (ue_context_p->emm_context._guti.gummei.plmn.mcc_digit1) || (ue_context_p->emm_context._guti.gummei.plmn.mcc_digit2) || (ue_context_p->emm_context._guti.gummei.plmn.mcc_digit3)) { // MCC 000 does not exist in ITU table
-      hash_rc = obj_hashtable_uint64_ts_remove (mme_ue_context_p->guti_ue_context_htbl, (const void *const)&ue_context_p->emm_context._guti, sizeof (ue_context_p->emm_context._guti));
+      pthread_mutex_lock (&mme_ue_context_p->guti_lock);
+      hash_rc = mme_app_guti_index_remove (mme_ue_context_p, &ue_context_p->emm_context._guti, ue_context_p);
+      pthread_mutex_unlock (&mme_ue_context_p->guti_lock);
       if (HASH_TABLE_OK != hash_rc)
         OAILOG_DEBUG(LOG_MME_APP, "UE context enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ", GUTI  not in GUTI collection\n",
             ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id);
@@ -641,15 +930,17 @@ void mme_remove_ue_context (
 
     // filled NAS UE ID/ MME UE S1AP ID
     if (INVALID_MME_UE_S1AP_ID != ue_context_p->mme_ue_s1ap_id) {
-      hash_rc = hashtable_ts_remove (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->mme_ue_s1ap_id, (void **)&ue_context_p);
+      hash_rc = mme_app_ue_index_remove (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->mme_ue_s1ap_id, ue_context_p);
       if (HASH_TABLE_OK != hash_rc)
         OAILOG_DEBUG(LOG_MME_APP, "UE context enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT ", mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " not in MME UE S1AP ID collection",
             ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id);
     }
   
     mme_app_ue_context_free_content(ue_context_p);
+    ue_context_p->is_removed = true;
     unlock_ue_contexts(ue_context_p);
-    free_wrapper ((void**)&ue_context_p);
+    // lock-free lookups may still reference it
+    epoch_defer_free (ue_context_p, mme_app_ue_context_release);
   }
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
@@ -917,7 +1208,7 @@ void mme_ue_context_update_ue_sig_connection_state (
   DevAssert (ue_context_p);
   if (new_ecm_state == ECM_IDLE)
   {
-    hash_rc = hashtable_uint64_ts_remove (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key);
+    hash_rc = mme_app_ue_index_remove (mme_ue_context_p->enb_ue_s1ap_id_ue_context_htbl, (const hash_key_t)ue_context_p->enb_s1ap_id_key, ue_context_p);
     if (HASH_TABLE_OK != hash_rc) 
     {
       OAILOG_DEBUG(LOG_MME_APP, "UE context enb_ue_s1ap_ue_id_key %ld mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ", ENB_UE_S1AP_ID_KEY could not be found",
@@ -929,7 +1220,7 @@ void mme_ue_context_update_ue_sig_connection_state (
     
     if (mme_config.nas_config.t3412_min > 0) {
       // Start Mobile reachability timer only if peroidic TAU timer is not disabled 
-      if (timer_setup (ue_context_p->mobile_reachability_timer.sec, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_context_p->mme_ue_s1ap_id), &(ue_context_p->mobile_reachability_timer.id)) < 0) {
+      if (timer_setup (ue_context_p->mobile_reachability_timer.sec, 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)(uintptr_t)ue_context_p->mme_ue_s1ap_id, &(ue_context_p->mobile_reachability_timer.id)) < 0) {
         OAILOG_ERROR (LOG_MME_APP, "Failed to start Mobile Reachability timer for UE id  " MME_UE_S1AP_ID_FMT "\n", ue_context_p->mme_ue_s1ap_id);
         ue_context_p->mobile_reachability_timer.id = MME_APP_TIMER_INACTIVE_ID;
       } else {
@@ -1093,7 +1384,7 @@ mme_app_dump_ue_contexts (
   const mme_ue_context_t * const mme_ue_context_p)
 //------------------------------------------------------------------------------
 {
-  hashtable_ts_apply_callback_on_elements (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, mme_app_dump_ue_context, NULL, NULL);
+  hashtable_oa_ts_apply_callback_on_elements (mme_ue_context_p->mme_ue_s1ap_id_ue_context_htbl, mme_app_dump_ue_context, NULL, NULL);
 }
 
 
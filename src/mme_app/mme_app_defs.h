@@ -93,6 +93,8 @@ void mme_app_handle_conn_est_cnf             (itti_nas_conn_est_cnf_t * const na
 
 void mme_app_handle_initial_ue_message       (itti_s1ap_initial_ue_message_t * const conn_est_ind_pP);
 
+bool mme_app_construct_guti                  (const plmn_t * const plmn_p, const s_tmsi_t * const s_tmsi_p, guti_t * const guti_p);
+
 int mme_app_handle_create_sess_resp          (itti_s11_create_session_response_t * const create_sess_resp_pP); //not const because we need to free internal stucts
 
 void mme_app_handle_erab_setup_req (itti_erab_setup_req_t * const itti_erab_setup_req);
@@ -40,6 +40,7 @@
 #include "log.h"
 #include "msc.h"
 #include "assertions.h"
+#include "conversions.h"
 #include "intertask_interface.h"
 #include "itti_free_defined_msg.h"
 #include "mme_config.h"
@@ -54,233 +55,537 @@
 #include "esm_sap.h"
 mme_app_desc_t                          mme_app_desc = {.rw_lock = PTHREAD_RWLOCK_INITIALIZER, 0} ;
 
+/* Maximum number of messages dispatched to the workers per wakeup of TASK_MME_APP */
+#define MME_APP_DISPATCH_BATCH_SIZE     64
+
+static uint32_t                         mme_app_nb_workers = 1;
+/* Workers that started or exited, protected by mme_app_workers_mutex */
+static uint32_t                         mme_app_nb_ready_workers = 0;
+static uint32_t                         mme_app_nb_exited_workers = 0;
+static pthread_mutex_t                  mme_app_workers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t                   mme_app_workers_cond = PTHREAD_COND_INITIALIZER;
+
 void     *mme_app_thread (void *args);
 
+//------------------------------------------------------------------------------
+static void mme_app_worker_count (uint32_t * const counter_p)
+{
+  pthread_mutex_lock (&mme_app_workers_mutex);
+  (*counter_p)++;
+  pthread_cond_broadcast (&mme_app_workers_cond);
+  pthread_mutex_unlock (&mme_app_workers_mutex);
+}
 
 //------------------------------------------------------------------------------
-void *mme_app_thread (void *args)
+/*
+ * S1AP_ENB_DEREGISTERED_IND and S1AP_ENB_INITIATED_RESET_REQ are queued in a
+ * higher priority class than the UE signalling, which they must not overtake.
+ */
+static inline bool mme_app_is_ordered_message (MessageDef * const message_p)
 {
-  struct ue_mm_context_s                    *ue_context_p = NULL;
-  itti_mark_task_ready (TASK_MME_APP);
+  return (ITTI_MSG_ID (message_p) == S1AP_ENB_DEREGISTERED_IND) || (ITTI_MSG_ID (message_p) == S1AP_ENB_INITIATED_RESET_REQ);
+}
 
-  while (1) {
-    MessageDef                             *received_message_p = NULL;
+static void mme_app_worker_handle_message (const task_id_t task_id, MessageDef * received_message_p);
 
-    /*
-     * Trying to fetch a message from the message queue.
-     * If the queue is empty, this function will block till a
-     * message is sent to the task.
-     */
-    itti_receive_msg (TASK_MME_APP, &received_message_p);
-    DevAssert (received_message_p );
+//------------------------------------------------------------------------------
+/*
+ * Handle the messages queued for the worker in the priority classes lower than
+ * the one of message_id, before a message of this id is handled.
+ */
+static void mme_app_worker_handle_lower_priority_messages (const task_id_t task_id, const MessagesIds message_id)
+{
+  MessageDef                             *received_messages_p[MME_APP_DISPATCH_BATCH_SIZE];
+  int                                     nb_messages = 0;
 
-    switch (ITTI_MSG_ID (received_message_p)) {
+  do {
+    nb_messages = itti_receive_lower_priority_msgs (task_id, message_id, received_messages_p, MME_APP_DISPATCH_BATCH_SIZE);
 
-    case MESSAGE_TEST:{
-        OAI_FPRINTF_INFO("TASK_MME_APP received MESSAGE_TEST\n");
-      }
-      break;
+    for (int i = 0; i < nb_messages; i++) {
+      mme_app_worker_handle_message (task_id, received_messages_p[i]);
+    }
+  } while (nb_messages == MME_APP_DISPATCH_BATCH_SIZE);
+}
 
-    case MME_APP_INITIAL_CONTEXT_SETUP_RSP:{
-        mme_app_handle_initial_context_setup_rsp (&MME_APP_INITIAL_CONTEXT_SETUP_RSP (received_message_p));
-      }
-      break;
+//------------------------------------------------------------------------------
+static void mme_app_worker_handle_message (const task_id_t task_id, MessageDef * received_message_p)
+{
+  struct ue_mm_context_s                 *ue_context_p = NULL;
 
-    case MME_APP_CREATE_DEDICATED_BEARER_RSP:{
-      mme_app_handle_create_dedicated_bearer_rsp (&MME_APP_CREATE_DEDICATED_BEARER_RSP (received_message_p));
+  if (mme_app_is_ordered_message (received_message_p)) {
+    mme_app_worker_handle_lower_priority_messages (task_id, ITTI_MSG_ID (received_message_p));
+  }
+
+  switch (ITTI_MSG_ID (received_message_p)) {
+
+  case MME_APP_INITIAL_CONTEXT_SETUP_RSP:{
+      mme_app_handle_initial_context_setup_rsp (&MME_APP_INITIAL_CONTEXT_SETUP_RSP (received_message_p));
     }
     break;
 
-    case MME_APP_CREATE_DEDICATED_BEARER_REJ:{
-      mme_app_handle_create_dedicated_bearer_rej (&MME_APP_CREATE_DEDICATED_BEARER_REJ (received_message_p));
+  case MME_APP_CREATE_DEDICATED_BEARER_RSP:{
+    mme_app_handle_create_dedicated_bearer_rsp (&MME_APP_CREATE_DEDICATED_BEARER_RSP (received_message_p));
+  }
+  break;
+
+  case MME_APP_CREATE_DEDICATED_BEARER_REJ:{
+    mme_app_handle_create_dedicated_bearer_rej (&MME_APP_CREATE_DEDICATED_BEARER_REJ (received_message_p));
+  }
+  break;
+
+  case NAS_CONNECTION_ESTABLISHMENT_CNF:{
+      mme_app_handle_conn_est_cnf (&NAS_CONNECTION_ESTABLISHMENT_CNF (received_message_p));
     }
     break;
 
-    case NAS_CONNECTION_ESTABLISHMENT_CNF:{
-        mme_app_handle_conn_est_cnf (&NAS_CONNECTION_ESTABLISHMENT_CNF (received_message_p));
-      }
-      break;
+  case NAS_DETACH_REQ: {
+      mme_app_handle_detach_req(&received_message_p->ittiMsg.nas_detach_req);
+    }
+    break;
 
-    case NAS_DETACH_REQ: {
-        mme_app_handle_detach_req(&received_message_p->ittiMsg.nas_detach_req);
-      }
-      break;
+  case NAS_DOWNLINK_DATA_REQ: {
+      mme_app_handle_nas_dl_req (&received_message_p->ittiMsg.nas_dl_data_req);
+    }
+    break;
 
-    case NAS_DOWNLINK_DATA_REQ: {
-        mme_app_handle_nas_dl_req (&received_message_p->ittiMsg.nas_dl_data_req);
+  case NAS_ERAB_SETUP_REQ:{
+    mme_app_handle_erab_setup_req (&NAS_ERAB_SETUP_REQ (received_message_p));
+  }
+  break;
+
+  case NAS_PDN_CONFIG_REQ: {
+      struct ue_mm_context_s                    *ue_context_p = NULL;
+      ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, received_message_p->ittiMsg.nas_pdn_config_req.ue_id);
+      if (ue_context_p) {
+        mme_app_send_s6a_update_location_req(ue_context_p);
+        unlock_ue_contexts(ue_context_p);
       }
-      break;
+    }
+    break;
 
-    case NAS_ERAB_SETUP_REQ:{
-      mme_app_handle_erab_setup_req (&NAS_ERAB_SETUP_REQ (received_message_p));
+  case NAS_PDN_CONNECTIVITY_REQ:{
+      mme_app_handle_nas_pdn_connectivity_req (&received_message_p->ittiMsg.nas_pdn_connectivity_req);
     }
     break;
 
-    case NAS_PDN_CONFIG_REQ: {
-        struct ue_mm_context_s                    *ue_context_p = NULL;
-        ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, received_message_p->ittiMsg.nas_pdn_config_req.ue_id);
-        if (ue_context_p) {
-          mme_app_send_s6a_update_location_req(ue_context_p);
-          unlock_ue_contexts(ue_context_p);
-        }
+  case NAS_UPLINK_DATA_IND:{
+      ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, NAS_UL_DATA_IND (received_message_p).ue_id);
+      nas_proc_ul_transfer_ind (NAS_UL_DATA_IND (received_message_p).ue_id,
+          NAS_UL_DATA_IND (received_message_p).tai,
+          NAS_UL_DATA_IND (received_message_p).cgi,
+          &NAS_UL_DATA_IND (received_message_p).nas_msg);
+      if (ue_context_p) {
+       unlock_ue_contexts(ue_context_p);
       }
-      break;
+    }
+    break;
 
-    case NAS_PDN_CONNECTIVITY_REQ:{
-        mme_app_handle_nas_pdn_connectivity_req (&received_message_p->ittiMsg.nas_pdn_connectivity_req);
-      }
-      break;
-
-    case NAS_UPLINK_DATA_IND:{
-        ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, NAS_UL_DATA_IND (received_message_p).ue_id);
-        nas_proc_ul_transfer_ind (NAS_UL_DATA_IND (received_message_p).ue_id,
-            NAS_UL_DATA_IND (received_message_p).tai,
-            NAS_UL_DATA_IND (received_message_p).cgi,
-            &NAS_UL_DATA_IND (received_message_p).nas_msg);
-        if (ue_context_p) {
-         unlock_ue_contexts(ue_context_p);
-        }
-      }
-      break;
+  case S11_CREATE_BEARER_REQUEST:
+    mme_app_handle_s11_create_bearer_req (&received_message_p->ittiMsg.s11_create_bearer_request);
+    break;
 
-    case S11_CREATE_BEARER_REQUEST:
-      mme_app_handle_s11_create_bearer_req (&received_message_p->ittiMsg.s11_create_bearer_request);
-      break;
+  case S11_CREATE_SESSION_RESPONSE:{
+      mme_app_handle_create_sess_resp (&received_message_p->ittiMsg.s11_create_session_response);
+    }
+    break;
 
-    case S11_CREATE_SESSION_RESPONSE:{
-        mme_app_handle_create_sess_resp (&received_message_p->ittiMsg.s11_create_session_response);
-      }
-      break;
+  case S11_DELETE_SESSION_RESPONSE: {
+    mme_app_handle_delete_session_rsp (&received_message_p->ittiMsg.s11_delete_session_response);
+    }
+    break;
+
+  case S11_MODIFY_BEARER_RESPONSE:{
+      ue_context_p = mme_ue_context_exists_s11_teid (&mme_app_desc.mme_ue_contexts, received_message_p->ittiMsg.s11_modify_bearer_response.teid);
 
-    case S11_DELETE_SESSION_RESPONSE: {
-      mme_app_handle_delete_session_rsp (&received_message_p->ittiMsg.s11_delete_session_response);
+      if (ue_context_p == NULL) {
+        MSC_LOG_RX_DISCARDED_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " ",
+          received_message_p->ittiMsg.s11_modify_bearer_response.teid);
+        OAILOG_WARNING (LOG_MME_APP, "We didn't find this teid in list of UE: %08x\n", received_message_p->ittiMsg.s11_modify_bearer_response.teid);
+      } else {
+        MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ",
+          received_message_p->ittiMsg.s11_modify_bearer_response.teid, ue_context_p->emm_context._imsi64);
+        /*
+         * Updating statistics
+         */
+        update_mme_app_stats_s1u_bearer_add();
+        unlock_ue_contexts(ue_context_p);
       }
-      break;
+    }
+    break;
+
+  case S11_RELEASE_ACCESS_BEARERS_RESPONSE:{
+      mme_app_handle_release_access_bearers_resp (&received_message_p->ittiMsg.s11_release_access_bearers_response);
+    }
+    break;
 
-    case S11_MODIFY_BEARER_RESPONSE:{
-        ue_context_p = mme_ue_context_exists_s11_teid (&mme_app_desc.mme_ue_contexts, received_message_p->ittiMsg.s11_modify_bearer_response.teid);
+  case S1AP_E_RAB_SETUP_RSP:{
+      mme_app_handle_e_rab_setup_rsp (&S1AP_E_RAB_SETUP_RSP (received_message_p));
+    }
+    break;
 
+  case S1AP_ENB_DEREGISTERED_IND: {
+      mme_app_handle_enb_deregister_ind(&received_message_p->ittiMsg.s1ap_eNB_deregistered_ind);
+  }
+  break;
+
+  case S1AP_ENB_INITIATED_RESET_REQ:{
+      mme_app_handle_enb_reset_req (&S1AP_ENB_INITIATED_RESET_REQ (received_message_p));
+    }
+    break;
+
+  case S1AP_INITIAL_UE_MESSAGE:{
+      mme_app_handle_initial_ue_message (&S1AP_INITIAL_UE_MESSAGE (received_message_p));
+    }
+    break;
+
+  case S1AP_UE_CAPABILITIES_IND:{
+      mme_app_handle_s1ap_ue_capabilities_ind (&received_message_p->ittiMsg.s1ap_ue_cap_ind);
+    }
+    break;
+
+  case S1AP_UE_CONTEXT_RELEASE_COMPLETE:{
+      mme_app_handle_s1ap_ue_context_release_complete (&received_message_p->ittiMsg.s1ap_ue_context_release_complete);
+    }
+    break;
+
+  case S1AP_UE_CONTEXT_RELEASE_REQ:{
+      mme_app_handle_s1ap_ue_context_release_req (&received_message_p->ittiMsg.s1ap_ue_context_release_req);
+    }
+    break;
+
+  case S6A_UPDATE_LOCATION_ANS:{
+      /*
+       * We received the update location answer message from HSS -> Handle it
+       */
+      mme_app_handle_s6a_update_location_ans (&received_message_p->ittiMsg.s6a_update_location_ans);
+    }
+    break;
+
+
+  case TERMINATE_MESSAGE:{
+      itti_free_msg_content(received_message_p);
+      itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+      OAI_FPRINTF_INFO("%s terminated\n", itti_get_task_name (task_id));
+      // the UE collections are not accessed anymore
+      mme_app_worker_count (&mme_app_nb_exited_workers);
+      itti_exit_task ();
+    }
+    break;
+  
+  case MME_APP_INITIAL_CONTEXT_SETUP_FAILURE:{
+      mme_app_handle_initial_context_setup_failure (&MME_APP_INITIAL_CONTEXT_SETUP_FAILURE (received_message_p));
+    }
+    break;
+  
+  case TIMER_HAS_EXPIRED:{
+      /*
+       * Check statistic timer
+       */
+      if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_desc.statistic_timer_id) {
+        mme_app_statistics_display ();
+      } else {
+        // the argument of the UE timers is the UE id itself
+        mme_ue_s1ap_id_t mme_ue_s1ap_id = (mme_ue_s1ap_id_t)(uintptr_t)received_message_p->ittiMsg.timer_has_expired.arg;
+        ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
         if (ue_context_p == NULL) {
-          MSC_LOG_RX_DISCARDED_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " ",
-            received_message_p->ittiMsg.s11_modify_bearer_response.teid);
-          OAILOG_WARNING (LOG_MME_APP, "We didn't find this teid in list of UE: %08x\n", received_message_p->ittiMsg.s11_modify_bearer_response.teid);
+          OAILOG_WARNING (LOG_MME_APP, "Timer expired but no assoicated UE context for UE id " MME_UE_S1AP_ID_FMT "\n",mme_ue_s1ap_id);
+          break;
+        }
+        if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->mobile_reachability_timer.id) {
+          // Mobile Reachability Timer expiry handler 
+          mme_app_handle_mobile_reachability_timer_expiry (ue_context_p);
+        } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->implicit_detach_timer.id) {
+          // Implicit Detach Timer expiry handler 
+          mme_app_handle_implicit_detach_timer_expiry (ue_context_p);
+        } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->initial_context_setup_rsp_timer.id) {
+          // Initial Context Setup Rsp Timer expiry handler
+          mme_app_handle_initial_context_setup_rsp_timer_expiry (ue_context_p);
         } else {
-          MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ",
-            received_message_p->ittiMsg.s11_modify_bearer_response.teid, ue_context_p->emm_context._imsi64);
-          /*
-           * Updating statistics
-           */
-          update_mme_app_stats_s1u_bearer_add();
-          unlock_ue_contexts(ue_context_p);
+          OAILOG_WARNING (LOG_MME_APP, "Timer expired but no associated timer_id for UE id " MME_UE_S1AP_ID_FMT "\n",mme_ue_s1ap_id);
         }
       }
-      break;
+    }
+    break;
 
-    case S11_RELEASE_ACCESS_BEARERS_RESPONSE:{
-        mme_app_handle_release_access_bearers_resp (&received_message_p->ittiMsg.s11_release_access_bearers_response);
-      }
-      break;
+ default:{
+    OAILOG_DEBUG (LOG_MME_APP, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+      AssertFatal (0, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+    }
+    break;
+  }
 
-    case S1AP_E_RAB_SETUP_RSP:{
-        mme_app_handle_e_rab_setup_rsp (&S1AP_E_RAB_SETUP_RSP (received_message_p));
-      }
-      break;
+  itti_free_msg_content(received_message_p);
+  itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * MME_APP worker task: all the messages related to a UE are handled by the
+ * worker its mme_ue_s1ap_id maps to, in the order TASK_MME_APP received them,
+ * NAS uplink messages included (nas_proc_ul_transfer_ind() runs here). The
+ * UE contexts of the different workers are protected by their own mutex.
+ */
+static void *mme_app_worker_thread (void *args)
+{
+  const task_id_t                         task_id = (task_id_t)(uintptr_t)args;
+
+  // UEs created by this worker get ids it serves
+  mme_app_ctx_set_ue_id_shard (task_id - TASK_MME_APP_WORKER_0);
+  itti_mark_task_ready (task_id);
+  mme_app_worker_count (&mme_app_nb_ready_workers);
+
+  while (1) {
+    MessageDef                             *received_message_p = NULL;
+
+    /*
+     * Trying to fetch a message from the message queue.
+     * If the queue is empty, this function will block till a
+     * message is sent to the task.
+     */
+    itti_receive_msg (task_id, &received_message_p);
+    DevAssert (received_message_p );
+    mme_app_worker_handle_message (task_id, received_message_p);
+  }
+
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static inline task_id_t mme_app_worker_for_ue (const mme_ue_s1ap_id_t mme_ue_s1ap_id)
+{
+  // see mme_app_ctx_get_new_ue_id(), an unknown UE is reported by worker 0
+  return (task_id_t)(TASK_MME_APP_WORKER_0 + ((uint32_t)mme_ue_s1ap_id % mme_app_nb_workers));
+}
+
+//------------------------------------------------------------------------------
+static task_id_t mme_app_worker_for_initial_ue_message (const itti_s1ap_initial_ue_message_t * const initial_p)
+{
+  mme_ue_s1ap_id_t                        mme_ue_s1ap_id = initial_p->mme_ue_s1ap_id;
+  enb_s1ap_id_key_t                       enb_s1ap_id_key = INVALID_ENB_UE_S1AP_ID_KEY;
+
+  if ((INVALID_MME_UE_S1AP_ID == mme_ue_s1ap_id) && (initial_p->is_s_tmsi_valid)) {
+    // Known UE coming back from IDLE: rehome on the worker of its context, see mme_app_handle_initial_ue_message()
+    guti_t                                  guti = {.gummei.plmn = {0}, .gummei.mme_gid = 0, .gummei.mme_code = 0, .m_tmsi = INVALID_M_TMSI};
+    plmn_t                                  plmn = {.mcc_digit1 = initial_p->tai.mcc_digit1,
+                                                    .mcc_digit2 = initial_p->tai.mcc_digit2,
+                                                    .mcc_digit3 = initial_p->tai.mcc_digit3,
+                                                    .mnc_digit1 = initial_p->tai.mnc_digit1,
+                                                    .mnc_digit2 = initial_p->tai.mnc_digit2,
+                                                    .mnc_digit3 = initial_p->tai.mnc_digit3};
+
+    if (mme_app_construct_guti (&plmn, &initial_p->opt_s_tmsi, &guti)) {
+      mme_ue_s1ap_id = mme_ue_context_get_mme_ue_s1ap_id_guti (&mme_app_desc.mme_ue_contexts, &guti);
+    }
+  }
+  if (INVALID_MME_UE_S1AP_ID != mme_ue_s1ap_id) {
+    return mme_app_worker_for_ue (mme_ue_s1ap_id);
+  }
+  /*
+   * New UE: any worker will do, its context gets a mme_ue_s1ap_id of the
+   * worker creating it. Spread the UEs of an eNB over the workers.
+   */
+  MME_APP_ENB_S1AP_ID_KEY (enb_s1ap_id_key, initial_p->enb_id, initial_p->enb_ue_s1ap_id);
+  return (task_id_t)(TASK_MME_APP_WORKER_0 + (uint32_t)((enb_s1ap_id_key ^ (enb_s1ap_id_key >> 24)) % mme_app_nb_workers));
+}
+
+//------------------------------------------------------------------------------
+static task_id_t mme_app_worker_for_message (MessageDef * const message_p)
+{
+  imsi64_t                                imsi64 = INVALID_IMSI64;
+
+  switch (ITTI_MSG_ID (message_p)) {
+  case S1AP_INITIAL_UE_MESSAGE:
+    return mme_app_worker_for_initial_ue_message (&S1AP_INITIAL_UE_MESSAGE (message_p));
+
+  case MME_APP_INITIAL_CONTEXT_SETUP_RSP:
+    return mme_app_worker_for_ue (MME_APP_INITIAL_CONTEXT_SETUP_RSP (message_p).ue_id);
+
+  case MME_APP_INITIAL_CONTEXT_SETUP_FAILURE:
+    return mme_app_worker_for_ue (MME_APP_INITIAL_CONTEXT_SETUP_FAILURE (message_p).mme_ue_s1ap_id);
+
+  case MME_APP_CREATE_DEDICATED_BEARER_RSP:
+    return mme_app_worker_for_ue (MME_APP_CREATE_DEDICATED_BEARER_RSP (message_p).ue_id);
+
+  case MME_APP_CREATE_DEDICATED_BEARER_REJ:
+    return mme_app_worker_for_ue (MME_APP_CREATE_DEDICATED_BEARER_REJ (message_p).ue_id);
+
+  case NAS_CONNECTION_ESTABLISHMENT_CNF:
+    return mme_app_worker_for_ue (NAS_CONNECTION_ESTABLISHMENT_CNF (message_p).ue_id);
+
+  case NAS_DETACH_REQ:
+    return mme_app_worker_for_ue (message_p->ittiMsg.nas_detach_req.ue_id);
+
+  case NAS_DOWNLINK_DATA_REQ:
+    return mme_app_worker_for_ue (message_p->ittiMsg.nas_dl_data_req.ue_id);
+
+  case NAS_ERAB_SETUP_REQ:
+    return mme_app_worker_for_ue (NAS_ERAB_SETUP_REQ (message_p).ue_id);
+
+  case NAS_PDN_CONFIG_REQ:
+    return mme_app_worker_for_ue (message_p->ittiMsg.nas_pdn_config_req.ue_id);
+
+  case NAS_PDN_CONNECTIVITY_REQ:
+    return mme_app_worker_for_ue (message_p->ittiMsg.nas_pdn_connectivity_req.ue_id);
+
+  case NAS_UPLINK_DATA_IND:
+    return mme_app_worker_for_ue (NAS_UL_DATA_IND (message_p).ue_id);
+
+  case S11_CREATE_BEARER_REQUEST:
+    return mme_app_worker_for_ue (mme_ue_context_get_mme_ue_s1ap_id_s11_teid (&mme_app_desc.mme_ue_contexts,
+        message_p->ittiMsg.s11_create_bearer_request.teid));
 
-    case S1AP_ENB_DEREGISTERED_IND: {
-        mme_app_handle_enb_deregister_ind(&received_message_p->ittiMsg.s1ap_eNB_deregistered_ind);
+  case S11_CREATE_SESSION_RESPONSE:
+    return mme_app_worker_for_ue (mme_ue_context_get_mme_ue_s1ap_id_s11_teid (&mme_app_desc.mme_ue_contexts,
+        message_p->ittiMsg.s11_create_session_response.teid));
+
+  case S11_DELETE_SESSION_RESPONSE:
+    return mme_app_worker_for_ue (mme_ue_context_get_mme_ue_s1ap_id_s11_teid (&mme_app_desc.mme_ue_contexts,
+        message_p->ittiMsg.s11_delete_session_response.teid));
+
+  case S11_MODIFY_BEARER_RESPONSE:
+    return mme_app_worker_for_ue (mme_ue_context_get_mme_ue_s1ap_id_s11_teid (&mme_app_desc.mme_ue_contexts,
+        message_p->ittiMsg.s11_modify_bearer_response.teid));
+
+  case S11_RELEASE_ACCESS_BEARERS_RESPONSE:
+    return mme_app_worker_for_ue (mme_ue_context_get_mme_ue_s1ap_id_s11_teid (&mme_app_desc.mme_ue_contexts,
+        message_p->ittiMsg.s11_release_access_bearers_response.teid));
+
+  case S1AP_E_RAB_SETUP_RSP:
+    return mme_app_worker_for_ue (S1AP_E_RAB_SETUP_RSP (message_p).mme_ue_s1ap_id);
+
+  case S1AP_UE_CAPABILITIES_IND:
+    return mme_app_worker_for_ue (message_p->ittiMsg.s1ap_ue_cap_ind.mme_ue_s1ap_id);
+
+  case S1AP_UE_CONTEXT_RELEASE_COMPLETE:
+    return mme_app_worker_for_ue (message_p->ittiMsg.s1ap_ue_context_release_complete.mme_ue_s1ap_id);
+
+  case S1AP_UE_CONTEXT_RELEASE_REQ:
+    return mme_app_worker_for_ue (message_p->ittiMsg.s1ap_ue_context_release_req.mme_ue_s1ap_id);
+
+  case S6A_UPDATE_LOCATION_ANS:
+    IMSI_STRING_TO_IMSI64 ((char *)message_p->ittiMsg.s6a_update_location_ans.imsi, &imsi64);
+    return mme_app_worker_for_ue (mme_ue_context_get_mme_ue_s1ap_id_imsi (&mme_app_desc.mme_ue_contexts, imsi64));
+
+  case TIMER_HAS_EXPIRED:
+    if (message_p->ittiMsg.timer_has_expired.timer_id != mme_app_desc.statistic_timer_id) {
+      // UE timers carry the UE id by value
+      return mme_app_worker_for_ue ((mme_ue_s1ap_id_t)(uintptr_t)message_p->ittiMsg.timer_has_expired.arg);
     }
+    return TASK_MME_APP_WORKER_0;
+
+  default:
+    // eNB wide messages (S1AP_ENB_DEREGISTERED_IND, S1AP_ENB_INITIATED_RESET_REQ) lock each UE they handle
+    return TASK_MME_APP_WORKER_0;
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Forward TERMINATE_MESSAGE to the workers and wait for their exit, the UE
+ * collections they share can only be released afterwards.
+ */
+static void mme_app_stop_workers (void)
+{
+  for (uint32_t w = 0; w < mme_app_nb_workers; w++) {
+    MessageDef                             *message_p = itti_alloc_new_message (TASK_MME_APP, TERMINATE_MESSAGE);
+
+    // the worker may already have received the broadcast TERMINATE_MESSAGE
+    itti_send_msg_to_task (TASK_MME_APP_WORKER_0 + w, INSTANCE_DEFAULT, message_p);
+  }
+
+  pthread_mutex_lock (&mme_app_workers_mutex);
+  while (mme_app_nb_exited_workers < mme_app_nb_ready_workers) {
+    pthread_cond_wait (&mme_app_workers_cond, &mme_app_workers_mutex);
+  }
+  pthread_mutex_unlock (&mme_app_workers_mutex);
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_dispatch_message (MessageDef * received_message_p)
+{
+  switch (ITTI_MSG_ID (received_message_p)) {
+  case MESSAGE_TEST:
+    OAI_FPRINTF_INFO("TASK_MME_APP received MESSAGE_TEST\n");
     break;
 
-    case S1AP_ENB_INITIATED_RESET_REQ:{
-        mme_app_handle_enb_reset_req (&S1AP_ENB_INITIATED_RESET_REQ (received_message_p));
-      }
-      break;
+  case TERMINATE_MESSAGE:
+    mme_app_stop_workers ();
+    mme_app_exit();
+    itti_free_msg_content(received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+    OAI_FPRINTF_INFO("TASK_MME_APP terminated\n");
+    itti_exit_task ();
+    break;
 
-    case S1AP_INITIAL_UE_MESSAGE:{
-        mme_app_handle_initial_ue_message (&S1AP_INITIAL_UE_MESSAGE (received_message_p));
-      }
-      break;
+  default:{
+      task_id_t                               worker_task_id = mme_app_worker_for_message (received_message_p);
 
-    case S1AP_UE_CAPABILITIES_IND:{
-        mme_app_handle_s1ap_ue_capabilities_ind (&received_message_p->ittiMsg.s1ap_ue_cap_ind);
+      if (itti_send_msg_to_task (worker_task_id, ITTI_MSG_INSTANCE (received_message_p), received_message_p) < 0) {
+        OAILOG_ERROR (LOG_MME_APP, "Could not dispatch %s to %s, message dropped\n",
+            ITTI_MSG_NAME (received_message_p), itti_get_task_name (worker_task_id));
       }
-      break;
+      // owned by the worker (or released by ITTI) now
+      received_message_p = NULL;
+    }
+    break;
+  }
 
-    case S1AP_UE_CONTEXT_RELEASE_COMPLETE:{
-        mme_app_handle_s1ap_ue_context_release_complete (&received_message_p->ittiMsg.s1ap_ue_context_release_complete);
-      }
-      break;
+  if (received_message_p) {
+    itti_free_msg_content(received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+  }
+}
 
-    case S1AP_UE_CONTEXT_RELEASE_REQ:{
-        mme_app_handle_s1ap_ue_context_release_req (&received_message_p->ittiMsg.s1ap_ue_context_release_req);
-      }
-      break;
+//------------------------------------------------------------------------------
+/*
+ * TASK_MME_APP only dispatches the messages of S1AP, NAS, S11, S6A and the
+ * timers to the worker serving the UE they relate to.
+ */
+void *mme_app_thread (__attribute__((unused)) void *args)
+{
+  MessageDef                             *received_messages_p[MME_APP_DISPATCH_BATCH_SIZE];
+  MessageDef                             *ordered_messages_p[MME_APP_DISPATCH_BATCH_SIZE];
+  int                                     nb_messages = 0;
+  int                                     nb_ordered_messages = 0;
+  int                                     i = 0;
+
+  // Nothing can be dispatched before every worker is ready
+  pthread_mutex_lock (&mme_app_workers_mutex);
+  while (mme_app_nb_ready_workers < mme_app_nb_workers) {
+    pthread_cond_wait (&mme_app_workers_cond, &mme_app_workers_mutex);
+  }
+  pthread_mutex_unlock (&mme_app_workers_mutex);
+  itti_mark_task_ready (TASK_MME_APP);
 
-    case S6A_UPDATE_LOCATION_ANS:{
-        /*
-         * We received the update location answer message from HSS -> Handle it
-         */
-        mme_app_handle_s6a_update_location_ans (&received_message_p->ittiMsg.s6a_update_location_ans);
+  while (1) {
+    nb_messages = itti_receive_msgs (TASK_MME_APP, received_messages_p, MME_APP_DISPATCH_BATCH_SIZE);
+    nb_ordered_messages = 0;
+
+    for (i = 0; i < nb_messages; i++) {
+      if (mme_app_is_ordered_message (received_messages_p[i])) {
+        ordered_messages_p[nb_ordered_messages++] = received_messages_p[i];
+      } else {
+        mme_app_dispatch_message (received_messages_p[i]);
       }
-      break;
+    }
 
+    if (nb_ordered_messages) {
+      /*
+       * The lower priority messages queued before them are dispatched first,
+       * the workers keep this order.
+       */
+      do {
+        nb_messages = itti_receive_lower_priority_msgs (TASK_MME_APP, ITTI_MSG_ID (ordered_messages_p[0]), received_messages_p, MME_APP_DISPATCH_BATCH_SIZE);
 
-    case TERMINATE_MESSAGE:{
-        /*
-         * Termination message received TODO -> release any data allocated
-         */
-        mme_app_exit();
-        itti_free_msg_content(received_message_p);
-        itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-        OAI_FPRINTF_INFO("TASK_MME_APP terminated\n");
-        itti_exit_task ();
-      }
-      break;
-    
-    case MME_APP_INITIAL_CONTEXT_SETUP_FAILURE:{
-        mme_app_handle_initial_context_setup_failure (&MME_APP_INITIAL_CONTEXT_SETUP_FAILURE (received_message_p));
-      }
-      break;
-    
-    case TIMER_HAS_EXPIRED:{
-        /*
-         * Check statistic timer
-         */
-        if (received_message_p->ittiMsg.timer_has_expired.timer_id == mme_app_desc.statistic_timer_id) {
-          mme_app_statistics_display ();
-        } else if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) { 
-          mme_ue_s1ap_id_t mme_ue_s1ap_id = *((mme_ue_s1ap_id_t *)(received_message_p->ittiMsg.timer_has_expired.arg));
-          ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, mme_ue_s1ap_id);
-          if (ue_context_p == NULL) {
-            OAILOG_WARNING (LOG_MME_APP, "Timer expired but no assoicated UE context for UE id " MME_UE_S1AP_ID_FMT "\n",mme_ue_s1ap_id);
-            break;
-          }
-          if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->mobile_reachability_timer.id) {
-            // Mobile Reachability Timer expiry handler 
-            mme_app_handle_mobile_reachability_timer_expiry (ue_context_p);
-          } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->implicit_detach_timer.id) {
-            // Implicit Detach Timer expiry handler 
-            mme_app_handle_implicit_detach_timer_expiry (ue_context_p);
-          } else if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_context_p->initial_context_setup_rsp_timer.id) {
-            // Initial Context Setup Rsp Timer expiry handler
-            mme_app_handle_initial_context_setup_rsp_timer_expiry (ue_context_p);
-          } else {
-            OAILOG_WARNING (LOG_MME_APP, "Timer expired but no associated timer_id for UE id " MME_UE_S1AP_ID_FMT "\n",mme_ue_s1ap_id);
-          }
+        for (i = 0; i < nb_messages; i++) {
+          mme_app_dispatch_message (received_messages_p[i]);
         }
-      }
-      break;
+      } while (nb_messages == MME_APP_DISPATCH_BATCH_SIZE);
 
-   default:{
-      OAILOG_DEBUG (LOG_MME_APP, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
-        AssertFatal (0, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+      for (i = 0; i < nb_ordered_messages; i++) {
+        mme_app_dispatch_message (ordered_messages_p[i]);
       }
-      break;
     }
-
-    itti_free_msg_content(received_message_p);
-    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-    received_message_p = NULL;
   }
 
   return NULL;
@@ -292,21 +597,27 @@ int mme_app_init (const mme_config_t * mme_config_p)
   OAILOG_FUNC_IN (LOG_MME_APP);
   memset (&mme_app_desc, 0, sizeof (mme_app_desc));
   pthread_rwlock_init (&mme_app_desc.rw_lock, NULL);
+  mme_app_desc.mme_ue_contexts.ue_context_slab = slab_create ("mme_app_ue_context_slab", sizeof (ue_mm_context_t), MME_APP_UE_CONTEXT_SLAB_CHUNK);
+  AssertFatal(mme_app_desc.mme_ue_contexts.ue_context_slab, "Cannot allocate UE contexts in MME_APP");
   bstring b = bfromcstr("mme_app_imsi_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl = hashtable_uint64_ts_create (mme_config.max_ues, NULL, b);
+  mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl = hashtable_oa_ts_create (mme_config.max_ues, NULL, hash_free_int_func, b);
   btrunc(b, 0);
   bassigncstr(b, "mme_app_tun11_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl = hashtable_uint64_ts_create (mme_config.max_ues, NULL, b);
-  AssertFatal(sizeof(uintptr_t) >= sizeof(uint64_t), "Problem with mme_ue_s1ap_id_ue_context_htbl in MME_APP");
+  mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl = hashtable_oa_ts_create (mme_config.max_ues, NULL, hash_free_int_func, b);
   btrunc(b, 0);
   bassigncstr(b, "mme_app_mme_ue_s1ap_id_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl = hashtable_ts_create (mme_config.max_ues, NULL, NULL, b);
+  mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl = hashtable_oa_ts_create (mme_config.max_ues, NULL, hash_free_int_func, b);
   btrunc(b, 0);
   bassigncstr(b, "mme_app_enb_ue_s1ap_id_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl = hashtable_uint64_ts_create (mme_config.max_ues, NULL, b);
+  mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl = hashtable_oa_ts_create (mme_config.max_ues, NULL, hash_free_int_func, b);
   btrunc(b, 0);
   bassigncstr(b, "mme_app_guti_ue_context_htbl");
-  mme_app_desc.mme_ue_contexts.guti_ue_context_htbl = obj_hashtable_uint64_ts_create (mme_config.max_ues, NULL, NULL, b);
+  mme_app_desc.mme_ue_contexts.guti_ue_context_htbl = hashtable_oa_ts_create (mme_config.max_ues, NULL, hash_free_int_func, b);
+  btrunc(b, 0);
+  bassigncstr(b, "mme_app_guti_collision_ue_context_htbl");
+  mme_app_desc.mme_ue_contexts.guti_collision_ue_context_htbl = obj_hashtable_ts_create (64, NULL, NULL, hash_free_int_func, b);
+  mme_app_desc.mme_ue_contexts.nb_guti_collisions = 0;
+  pthread_mutex_init (&mme_app_desc.mme_ue_contexts.guti_lock, NULL);
   bdestroy_wrapper (&b);
 
   if (mme_app_edns_init(mme_config_p)) {
@@ -321,8 +632,21 @@ int mme_app_init (const mme_config_t * mme_config_p)
 
 
   /*
-   * Create the thread associated with MME applicative layer
+   * Create the threads associated with MME applicative layer, the workers first
    */
+  mme_app_nb_workers = mme_config_p->mme_app_nb_workers;
+  if ((mme_app_nb_workers == 0) || (mme_app_nb_workers > MME_APP_NB_WORKERS_MAX)) {
+    OAILOG_ERROR (LOG_MME_APP, "Bad number of MME_APP workers %u, expecting 1..%d\n", mme_app_nb_workers, MME_APP_NB_WORKERS_MAX);
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
+  mme_app_ctx_set_ue_id_shards (mme_app_nb_workers);
+  for (uint32_t w = 0; w < mme_app_nb_workers; w++) {
+    if (itti_create_task (TASK_MME_APP_WORKER_0 + w, &mme_app_worker_thread, (void *)(uintptr_t)(TASK_MME_APP_WORKER_0 + w)) < 0) {
+      OAILOG_ERROR (LOG_MME_APP, "MME APP create worker task %u failed\n", w);
+      OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+    }
+  }
+
   if (itti_create_task (TASK_MME_APP, &mme_app_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_MME_APP, "MME APP create task failed\n");
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
@@ -347,10 +671,14 @@ void mme_app_exit (void)
 {
   timer_remove(mme_app_desc.statistic_timer_id, NULL);
   mme_app_edns_exit();
-  hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl);
-  hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl);
-  hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl);
-  hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl);
-  obj_hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.guti_ue_context_htbl);
+  hashtable_oa_ts_destroy (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl);
+  hashtable_oa_ts_destroy (mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl);
+  hashtable_oa_ts_destroy (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl);
+  hashtable_oa_ts_destroy (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl);
+  hashtable_oa_ts_destroy (mme_app_desc.mme_ue_contexts.guti_ue_context_htbl);
+  obj_hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.guti_collision_ue_context_htbl);
+  pthread_mutex_destroy (&mme_app_desc.mme_ue_contexts.guti_lock);
+  // UE contexts still referenced are released with the slab
+  slab_destroy (&mme_app_desc.mme_ue_contexts.ue_context_slab);
   mme_config_exit();
 }
@@ -31,6 +31,7 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
+#include "sctp_primitives_server.h"
 
 int mme_app_statistics_display (
   void)
@@ -48,6 +49,7 @@ int mme_app_statistics_display (
   OAILOG_DEBUG (LOG_MME_APP, "S1-U Bearers   | %10u      |     %10u              |    %10u               |\n\n",mme_app_desc.nb_s1u_bearers,
                                           mme_app_desc.nb_s1u_bearers_established_since_last_stat,mme_app_desc.nb_s1u_bearers_released_since_last_stat);
   OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
+  sctp_statistics_display ();
   
   mme_stats_write_lock (&mme_app_desc);
   
@@ -73,7 +73,9 @@ int mme_app_handle_nas_dl_req (
   
   S1AP_NAS_DL_DATA_REQ (message_p).enb_ue_s1ap_id         = enb_ue_s1ap_id;
   S1AP_NAS_DL_DATA_REQ (message_p).mme_ue_s1ap_id         = nas_dl_req_pP->ue_id;
-  S1AP_NAS_DL_DATA_REQ (message_p).nas_msg                = bstrcpy(nas_dl_req_pP->nas_msg);
+  // the NAS PDU encoded by NAS is handed over to S1AP without copy
+  S1AP_NAS_DL_DATA_REQ (message_p).nas_msg                = nas_dl_req_pP->nas_msg;
+  nas_dl_req_pP->nas_msg = NULL;
 
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME,TASK_S1AP,NULL, 0,
       "0 DOWNLINK NAS TRANSPORT enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " ue id " MME_UE_S1AP_ID_FMT " ",
@@ -36,6 +36,7 @@
 #include "bstrlib.h"
 
 #include "log.h"
+#include "assertions.h"
 #include "conversions.h"
 #include "common_types.h"
 #include "common_defs.h"
@@ -45,8 +46,16 @@
 #include "3gpp_29.274.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_bearer_context.h"
+#include "mme_default_values.h"
 
-static mme_ue_s1ap_id_t mme_app_ue_s1ap_id_generator = 1;
+/*
+ * MME UE S1AP ids are allocated in nb_shards interleaved ranges: the ids
+ * allocated by the thread of shard s are such that id % nb_shards == s, so
+ * that the UE is always routed to the MME_APP worker which created it.
+ */
+static uint32_t                         mme_app_ue_s1ap_id_nb_shards = 1;
+static __thread uint32_t                mme_app_ue_s1ap_id_shard = 0;
+static uint32_t                         mme_app_ue_s1ap_id_generator[MME_APP_NB_WORKERS_MAX] = {0};
 
 /**
  * @brief mme_app_convert_imsi_to_imsi_mme: converts the imsi_t struct to the imsi mme struct
@@ -150,9 +159,26 @@ mme_app_imsi_to_u64 (mme_app_imsi_t imsi_src)
   return uint_imsi;
 }
 
+void mme_app_ctx_set_ue_id_shards(const uint32_t nb_shards)
+{
+  AssertFatal ((nb_shards > 0) && (nb_shards <= MME_APP_NB_WORKERS_MAX), "Bad number of shards %u", nb_shards);
+  mme_app_ue_s1ap_id_nb_shards = nb_shards;
+}
+
+void mme_app_ctx_set_ue_id_shard(const uint32_t shard)
+{
+  AssertFatal (shard < mme_app_ue_s1ap_id_nb_shards, "Bad shard %u", shard);
+  mme_app_ue_s1ap_id_shard = shard;
+}
+
 mme_ue_s1ap_id_t mme_app_ctx_get_new_ue_id(void)
 {
-  mme_ue_s1ap_id_t tmp = 0;
-  tmp = __sync_fetch_and_add (&mme_app_ue_s1ap_id_generator, 1);
-  return tmp;
+  const uint32_t                          nb_shards = mme_app_ue_s1ap_id_nb_shards;
+  const uint32_t                          shard = mme_app_ue_s1ap_id_shard;
+  uint32_t                                k = 0;
+
+  k = __sync_fetch_and_add (&mme_app_ue_s1ap_id_generator[shard], 1);
+  // k > 0: INVALID_MME_UE_S1AP_ID (0) is never allocated, the shard is kept when the generator wraps
+  k = 1 + (k % ((UINT32_MAX / nb_shards) - 1));
+  return (mme_ue_s1ap_id_t)(k * nb_shards + shard);
 }
@@ -43,6 +43,7 @@
 #include "queue.h"
 #include "hashtable.h"
 #include "obj_hashtable.h"
+#include "slab.h"
 #include "bstrlib.h"
 #include "common_types.h"
 #include "s1ap_messages_types.h"
@@ -83,6 +84,8 @@ void mme_app_imsi_to_string(char * const imsi_dst, mme_app_imsi_t const * const
 uint64_t mme_app_imsi_to_u64 (mme_app_imsi_t imsi_src);
 void mme_app_ue_context_uint_to_imsi(uint64_t imsi_src, mme_app_imsi_t *imsi_dst);
 void mme_app_convert_imsi_to_imsi_mme (mme_app_imsi_t * imsi_dst, const imsi_t *imsi_src);
+void mme_app_ctx_set_ue_id_shards(const uint32_t nb_shards);
+void mme_app_ctx_set_ue_id_shard(const uint32_t shard);
 mme_ue_s1ap_id_t mme_app_ctx_get_new_ue_id(void);
 /*
  * Timer identifier returned when in inactive state (timer is stopped or has
@@ -92,6 +95,9 @@ mme_ue_s1ap_id_t mme_app_ctx_get_new_ue_id(void);
 #define MME_APP_DELTA_T3412_REACHABILITY_TIMER 4 // in minutes 
 #define MME_APP_DELTA_REACHABILITY_IMPLICIT_DETACH_TIMER 0 // in minutes 
 
+/* Number of UE contexts allocated at once by the UE context slab */
+#define MME_APP_UE_CONTEXT_SLAB_CHUNK 256
+
 #define BEARER_STATE_NULL        0
 #define BEARER_STATE_SGW_CREATED (1 << 0)
 #define BEARER_STATE_MME_CREATED (1 << 1)
@@ -256,6 +262,7 @@ typedef struct pdn_context_s {
  */
 typedef struct ue_mm_context_s {
   pthread_mutex_t recmutex;  // mutex on the ue_mm_context_t + emm_context_s + esm_context_t
+  bool            is_removed; // removed from the collections, memory released when no lock-free reader can reference it
 
   /* Basic identifier for ue. IMSI is encoded on maximum of 15 digits of 4 bits,
    * so usage of an unsigned integer on 64 bits is necessary.
@@ -442,11 +449,20 @@ typedef struct mme_ue_context_s {
   uint32_t               nb_ue_since_last_stat;
   uint32_t               nb_bearers_since_last_stat;
 
-  hash_table_uint64_ts_t  *imsi_ue_context_htbl; // data is mme_ue_s1ap_id_t
-  hash_table_uint64_ts_t  *tun11_ue_context_htbl;// data is mme_ue_s1ap_id_t
-  hash_table_ts_t         *mme_ue_s1ap_id_ue_context_htbl;
-  hash_table_uint64_ts_t  *enb_ue_s1ap_id_ue_context_htbl;
-  obj_hash_table_uint64_t *guti_ue_context_htbl;// data is mme_ue_s1ap_id_t
+  /*
+   * UE index: every identifier resolves to the UE context in one probe.
+   * Data of all collections is the ue_mm_context_t pointer, UE contexts are
+   * allocated from ue_context_slab and hold the keys they are indexed by.
+   */
+  slab_t                    *ue_context_slab;
+  hash_table_oa_ts_t        *imsi_ue_context_htbl;
+  hash_table_oa_ts_t        *tun11_ue_context_htbl;
+  hash_table_oa_ts_t        *mme_ue_s1ap_id_ue_context_htbl;
+  hash_table_oa_ts_t        *enb_ue_s1ap_id_ue_context_htbl;
+  hash_table_oa_ts_t        *guti_ue_context_htbl;  // key is a 64 bit packing of the GUTI
+  obj_hash_table_t          *guti_collision_ue_context_htbl;  // key is the GUTI, GUTIs whose 64 bit key designates another UE
+  uint32_t                   nb_guti_collisions;
+  pthread_mutex_t            guti_lock;             // serializes the updates of the GUTI collections
 } mme_ue_context_t;
 
 
@@ -486,6 +502,23 @@ ue_mm_context_t *mme_ue_context_exists_enb_ue_s1ap_id (
 ue_mm_context_t *mme_ue_context_exists_guti(mme_ue_context_t * const mme_ue_context,
     const guti_t * const guti);
 
+/** \brief Retrieve the mme_ue_s1ap_id of an UE context without locking it,
+ * the value may be stale by the time it is used, it is a routing hint only.
+ * \param imsi, teid, enb_key, guti The key of the UE in the collection
+ * @returns the mme_ue_s1ap_id of the UE or INVALID_MME_UE_S1AP_ID if the context doesn't exists
+ **/
+mme_ue_s1ap_id_t mme_ue_context_get_mme_ue_s1ap_id_imsi(mme_ue_context_t * const mme_ue_context,
+    const imsi64_t imsi);
+
+mme_ue_s1ap_id_t mme_ue_context_get_mme_ue_s1ap_id_s11_teid(mme_ue_context_t * const mme_ue_context,
+    const s11_teid_t teid);
+
+mme_ue_s1ap_id_t mme_ue_context_get_mme_ue_s1ap_id_enb_ue_s1ap_id(mme_ue_context_t * const mme_ue_context,
+    const enb_s1ap_id_key_t enb_key);
+
+mme_ue_s1ap_id_t mme_ue_context_get_mme_ue_s1ap_id_guti(mme_ue_context_t * const mme_ue_context,
+    const guti_t * const guti);
+
 /** \brief Move the content of a context to another context
  * \param dst            The destination context
  * \param src            The source context
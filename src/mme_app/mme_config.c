@@ -146,12 +146,17 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->ipv4.s11.s_addr = INADDR_ANY;
   config_pP->ipv4.port_s11 = 2123;
   config_pP->s6a_config.conf_file = bfromcstr(S6A_CONF_FILE);
+  config_pP->s6a_config.auth_vectors_per_request = S6A_AUTH_VECTORS_PER_REQUEST_DEFAULT;
+  config_pP->s6a_config.auth_vectors_low_water_mark = S6A_AUTH_VECTORS_LOW_WATER_MARK_DEFAULT;
+  config_pP->s6a_config.auth_vectors_cache_ttl_sec = S6A_AUTH_VECTORS_CACHE_TTL_DEFAULT;
   config_pP->itti_config.queue_size = ITTI_QUEUE_MAX_ELEMENTS;
   config_pP->itti_config.log_file = NULL;
   config_pP->sctp_config.in_streams = SCTP_IN_STREAMS;
   config_pP->sctp_config.out_streams = SCTP_OUT_STREAMS;
+  config_pP->sctp_config.one_to_many = false;
   config_pP->relative_capacity = RELATIVE_CAPACITY;
   config_pP->mme_statistic_timer = MME_STATISTIC_TIMER_S;
+  config_pP->mme_app_nb_workers = MME_APP_NB_WORKERS_DEFAULT;
   config_pP->gummei.nb = 1;
   config_pP->gummei.gummei[0].mme_code = MMEC;
   config_pP->gummei.gummei[0].mme_gid = MMEGID;
@@ -188,6 +193,7 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->served_tai.plmn_mnc_len[0] = PLMN_MNC_LEN;
   config_pP->served_tai.tac[0] = PLMN_TAC;
   config_pP->s1ap_config.outcome_drop_timer_sec = S1AP_OUTCOME_TIMER_DEFAULT;
+  config_pP->s1ap_config.nb_workers = S1AP_NB_WORKERS_DEFAULT;
 }
 
 //------------------------------------------------------------------------------
@@ -367,6 +373,11 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       config_pP->mme_statistic_timer = (uint32_t) aint;
     }
 
+    if ((config_setting_lookup_int (setting_mme, MME_CONFIG_STRING_MME_APP_WORKERS, &aint))) {
+      AssertFatal ((aint > 0) && (aint <= MME_APP_NB_WORKERS_MAX), "%s must be in [1..%d]\n", MME_CONFIG_STRING_MME_APP_WORKERS, MME_APP_NB_WORKERS_MAX);
+      config_pP->mme_app_nb_workers = (uint8_t) aint;
+    }
+
     if ((config_setting_lookup_string (setting_mme, EPS_NETWORK_FEATURE_SUPPORT_EMERGENCY_BEARER_SERVICES_IN_S1_MODE, (const char **)&astring))) {
       if (strcasecmp (astring, "yes") == 0)
         config_pP->eps_network_feature_support.emergency_bearer_services_in_s1_mode = 1;
@@ -431,6 +442,23 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         } else
           AssertFatal (1 == 0, "You have to provide a valid HSS hostname %s=...\n", MME_CONFIG_STRING_S6A_HSS_HOSTNAME);
       }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_AUTH_VECTORS_PER_REQUEST, &aint))) {
+        AssertFatal ((aint > 0) && (aint <= MAX_EPS_AUTH_VECTORS_PER_REQUEST), "%s must be in [1..%d]\n",
+            MME_CONFIG_STRING_S6A_AUTH_VECTORS_PER_REQUEST, MAX_EPS_AUTH_VECTORS_PER_REQUEST);
+        config_pP->s6a_config.auth_vectors_per_request = (uint8_t) aint;
+      }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_AUTH_VECTORS_LOW_WATER_MARK, &aint))) {
+        config_pP->s6a_config.auth_vectors_low_water_mark = (uint8_t) aint;
+      }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_AUTH_VECTORS_CACHE_TTL, &aint))) {
+        config_pP->s6a_config.auth_vectors_cache_ttl_sec = (uint32_t) aint;
+      }
+
+      AssertFatal (config_pP->s6a_config.auth_vectors_low_water_mark < config_pP->s6a_config.auth_vectors_per_request,
+          "%s must be lower than %s\n", MME_CONFIG_STRING_S6A_AUTH_VECTORS_LOW_WATER_MARK, MME_CONFIG_STRING_S6A_AUTH_VECTORS_PER_REQUEST);
     }
     // SCTP SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_SCTP_CONFIG);
@@ -443,6 +471,13 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_SCTP_OUTSTREAMS, &aint))) {
         config_pP->sctp_config.out_streams = (uint16_t) aint;
       }
+
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_SCTP_ONE_TO_MANY, (const char **)&astring))) {
+        if (strcasecmp (astring, "yes") == 0)
+          config_pP->sctp_config.one_to_many = true;
+        else
+          config_pP->sctp_config.one_to_many = false;
+      }
     }
     // S1AP SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S1AP_CONFIG);
@@ -455,6 +490,11 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S1AP_PORT, &aint))) {
         config_pP->s1ap_config.port_number = (uint16_t) aint;
       }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S1AP_WORKERS, &aint))) {
+        AssertFatal ((aint > 0) && (aint <= S1AP_NB_WORKERS_MAX), "%s must be in [1..%d]\n", MME_CONFIG_STRING_S1AP_WORKERS, S1AP_NB_WORKERS_MAX);
+        config_pP->s1ap_config.nb_workers = (uint8_t) aint;
+      }
     }
     // TAI list setting
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_TAI_LIST);
@@ -823,9 +863,11 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- Extended service request .............: %s\n", config_pP->eps_network_feature_support.extended_service_request == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Unauth IMSI support ..................: %s\n", config_pP->unauthenticated_imsi_supported == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Relative capa ........................: %u\n", config_pP->relative_capacity);
-  OAILOG_INFO (LOG_CONFIG, "- Statistics timer .....................: %u (seconds)\n\n", config_pP->mme_statistic_timer);
+  OAILOG_INFO (LOG_CONFIG, "- Statistics timer .....................: %u (seconds)\n", config_pP->mme_statistic_timer);
+  OAILOG_INFO (LOG_CONFIG, "- MME_APP workers ......................: %u\n\n", config_pP->mme_app_nb_workers);
   OAILOG_INFO (LOG_CONFIG, "- S1-MME:\n");
   OAILOG_INFO (LOG_CONFIG, "    port number ......: %d\n", config_pP->s1ap_config.port_number);
+  OAILOG_INFO (LOG_CONFIG, "    S1AP workers .....: %u\n", config_pP->s1ap_config.nb_workers);
   OAILOG_INFO (LOG_CONFIG, "- IP:\n");
   OAILOG_INFO (LOG_CONFIG, "    s1-MME iface .....: %s\n", bdata(config_pP->ipv4.if_name_s1_mme));
   OAILOG_INFO (LOG_CONFIG, "    s1-MME ip ........: %s\n", inet_ntoa (*((struct in_addr *)&config_pP->ipv4.s1_mme)));
@@ -838,6 +880,7 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- SCTP:\n");
   OAILOG_INFO (LOG_CONFIG, "    in streams .......: %u\n", config_pP->sctp_config.in_streams);
   OAILOG_INFO (LOG_CONFIG, "    out streams ......: %u\n", config_pP->sctp_config.out_streams);
+  OAILOG_INFO (LOG_CONFIG, "    one to many ......: %s\n", (config_pP->sctp_config.one_to_many) ? "yes" : "no");
   OAILOG_INFO (LOG_CONFIG, "- GUMMEIs (PLMN|MMEGI|MMEC):\n");
   for (j = 0; j < config_pP->gummei.nb; j++) {
     OAILOG_INFO (LOG_CONFIG, "            " PLMN_FMT "|%u|%u \n",
@@ -893,6 +936,9 @@ static void mme_config_display (mme_config_t * config_pP)
 
   OAILOG_INFO (LOG_CONFIG, "- S6A:\n");
   OAILOG_INFO (LOG_CONFIG, "    conf file ........: %s\n", bdata(config_pP->s6a_config.conf_file));
+  OAILOG_INFO (LOG_CONFIG, "    auth vectors per request ....: %u\n", config_pP->s6a_config.auth_vectors_per_request);
+  OAILOG_INFO (LOG_CONFIG, "    auth vectors low water mark .: %u\n", config_pP->s6a_config.auth_vectors_low_water_mark);
+  OAILOG_INFO (LOG_CONFIG, "    auth vectors cache TTL ......: %u (seconds)\n", config_pP->s6a_config.auth_vectors_cache_ttl_sec);
   OAILOG_INFO (LOG_CONFIG, "- Logging:\n");
   OAILOG_INFO (LOG_CONFIG, "    Output ..............: %s\n", bdata(config_pP->log_config.output));
   OAILOG_INFO (LOG_CONFIG, "    Output thread safe ..: %s\n", (config_pP->log_config.is_output_thread_safe) ? "true":"false");
@@ -54,6 +54,7 @@
 #define MME_CONFIG_STRING_MAXUE                          "MAXUE"
 #define MME_CONFIG_STRING_RELATIVE_CAPACITY              "RELATIVE_CAPACITY"
 #define MME_CONFIG_STRING_STATISTIC_TIMER                "MME_STATISTIC_TIMER"
+#define MME_CONFIG_STRING_MME_APP_WORKERS                "MME_APP_WORKERS"
 
 #define MME_CONFIG_STRING_EMERGENCY_ATTACH_SUPPORTED     "EMERGENCY_ATTACH_SUPPORTED"
 #define MME_CONFIG_STRING_UNAUTHENTICATED_IMSI_SUPPORTED "UNAUTHENTICATED_IMSI_SUPPORTED"
@@ -70,15 +71,20 @@
 #define MME_CONFIG_STRING_S6A_CONFIG                     "S6A"
 #define MME_CONFIG_STRING_S6A_CONF_FILE_PATH             "S6A_CONF"
 #define MME_CONFIG_STRING_S6A_HSS_HOSTNAME               "HSS_HOSTNAME"
+#define MME_CONFIG_STRING_S6A_AUTH_VECTORS_PER_REQUEST   "AUTH_VECTORS_PER_REQUEST"
+#define MME_CONFIG_STRING_S6A_AUTH_VECTORS_LOW_WATER_MARK "AUTH_VECTORS_LOW_WATER_MARK"
+#define MME_CONFIG_STRING_S6A_AUTH_VECTORS_CACHE_TTL     "AUTH_VECTORS_CACHE_TTL"
 
 #define MME_CONFIG_STRING_SCTP_CONFIG                    "SCTP"
 #define MME_CONFIG_STRING_SCTP_INSTREAMS                 "SCTP_INSTREAMS"
 #define MME_CONFIG_STRING_SCTP_OUTSTREAMS                "SCTP_OUTSTREAMS"
+#define MME_CONFIG_STRING_SCTP_ONE_TO_MANY               "SCTP_ONE_TO_MANY"
 
 
 #define MME_CONFIG_STRING_S1AP_CONFIG                    "S1AP"
 #define MME_CONFIG_STRING_S1AP_OUTCOME_TIMER             "S1AP_OUTCOME_TIMER"
 #define MME_CONFIG_STRING_S1AP_PORT                      "S1AP_PORT"
+#define MME_CONFIG_STRING_S1AP_WORKERS                   "S1AP_WORKERS"
 
 #define MME_CONFIG_STRING_GUMMEI_LIST                    "GUMMEI_LIST"
 #define MME_CONFIG_STRING_MME_CODE                       "MME_CODE"
@@ -140,6 +146,8 @@ typedef struct mme_config_s {
 
   uint32_t mme_statistic_timer;
 
+  uint8_t mme_app_nb_workers; // MME_APP worker tasks, each UE is served by one of them
+
   uint8_t unauthenticated_imsi_supported;
 
   struct {
@@ -169,11 +177,13 @@ typedef struct mme_config_s {
   struct {
     uint16_t in_streams;
     uint16_t out_streams;
+    bool     one_to_many; // one-to-many (SOCK_SEQPACKET) listening socket instead of one socket per association
   } sctp_config;
 
   struct {
     uint16_t port_number;
     uint8_t  outcome_drop_timer_sec;
+    uint8_t  nb_workers; // S1AP worker tasks, each eNB association is served by one of them
   } s1ap_config;
 
   struct {
@@ -191,6 +201,9 @@ typedef struct mme_config_s {
   struct {
     bstring conf_file;
     bstring hss_host_name;
+    uint8_t  auth_vectors_per_request;     // E-UTRAN vectors requested in one AIR
+    uint8_t  auth_vectors_low_water_mark;  // cached vectors of an IMSI below which a refill AIR is sent
+    uint32_t auth_vectors_cache_ttl_sec;   // lifetime of a cached vector
   } s6a_config;
   struct {
     uint32_t  queue_size;
@@ -265,6 +265,10 @@ int nas_message_encrypt (
  **    Others:  None                                       **
  **                                                                        **
  ** Outputs:   outbuf:  Output buffer containing plain NAS message **
+ **       outbuf may be inbuf, the message is then   **
+ **       deciphered in place and the plain NAS mes- **
+ **       sage starts after the security header, at  **
+ **       offset length - returned bytes             **
  **    header:  Security protected header applied          **
  **      Return:  The number of bytes in the output buffer   **
  **       if the input buffer has been successfully  **
@@ -334,7 +338,7 @@ int nas_message_decrypt (
      * Decrypt the security protected NAS message
      */
     //OAI_GCC_DIAG_OFF(discarded-qualifiers);
-    header->protocol_discriminator = _nas_message_decrypt (outbuf,
+    header->protocol_discriminator = _nas_message_decrypt ((outbuf == inbuf) ? outbuf + size : outbuf,
         (unsigned char * const)(inbuf + size),
         header->security_header_type,
         header->message_authentication_code,
@@ -350,7 +354,9 @@ int nas_message_decrypt (
     /*
      * The input buffer contains a plain NAS message
      */
-    memcpy (outbuf, inbuf, length);
+    if (outbuf != inbuf) {
+      memcpy (outbuf, inbuf, length);
+    }
   }
 
   OAILOG_FUNC_RETURN (LOG_NAS, bytes);
@@ -363,7 +369,8 @@ int nas_message_decrypt (
    Description: Decode layer 3 NAS message
 
    Inputs:  buffer:  Pointer to the buffer containing layer 3
-       NAS message data
+       NAS message data, a security protected
+       message is deciphered in place
        length:  Number of bytes that should be decoded
        security:  security context
        Others:  None
@@ -376,7 +383,7 @@ int nas_message_decrypt (
 
 */
 int nas_message_decode (
-    const unsigned char *const buffer,
+    unsigned char *const buffer,
     nas_message_t * msg,
     size_t length,
     void *security,
@@ -516,7 +523,7 @@ int nas_message_decode (
      * Decode security protected NAS message
      */
     // LG WARNING  msg->plain versus msg->security.plain.
-    bytes = _nas_message_protected_decode ((unsigned char *const)(buffer + size), &msg->header, &msg->plain, length - size, emm_security_context, status);
+    bytes = _nas_message_protected_decode (buffer + size, &msg->header, &msg->plain, length - size, emm_security_context, status);
   } else {
     /*
      * Decode plain NAS message
@@ -800,7 +807,8 @@ static int _nas_message_plain_decode (
  ** Description: Decode security protected NAS message                     **
  **                                                                        **
  ** Inputs:  buffer:  Pointer to the buffer containing the secu-           **
- **                     rity protected NAS message data                    **
+ **                     rity protected NAS message data, deciphered        **
+ **                     in place                                           **
  **          header:  Header of the security protected NAS message       **
  **      length:  Number of bytes that should be decoded             **
  **      emm_security_context: security context                       **
@@ -823,26 +831,23 @@ static int _nas_message_protected_decode (
 {
   OAILOG_FUNC_IN (LOG_NAS);
   int                                     bytes = TLV_BUFFER_TOO_SHORT;
-  unsigned char                    *const plain_msg = (unsigned char *)calloc (1, length);
 
-  if (plain_msg) {
-    /*
-     * Decrypt the security protected NAS message
-     */
-    header->protocol_discriminator = _nas_message_decrypt (
-        plain_msg,
-        buffer,
-        header->security_header_type,
-        header->message_authentication_code,
-        header->sequence_number,
-        length, emm_security_context,
-        status);
-    /*
-     * Decode the decrypted message as plain NAS message
-     */
-    bytes = _nas_message_plain_decode (plain_msg, header, msg, length);
-    free_wrapper ((void**)&plain_msg);
-  }
+  /*
+   * Decrypt the security protected NAS message in place, the MAC has
+   * already been computed on the ciphered message
+   */
+  header->protocol_discriminator = _nas_message_decrypt (
+      buffer,
+      buffer,
+      header->security_header_type,
+      header->message_authentication_code,
+      header->sequence_number,
+      length, emm_security_context,
+      status);
+  /*
+   * Decode the decrypted message as plain NAS message
+   */
+  bytes = _nas_message_plain_decode (buffer, header, msg, length);
 
   OAILOG_FUNC_RETURN (LOG_NAS, bytes);
 }
@@ -972,7 +977,8 @@ static int _nas_message_plain_encode (
  **           length:  Maximal capacity of the output buffer               **
  **           Others:  None                                                **
  **                                                                        **
- ** Outputs:  buffer:  Pointer to the encoded data buffer                  **
+ ** Outputs:  buffer:  Pointer to the encoded data buffer, the plain      **
+ **                    message is encoded then ciphered in place           **
  ** Return:   The number of bytes in the buffer if the                     **
  **           data have been successfully encoded;                         **
  **           A negative error code otherwise.                             **
@@ -988,27 +994,20 @@ static int _nas_message_protected_encode (
   OAILOG_FUNC_IN (LOG_NAS);
   emm_security_context_t                 *emm_security_context = (emm_security_context_t *) security;
   int                                     bytes = TLV_BUFFER_TOO_SHORT;
-  unsigned char                          *plain_msg = (unsigned char *)calloc (1, length);
 
-  if (plain_msg) {
+  /*
+   * Encode the security protected NAS message as plain NAS message,
+   * directly in the output buffer
+   */
+  int                                     size = _nas_message_plain_encode (buffer, &msg->header,
+                                                                            &msg->plain, length);
+
+  if (size > 0) {
     /*
-     * Encode the security protected NAS message as plain NAS message
+     * Encrypt the encoded plain NAS message in place
      */
-    int                                     size = _nas_message_plain_encode (plain_msg, &msg->header,
-                                                                              &msg->plain, length);
-
-    if (size > 0) {
-      //static uint8_t seq = 0;
-      /*
-       * Encrypt the encoded plain NAS message
-       */
-      bytes = _nas_message_encrypt (buffer, plain_msg, msg->header.security_header_type, msg->header.message_authentication_code, msg->header.sequence_number,
-          emm_security_context->direction_encode, size, emm_security_context);
-      //seq, size);
-      //seq ++;
-    }
-
-    free_wrapper ((void**)&plain_msg);
+    bytes = _nas_message_encrypt (buffer, buffer, msg->header.security_header_type, msg->header.message_authentication_code, msg->header.sequence_number,
+        emm_security_context->direction_encode, size, emm_security_context);
   }
 
   OAILOG_FUNC_RETURN (LOG_NAS, bytes);
@@ -1033,7 +1032,8 @@ static int _nas_message_protected_encode (
  **    length:  Maximal capacity of the output buffer      **
  **    Others:  None                                       **
  **                                                                        **
- ** Outputs:   dest:    Pointer to the decrypted data buffer       **
+ ** Outputs:   dest:    Pointer to the decrypted data buffer, may   **
+ **       be src to decrypt in place                 **
  **      Return:  The protocol discriminator of the message  **
  **       that has been decrypted;                   **
  **    Others:  None                                       **
@@ -1063,7 +1063,9 @@ static int _nas_message_decrypt (
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED:
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_NEW:
     OAILOG_DEBUG (LOG_NAS, "No decryption of message length %lu according to security header type 0x%02x\n", length, security_header_type);
-    memcpy (dest, src, length);
+    if (dest != src) {
+      memcpy (dest, src, length);
+    }
     DECODE_U8 (dest, *(uint8_t *) (&header), size);
     OAILOG_FUNC_RETURN (LOG_NAS, header.protocol_discriminator);
     //LOG_FUNC_RETURN (LOG_NAS, length);
@@ -1134,7 +1136,7 @@ static int _nas_message_decrypt (
            * length in bits
            */
           stream_cipher.blength = length << 3;
-          nas_stream_encrypt_eea2 (&stream_cipher, (uint8_t*)dest);
+          nas_stream_encrypt_eea2_cached (&emm_security_context->knas_enc_schedule, &stream_cipher, (uint8_t*)dest);
           /*
            * Decode the first octet (security header type or EPS bearer identity,
            * * * * and protocol discriminator)
@@ -1146,7 +1148,9 @@ static int _nas_message_decrypt (
 
         case NAS_SECURITY_ALGORITHMS_EEA0:
           OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EEA0 dir %d ul_count.seq_num %d dl_count.seq_num %d\n", direction, emm_security_context->ul_count.seq_num, emm_security_context->dl_count.seq_num);
-          memcpy (dest, src, length);
+          if (dest != src) {
+            memcpy (dest, src, length);
+          }
           /*
            * Decode the first octet (security header type or EPS bearer identity,
            * * * * and protocol discriminator)
@@ -1157,7 +1161,9 @@ static int _nas_message_decrypt (
 
         default:
           OAILOG_ERROR(LOG_NAS, "Unknown Cyphering protection algorithm %d\n", emm_security_context->selected_algorithms.encryption);
-          memcpy (dest, src, length);
+          if (dest != src) {
+            memcpy (dest, src, length);
+          }
           /*
            * Decode the first octet (security header type or EPS bearer identity,
            * * * * and protocol discriminator)
@@ -1193,7 +1199,8 @@ static int _nas_message_decrypt (
  **    length:  Maximal capacity of the output buffer      **
  **    Others:  None                                       **
  **                                                                        **
- ** Outputs:   dest:    Pointer to the encrypted data buffer       **
+ ** Outputs:   dest:    Pointer to the encrypted data buffer, may  **
+ **       be src for in place encryption             **
  **      Return:  The number of bytes in the output buffer   **
  **       if data have been successfully encrypted;  **
  **       RETURNerror otherwise.                     **
@@ -1226,7 +1233,9 @@ static int _nas_message_encrypt (
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED:
   case SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_NEW:
     OAILOG_DEBUG (LOG_NAS, "No encryption of message according to security header type 0x%02x\n", security_header_type);
-    memcpy (dest, src, length);
+    if (dest != src) {
+      memcpy (dest, src, length);
+    }
     OAILOG_FUNC_RETURN (LOG_NAS, length);
     break;
 
@@ -1278,14 +1287,16 @@ static int _nas_message_encrypt (
          * length in bits
          */
         stream_cipher.blength = length << 3;
-        nas_stream_encrypt_eea2 (&stream_cipher, (uint8_t*)dest);
+        nas_stream_encrypt_eea2_cached (&emm_security_context->knas_enc_schedule, &stream_cipher, (uint8_t*)dest);
         OAILOG_FUNC_RETURN (LOG_NAS, length);
       }
       break;
 
     case NAS_SECURITY_ALGORITHMS_EEA0:
       OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EEA0 dir %d ul_count.seq_num %d dl_count.seq_num %d\n", direction, emm_security_context->ul_count.seq_num, emm_security_context->dl_count.seq_num);
-      memcpy (dest, src, length);
+      if (dest != src) {
+        memcpy (dest, src, length);
+      }
       OAILOG_FUNC_RETURN (LOG_NAS, length);
       break;
 
@@ -1405,7 +1416,7 @@ static uint32_t _nas_message_get_mac (
        * length in bits
        */
       stream_cipher.blength = length << 3;
-      nas_stream_encrypt_eia2 (&stream_cipher, mac);
+      nas_stream_encrypt_eia2_cached (&emm_security_context->knas_int_schedule, &stream_cipher, mac);
       OAILOG_DEBUG (LOG_NAS, "NAS_SECURITY_ALGORITHMS_EIA2 returned MAC %x.%x.%x.%x(%u) for length %lu direction %d, count %d\n",
           mac[0], mac[1], mac[2], mac[3], *((uint32_t *) & mac), length, direction, count);
       mac32 = (uint32_t *) & mac;
@@ -128,7 +128,7 @@ int nas_message_decrypt(
     nas_message_decode_status_t *   status);
 
 int nas_message_decode(
-    const unsigned char * const  buffer,
+    unsigned char       * const  buffer,
     nas_message_t      *msg,
     size_t              length,
     void               *security,
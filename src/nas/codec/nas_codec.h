@@ -0,0 +1,44 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file nas_codec.h
+  \brief EMM and ESM message decoders and encoders generated at build time by
+         nas_codec_gen.py from the nas_messages.def message description.
+         They decode and encode the message following its header, the message
+         type selects the message, like emm_msg_decode() and esm_msg_decode()
+         after the header is decoded, and return the same values as the
+         decode_xxx() and encode_xxx() message codecs.
+*/
+#ifndef FILE_NAS_CODEC_SEEN
+#define FILE_NAS_CODEC_SEEN
+
+#include "emm_msg.h"
+#include "esm_msg.h"
+
+int nas_codec_decode_emm (EMM_msg * const msg, uint8_t * const buffer, const uint32_t len);
+
+int nas_codec_encode_emm (EMM_msg * const msg, uint8_t * const buffer, const uint32_t len);
+
+int nas_codec_decode_esm (ESM_msg * const msg, uint8_t * const buffer, const uint32_t len);
+
+int nas_codec_encode_esm (ESM_msg * const msg, uint8_t * const buffer, const uint32_t len);
+
+#endif /* FILE_NAS_CODEC_SEEN */
@@ -0,0 +1,321 @@
+#
+# Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.
+# The OpenAirInterface Software Alliance licenses this file to You under
+# the Apache License, Version 2.0  (the "License"); you may not use this file
+# except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#-------------------------------------------------------------------------------
+# For more information about the OpenAirInterface (OAI) Software Alliance:
+#      contact@openairinterface.org
+#
+
+#
+# Generates the EMM and ESM message decoders and encoders of
+# nas_codec_generated.c from the nas_messages.def message description.
+#
+# Each message gets its own decoder and encoder: the minimum length is checked
+# once, the mandatory IEs are decoded in sequence, half octet IEs sharing an
+# octet are read from a single load, and the optional IEs are dispatched on a
+# 256 entries IEI index table in which the type 1 IEIs cover their 16 values,
+# there is no IEI masking. The IE values themselves are decoded and encoded by
+# the IE codecs of src/nas/ies.
+#
+
+from __future__ import print_function
+
+import os, sys
+import getopt
+
+version = "1.0.0"
+
+FAIL = '\033[91m'
+ENDC = '\033[0m'
+
+PROTOCOLS = { "EMM": "EMM_msg", "ESM": "ESM_msg" }
+
+verbosity = 0
+filename = ""
+outdir = './'
+
+def printFail(string):
+    sys.stderr.write(FAIL + string + ENDC + "\n")
+
+def printDebug(string):
+    if verbosity > 0:
+        print(string)
+
+def usage():
+    print("NAS message codec generator v%s" % (version))
+    print("Usage: python nas_codec_gen.py [options]")
+    print("Available options:")
+    print("-d        Enable script debug")
+    print("-f [file] Message description file to parse")
+    print("-o [dir]  Output files to given directory")
+    print("-h        Print this help and return")
+
+def fail(lineno, string):
+    printFail("%s:%d: %s" % (filename, lineno, string))
+    sys.exit(1)
+
+def parse(lines):
+    ies = {}
+    messages = []
+    message = None
+    for lineno, line in enumerate(lines, 1):
+        # Removing any comment
+        if line.find('#') >= 0:
+            line = line[:line.find('#')]
+        words = line.split()
+        if len(words) == 0:
+            continue
+        if words[0] == "IE":
+            for flag in words[2:]:
+                if flag not in ("value", "half"):
+                    fail(lineno, "unknown IE flag " + flag)
+            ies[words[1]] = { "value": "value" in words[2:], "half": "half" in words[2:] }
+        elif words[0] == "MESSAGE":
+            if len(words) < 3 or words[1] not in PROTOCOLS:
+                fail(lineno, "expecting MESSAGE <EMM|ESM> <message> [encode]")
+            message = { "protocol": words[1], "name": words[2], "upper": words[2].upper(),
+                        "decode": "encode" not in words[3:], "mandatory": [], "optional": [] }
+            messages.append(message)
+            printDebug("Got new message " + words[2])
+        elif words[0] in ("H", "L", "V", "O"):
+            if message is None:
+                fail(lineno, "IE outside of a MESSAGE")
+            if len(words) != (4 if words[0] == "O" else 3):
+                fail(lineno, "malformed %s IE" % (words[0]))
+            if words[0] != "H" and words[0] != "L" and words[1] not in ies:
+                fail(lineno, "undeclared IE codec " + words[1])
+            if words[0] == "O":
+                if len(message["optional"]) == 255:
+                    fail(lineno, "too many optional IEs")
+                message["optional"].append({ "codec": words[1], "field": words[2], "ie": words[3] })
+            else:
+                if len(message["optional"]) > 0:
+                    fail(lineno, "mandatory IE after optional IEs")
+                message["mandatory"].append({ "format": words[0], "codec": words[1], "field": words[2] })
+        else:
+            fail(lineno, "unexpected " + words[0])
+    return ies, messages
+
+def octets(mandatory):
+    """ groups the mandatory IEs by octet, H and L IEs next to each other share one """
+    groups = []
+    for ie in mandatory:
+        if ie["format"] == "V":
+            groups.append([ie])
+        elif len(groups) > 0 and len(groups[-1]) == 1 and groups[-1][0]["format"] in ("H", "L") \
+                and groups[-1][0]["format"] != ie["format"]:
+            groups[-1].append(ie)
+        else:
+            groups.append([ie])
+    return groups
+
+def outputHeaderToFile(f):
+    f.write("""/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+""")
+    f.write("/*******************************************************************************\n")
+    f.write(" * This file had been created by nas_codec_gen.py script v%s\n" % (version))
+    f.write(" * Please do not modify this file but regenerate it via script.\n")
+    f.write(" * from %s\n" % (os.path.basename(filename)))
+    f.write(" ******************************************************************************/\n")
+    f.write("""#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bstrlib.h"
+
+#include "log.h"
+#include "TLVEncoder.h"
+#include "TLVDecoder.h"
+#include "common_types.h"
+#include "3gpp_24.008.h"
+#include "3gpp_36.331.h"
+#include "3gpp_36.401.h"
+#include "3gpp_29.274.h"
+#include "emm_msg.h"
+#include "esm_msg.h"
+#include "nas_codec.h"
+""")
+
+def outputIeiIndex(f, ies, message):
+    f.write("\n//------------------------------------------------------------------------------\n")
+    f.write("static const uint8_t %s_iei_index[256] = {\n" % (message["name"]))
+    for i, ie in enumerate(message["optional"], 1):
+        iei = "%s_%s_IEI" % (message["upper"], ie["ie"])
+        if ies[ie["codec"]]["half"]:
+            f.write("  [%s ... %s + 0x0f] = %d,\n" % (iei, iei, i))
+        else:
+            f.write("  [%s] = %d,\n" % (iei, i))
+    f.write("};\n")
+
+def outputDecoder(f, ies, message):
+    name = message["name"]
+    upper = message["upper"]
+    if len(message["optional"]) > 0:
+        outputIeiIndex(f, ies, message)
+    f.write("\n//------------------------------------------------------------------------------\n")
+    f.write("static int nas_codec_decode_%s (\n" % (name))
+    f.write("  %s_msg * const %s,\n  uint8_t * const buffer,\n  const uint32_t len)\n{\n" % (name, name))
+    f.write("  uint32_t                                decoded = 0;\n")
+    if len(message["mandatory"]) + len(message["optional"]) > 0:
+        f.write("  int                                     decoded_result = 0;\n")
+    f.write("\n  CHECK_PDU_POINTER_AND_LENGTH_DECODER (buffer, %s_MINIMUM_LENGTH, len);\n" % (upper))
+    for octet in octets(message["mandatory"]):
+        if octet[0]["format"] == "V":
+            ie = octet[0]
+            f.write("  if ((decoded_result = decode_%s (&%s->%s, 0, buffer + decoded, len - decoded)) < 0)\n"
+                    % (ie["codec"], name, ie["field"]))
+            f.write("    return decoded_result;\n")
+            f.write("  if ((decoded += decoded_result) > len)\n")
+            f.write("    return TLV_BUFFER_TOO_SHORT;\n")
+            continue
+        f.write("  {\n    const uint8_t                         octet = buffer[decoded];\n\n")
+        for ie in octet:
+            value = "octet >> 4" if ie["format"] == "H" else "octet & 0x0f"
+            f.write("    if ((decoded_result = decode_u8_%s (&%s->%s, 0, %s, len - decoded)) < 0)\n"
+                    % (ie["codec"], name, ie["field"], value))
+            f.write("      return decoded_result;\n")
+        f.write("  }\n  decoded++;\n")
+    if len(message["optional"]) > 0:
+        f.write("\n  while (decoded < len) {\n")
+        f.write("    switch (%s_iei_index[buffer[decoded]]) {\n" % (name))
+        for i, ie in enumerate(message["optional"], 1):
+            f.write("    case %d:\n" % (i))
+            f.write("      if ((decoded_result = decode_%s (&%s->%s, %s_%s_IEI, buffer + decoded, len - decoded)) <= 0)\n"
+                    % (ie["codec"], name, ie["field"], upper, ie["ie"]))
+            f.write("        return decoded_result;\n")
+            f.write("      %s->presencemask |= %s_%s_PRESENT;\n" % (name, upper, ie["ie"]))
+            f.write("      break;\n\n")
+        f.write("    default:\n")
+        f.write("      errorCodeDecoder = TLV_UNEXPECTED_IEI;\n")
+        f.write("      return TLV_UNEXPECTED_IEI;\n")
+        f.write("    }\n")
+        f.write("    decoded += decoded_result;\n")
+        f.write("  }\n")
+        f.write("  if (decoded > len)\n")
+        f.write("    return TLV_BUFFER_TOO_SHORT;\n")
+    f.write("  return decoded;\n}\n")
+
+def outputEncoder(f, ies, message):
+    name = message["name"]
+    upper = message["upper"]
+    f.write("\n//------------------------------------------------------------------------------\n")
+    f.write("static int nas_codec_encode_%s (\n" % (name))
+    f.write("  %s_msg * const %s,\n  uint8_t * const buffer,\n  const uint32_t len)\n{\n" % (name, name))
+    f.write("  int                                     encoded = 0;\n")
+    if len([ie for ie in message["mandatory"] if ie["format"] == "V"]) + len(message["optional"]) > 0:
+        f.write("  int                                     encode_result = 0;\n")
+    f.write("\n  CHECK_PDU_POINTER_AND_LENGTH_ENCODER (buffer, %s_MINIMUM_LENGTH, len);\n" % (upper))
+    for octet in octets(message["mandatory"]):
+        if octet[0]["format"] == "V":
+            ie = octet[0]
+            f.write("  if ((encode_result = encode_%s (%s%s->%s, 0, buffer + encoded, len - encoded)) < 0)\n"
+                    % (ie["codec"], "" if ies[ie["codec"]]["value"] else "&", name, ie["field"]))
+            f.write("    return encode_result;\n")
+            f.write("  encoded += encode_result;\n")
+            continue
+        halves = []
+        for ie in sorted(octet, key=lambda ie: ie["format"]):
+            value = "(encode_u8_%s (&%s->%s) & 0x0f)" % (ie["codec"], name, ie["field"])
+            halves.append("(%s << 4)" % (value) if ie["format"] == "H" else value)
+        f.write("  buffer[encoded++] = %s;\n" % (" | ".join(halves)))
+    for ie in message["optional"]:
+        f.write("  if (%s->presencemask & %s_%s_PRESENT) {\n" % (name, upper, ie["ie"]))
+        f.write("    if ((encode_result = encode_%s (%s%s->%s, %s_%s_IEI, buffer + encoded, len - encoded)) < 0)\n"
+                % (ie["codec"], "" if ies[ie["codec"]]["value"] else "&", name, ie["field"], upper, ie["ie"]))
+        f.write("      return encode_result;\n")
+        f.write("    encoded += encode_result;\n")
+        f.write("  }\n")
+    f.write("  return encoded;\n}\n")
+
+def outputDispatch(f, messages, protocol, direction):
+    msg = PROTOCOLS[protocol]
+    f.write("\n//------------------------------------------------------------------------------\n")
+    f.write("int nas_codec_%s_%s (\n" % (direction, protocol.lower()))
+    f.write("  %s * const msg,\n  uint8_t * const buffer,\n  const uint32_t len)\n{\n" % (msg))
+    f.write("  switch (msg->header.message_type) {\n")
+    for message in messages:
+        if message["protocol"] != protocol or (direction == "decode" and not message["decode"]):
+            continue
+        f.write("  case %s:\n" % (message["upper"]))
+        f.write("    return nas_codec_%s_%s (&msg->%s, buffer, len);\n\n"
+                % (direction, message["name"], message["name"]))
+    f.write("  default:\n")
+    f.write("    return TLV_WRONG_MESSAGE_TYPE;\n")
+    f.write("  }\n}\n")
+
+try:
+    opts, args = getopt.getopt(sys.argv[1:], "df:ho:", ["debug", "file", "help", "outdir"])
+except getopt.GetoptError as err:
+    # print help information and exit:
+    usage()
+    sys.exit(2)
+
+for o, a in opts:
+    if o in ("-f", "--file"):
+        filename = a
+    if o in ("-d", "--debug"):
+        verbosity = 1
+    if o in ("-o", "--outdir"):
+        outdir = a
+        if outdir.rfind('/') != len(outdir) - 1:
+            outdir += '/'
+    if o in ("-h", "--help"):
+        usage()
+        sys.exit(2)
+
+if filename == "":
+    usage()
+    sys.exit(2)
+
+with open(filename, 'r') as description:
+    ies, messages = parse(description.readlines())
+
+if len(messages) == 0:
+    printFail("No message parsed, exiting")
+    sys.exit(1)
+
+f = open(outdir + 'nas_codec_generated.c', 'w')
+outputHeaderToFile(f)
+for message in messages:
+    if message["decode"]:
+        outputDecoder(f, ies, message)
+    outputEncoder(f, ies, message)
+for protocol in sorted(PROTOCOLS):
+    outputDispatch(f, messages, protocol, "decode")
+    outputDispatch(f, messages, protocol, "encode")
+f.close()
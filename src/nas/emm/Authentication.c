@@ -72,6 +72,7 @@
 #include "emm_proc.h"
 #include "nas_timer.h"
 #include "emm_data.h"
+#include "emm_auth_vector_cache.h"
 #include "emm_sap.h"
 #include "emm_cause.h"
 #include "nas_itti_messaging.h"
@@ -105,6 +106,10 @@ static int _authentication_abort (struct emm_context_s *emm_context, struct nas_
 static int _start_authentication_information_procedure(struct emm_context_s *emm_context, nas_emm_auth_proc_t * const auth_proc, const_bstring auts);
 static int _auth_info_proc_success_cb (struct emm_context_s *emm_ctx);
 static int _auth_info_proc_failure_cb (struct emm_context_s *emm_ctx);
+static ksi_t _authentication_next_eksi (const struct emm_context_s * const emm_context);
+static void _authentication_set_vector (struct emm_context_s * const emm_context, const int index, const eutran_vector_t * const vector);
+static void _authentication_visited_plmn (const struct emm_context_s * const emm_context, plmn_t * const visited_plmn);
+static void _authentication_refill_vectors (struct emm_context_s * const emm_context);
 
 
 static int _authentication_check_imsi_5_4_2_5__1 (struct emm_context_s *emm_context);
@@ -272,6 +277,23 @@ emm_proc_authentication (
     auth_proc->emm_com_proc.emm_proc.base_proc.time_out      = NULL;
 
     bool  run_auth_info_proc = false;
+    eutran_vector_t cached_vector = {0};
+    if ((!IS_EMM_CTXT_VALID_AUTH_VECTORS(emm_context)) && (!get_nas_cn_procedure_auth_info(emm_context))
+        && (emm_auth_vector_cache_pop (emm_context->_imsi64, &cached_vector))) {
+      /*
+       * A vector left over from a previous AIR of this IMSI, no need to wait for the HSS
+       */
+      ksi_t eksi = _authentication_next_eksi (emm_context);
+      _authentication_set_vector (emm_context, eksi % MAX_EPS_AUTH_VECTORS, &cached_vector);
+      memset (&cached_vector, 0, sizeof (cached_vector));
+      emm_ctx_set_attribute_present(emm_context, EMM_CTXT_MEMBER_AUTH_VECTORS);
+      _authentication_refill_vectors (emm_context);
+      rc = emm_proc_authentication_ksi (emm_context, emm_specific_proc, eksi,
+        emm_context->_vector[eksi % MAX_EPS_AUTH_VECTORS].rand,
+        emm_context->_vector[eksi % MAX_EPS_AUTH_VECTORS].autn,
+        success, failure);
+      OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
+    }
     if (!IS_EMM_CTXT_VALID_AUTH_VECTORS(emm_context)) {
       // Ask upper layer to fetch new security context
       nas_auth_info_proc_t * auth_info_proc = get_nas_cn_procedure_auth_info(emm_context);
@@ -333,19 +355,15 @@ static int _start_authentication_information_procedure(struct emm_context_s *emm
   auth_info_proc->resync = auth_info_proc->request_sent;
 
   plmn_t visited_plmn = {0};
-  visited_plmn.mcc_digit1 = emm_context->originating_tai.mcc_digit1;
-  visited_plmn.mcc_digit2 = emm_context->originating_tai.mcc_digit2;
-  visited_plmn.mcc_digit3 = emm_context->originating_tai.mcc_digit3;
-  visited_plmn.mnc_digit1 = emm_context->originating_tai.mnc_digit1;
-  visited_plmn.mnc_digit2 = emm_context->originating_tai.mnc_digit2;
-  visited_plmn.mnc_digit3 = emm_context->originating_tai.mnc_digit3;
+  _authentication_visited_plmn (emm_context, &visited_plmn);
 
   bool is_initial_req = !(auth_info_proc->request_sent);
   auth_info_proc->request_sent = true;
 
   nas_start_Ts6a_auth_info (auth_info_proc->ue_id, &auth_info_proc->timer_s6a, auth_info_proc->cn_proc.base_proc.time_out, emm_context);
 
-  nas_itti_auth_info_req (ue_id, &emm_context->_imsi, is_initial_req, &visited_plmn, MAX_EPS_AUTH_VECTORS, auts);
+  // vectors not used by this procedure are kept in the authentication vector cache
+  nas_itti_auth_info_req (ue_id, &emm_context->_imsi, is_initial_req, &visited_plmn, emm_auth_vector_cache_nb_vectors_per_request (), auts);
 
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
 }
@@ -368,6 +386,57 @@ static int _start_authentication_information_procedure_synch(struct emm_context_
 }
 
 
+//------------------------------------------------------------------------------
+static ksi_t _authentication_next_eksi (const struct emm_context_s * const emm_context)
+{
+  ksi_t eksi = 0;
+
+  if (emm_context->_security.eksi < KSI_NO_KEY_AVAILABLE) {
+    REQUIREMENT_3GPP_24_301(R10_5_4_2_4__2);
+    eksi = (emm_context->_security.eksi + 1) % (EKSI_MAX_VALUE + 1);
+  }
+  return eksi;
+}
+
+//------------------------------------------------------------------------------
+static void _authentication_set_vector (struct emm_context_s * const emm_context, const int index, const eutran_vector_t * const vector)
+{
+  memcpy (emm_context->_vector[index].kasme, vector->kasme, AUTH_KASME_SIZE);
+  memcpy (emm_context->_vector[index].autn,  vector->autn, AUTH_AUTN_SIZE);
+  memcpy (emm_context->_vector[index].rand, vector->rand, AUTH_RAND_SIZE);
+  memcpy (emm_context->_vector[index].xres, vector->xres.data, vector->xres.size);
+  emm_context->_vector[index].xres_size = vector->xres.size;
+  OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received XRES ..: " XRES_FORMAT "\n", XRES_DISPLAY (emm_context->_vector[index].xres));
+  OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received RAND ..: " RAND_FORMAT "\n", RAND_DISPLAY (emm_context->_vector[index].rand));
+  OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received AUTN ..: " AUTN_FORMAT "\n", AUTN_DISPLAY (emm_context->_vector[index].autn));
+  OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received KASME .: " KASME_FORMAT " " KASME_FORMAT "\n",
+      KASME_DISPLAY_1 (emm_context->_vector[index].kasme), KASME_DISPLAY_2 (emm_context->_vector[index].kasme));
+  emm_ctx_set_attribute_valid(emm_context, EMM_CTXT_MEMBER_AUTH_VECTOR0+index);
+}
+
+//------------------------------------------------------------------------------
+static void _authentication_visited_plmn (const struct emm_context_s * const emm_context, plmn_t * const visited_plmn)
+{
+  visited_plmn->mcc_digit1 = emm_context->originating_tai.mcc_digit1;
+  visited_plmn->mcc_digit2 = emm_context->originating_tai.mcc_digit2;
+  visited_plmn->mcc_digit3 = emm_context->originating_tai.mcc_digit3;
+  visited_plmn->mnc_digit1 = emm_context->originating_tai.mnc_digit1;
+  visited_plmn->mnc_digit2 = emm_context->originating_tai.mnc_digit2;
+  visited_plmn->mnc_digit3 = emm_context->originating_tai.mnc_digit3;
+}
+
+//------------------------------------------------------------------------------
+static void _authentication_refill_vectors (struct emm_context_s * const emm_context)
+{
+  plmn_t visited_plmn = {0};
+
+  if (IS_EMM_CTXT_VALID_IMSI(emm_context)) {
+    // asynchronous, the AIA is stored in the authentication vector cache for the next AKA runs
+    _authentication_visited_plmn (emm_context, &visited_plmn);
+    emm_auth_vector_cache_refill (emm_context->_imsi64, &emm_context->_imsi, &visited_plmn);
+  }
+}
+
 //------------------------------------------------------------------------------
 static int _auth_info_proc_success_cb (struct emm_context_s *emm_ctx)
 {
@@ -383,31 +452,17 @@ static int _auth_info_proc_success_cb (struct emm_context_s *emm_ctx)
     }
 
     // compute next eksi
-    ksi_t eksi = 0;
-    if (emm_ctx->_security.eksi <  KSI_NO_KEY_AVAILABLE) {
-      REQUIREMENT_3GPP_24_301(R10_5_4_2_4__2);
-      eksi = (emm_ctx->_security.eksi + 1) % (EKSI_MAX_VALUE + 1);
-    }
+    ksi_t eksi = _authentication_next_eksi (emm_ctx);
 
     /*
      * Copy provided vector to user context
      */
     for (int i = 0; i < auth_info_proc->nb_vectors; i++) {
       AssertFatal (MAX_EPS_AUTH_VECTORS > i, " TOO many vectors");
-      int destination_index = (i + eksi)%MAX_EPS_AUTH_VECTORS;
-      memcpy (emm_ctx->_vector[destination_index].kasme, auth_info_proc->vector[i]->kasme, AUTH_KASME_SIZE);
-      memcpy (emm_ctx->_vector[destination_index].autn,  auth_info_proc->vector[i]->autn, AUTH_AUTN_SIZE);
-      memcpy (emm_ctx->_vector[destination_index].rand, auth_info_proc->vector[i]->rand, AUTH_RAND_SIZE);
-      memcpy (emm_ctx->_vector[destination_index].xres, auth_info_proc->vector[i]->xres.data, auth_info_proc->vector[i]->xres.size);
-      emm_ctx->_vector[destination_index].xres_size = auth_info_proc->vector[i]->xres.size;
       OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received Vector %u:\n", i);
-      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received XRES ..: " XRES_FORMAT "\n", XRES_DISPLAY (emm_ctx->_vector[destination_index].xres));
-      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received RAND ..: " RAND_FORMAT "\n", RAND_DISPLAY (emm_ctx->_vector[destination_index].rand));
-      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received AUTN ..: " AUTN_FORMAT "\n", AUTN_DISPLAY (emm_ctx->_vector[destination_index].autn));
-      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received KASME .: " KASME_FORMAT " " KASME_FORMAT "\n",
-          KASME_DISPLAY_1 (emm_ctx->_vector[destination_index].kasme), KASME_DISPLAY_2 (emm_ctx->_vector[destination_index].kasme));
-      emm_ctx_set_attribute_valid(emm_ctx, EMM_CTXT_MEMBER_AUTH_VECTOR0+destination_index);
+      _authentication_set_vector (emm_ctx, (i + eksi)%MAX_EPS_AUTH_VECTORS, auth_info_proc->vector[i]);
     }
+    _authentication_refill_vectors (emm_ctx);
 
     nas_emm_auth_proc_t * auth_proc = get_nas_common_procedure_authentication(emm_ctx);
 
@@ -577,12 +632,15 @@ int emm_proc_authentication_failure (
           OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
         }
 
-        memcpy (resync_param.data, (emm_ctx->_vector[emm_ctx->_security.vector_index].rand), RAND_LENGTH_OCTETS);
+        // RAND of the challenge the USIM answered, the HSS derives SQN MS with it
+        memcpy (resync_param.data, auth_proc->rand, RAND_LENGTH_OCTETS);
         memcpy ((resync_param.data + RAND_LENGTH_OCTETS), auts->data, AUTS_LENGTH);
         // TODO: Double check this case as there is no identity request being sent.
         _start_authentication_information_procedure_synch(emm_ctx, auth_proc, &resync_param);
         free_wrapper((void**)&resync_param.data);
         emm_ctx_clear_auth_vectors(emm_ctx);
+        // cached vectors were generated with the SQN the USIM just rejected
+        emm_auth_vector_cache_purge (emm_ctx->_imsi64);
         rc = RETURNok;
         unlock_ue_contexts(ue_mm_context);
         OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
@@ -605,6 +663,7 @@ int emm_proc_authentication_failure (
       REQUIREMENT_3GPP_24_301(R10_5_4_2_7_c__2);
       auth_proc->mac_fail_count++;
       auth_proc->sync_fail_count = 0;
+      emm_auth_vector_cache_purge (emm_ctx->_imsi64);
       if (!IS_EMM_CTXT_PRESENT_IMSI(emm_ctx)) { // VALID means received in IDENTITY RESPONSE
         if (1 == auth_proc->mac_fail_count) {
           // Only to return to a "valid" EMM state
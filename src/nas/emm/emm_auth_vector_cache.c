@@ -0,0 +1,277 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file emm_auth_vector_cache.c
+   \brief IMSI keyed cache of E-UTRAN authentication vectors.
+*/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "log.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.008.h"
+#include "3gpp_29.274.h"
+#include "emm_data.h"
+#include "nas_itti_messaging.h"
+#include "emm_auth_vector_cache.h"
+
+/* Entries are removed by a sweep only when the table is full, the sweep removes at most this many entries */
+#define EMM_AUTH_VECTOR_CACHE_SWEEP_MAX  64
+
+typedef struct emm_auth_vector_cache_entry_s {
+  eutran_vector_t  vector[EMM_AUTH_VECTOR_CACHE_DEPTH];    // ring, oldest vector at head
+  time_t           stored_at[EMM_AUTH_VECTOR_CACHE_DEPTH];
+  uint8_t          head;
+  uint8_t          nb_vectors;
+  bool             refill_pending;
+  time_t           refill_sent_at;
+} emm_auth_vector_cache_entry_t;
+
+typedef struct emm_auth_vector_cache_sweep_s {
+  time_t           now;
+  int              nb_keys;
+  hash_key_t       keys[EMM_AUTH_VECTOR_CACHE_SWEEP_MAX];
+} emm_auth_vector_cache_sweep_t;
+
+static struct {
+  pthread_mutex_t  mutex;      // the cache is shared by the MME_APP workers and TASK_NAS_MME
+  hash_table_t    *entries;    // key is imsi64, data is emm_auth_vector_cache_entry_t
+  hash_size_t      max_imsis;
+  uint8_t          nb_vectors_per_request;
+  uint8_t          low_water_mark;
+  uint32_t         ttl_sec;
+} _emm_auth_vector_cache = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0};
+
+//------------------------------------------------------------------------------
+static time_t _emm_auth_vector_cache_now (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+//------------------------------------------------------------------------------
+static void _emm_auth_vector_cache_expire (emm_auth_vector_cache_entry_t * const entry, const time_t now)
+{
+  // vectors are stored in order, the oldest ones expire first
+  while ((entry->nb_vectors) && ((now - entry->stored_at[entry->head]) > (time_t)_emm_auth_vector_cache.ttl_sec)) {
+    memset (&entry->vector[entry->head], 0, sizeof (entry->vector[entry->head]));
+    entry->head = (entry->head + 1) % EMM_AUTH_VECTOR_CACHE_DEPTH;
+    entry->nb_vectors--;
+  }
+  if ((entry->refill_pending) && ((now - entry->refill_sent_at) > TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE)) {
+    // the AIA has been lost, allow another refill
+    entry->refill_pending = false;
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool _emm_auth_vector_cache_sweep_cb (hash_key_t keyP, void *dataP, void *parameterP, void **resultP)
+{
+  emm_auth_vector_cache_entry_t          *entry = (emm_auth_vector_cache_entry_t *)dataP;
+  emm_auth_vector_cache_sweep_t          *sweep = (emm_auth_vector_cache_sweep_t *)parameterP;
+
+  _emm_auth_vector_cache_expire (entry, sweep->now);
+  if ((!entry->nb_vectors) && (!entry->refill_pending)) {
+    sweep->keys[sweep->nb_keys++] = keyP;
+  }
+  return (sweep->nb_keys == EMM_AUTH_VECTOR_CACHE_SWEEP_MAX);
+}
+
+//------------------------------------------------------------------------------
+static emm_auth_vector_cache_entry_t *_emm_auth_vector_cache_get (const imsi64_t imsi64, const bool create, const time_t now)
+{
+  emm_auth_vector_cache_entry_t          *entry = NULL;
+
+  if (HASH_TABLE_OK == hashtable_get (_emm_auth_vector_cache.entries, (const hash_key_t)imsi64, (void **)&entry)) {
+    _emm_auth_vector_cache_expire (entry, now);
+    return entry;
+  }
+  if (!create) {
+    return NULL;
+  }
+
+  if (_emm_auth_vector_cache.entries->num_elements >= _emm_auth_vector_cache.max_imsis) {
+    emm_auth_vector_cache_sweep_t         sweep = {.now = now, .nb_keys = 0};
+
+    hashtable_apply_callback_on_elements (_emm_auth_vector_cache.entries, _emm_auth_vector_cache_sweep_cb, &sweep, NULL);
+    for (int i = 0; i < sweep.nb_keys; i++) {
+      hashtable_free (_emm_auth_vector_cache.entries, sweep.keys[i]);
+    }
+    if (!sweep.nb_keys) {
+      OAILOG_WARNING (LOG_NAS_EMM, "Authentication vector cache full (%zu IMSIs), not caching vectors of " IMSI_64_FMT "\n",
+          _emm_auth_vector_cache.max_imsis, imsi64);
+      return NULL;
+    }
+  }
+
+  entry = calloc (1, sizeof (*entry));
+  if (entry) {
+    hashtable_insert (_emm_auth_vector_cache.entries, (const hash_key_t)imsi64, entry);
+  }
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+int emm_auth_vector_cache_init (const uint8_t nb_vectors_per_request, const uint8_t low_water_mark, const uint32_t ttl_sec, const hash_size_t max_imsis)
+{
+  bstring                                 b = NULL;
+
+  AssertFatal ((nb_vectors_per_request > 0) && (nb_vectors_per_request <= MAX_EPS_AUTH_VECTORS_PER_REQUEST),
+      "Bad number of vectors per request %u", nb_vectors_per_request);
+  AssertFatal (low_water_mark < nb_vectors_per_request, "Low water mark %u must be lower than %u", low_water_mark, nb_vectors_per_request);
+
+  _emm_auth_vector_cache.nb_vectors_per_request = nb_vectors_per_request;
+  _emm_auth_vector_cache.low_water_mark = low_water_mark;
+  _emm_auth_vector_cache.ttl_sec = ttl_sec;
+  _emm_auth_vector_cache.max_imsis = (max_imsis) ? max_imsis : 1;
+  b = bfromcstr ("emm_auth_vector_cache");
+  _emm_auth_vector_cache.entries = hashtable_create (_emm_auth_vector_cache.max_imsis, NULL, free_wrapper, b);
+  bdestroy_wrapper (&b);
+  if (!_emm_auth_vector_cache.entries) {
+    OAILOG_ERROR (LOG_NAS_EMM, "Failed to create the authentication vector cache\n");
+    return RETURNerror;
+  }
+  OAILOG_INFO (LOG_NAS_EMM, "Authentication vector cache: %u vectors per AIR, low water mark %u, TTL %u s, %zu IMSIs\n",
+      nb_vectors_per_request, low_water_mark, ttl_sec, _emm_auth_vector_cache.max_imsis);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void emm_auth_vector_cache_exit (void)
+{
+  if (_emm_auth_vector_cache.entries) {
+    hashtable_destroy (_emm_auth_vector_cache.entries);
+    _emm_auth_vector_cache.entries = NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+uint8_t emm_auth_vector_cache_nb_vectors_per_request (void)
+{
+  return _emm_auth_vector_cache.nb_vectors_per_request;
+}
+
+//------------------------------------------------------------------------------
+void emm_auth_vector_cache_store (const imsi64_t imsi64, const uint8_t nb_vectors, const eutran_vector_t * const vectors)
+{
+  const time_t                            now = _emm_auth_vector_cache_now ();
+  emm_auth_vector_cache_entry_t          *entry = NULL;
+  int                                     tail = 0;
+
+  pthread_mutex_lock (&_emm_auth_vector_cache.mutex);
+  entry = _emm_auth_vector_cache_get (imsi64, (nb_vectors > 0), now);
+  if (!entry) {
+    pthread_mutex_unlock (&_emm_auth_vector_cache.mutex);
+    return;
+  }
+  entry->refill_pending = false;
+  for (int i = 0; i < nb_vectors; i++) {
+    if (EMM_AUTH_VECTOR_CACHE_DEPTH == entry->nb_vectors) {
+      // keep the oldest vectors, they have the lowest SQNs
+      OAILOG_WARNING (LOG_NAS_EMM, "Authentication vector cache full for " IMSI_64_FMT ", dropping %d vector(s)\n", imsi64, nb_vectors - i);
+      break;
+    }
+    tail = (entry->head + entry->nb_vectors) % EMM_AUTH_VECTOR_CACHE_DEPTH;
+    memcpy (&entry->vector[tail], &vectors[i], sizeof (entry->vector[tail]));
+    entry->stored_at[tail] = now;
+    entry->nb_vectors++;
+  }
+  OAILOG_DEBUG (LOG_NAS_EMM, "Authentication vector cache " IMSI_64_FMT ": stored %u vector(s), %u cached\n", imsi64, nb_vectors, entry->nb_vectors);
+  pthread_mutex_unlock (&_emm_auth_vector_cache.mutex);
+}
+
+//------------------------------------------------------------------------------
+bool emm_auth_vector_cache_pop (const imsi64_t imsi64, eutran_vector_t * const vector)
+{
+  emm_auth_vector_cache_entry_t          *entry = NULL;
+
+  pthread_mutex_lock (&_emm_auth_vector_cache.mutex);
+  entry = _emm_auth_vector_cache_get (imsi64, false, _emm_auth_vector_cache_now ());
+  if ((!entry) || (!entry->nb_vectors)) {
+    pthread_mutex_unlock (&_emm_auth_vector_cache.mutex);
+    return false;
+  }
+  memcpy (vector, &entry->vector[entry->head], sizeof (*vector));
+  memset (&entry->vector[entry->head], 0, sizeof (entry->vector[entry->head]));
+  entry->head = (entry->head + 1) % EMM_AUTH_VECTOR_CACHE_DEPTH;
+  entry->nb_vectors--;
+  OAILOG_DEBUG (LOG_NAS_EMM, "Authentication vector cache " IMSI_64_FMT ": hit, %u vector(s) left\n", imsi64, entry->nb_vectors);
+  pthread_mutex_unlock (&_emm_auth_vector_cache.mutex);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void emm_auth_vector_cache_refill (const imsi64_t imsi64, const imsi_t * const imsi, plmn_t * const visited_plmn)
+{
+  const time_t                            now = _emm_auth_vector_cache_now ();
+  emm_auth_vector_cache_entry_t          *entry = NULL;
+
+  if (!_emm_auth_vector_cache.low_water_mark) {
+    return;
+  }
+  pthread_mutex_lock (&_emm_auth_vector_cache.mutex);
+  entry = _emm_auth_vector_cache_get (imsi64, true, now);
+  if ((!entry) || (entry->refill_pending) || (entry->nb_vectors >= _emm_auth_vector_cache.low_water_mark)) {
+    pthread_mutex_unlock (&_emm_auth_vector_cache.mutex);
+    return;
+  }
+  entry->refill_pending = true;
+  entry->refill_sent_at = now;
+  OAILOG_DEBUG (LOG_NAS_EMM, "Authentication vector cache " IMSI_64_FMT ": %u vector(s) left, refill\n", imsi64, entry->nb_vectors);
+  pthread_mutex_unlock (&_emm_auth_vector_cache.mutex);
+  nas_itti_auth_info_req (INVALID_MME_UE_S1AP_ID, imsi, true, visited_plmn, _emm_auth_vector_cache.nb_vectors_per_request, NULL);
+}
+
+//------------------------------------------------------------------------------
+void emm_auth_vector_cache_purge (const imsi64_t imsi64)
+{
+  pthread_mutex_lock (&_emm_auth_vector_cache.mutex);
+  if (HASH_TABLE_OK == hashtable_free (_emm_auth_vector_cache.entries, (const hash_key_t)imsi64)) {
+    OAILOG_DEBUG (LOG_NAS_EMM, "Authentication vector cache " IMSI_64_FMT ": purged\n", imsi64);
+  }
+  pthread_mutex_unlock (&_emm_auth_vector_cache.mutex);
+}
+
+//------------------------------------------------------------------------------
+uint8_t emm_auth_vector_cache_nb_vectors (const imsi64_t imsi64)
+{
+  emm_auth_vector_cache_entry_t          *entry = NULL;
+  uint8_t                                 nb_vectors = 0;
+
+  pthread_mutex_lock (&_emm_auth_vector_cache.mutex);
+  entry = _emm_auth_vector_cache_get (imsi64, false, _emm_auth_vector_cache_now ());
+  nb_vectors = (entry) ? entry->nb_vectors : 0;
+  pthread_mutex_unlock (&_emm_auth_vector_cache.mutex);
+  return nb_vectors;
+}
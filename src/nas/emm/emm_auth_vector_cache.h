@@ -0,0 +1,71 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file emm_auth_vector_cache.h
+   \brief IMSI keyed cache of E-UTRAN authentication vectors.
+
+   The MME requests a batch of vectors in each Authentication-Information-Request,
+   the vectors not used by the running authentication procedure are kept here, in
+   the order they were generated by the HSS, and handed to the next AKA runs of the
+   same IMSI, also after the UE context has been released. A vector older than the
+   configured TTL is never handed out. When fewer vectors than the low water mark
+   remain, an asynchronous AIR refills the cache.
+
+   The cache is shared by the MME_APP workers, which run the NAS procedures of
+   their UEs, and TASK_NAS_MME, which receives the AIAs; it is protected by a mutex.
+*/
+
+#ifndef FILE_EMM_AUTH_VECTOR_CACHE_SEEN
+#define FILE_EMM_AUTH_VECTOR_CACHE_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hashtable.h"
+#include "3gpp_23.003.h"
+#include "common_types.h"
+#include "security_types.h"
+
+/* Vectors kept per IMSI: a refill may arrive while up to low water mark - 1 vectors are still cached */
+#define EMM_AUTH_VECTOR_CACHE_DEPTH  (2 * MAX_EPS_AUTH_VECTORS_PER_REQUEST)
+
+int  emm_auth_vector_cache_init (const uint8_t nb_vectors_per_request, const uint8_t low_water_mark, const uint32_t ttl_sec, const hash_size_t max_imsis);
+void emm_auth_vector_cache_exit (void);
+
+/* Number of vectors to request in an AIR */
+uint8_t emm_auth_vector_cache_nb_vectors_per_request (void);
+
+/* Append the vectors of an AIA (nb_vectors may be 0 for a failed AIA), clears the pending refill of the IMSI */
+void emm_auth_vector_cache_store (const imsi64_t imsi64, const uint8_t nb_vectors, const eutran_vector_t * const vectors);
+
+/* Remove the oldest unexpired vector of the IMSI, a vector is never returned twice */
+bool emm_auth_vector_cache_pop (const imsi64_t imsi64, eutran_vector_t * const vector);
+
+/* Send an AIR for the IMSI if fewer than low water mark vectors are cached and no refill is pending */
+void emm_auth_vector_cache_refill (const imsi64_t imsi64, const imsi_t * const imsi, plmn_t * const visited_plmn);
+
+/* Drop the vectors of the IMSI, after a SQN synchronisation or MAC failure reported by the USIM */
+void emm_auth_vector_cache_purge (const imsi64_t imsi64);
+
+/* Number of unexpired vectors cached for the IMSI */
+uint8_t emm_auth_vector_cache_nb_vectors (const imsi64_t imsi64);
+
+#endif /* FILE_EMM_AUTH_VECTOR_CACHE_SEEN */
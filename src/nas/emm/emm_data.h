@@ -44,6 +44,7 @@ Description Defines internal private data handled by EPS Mobility
 #include "hashtable.h"
 #include "obj_hashtable.h"
 #include "securityDef.h"
+#include "secu_defs.h"
 #include "TrackingAreaIdentityList.h"
 #include "emm_fsm.h"
 #include "nas_timer.h"
@@ -82,6 +83,8 @@ typedef struct emm_security_context_s {
   int vector_index;   /* Pointer on vector */
   uint8_t knas_enc[AUTH_KNAS_ENC_SIZE];/* NAS cyphering key               */
   uint8_t knas_int[AUTH_KNAS_INT_SIZE];/* NAS integrity key               */
+  nas_stream_key_schedule_t knas_enc_schedule; /* EEA2 AES key schedule of knas_enc */
+  nas_stream_key_schedule_t knas_int_schedule; /* EIA2 AES key schedule of knas_int */
 
   struct count_s{
     uint32_t spare:8;
@@ -551,11 +551,12 @@ emm_context_upsert_imsi (
     struct emm_context_s *elm)
 {
   hashtable_rc_t                          h_rc = HASH_TABLE_OK;
-  mme_ue_s1ap_id_t                        ue_id = (PARENT_STRUCT(elm, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id;
+  struct ue_mm_context_s                 *ue_mm_context = PARENT_STRUCT(elm, struct ue_mm_context_s, emm_context);
+  mme_ue_s1ap_id_t                        ue_id = ue_mm_context->mme_ue_s1ap_id;
 
-  h_rc = hashtable_uint64_ts_remove (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl, (const hash_key_t)elm->_imsi64);
-  if (INVALID_MME_UE_S1AP_ID != ue_id) {
-    h_rc = hashtable_uint64_ts_insert (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl, (const hash_key_t)(const hash_key_t)elm->_imsi64, ue_id);
+  // the IMSI index stores the UE context itself, insert overwrites any previous association
+  if (INVALID_IMSI64 != elm->_imsi64) {
+    h_rc = hashtable_oa_ts_insert (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl, (const hash_key_t)elm->_imsi64, (void *)ue_mm_context);
   } else {
     h_rc = HASH_TABLE_KEY_NOT_EXISTS;
   }
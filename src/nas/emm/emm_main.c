@@ -52,6 +52,7 @@
 #include "common_defs.h"
 #include "emm_main.h"
 #include "emm_data.h"
+#include "emm_auth_vector_cache.h"
 #include "mme_config.h"
 
 
@@ -96,6 +97,10 @@ emm_main_initialize (
   if (mme_api_get_emm_config (&_emm_data.conf, mme_config_p) != RETURNok) {
     OAILOG_ERROR (LOG_NAS_EMM, "EMM-MAIN  - Failed to get MME configuration data");
   }
+  if (emm_auth_vector_cache_init (mme_config_p->s6a_config.auth_vectors_per_request, mme_config_p->s6a_config.auth_vectors_low_water_mark,
+      mme_config_p->s6a_config.auth_vectors_cache_ttl_sec, mme_config_p->max_ues) != RETURNok) {
+    OAILOG_ERROR (LOG_NAS_EMM, "EMM-MAIN  - Failed to initialize the authentication vector cache");
+  }
   OAILOG_FUNC_OUT(LOG_NAS_EMM);
 }
 
@@ -118,6 +123,7 @@ emm_main_cleanup (
   void)
 {
   OAILOG_FUNC_IN (LOG_NAS_EMM);
+  emm_auth_vector_cache_exit ();
   OAILOG_FUNC_OUT(LOG_NAS_EMM);
 }
 
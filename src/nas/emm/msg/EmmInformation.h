@@ -54,6 +54,7 @@ typedef enum emm_information_iei_tag {
   EMM_INFORMATION_SHORT_NAME_FOR_NETWORK_IEI              = MM_SHORT_NETWORK_NAME_IEI,
   EMM_INFORMATION_LOCAL_TIME_ZONE_IEI                     = MM_TIME_ZONE_IEI,
   EMM_INFORMATION_UNIVERSAL_TIME_AND_LOCAL_TIME_ZONE_IEI  = MM_TIME_ZONE_AND_TIME_IEI,
+  EMM_INFORMATION_NETWORK_DAYLIGHT_SAVING_TIME_IEI        = MM_DAYLIGHT_SAVING_TIME_IEI,
 } emm_information_iei;
 
 /*
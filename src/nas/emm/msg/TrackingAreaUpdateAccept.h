@@ -79,6 +79,7 @@ typedef enum tracking_area_update_accept_iei_tag {
   TRACKING_AREA_UPDATE_ACCEPT_GUTI_IEI                          = 0x50, /* 0x50 = 80 */
   TRACKING_AREA_UPDATE_ACCEPT_TAI_LIST_IEI                      = 0x54, /* 0x54 = 84 */
   TRACKING_AREA_UPDATE_ACCEPT_EPS_BEARER_CONTEXT_STATUS_IEI     = 0x57, /* 0x57 = 87 */
+  TRACKING_AREA_UPDATE_ACCEPT_LOCATION_AREA_IDENTIFICATION_IEI  = C_LOCATION_AREA_IDENTIFICATION_IEI,
   TRACKING_AREA_UPDATE_ACCEPT_MS_IDENTITY_IEI                   = C_MOBILE_IDENTITY_IEI,
   TRACKING_AREA_UPDATE_ACCEPT_EMM_CAUSE_IEI                     = 0x53, /* 0x53 = 83 */
   TRACKING_AREA_UPDATE_ACCEPT_T3402_VALUE_IEI                   = GPRS_C_TIMER_3402_VALUE_IEI,
@@ -61,6 +61,7 @@
 #include "mme_app_ue_context.h"
 #include "emm_msg.h"
 #include "esm_msg.h"
+#include "nas_codec.h"
 #include "intertask_interface.h"
 #include "TLVDecoder.h"
 #include "TLVEncoder.h"
@@ -126,6 +127,9 @@ emm_msg_decode (
   len -= header_result;
   OAILOG_DEBUG (LOG_NAS_EMM, "EMM-MSG   - Message Type 0x%02x\n", msg->header.message_type);
 
+#if NAS_GENERATED_CODEC
+  decode_result = nas_codec_decode_emm (msg, buffer, len);
+#else
   switch (msg->header.message_type) {
   case ATTACH_ACCEPT:
     decode_result = decode_attach_accept (&msg->attach_accept, buffer, len);
@@ -246,6 +250,7 @@ emm_msg_decode (
      * TODO: Handle not standard layer 3 messages: SERVICE_REQUEST
      */
   }
+#endif
 
   if (decode_result < 0) {
     OAILOG_ERROR (LOG_NAS_EMM, "EMM-MSG   - Failed to decode L3 EMM message 0x%x " "(%d)\n", msg->header.message_type, decode_result);
@@ -294,6 +299,9 @@ emm_msg_encode (
   buffer += header_result;
   len -= header_result;
 
+#if NAS_GENERATED_CODEC
+  encode_result = nas_codec_encode_emm (msg, buffer, len);
+#else
   switch (msg->header.message_type) {
   case ATTACH_ACCEPT:
     encode_result = encode_attach_accept (&msg->attach_accept, buffer, len);
@@ -414,6 +422,7 @@ emm_msg_encode (
      * TODO: Handle not standard layer 3 messages: SERVICE_REQUEST
      */
   }
+#endif
 
   if (encode_result < 0) {
     OAILOG_ERROR (LOG_NAS_EMM, "EMM-MSG   - Failed to encode L3 EMM message 0x%x " "(%d)\n", msg->header.message_type, encode_result);
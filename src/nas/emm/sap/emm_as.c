@@ -108,7 +108,7 @@ static int _emm_as_recv (
     mme_ue_s1ap_id_t ue_id,
     tai_t  const *originating_tai,
     ecgi_t  const *originating_ecgi,
-    bstring msg,
+    unsigned char * const msg,
     size_t len,
     int *emm_cause,
     nas_message_decode_status_t   * decode_status);
@@ -277,7 +277,8 @@ int emm_as_send (emm_as_t * msg)
  **      received from the Access Stratum                          **
  **                                                                        **
  ** Inputs:  ue_id:      UE lower layer identifier                  **
- **      msg:       The EMM message to process                 **
+ **      msg:       The EMM message to process, deciphered in  **
+ **             place if security protected                **
  **      len:       The length of the EMM message              **
  **      Others:    None                                       **
  **                                                                        **
@@ -290,7 +291,7 @@ static int _emm_as_recv (
   mme_ue_s1ap_id_t ue_id,
   tai_t  const *originating_tai,
   ecgi_t  const *originating_ecgi,
-  bstring msg,
+  unsigned char * const msg,
   size_t len,
   int *emm_cause,
   nas_message_decode_status_t   * decode_status)
@@ -333,7 +334,7 @@ static int _emm_as_recv (
   /*
    * Decode the received message
    */
-  decoder_rc = nas_message_decode (msg->data, &nas_msg, len, emm_security_context, decode_status);
+  decoder_rc = nas_message_decode (msg, &nas_msg, len, emm_security_context, decode_status);
 
   if (decoder_rc < 0) {
     OAILOG_WARNING (LOG_NAS_EMM, "EMMAS-SAP - Failed to decode NAS message " "(err=%d)\n", decoder_rc);
@@ -490,66 +491,66 @@ static int _emm_as_data_ind (emm_as_data_t * msg, int *emm_cause)
   if ( EMM_AS_DATA_DELIVERED_TRUE == msg->delivered) {
     if (blength(msg->nas_msg) > 0) {
       /*
-       * Process the received NAS message
+       * Process the received NAS message, the buffer received from S1AP
+       * is owned here and deciphered in place
        */
-      bstring                                   plain_msg = bstrcpy(msg->nas_msg);
+      nas_message_security_header_t           header = {0};
+      emm_security_context_t                 *security = NULL;        /* Current EPS NAS security context     */
+      nas_message_decode_status_t             decode_status = {0};
+      const int                               length = blength(msg->nas_msg);
 
-      if (plain_msg) {
-        nas_message_security_header_t           header = {0};
-        emm_security_context_t                 *security = NULL;        /* Current EPS NAS security context     */
-        nas_message_decode_status_t             decode_status = {0};
-
-        /*
-         * Decrypt the received security protected message
-         */
-        ue_mm_context_t *ue_mm_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, msg->ue_id);
+      /*
+       * Decrypt the received security protected message
+       */
+      ue_mm_context_t *ue_mm_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, msg->ue_id);
 
-        emm_context_t     *emm_ctx =  NULL;
+      emm_context_t     *emm_ctx =  NULL;
 
-        if (ue_mm_context) {
-          emm_ctx = &ue_mm_context->emm_context;
-          if (emm_ctx) {
-            if (IS_EMM_CTXT_PRESENT_SECURITY(emm_ctx)) {
-              security = &emm_ctx->_security;
-            }
+      if (ue_mm_context) {
+        emm_ctx = &ue_mm_context->emm_context;
+        if (emm_ctx) {
+          if (IS_EMM_CTXT_PRESENT_SECURITY(emm_ctx)) {
+            security = &emm_ctx->_security;
           }
         }
+      }
 
-        int  bytes = nas_message_decrypt (msg->nas_msg->data,
-            plain_msg->data,
-            &header,
-            blength(msg->nas_msg),
-            security,
-            &decode_status);
-
-        if ((bytes < 0) &&
-            (bytes != TLV_MAC_MISMATCH)) { // not in spec, (case identity response for attach with unknown GUTI)
-          /*
-           * Failed to decrypt the message
-           */
-          *emm_cause = EMM_CAUSE_PROTOCOL_ERROR;
-          unlock_ue_contexts(ue_mm_context);
-          OAILOG_FUNC_RETURN (LOG_NAS_EMM, bytes);
-        } else if (header.protocol_discriminator == EPS_MOBILITY_MANAGEMENT_MESSAGE) {
-          /*
-           * Process EMM data
-           */
-          tai_t                                   originating_tai = {0}; // originating TAI
-          memcpy(&originating_tai, msg->tai, sizeof(originating_tai));
-
-          rc = _emm_as_recv (msg->ue_id, &originating_tai, &msg->ecgi, plain_msg, bytes, emm_cause, &decode_status);
-        } else if (header.protocol_discriminator == EPS_SESSION_MANAGEMENT_MESSAGE) {
-          /*
-           * Foward ESM data to EPS session management
-           */
-          // shrink plain_msg
-          btrunc(plain_msg, bytes);
-          rc = lowerlayer_data_ind (msg->ue_id, plain_msg);
-        }
-
-        bdestroy_wrapper (&plain_msg);
+      int  bytes = nas_message_decrypt (msg->nas_msg->data,
+          msg->nas_msg->data,
+          &header,
+          length,
+          security,
+          &decode_status);
+      // the plain NAS message follows the security header
+      unsigned char                          *plain_msg = msg->nas_msg->data + ((bytes >= 0) ? length - bytes : 0);
+
+      if ((bytes < 0) &&
+          (bytes != TLV_MAC_MISMATCH)) { // not in spec, (case identity response for attach with unknown GUTI)
+        /*
+         * Failed to decrypt the message
+         */
+        *emm_cause = EMM_CAUSE_PROTOCOL_ERROR;
         unlock_ue_contexts(ue_mm_context);
+        bdestroy_wrapper (&msg->nas_msg);
+        OAILOG_FUNC_RETURN (LOG_NAS_EMM, bytes);
+      } else if (header.protocol_discriminator == EPS_MOBILITY_MANAGEMENT_MESSAGE) {
+        /*
+         * Process EMM data
+         */
+        tai_t                                   originating_tai = {0}; // originating TAI
+        memcpy(&originating_tai, msg->tai, sizeof(originating_tai));
+
+        rc = _emm_as_recv (msg->ue_id, &originating_tai, &msg->ecgi, plain_msg, bytes, emm_cause, &decode_status);
+      } else if (header.protocol_discriminator == EPS_SESSION_MANAGEMENT_MESSAGE) {
+        /*
+         * Foward ESM data to EPS session management
+         */
+        // strip the security header
+        bdelete(msg->nas_msg, 0, length - bytes);
+        rc = lowerlayer_data_ind (msg->ue_id, msg->nas_msg);
       }
+
+      unlock_ue_contexts(ue_mm_context);
     } else {
       /*
        * Process successfull lower layer transfer indication
@@ -847,7 +848,10 @@ static EMM_msg *_emm_as_set_header (nas_message_t * msg, const emm_as_security_d
  ** Description: Encodes NAS message into NAS information container        **
  **                                                                        **
  ** Inputs:  msg:       The NAS message to encode                  **
- **      length:    The maximum length of the NAS message      **
+ **      length:    The maximum length of the NAS message, as  **
+ **             computed by emm_send_xxx() for the message **
+ **             type; the message is encoded and ciphered  **
+ **             in the NAS information container directly  **
  **      Others:    None                                       **
  **                                                                        **
  ** Outputs:     info:      The NAS information container              **
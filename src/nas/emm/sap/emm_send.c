@@ -272,7 +272,8 @@ emm_send_attach_accept (
    * Mandatory - ESM message container
    */
   size += ESM_MESSAGE_CONTAINER_MINIMUM_LENGTH + blength(msg->nas_msg);
-  emm_msg->esmmessagecontainer = bstrcpy(msg->nas_msg);
+  // borrowed, the encoder copies it in the NAS PDU
+  emm_msg->esmmessagecontainer = msg->nas_msg;
   OAILOG_INFO (LOG_NAS_EMM, "EMMAS-SAP - size += " "ESM_MESSAGE_CONTAINER_MINIMUM_LENGTH(%d)  (%d)\n", ESM_MESSAGE_CONTAINER_MINIMUM_LENGTH, size);
 
   /*
@@ -426,7 +427,8 @@ emm_send_attach_accept_dl_nas (
    * Mandatory - ESM message container
    */
   size += ESM_MESSAGE_CONTAINER_MINIMUM_LENGTH + blength(msg->nas_msg);
-  emm_msg->esmmessagecontainer = bstrcpy(msg->nas_msg);
+  // borrowed, the encoder copies it in the NAS PDU
+  emm_msg->esmmessagecontainer = msg->nas_msg;
   OAILOG_INFO (LOG_NAS_EMM, "EMMAS-SAP - size += " "ESM_MESSAGE_CONTAINER_MINIMUM_LENGTH(%d)  (%d)\n", ESM_MESSAGE_CONTAINER_MINIMUM_LENGTH, size);
 
   /*
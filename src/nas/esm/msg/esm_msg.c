@@ -77,6 +77,7 @@
 
 #include "mme_app_ue_context.h"
 #include "esm_msg.h"
+#include "nas_codec.h"
 #include "esm_proc.h"
 #include "nas_itti_messaging.h"
 
@@ -139,6 +140,9 @@ esm_msg_decode (
   buffer += header_result;
   len -= header_result;
 
+#if NAS_GENERATED_CODEC
+  decode_result = nas_codec_decode_esm (msg, buffer, len);
+#else
   switch (msg->header.message_type) {
   case PDN_DISCONNECT_REQUEST:
     decode_result = decode_pdn_disconnect_request (&msg->pdn_disconnect_request, buffer, len);
@@ -233,6 +237,7 @@ esm_msg_decode (
     decode_result = TLV_WRONG_MESSAGE_TYPE;
     break;
   }
+#endif
 
   if (decode_result < 0) {
     OAILOG_ERROR (LOG_NAS_ESM, "ESM-MSG   - Failed to decode L3 ESM message 0x%x " "(%u)\n", msg->header.message_type, decode_result);
@@ -282,6 +287,9 @@ esm_msg_encode (
   buffer += header_result;
   len -= header_result;
 
+#if NAS_GENERATED_CODEC
+  encode_result = nas_codec_encode_esm (msg, buffer, len);
+#else
   switch (msg->header.message_type) {
   case PDN_DISCONNECT_REQUEST:
     encode_result = encode_pdn_disconnect_request (&msg->pdn_disconnect_request, buffer, len);
@@ -376,6 +384,7 @@ esm_msg_encode (
     encode_result = TLV_WRONG_MESSAGE_TYPE;
     break;
   }
+#endif
 
   if (encode_result < 0) {
     OAILOG_ERROR (LOG_NAS_ESM, "ESM-MSG   - Failed to encode L3 ESM message 0x%x " "(%d)\n", msg->header.message_type, encode_result);
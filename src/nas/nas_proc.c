@@ -37,6 +37,7 @@
 *****************************************************************************/
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <pthread.h>
 
 #include "bstrlib.h"
@@ -47,6 +48,7 @@
 #include "conversions.h"
 #include "nas_proc.h"
 #include "emm_main.h"
+#include "emm_auth_vector_cache.h"
 #include "emm_sap.h"
 #include "esm_main.h"
 #include "esm_sap.h"
@@ -382,23 +384,46 @@ nas_proc_authentication_info_answer (
     ctxt = &ue_mm_context->emm_context;
   }
 
-  if (!(ctxt)) {
-    OAILOG_ERROR (LOG_NAS_EMM, "That's embarrassing as we don't know this IMSI\n");
-    MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_AUTH_INFO_ANS Unknown imsi " IMSI_64_FMT, imsi64);
-    OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNerror);
-  }
-
   if ((aia->result.present == S6A_RESULT_BASE)
       && (aia->result.choice.base == DIAMETER_SUCCESS)) {
     /*
-     * Check that list is not empty and contain at most MAX_EPS_AUTH_VECTORS elements
+     * Check that list is not empty and contain at most MAX_EPS_AUTH_VECTORS_PER_REQUEST elements
      */
-    DevCheck(aia->auth_info.nb_of_vectors <= MAX_EPS_AUTH_VECTORS, aia->auth_info.nb_of_vectors, MAX_EPS_AUTH_VECTORS, 0);
+    DevCheck(aia->auth_info.nb_of_vectors <= MAX_EPS_AUTH_VECTORS_PER_REQUEST, aia->auth_info.nb_of_vectors, MAX_EPS_AUTH_VECTORS_PER_REQUEST, 0);
     DevCheck(aia->auth_info.nb_of_vectors > 0, aia->auth_info.nb_of_vectors, 1, 0);
 
-    OAILOG_DEBUG (LOG_NAS_EMM, "INFORMING NAS ABOUT AUTH RESP SUCCESS got %u vector(s)\n", aia->auth_info.nb_of_vectors);
-    rc = nas_proc_auth_param_res (ue_mm_context->mme_ue_s1ap_id, aia->auth_info.nb_of_vectors, aia->auth_info.eutran_vector);
+    /*
+     * All vectors go through the authentication vector cache, in the order they were generated,
+     * the AIA may answer a refill request sent after the UE context has been released
+     */
+    emm_auth_vector_cache_store (imsi64, aia->auth_info.nb_of_vectors, aia->auth_info.eutran_vector);
+
+    if ((ctxt) && (get_nas_cn_procedure_auth_info(ctxt))) {
+      eutran_vector_t                         vector = {0};
+
+      if (!emm_auth_vector_cache_pop (imsi64, &vector)) {
+        // not cached (cache full), this vector was not stored
+        memcpy (&vector, &aia->auth_info.eutran_vector[0], sizeof (vector));
+      }
+      OAILOG_DEBUG (LOG_NAS_EMM, "INFORMING NAS ABOUT AUTH RESP SUCCESS got %u vector(s)\n", aia->auth_info.nb_of_vectors);
+      rc = nas_proc_auth_param_res (ue_mm_context->mme_ue_s1ap_id, 1, &vector);
+      memset (&vector, 0, sizeof (vector));
+    } else {
+      OAILOG_DEBUG (LOG_NAS_EMM, "Cached %u vector(s) for imsi " IMSI_64_FMT "\n", aia->auth_info.nb_of_vectors, imsi64);
+      rc = RETURNok;
+    }
   } else {
+    emm_auth_vector_cache_store (imsi64, 0, NULL);
+
+    if (!(ctxt) || !(get_nas_cn_procedure_auth_info(ctxt))) {
+      // failed refill request
+      OAILOG_WARNING (LOG_NAS_EMM, "Authentication information request failed for imsi " IMSI_64_FMT "\n", imsi64);
+      MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_AUTH_INFO_ANS S6A Failure imsi " IMSI_64_FMT, imsi64);
+      if (ue_mm_context) {
+        unlock_ue_contexts(ue_mm_context);
+      }
+      OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNerror);
+    }
     OAILOG_ERROR (LOG_NAS_EMM, "INFORMING NAS ABOUT AUTH RESP ERROR CODE\n");
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_AUTH_INFO_ANS S6A Failure imsi " IMSI_64_FMT, imsi64);
 
@@ -412,7 +437,9 @@ nas_proc_authentication_info_answer (
     }
   }
 
-  unlock_ue_contexts(ue_mm_context);
+  if (ue_mm_context) {
+    unlock_ue_contexts(ue_mm_context);
+  }
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
 }
 
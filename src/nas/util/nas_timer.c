@@ -51,17 +51,40 @@
 #include "nas_timer.h"
 #include "commonDef.h"
 #include "common_defs.h"
+#include "log.h"
 #include "dynamic_memory_check.h"
+#include "hashtable.h"
+
+/* Size of the table of the running NAS timers */
+#define NAS_TIMER_HTBL_SIZE 8192
+
+/*
+ * Identifiers of the NAS timers started and neither stopped nor expired yet.
+ * The expiry of a timer may be queued, with a higher priority, before the
+ * message which stops it: such a late expiry is ignored.
+ */
+static hash_table_uint64_ts_t          *nas_timers = NULL;
 
 //------------------------------------------------------------------------------
 int nas_timer_init (void)
 {
+  if (!nas_timers) {
+    nas_timers = hashtable_uint64_ts_create (NAS_TIMER_HTBL_SIZE, NULL, bfromcstr ("nas_timers"));
+
+    if (!nas_timers) {
+      return (RETURNerror);
+    }
+  }
   return (RETURNok);
 }
 
 //------------------------------------------------------------------------------
 void nas_timer_cleanup (void)
 {
+  if (nas_timers) {
+    hashtable_uint64_ts_destroy (nas_timers);
+    nas_timers = NULL;
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -92,7 +115,7 @@ long int nas_timer_start (
     free_wrapper((void*)&nas_itti_timer_arg);
     return (long)NAS_TIMER_INACTIVE_ID;
   }
-
+  hashtable_uint64_ts_insert (nas_timers, (const hash_key_t)timer_id, (uint64_t)(uintptr_t)nas_itti_timer_arg);
 
   return (timer_id);
 }
@@ -101,6 +124,8 @@ long int nas_timer_start (
 long int nas_timer_stop (long int timer_id, void **nas_timer_callback_arg)
 {
   nas_itti_timer_arg_t                   *nas_itti_timer_arg = NULL;
+  // a pending expiry of the timer will be ignored
+  hashtable_uint64_ts_remove (nas_timers, (const hash_key_t)timer_id);
   timer_remove (timer_id, (void**)&nas_itti_timer_arg);
   if (nas_itti_timer_arg) {
     *nas_timer_callback_arg = nas_itti_timer_arg->nas_timer_callback_arg;
@@ -117,7 +142,11 @@ void nas_timer_handle_signal_expiry (long timer_id, nas_itti_timer_arg_t *nas_it
   /*
    * Get the timer entry for which the system timer expired
    */
-  nas_itti_timer_arg->nas_timer_callback (nas_itti_timer_arg->nas_timer_callback_arg);
+  if (HASH_TABLE_OK == hashtable_uint64_ts_remove (nas_timers, (const hash_key_t)timer_id)) {
+    nas_itti_timer_arg->nas_timer_callback (nas_itti_timer_arg->nas_timer_callback_arg);
+  } else {
+    OAILOG_DEBUG (LOG_NAS, "Ignoring expiry of stopped NAS timer %ld\n", timer_id);
+  }
   // assuming timer type is TIMER_ONE_SHOT
   free_wrapper((void**)&nas_itti_timer_arg);
 }
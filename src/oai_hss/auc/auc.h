@@ -37,6 +37,7 @@
 #define AUTN_LENGTH_OCTETS  (16)
 #define KASME_LENGTH_OCTETS (32)
 #define MAC_S_LENGTH        (8)
+#define AUTS_LENGTH_OCTETS  (SQN_LENGTH_OCTEST + MAC_S_LENGTH)
 
 extern uint8_t opc[16];
 
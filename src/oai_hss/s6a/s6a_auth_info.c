@@ -43,6 +43,26 @@
 
 #define AUTH_MAX_EUTRAN_VECTORS 6
 
+/*
+ * SQN of the next vector of a batch, same step as hss_mysql_increment_sqn(),
+ * the vectors of a batch must be accepted by the USIM in order
+ */
+static void
+s6a_sqn_next (
+  uint8_t * sqn)
+{
+  uint64_t                                sqn_decimal = 0;
+
+  for (int i = 0; i < SQN_LENGTH; i++) {
+    sqn_decimal = (sqn_decimal << 8) | sqn[i];
+  }
+  sqn_decimal += 32;
+  for (int i = SQN_LENGTH - 1; i >= 0; i--) {
+    sqn[i] = (uint8_t)sqn_decimal;
+    sqn_decimal >>= 8;
+  }
+}
+
 int
 s6a_auth_info_cb (
   struct msg **msg,
@@ -74,7 +94,8 @@ s6a_auth_info_cb (
   uint64_t                                imsi = 0;
   uint32_t                                num_vectors = 0;
   uint8_t                                *sqn = NULL,
-    *auts = NULL;
+    *auts = NULL,
+    *auts_rand = NULL;
 
   if (msg == NULL) {
     return EINVAL;
@@ -162,10 +183,20 @@ s6a_auth_info_cb (
 
         /*
          * The resynchronization-info AVP is present.
-         * * * * AUTS = Conc(SQN MS ) || MAC-S
+         * * * * RAND || AUTS, AUTS = Conc(SQN MS ) || MAC-S
+         * * * * Without RAND, the last RAND stored for the subscriber is used.
          */
         if (avp) {
-          auts = hdr->avp_value->os.data;
+          if (hdr->avp_value->os.len == (RAND_LENGTH_OCTETS + AUTS_LENGTH_OCTETS)) {
+            auts_rand = hdr->avp_value->os.data;
+            auts = hdr->avp_value->os.data + RAND_LENGTH_OCTETS;
+          } else if (hdr->avp_value->os.len == AUTS_LENGTH_OCTETS) {
+            auts = hdr->avp_value->os.data;
+          } else {
+            result_code = ER_DIAMETER_INVALID_AVP_VALUE;
+            failed_avp = child_avp;
+            goto out;
+          }
         }
 
         break;
@@ -252,9 +283,10 @@ s6a_auth_info_cb (
 
   if (auts != NULL) {
     /*
-     * Try to derive SQN_MS from previous RAND
+     * Try to derive SQN_MS from the RAND of the rejected challenge, a batch
+     * holds several of them: the stored RAND is the one of the last vector
      */
-    sqn = sqn_ms_derive (auth_info_resp.opc, auth_info_resp.key, auts, auth_info_resp.rand);
+    sqn = sqn_ms_derive (auth_info_resp.opc, auth_info_resp.key, auts, (auts_rand) ? auts_rand : auth_info_resp.rand);
 
     if (sqn != NULL) {
       /*
@@ -283,6 +315,9 @@ s6a_auth_info_cb (
 
     sqn = auth_info_resp.sqn;
     for (int i = 0; i < num_vectors; i++) {
+      if (i) {
+        s6a_sqn_next (sqn);
+      }
       generate_random (vector[i].rand, RAND_LENGTH);
       generate_vector (auth_info_resp.opc, imsi, auth_info_resp.key, hdr->avp_value->os.data, sqn, &vector[i]);
     }
@@ -291,9 +326,12 @@ s6a_auth_info_cb (
     /*
      * Pick a new RAND and store SQN_MS + RAND in the HSS
      */
+    sqn = auth_info_resp.sqn;
     for (int i = 0; i < num_vectors; i++) {
+      if (i) {
+        s6a_sqn_next (sqn);
+      }
       generate_random (vector[i].rand, RAND_LENGTH);
-      sqn = auth_info_resp.sqn;
       /*
        * Generate authentication vector
        */
@@ -309,8 +347,9 @@ s6a_auth_info_cb (
   {
     struct avp                             *e_utran_vector,
                                            *child_avp;
+    // one Authentication-Info AVP grouping all the E-UTRAN-Vector AVPs
+    CHECK_FCT (fd_msg_avp_new (s6a_cnf.dataobj_s6a_authentication_info, 0, &avp));
     for (int i = 0; i < num_vectors; i++) {
-      CHECK_FCT (fd_msg_avp_new (s6a_cnf.dataobj_s6a_authentication_info, 0, &avp));
       CHECK_FCT (fd_msg_avp_new (s6a_cnf.dataobj_s6a_e_utran_vector, 0, &e_utran_vector));
       CHECK_FCT (fd_msg_avp_new (s6a_cnf.dataobj_s6a_rand, 0, &child_avp));
       value.os.data = vector[i].rand;
@@ -333,8 +372,8 @@ s6a_auth_info_cb (
       CHECK_FCT (fd_msg_avp_setvalue (child_avp, &value));
       CHECK_FCT (fd_msg_avp_add (e_utran_vector, MSG_BRW_LAST_CHILD, child_avp));
       CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, e_utran_vector));
-      CHECK_FCT (fd_msg_avp_add (ans, MSG_BRW_LAST_CHILD, avp));
     }
+    CHECK_FCT (fd_msg_avp_add (ans, MSG_BRW_LAST_CHILD, avp));
   }
 out:
   /*
@@ -30,12 +30,74 @@
 #include <stdint.h>
 
 #include "s1ap_common.h"
+#include "arena.h"
 #include "dynamic_memory_check.h"
 #include "log.h"
 
 int                                     asn_debug = 0;
 int                                     asn1_xer_print = 0;
 
+__thread arena_t                       *s1ap_asn_arena = NULL;
+__thread uint64_t                       s1ap_asn_nb_heap_allocations = 0;
+
+//------------------------------------------------------------------------------
+void *s1ap_asn_calloc (size_t nmemb, size_t size)
+{
+  if (s1ap_asn_arena) {
+    return arena_calloc (s1ap_asn_arena, nmemb, size);
+  }
+  s1ap_asn_nb_heap_allocations++;
+  return calloc (nmemb, size);
+}
+
+//------------------------------------------------------------------------------
+void *s1ap_asn_malloc (size_t size)
+{
+  if (s1ap_asn_arena) {
+    return arena_alloc (s1ap_asn_arena, size);
+  }
+  s1ap_asn_nb_heap_allocations++;
+  return malloc (size);
+}
+
+//------------------------------------------------------------------------------
+void *s1ap_asn_realloc (void *ptr, size_t size)
+{
+  if (s1ap_asn_arena) {
+    if ((!ptr) || (arena_owns (s1ap_asn_arena, ptr))) {
+      return arena_realloc (s1ap_asn_arena, ptr, size);
+    }
+  }
+  // ptr allocated before the arena was bound, keep it on the heap
+  s1ap_asn_nb_heap_allocations++;
+  return realloc (ptr, size);
+}
+
+//------------------------------------------------------------------------------
+void s1ap_asn_free (void *ptr)
+{
+  if ((s1ap_asn_arena) && (arena_owns (s1ap_asn_arena, ptr))) {
+    return;
+  }
+  free (ptr);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The encoded PDU is handed over to the caller who frees it with free(),
+ * it must not come from the arena.
+ */
+static ssize_t s1ap_encode_pdu_to_new_buffer (S1AP_PDU_t * const pdu, uint8_t ** buffer)
+{
+  arena_t                                *arena = s1ap_asn_arena;
+  ssize_t                                 encoded = 0;
+
+  s1ap_asn_arena = NULL;
+  encoded = aper_encode_to_new_buffer (&asn_DEF_S1AP_PDU, 0, pdu, (void **)buffer);
+  s1ap_asn_arena = arena;
+  return encoded;
+}
+
 
 ssize_t
 s1ap_generate_initiating_message (
@@ -64,7 +126,7 @@ s1ap_generate_initiating_message (
    */
   ASN_STRUCT_FREE_CONTENTS_ONLY (*td, sptr);
 
-  if ((encoded = aper_encode_to_new_buffer (&asn_DEF_S1AP_PDU, 0, &pdu, (void **)buffer)) < 0) {
+  if ((encoded = s1ap_encode_pdu_to_new_buffer (&pdu, buffer)) < 0) {
   OAILOG_ERROR (LOG_S1AP, "Encoding of %s failed\n", td->name);
     return -1;
   }
@@ -100,7 +162,7 @@ s1ap_generate_successfull_outcome (
    */
   ASN_STRUCT_FREE_CONTENTS_ONLY (*td, sptr);
 
-  if ((encoded = aper_encode_to_new_buffer (&asn_DEF_S1AP_PDU, 0, &pdu, (void **)buffer)) < 0) {
+  if ((encoded = s1ap_encode_pdu_to_new_buffer (&pdu, buffer)) < 0) {
     OAILOG_ERROR (LOG_S1AP, "Encoding of %s failed\n", td->name);
     return -1;
   }
@@ -136,7 +198,7 @@ s1ap_generate_unsuccessfull_outcome (
    */
   ASN_STRUCT_FREE_CONTENTS_ONLY (*td, sptr);
 
-  if ((encoded = aper_encode_to_new_buffer (&asn_DEF_S1AP_PDU, 0, &pdu, (void **)buffer)) < 0) {
+  if ((encoded = s1ap_encode_pdu_to_new_buffer (&pdu, buffer)) < 0) {
     OAILOG_ERROR (LOG_S1AP, "Encoding of %s failed\n", td->name);
     return -1;
   }
@@ -154,7 +216,7 @@ s1ap_new_ie (
 {
   S1ap_IE_t                              *buff;
 
-  if ((buff = malloc (sizeof (S1ap_IE_t))) == NULL) {
+  if ((buff = s1ap_asn_malloc (sizeof (S1ap_IE_t))) == NULL) {
     // Possible error on malloc
     return NULL;
   }
@@ -165,13 +227,13 @@ s1ap_new_ie (
 
   if (ANY_fromType_aper (&buff->value, type, sptr) < 0) {
     OAILOG_ERROR (LOG_S1AP, "Encoding of %s failed\n", type->name);
-    free_wrapper ((void**) &buff);
+    s1ap_asn_free (buff);
     return NULL;
   }
 
   if (asn1_xer_print)
     if (xer_fprint (stdout, &asn_DEF_S1ap_IE, buff) < 0) {
-      free_wrapper ((void**) &buff);
+      s1ap_asn_free (buff);
       return NULL;
     }
 
@@ -475,4 +475,21 @@ S1ap_IE_t *s1ap_new_ie(S1ap_ProtocolIE_ID_t   id,
  **/
 void s1ap_handle_criticality(S1ap_Criticality_t criticality);
 
+/*
+ * Memory hooks of the asn1c runtime: generate_asn1 maps CALLOC, MALLOC,
+ * REALLOC and FREEMEM of asn_internal.h on them. When an arena is bound to
+ * the calling thread (s1ap_asn_arena), allocations of the S1AP codec are
+ * carved from it and released all at once by arena_reset(), FREEMEM is then
+ * a no-op for them. Without arena they fall back on the C library.
+ */
+struct arena_s;
+extern __thread struct arena_s *s1ap_asn_arena;
+/* Codec allocations served by the C library on this thread, for statistics */
+extern __thread uint64_t        s1ap_asn_nb_heap_allocations;
+
+void *s1ap_asn_calloc(size_t nmemb, size_t size);
+void *s1ap_asn_malloc(size_t size);
+void *s1ap_asn_realloc(void *ptr, size_t size);
+void  s1ap_asn_free(void *ptr);
+
 #endif /* FILE_S1AP_COMMON_SEEN */
@@ -34,6 +34,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <pthread.h>
+#include <unistd.h>
 #include <netinet/in.h>
 
 #include "bstrlib.h"
@@ -41,12 +42,16 @@
 #include "tree.h"
 
 #include "hashtable.h"
+#include "epoch.h"
+#include "slab.h"
+#include "arena.h"
 #include "log.h"
 #include "msc.h"
 #include "assertions.h"
 #include "mme_app_statistics.h"
 #include "s1ap_mme.h"
 #include "s1ap_mme_decoder.h"
+#include "s1ap_mme_fast_codec.h"
 #include "s1ap_mme_handlers.h"
 #include "s1ap_ies_defs.h"
 #include "s1ap_mme_nas_procedures.h"
@@ -71,8 +76,32 @@ uint32_t                                nb_enb_associated = 0;
 
 hash_table_ts_t g_s1ap_enb_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains eNB_description_s, key is eNB_description_s.enb_id (uint32_t);
 hash_table_ts_t g_s1ap_mme_id2assoc_id_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains sctp association id, key is mme_ue_s1ap_id;
+hash_table_ts_t g_s1ap_ue_mme_id_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains ue_description_t*, key is mme_ue_s1ap_id, UEs of all eNBs;
+slab_t         *g_s1ap_ue_slab = NULL; // ue_description_t of all eNBs;
+hash_table_ts_t g_s1ap_ue_s11_teid_coll = {.mutex = PTHREAD_MUTEX_INITIALIZER, 0}; // contains ue_description_t*, key is s11_sgw_teid, UEs of all eNBs;
+
+/* Initial size of the per worker arena backing the S1AP codec, it grows to fit the biggest PDU */
+#define S1AP_ASN_ARENA_CHUNK_SIZE       (16 * 1024)
+
+/* Maximum number of messages dispatched to the workers per wakeup of TASK_S1AP */
+#define S1AP_DISPATCH_BATCH_SIZE        64
+
+/* Initial number of UE descriptors per eNB, ue_coll grows as UEs attach */
+#define S1AP_ENB_UE_COLL_INITIAL_SIZE   16
+/* Number of UE descriptors per slab chunk */
+#define S1AP_UE_SLAB_CHUNK_SIZE         1024
+/* Maximum number of 1 ms waits for the deferred releases of UE descriptors at exit */
+#define S1AP_EXIT_RECLAIM_ROUNDS        100
 
 static int                              indent = 0;
+static uint32_t                         s1ap_nb_workers = 1;
+/* Workers that started or exited, protected by s1ap_workers_mutex */
+static uint32_t                         s1ap_nb_ready_workers = 0;
+static uint32_t                         s1ap_nb_exited_workers = 0;
+static pthread_mutex_t                  s1ap_workers_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t                   s1ap_workers_cond = PTHREAD_COND_INITIALIZER;
+/* Worker task of the calling thread, TASK_UNKNOWN outside the S1AP workers */
+static __thread task_id_t               s1ap_worker_task_id = TASK_UNKNOWN;
  void *s1ap_mme_thread (void *args);
 
 //------------------------------------------------------------------------------
@@ -98,161 +127,470 @@ static int s1ap_send_init_sctp (void)
 }
 
 //------------------------------------------------------------------------------
-void                                   *
-s1ap_mme_thread (
-  __attribute__((unused)) void *args)
+static void s1ap_mme_worker_count (uint32_t * const counter_p)
 {
-  itti_mark_task_ready (TASK_S1AP);
+  pthread_mutex_lock (&s1ap_workers_mutex);
+  (*counter_p)++;
+  pthread_cond_broadcast (&s1ap_workers_cond);
+  pthread_mutex_unlock (&s1ap_workers_mutex);
+}
+
+//------------------------------------------------------------------------------
+static inline task_id_t s1ap_mme_worker_for_assoc (const sctp_assoc_id_t sctp_assoc_id)
+{
+  return (task_id_t)(TASK_S1AP_WORKER_0 + ((uint32_t)sctp_assoc_id % s1ap_nb_workers));
+}
+
+//------------------------------------------------------------------------------
+static task_id_t s1ap_mme_worker_for_ue (const mme_ue_s1ap_id_t mme_ue_s1ap_id)
+{
+  void                                   *id = NULL;
+
+  if (HASH_TABLE_OK == hashtable_ts_get (&g_s1ap_mme_id2assoc_id_coll, (const hash_key_t)mme_ue_s1ap_id, (void **)&id)) {
+    return s1ap_mme_worker_for_assoc ((sctp_assoc_id_t)(uintptr_t)id);
+  }
+  // Unknown UE, the worker will report it
+  return TASK_S1AP_WORKER_0;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * A Path Switch Request is received from the target eNB of an X2 handover
+ * while the UE still belongs to the worker of its source eNB: the PDU is
+ * handed over to that worker, which decodes it again.
+ * Returns true if the message has been forwarded.
+ */
+static bool s1ap_mme_forward_to_ue_worker (const task_id_t task_id, MessageDef * const received_message_p, const s1ap_message * const message)
+{
+  MessageDef                             *message_p = NULL;
+  void                                   *id = NULL;
+  task_id_t                               ue_task_id = task_id;
+
+  // Forwarded messages are not forwarded again
+  if ((ITTI_MSG_ORIGIN_ID (received_message_p) != TASK_SCTP) ||
+      (message->direction != S1AP_PDU_PR_initiatingMessage) ||
+      (message->procedureCode != S1ap_ProcedureCode_id_PathSwitchRequest)) {
+    return false;
+  }
+  if (HASH_TABLE_OK != hashtable_ts_get (&g_s1ap_mme_id2assoc_id_coll,
+      (const hash_key_t)message->msg.s1ap_PathSwitchRequestIEs.sourceMME_UE_S1AP_ID, (void **)&id)) {
+    // Unknown UE, the handler rejects it
+    return false;
+  }
+  ue_task_id = s1ap_mme_worker_for_assoc ((sctp_assoc_id_t)(uintptr_t)id);
+  if (ue_task_id == task_id) {
+    return false;
+  }
+  message_p = itti_alloc_new_message (task_id, SCTP_DATA_IND);
+  AssertFatal (message_p != NULL, "itti_alloc_new_message Failed");
+  SCTP_DATA_IND (message_p) = SCTP_DATA_IND (received_message_p);
+  // the payload now belongs to the forwarded message
+  SCTP_DATA_IND (received_message_p).payload = NULL;
+  OAILOG_DEBUG (LOG_S1AP, "Path Switch Request of UE " MME_UE_S1AP_ID_FMT " forwarded to %s\n",
+      (mme_ue_s1ap_id_t)message->msg.s1ap_PathSwitchRequestIEs.sourceMME_UE_S1AP_ID, itti_get_task_name (ue_task_id));
+  itti_send_msg_to_task (ue_task_id, INSTANCE_DEFAULT, message_p);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * S1AP_ENB_INITIATED_RESET_ACK and SCTP_CLOSE_ASSOCIATION are queued in a
+ * higher priority class than the signalling of the association, which they
+ * must not overtake.
+ */
+static inline bool s1ap_mme_is_ordered_message (MessageDef * const message_p)
+{
+  return (ITTI_MSG_ID (message_p) == SCTP_CLOSE_ASSOCIATION) || (ITTI_MSG_ID (message_p) == S1AP_ENB_INITIATED_RESET_ACK);
+}
+
+static void s1ap_mme_worker_handle_message (const task_id_t task_id, MessageDef * received_message_p);
+
+//------------------------------------------------------------------------------
+/*
+ * Handle the messages queued for the worker in the priority classes lower than
+ * the one of message_id, before a message of this id is handled.
+ */
+static void s1ap_mme_worker_handle_lower_priority_messages (const task_id_t task_id, const MessagesIds message_id)
+{
+  MessageDef                             *received_messages_p[S1AP_DISPATCH_BATCH_SIZE];
+  int                                     nb_messages = 0;
+
+  do {
+    nb_messages = itti_receive_lower_priority_msgs (task_id, message_id, received_messages_p, S1AP_DISPATCH_BATCH_SIZE);
+
+    for (int i = 0; i < nb_messages; i++) {
+      s1ap_mme_worker_handle_message (task_id, received_messages_p[i]);
+    }
+  } while (nb_messages == S1AP_DISPATCH_BATCH_SIZE);
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_mme_worker_handle_message (const task_id_t task_id, MessageDef * received_message_p)
+{
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+
+  if (s1ap_mme_is_ordered_message (received_message_p)) {
+    s1ap_mme_worker_handle_lower_priority_messages (task_id, ITTI_MSG_ID (received_message_p));
+  }
+
+  switch (ITTI_MSG_ID (received_message_p)) {
+  case SCTP_DATA_IND:{
+      /*
+       * New message received from SCTP layer.
+       * * * * Decode and handle it.
+       */
+      s1ap_message                            message = {0};
+      s1ap_uplink_nas_transport_t             ul_nas_transport = {0};
+
+      /*
+       * UplinkNASTransport, most of the S1AP traffic, is decoded without
+       * asn1c, anything else or any unexpected encoding falls back to asn1c.
+       */
+      if (s1ap_mme_fast_decode_uplink_nas_transport (SCTP_DATA_IND (received_message_p).payload, &ul_nas_transport) == RETURNok) {
+        s1ap_mme_handle_uplink_nas_transport_fast (SCTP_DATA_IND (received_message_p).assoc_id,
+                                                   SCTP_DATA_IND (received_message_p).stream, &ul_nas_transport,
+                                                   &SCTP_DATA_IND (received_message_p).payload);
+        break;
+      }
+
+      /*
+       * Invoke S1AP message decoder
+       */
+      if (s1ap_mme_decode_pdu (&message, SCTP_DATA_IND (received_message_p).payload, &message_id) < 0) {
+        // TODO: Notify eNB of failure with right cause
+        OAILOG_ERROR (LOG_S1AP, "Failed to decode new buffer\n");
+      } else if (!s1ap_mme_forward_to_ue_worker (task_id, received_message_p, &message)) {
+        s1ap_mme_handle_message (SCTP_DATA_IND (received_message_p).assoc_id,
+                                 SCTP_DATA_IND (received_message_p).stream, &message);
+      }
+
+      if (message_id != MESSAGES_ID_MAX) {
+        s1ap_free_mme_decode_pdu(&message, message_id);
+      }
+
+      /*
+       * Free received PDU array
+       */
+      bdestroy_wrapper (&SCTP_DATA_IND (received_message_p).payload);
+    }
+    break;
+
+  case SCTP_DATA_CNF:
+    s1ap_mme_itti_nas_downlink_cnf(SCTP_DATA_CNF (received_message_p).mme_ue_s1ap_id, SCTP_DATA_CNF (received_message_p).is_success);
+    break;
+    /*
+     * SCTP layer notifies S1AP of disconnection of a peer.
+     */
+  case SCTP_CLOSE_ASSOCIATION:{
+    s1ap_handle_sctp_disconnection(SCTP_CLOSE_ASSOCIATION (received_message_p).assoc_id,
+                                   SCTP_CLOSE_ASSOCIATION (received_message_p).reset);
+    }
+    break;
+
+  case SCTP_NEW_ASSOCIATION:{
+      s1ap_handle_new_association (&received_message_p->ittiMsg.sctp_new_peer);
+    }
+    break;
+
+  case S1AP_E_RAB_SETUP_REQ:{
+      s1ap_generate_s1ap_e_rab_setup_req (&S1AP_E_RAB_SETUP_REQ (received_message_p));
+    }
+    break;
+
+  case S1AP_ENB_INITIATED_RESET_ACK:{
+      s1ap_handle_enb_initiated_reset_ack (&S1AP_ENB_INITIATED_RESET_ACK (received_message_p));
+    }
+    break;
+
+  case S1AP_NAS_DL_DATA_REQ:{
+      /*
+       * New message received from NAS task.
+       * This corresponds to a S1AP downlink nas transport message.
+       */
+      s1ap_generate_downlink_nas_transport (S1AP_NAS_DL_DATA_REQ (received_message_p).enb_ue_s1ap_id,
+          S1AP_NAS_DL_DATA_REQ (received_message_p).mme_ue_s1ap_id,
+          &S1AP_NAS_DL_DATA_REQ (received_message_p).nas_msg);
+    }
+    break;
+
+  // From MME_APP task
+  case S1AP_UE_CONTEXT_RELEASE_COMMAND:{
+      s1ap_handle_ue_context_release_command (&received_message_p->ittiMsg.s1ap_ue_context_release_command);
+    }
+    break;
+
+  case MME_APP_CONNECTION_ESTABLISHMENT_CNF:{
+      s1ap_handle_conn_est_cnf (&MME_APP_CONNECTION_ESTABLISHMENT_CNF (received_message_p));
+    }
+    break;
+  
+  case MME_APP_S1AP_MME_UE_ID_NOTIFICATION:{
+      s1ap_handle_mme_ue_id_notification (&MME_APP_S1AP_MME_UE_ID_NOTIFICATION (received_message_p));
+    }
+    break;
+  
+  case TIMER_HAS_EXPIRED:{
+      ue_description_t                       *ue_ref_p = NULL;
+      // the timer argument is the UE id itself
+      mme_ue_s1ap_id_t mme_ue_s1ap_id = (mme_ue_s1ap_id_t)(uintptr_t)received_message_p->ittiMsg.timer_has_expired.arg;
+
+      if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (mme_ue_s1ap_id)) == NULL) {
+        OAILOG_WARNING (LOG_S1AP, "Timer expired but no assoicated UE context for UE id %d\n",mme_ue_s1ap_id);
+        break;
+      }
+      if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_ref_p->s1ap_ue_context_rel_timer.id) {
+        // UE context release complete timer expiry handler 
+        s1ap_mme_handle_ue_context_rel_comp_timer_expiry (ue_ref_p);
+      } 
+      
+      /* TODO - Commenting out below function as it is not used as of now. 
+       * Need to handle it when we support other timers in S1AP
+       */
+
+      //s1ap_handle_timer_expiry (&received_message_p->ittiMsg.timer_has_expired);
+    }
+    break;
+
+  case TERMINATE_MESSAGE:{
+      itti_free_msg_content(received_message_p);
+      itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+      arena_destroy (&s1ap_asn_arena);
+      OAI_FPRINTF_INFO("%s terminated\n", itti_get_task_name (task_id));
+      // the shared collections are not accessed anymore
+      s1ap_mme_worker_count (&s1ap_nb_exited_workers);
+      itti_exit_task ();
+    }
+    break;
+
+  default:{
+      OAILOG_ERROR (LOG_S1AP, "Unknown message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+    }
+    break;
+  }
+
+  itti_free_msg_content(received_message_p);
+  itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+  arena_reset (s1ap_asn_arena);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * S1AP worker task: all the messages related to an eNB association (and to
+ * its UEs) are handled by the same worker, in the order TASK_S1AP received
+ * them, so that the per eNB procedures need no locking. Workers only share
+ * the thread safe eNB and UE collections.
+ */
+static void                            *
+s1ap_mme_worker_thread (
+  void *args)
+{
+  const task_id_t                         task_id = (task_id_t)(uintptr_t)args;
+
+  /*
+   * The asn1c allocations done while a message is handled (decoded PDU,
+   * encoded answers) are released at once when it has been handled
+   */
+  s1ap_worker_task_id = task_id;
+  s1ap_asn_arena = arena_create (itti_get_task_name (task_id), S1AP_ASN_ARENA_CHUNK_SIZE);
+  AssertFatal (s1ap_asn_arena, "Cannot create S1AP codec arena\n");
+  itti_mark_task_ready (task_id);
+  s1ap_mme_worker_count (&s1ap_nb_ready_workers);
 
   while (1) {
     MessageDef                             *received_message_p = NULL;
-    MessagesIds                             message_id = MESSAGES_ID_MAX;
     /*
      * Trying to fetch a message from the message queue.
      * * * * If the queue is empty, this function will block till a
      * * * * message is sent to the task.
      */
-    itti_receive_msg (TASK_S1AP, &received_message_p);
+    itti_receive_msg (task_id, &received_message_p);
     DevAssert (received_message_p != NULL);
+    s1ap_mme_worker_handle_message (task_id, received_message_p);
+  }
 
-    switch (ITTI_MSG_ID (received_message_p)) {
-    case ACTIVATE_MESSAGE:{
-        hss_associated = true;
-      }
-      break;
-
-    case MESSAGE_TEST:
-      OAILOG_DEBUG (LOG_S1AP, "Received MESSAGE_TEST\n");
-      break;
-
-    case SCTP_DATA_IND:{
-        /*
-         * New message received from SCTP layer.
-         * * * * Decode and handle it.
-         */
-        s1ap_message                            message = {0};
-
-        /*
-         * Invoke S1AP message decoder
-         */
-        if (s1ap_mme_decode_pdu (&message, SCTP_DATA_IND (received_message_p).payload, &message_id) < 0) {
-          // TODO: Notify eNB of failure with right cause
-          OAILOG_ERROR (LOG_S1AP, "Failed to decode new buffer\n");
-        } else {
-          s1ap_mme_handle_message (SCTP_DATA_IND (received_message_p).assoc_id,
-                                   SCTP_DATA_IND (received_message_p).stream, &message);
-        }
+  return NULL;
+}
 
-        if (message_id != MESSAGES_ID_MAX) {
-          s1ap_free_mme_decode_pdu(&message, message_id);
-        }
+//------------------------------------------------------------------------------
+static task_id_t s1ap_mme_worker_for_message (MessageDef * const message_p)
+{
+  switch (ITTI_MSG_ID (message_p)) {
+  case SCTP_DATA_IND:
+    return s1ap_mme_worker_for_assoc (SCTP_DATA_IND (message_p).assoc_id);
 
-        /*
-         * Free received PDU array
-         */
-        bdestroy_wrapper (&SCTP_DATA_IND (received_message_p).payload);
-      }
-      break;
+  case SCTP_DATA_CNF:
+    return s1ap_mme_worker_for_assoc (SCTP_DATA_CNF (message_p).assoc_id);
 
-    case SCTP_DATA_CNF:
-      s1ap_mme_itti_nas_downlink_cnf(SCTP_DATA_CNF (received_message_p).mme_ue_s1ap_id, SCTP_DATA_CNF (received_message_p).is_success);
-      break;
-      /*
-       * SCTP layer notifies S1AP of disconnection of a peer.
-       */
-    case SCTP_CLOSE_ASSOCIATION:{
-      s1ap_handle_sctp_disconnection(SCTP_CLOSE_ASSOCIATION (received_message_p).assoc_id,
-                                     SCTP_CLOSE_ASSOCIATION (received_message_p).reset);
-      }
-      break;
+  case SCTP_CLOSE_ASSOCIATION:
+    return s1ap_mme_worker_for_assoc (SCTP_CLOSE_ASSOCIATION (message_p).assoc_id);
 
-    case SCTP_NEW_ASSOCIATION:{
-        s1ap_handle_new_association (&received_message_p->ittiMsg.sctp_new_peer);
-      }
-      break;
+  case SCTP_NEW_ASSOCIATION:
+    return s1ap_mme_worker_for_assoc (SCTP_NEW_ASSOCIATION (message_p).assoc_id);
 
-    case S1AP_E_RAB_SETUP_REQ:{
-        s1ap_generate_s1ap_e_rab_setup_req (&S1AP_E_RAB_SETUP_REQ (received_message_p));
-      }
-      break;
+  case S1AP_ENB_INITIATED_RESET_ACK:
+    return s1ap_mme_worker_for_assoc (S1AP_ENB_INITIATED_RESET_ACK (message_p).sctp_assoc_id);
 
-    case S1AP_ENB_INITIATED_RESET_ACK:{
-        s1ap_handle_enb_initiated_reset_ack (&S1AP_ENB_INITIATED_RESET_ACK (received_message_p));
-      }
-      break;
-
-    case S1AP_NAS_DL_DATA_REQ:{
-        /*
-         * New message received from NAS task.
-         * This corresponds to a S1AP downlink nas transport message.
-         */
-        s1ap_generate_downlink_nas_transport (S1AP_NAS_DL_DATA_REQ (received_message_p).enb_ue_s1ap_id,
-            S1AP_NAS_DL_DATA_REQ (received_message_p).mme_ue_s1ap_id,
-            &S1AP_NAS_DL_DATA_REQ (received_message_p).nas_msg);
-      }
-      break;
+  case MME_APP_S1AP_MME_UE_ID_NOTIFICATION:
+    /*
+     * Record the association of the UE now, the messages MME_APP sends
+     * right after this one for the same UE must reach the same worker.
+     */
+    hashtable_ts_insert (&g_s1ap_mme_id2assoc_id_coll, (const hash_key_t)MME_APP_S1AP_MME_UE_ID_NOTIFICATION (message_p).mme_ue_s1ap_id,
+        (void *)(uintptr_t)MME_APP_S1AP_MME_UE_ID_NOTIFICATION (message_p).sctp_assoc_id);
+    return s1ap_mme_worker_for_assoc (MME_APP_S1AP_MME_UE_ID_NOTIFICATION (message_p).sctp_assoc_id);
 
-    // From MME_APP task
-    case S1AP_UE_CONTEXT_RELEASE_COMMAND:{
-        s1ap_handle_ue_context_release_command (&received_message_p->ittiMsg.s1ap_ue_context_release_command);
-      }
-      break;
+  case S1AP_E_RAB_SETUP_REQ:
+    return s1ap_mme_worker_for_ue (S1AP_E_RAB_SETUP_REQ (message_p).mme_ue_s1ap_id);
 
-    case MME_APP_CONNECTION_ESTABLISHMENT_CNF:{
-        s1ap_handle_conn_est_cnf (&MME_APP_CONNECTION_ESTABLISHMENT_CNF (received_message_p));
-      }
-      break;
-    
-    case MME_APP_S1AP_MME_UE_ID_NOTIFICATION:{
-        s1ap_handle_mme_ue_id_notification (&MME_APP_S1AP_MME_UE_ID_NOTIFICATION (received_message_p));
-      }
-      break;
-    
-    case TIMER_HAS_EXPIRED:{
-        ue_description_t                       *ue_ref_p = NULL;
-        if (received_message_p->ittiMsg.timer_has_expired.arg != NULL) { 
-          mme_ue_s1ap_id_t mme_ue_s1ap_id = *((mme_ue_s1ap_id_t *)(received_message_p->ittiMsg.timer_has_expired.arg));
-          if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (mme_ue_s1ap_id)) == NULL) {
-            OAILOG_WARNING (LOG_S1AP, "Timer expired but no assoicated UE context for UE id %d\n",mme_ue_s1ap_id);
-            break;
-          }
-          if (received_message_p->ittiMsg.timer_has_expired.timer_id == ue_ref_p->s1ap_ue_context_rel_timer.id) {
-            // UE context release complete timer expiry handler 
-            s1ap_mme_handle_ue_context_rel_comp_timer_expiry (ue_ref_p);
-          } 
-        }
-        
-        /* TODO - Commenting out below function as it is not used as of now. 
-         * Need to handle it when we support other timers in S1AP
-         */
+  case S1AP_NAS_DL_DATA_REQ:
+    return s1ap_mme_worker_for_ue (S1AP_NAS_DL_DATA_REQ (message_p).mme_ue_s1ap_id);
 
-        //s1ap_handle_timer_expiry (&received_message_p->ittiMsg.timer_has_expired);
-      }
-      break;
-
-    case TERMINATE_MESSAGE:{
-        s1ap_mme_exit();
-        itti_free_msg_content(received_message_p);
-        itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-        OAI_FPRINTF_INFO("TASK_S1AP terminated\n");
-        itti_exit_task ();
-      }
-      break;
+  case S1AP_UE_CONTEXT_RELEASE_COMMAND:
+    return s1ap_mme_worker_for_ue (S1AP_UE_CONTEXT_RELEASE_COMMAND (message_p).mme_ue_s1ap_id);
+
+  case MME_APP_CONNECTION_ESTABLISHMENT_CNF:
+    return s1ap_mme_worker_for_ue (MME_APP_CONNECTION_ESTABLISHMENT_CNF (message_p).ue_id);
+
+  case TIMER_HAS_EXPIRED:
+    // the only S1AP timer, UE context release complete, carries the UE id by value
+    return s1ap_mme_worker_for_ue ((mme_ue_s1ap_id_t)(uintptr_t)message_p->ittiMsg.timer_has_expired.arg);
+
+  default:
+    return TASK_S1AP_WORKER_0;
+  }
+}
 
-    default:{
-        OAILOG_ERROR (LOG_S1AP, "Unknown message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+//------------------------------------------------------------------------------
+/*
+ * Forward TERMINATE_MESSAGE to the workers and wait for their exit, the eNB
+ * and UE collections they share can only be released afterwards.
+ */
+static void s1ap_mme_stop_workers (void)
+{
+  for (uint32_t w = 0; w < s1ap_nb_workers; w++) {
+    MessageDef                             *message_p = itti_alloc_new_message (TASK_S1AP, TERMINATE_MESSAGE);
+
+    // the worker may already have received the broadcast TERMINATE_MESSAGE
+    itti_send_msg_to_task (TASK_S1AP_WORKER_0 + w, INSTANCE_DEFAULT, message_p);
+  }
+
+  pthread_mutex_lock (&s1ap_workers_mutex);
+  while (s1ap_nb_exited_workers < s1ap_nb_ready_workers) {
+    pthread_cond_wait (&s1ap_workers_cond, &s1ap_workers_mutex);
+  }
+  pthread_mutex_unlock (&s1ap_workers_mutex);
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_mme_dispatch_message (MessageDef * received_message_p)
+{
+  switch (ITTI_MSG_ID (received_message_p)) {
+  case ACTIVATE_MESSAGE:
+    hss_associated = true;
+    break;
+
+  case MESSAGE_TEST:
+    OAILOG_DEBUG (LOG_S1AP, "Received MESSAGE_TEST\n");
+    break;
+
+  case TERMINATE_MESSAGE:
+    s1ap_mme_stop_workers ();
+    s1ap_mme_exit();
+    itti_free_msg_content(received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+    OAI_FPRINTF_INFO("TASK_S1AP terminated\n");
+    itti_exit_task ();
+    break;
+
+  default:{
+      task_id_t                               worker_task_id = s1ap_mme_worker_for_message (received_message_p);
+
+      if (itti_send_msg_to_task (worker_task_id, ITTI_MSG_INSTANCE (received_message_p), received_message_p) < 0) {
+        OAILOG_ERROR (LOG_S1AP, "Could not dispatch %s to %s, message dropped\n",
+            ITTI_MSG_NAME (received_message_p), itti_get_task_name (worker_task_id));
       }
-      break;
+      // owned by the worker (or released by ITTI) now
+      received_message_p = NULL;
     }
+    break;
+  }
 
+  if (received_message_p) {
     itti_free_msg_content(received_message_p);
     itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-    received_message_p = NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+ * TASK_S1AP only dispatches the messages received from SCTP, MME_APP and the
+ * timers to the worker serving the eNB association they relate to, decoding,
+ * encoding and handling take place in the workers.
+ */
+void                                   *
+s1ap_mme_thread (
+  __attribute__((unused)) void *args)
+{
+  MessageDef                             *received_messages_p[S1AP_DISPATCH_BATCH_SIZE];
+  MessageDef                             *ordered_messages_p[S1AP_DISPATCH_BATCH_SIZE];
+  int                                     nb_messages = 0;
+  int                                     nb_ordered_messages = 0;
+  int                                     i = 0;
+
+  // Nothing can be dispatched before every worker is ready
+  pthread_mutex_lock (&s1ap_workers_mutex);
+  while (s1ap_nb_ready_workers < s1ap_nb_workers) {
+    pthread_cond_wait (&s1ap_workers_cond, &s1ap_workers_mutex);
+  }
+  pthread_mutex_unlock (&s1ap_workers_mutex);
+  itti_mark_task_ready (TASK_S1AP);
+
+  if (s1ap_send_init_sctp () < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Error while sendind SCTP_INIT_MSG to SCTP \n");
+  }
+
+  while (1) {
+    nb_messages = itti_receive_msgs (TASK_S1AP, received_messages_p, S1AP_DISPATCH_BATCH_SIZE);
+    nb_ordered_messages = 0;
+
+    for (i = 0; i < nb_messages; i++) {
+      if (s1ap_mme_is_ordered_message (received_messages_p[i])) {
+        ordered_messages_p[nb_ordered_messages++] = received_messages_p[i];
+      } else {
+        s1ap_mme_dispatch_message (received_messages_p[i]);
+      }
+    }
+
+    if (nb_ordered_messages) {
+      /*
+       * The lower priority messages queued before them are dispatched first,
+       * the workers keep this order.
+       */
+      do {
+        nb_messages = itti_receive_lower_priority_msgs (TASK_S1AP, ITTI_MSG_ID (ordered_messages_p[0]), received_messages_p, S1AP_DISPATCH_BATCH_SIZE);
+
+        for (i = 0; i < nb_messages; i++) {
+          s1ap_mme_dispatch_message (received_messages_p[i]);
+        }
+      } while (nb_messages == S1AP_DISPATCH_BATCH_SIZE);
+
+      for (i = 0; i < nb_ordered_messages; i++) {
+        s1ap_mme_dispatch_message (ordered_messages_p[i]);
+      }
+    }
   }
 
   return NULL;
 }
 
+//------------------------------------------------------------------------------
+// g_s1ap_enb_coll free function, a worker may still read the eNB of a UE it looked up
+static void s1ap_free_enb_description (void **enb_pp)
+{
+  epoch_defer_free (*enb_pp, free_wrapper);
+  *enb_pp = NULL;
+}
+
 //------------------------------------------------------------------------------
 int s1ap_mme_init(void)
 {
@@ -264,11 +602,12 @@ int s1ap_mme_init(void)
   } else {
     OAILOG_DEBUG (LOG_S1AP, "ASN1C version %d\n", get_asn1c_environment_version ());
   }
+  s1ap_mme_fast_codec_init ();
 
   OAILOG_DEBUG (LOG_S1AP, "S1AP Release v10.5\n");
   // 16 entries for n eNB.
   bstring bs1 = bfromcstr("s1ap_eNB_coll");
-  hash_table_ts_t* h = hashtable_ts_init (&g_s1ap_enb_coll, mme_config.max_enbs, NULL, free_wrapper, bs1);
+  hash_table_ts_t* h = hashtable_ts_init (&g_s1ap_enb_coll, mme_config.max_enbs, NULL, s1ap_free_enb_description, bs1);
   bdestroy_wrapper (&bs1);
   if (!h) return RETURNerror;
 
@@ -277,13 +616,35 @@ int s1ap_mme_init(void)
   bdestroy_wrapper (&bs2);
   if (!h) return RETURNerror;
 
-  if (itti_create_task (TASK_S1AP, &s1ap_mme_thread, NULL) < 0) {
-    OAILOG_ERROR (LOG_S1AP, "Error while creating S1AP task\n");
+  // UE descriptors are owned by their eNB ue_coll, these indexes only reference them
+  bstring bs3 = bfromcstr("s1ap_ue_mme_id_coll");
+  h = hashtable_ts_init (&g_s1ap_ue_mme_id_coll, mme_config.max_ues, NULL, hash_free_int_func, bs3);
+  bdestroy_wrapper (&bs3);
+  if (!h) return RETURNerror;
+
+  bstring bs4 = bfromcstr("s1ap_ue_s11_teid_coll");
+  h = hashtable_ts_init (&g_s1ap_ue_s11_teid_coll, mme_config.max_ues, NULL, hash_free_int_func, bs4);
+  bdestroy_wrapper (&bs4);
+  if (!h) return RETURNerror;
+
+  g_s1ap_ue_slab = slab_create ("s1ap_ue_slab", sizeof (ue_description_t), S1AP_UE_SLAB_CHUNK_SIZE);
+  if (!g_s1ap_ue_slab) return RETURNerror;
+
+  s1ap_nb_workers = mme_config.s1ap_config.nb_workers;
+  if ((s1ap_nb_workers == 0) || (s1ap_nb_workers > S1AP_NB_WORKERS_MAX)) {
+    OAILOG_ERROR (LOG_S1AP, "Bad number of S1AP workers %u, expecting 1..%d\n", s1ap_nb_workers, S1AP_NB_WORKERS_MAX);
     return RETURNerror;
   }
+  for (uint32_t w = 0; w < s1ap_nb_workers; w++) {
+    if (itti_create_task (TASK_S1AP_WORKER_0 + w, &s1ap_mme_worker_thread, (void *)(uintptr_t)(TASK_S1AP_WORKER_0 + w)) < 0) {
+      OAILOG_ERROR (LOG_S1AP, "Error while creating S1AP worker task %u\n", w);
+      return RETURNerror;
+    }
+  }
 
-  if (s1ap_send_init_sctp () < 0) {
-    OAILOG_ERROR (LOG_S1AP, "Error while sendind SCTP_INIT_MSG to SCTP \n");
+  // SCTP_INIT_MSG is sent by the task once ready to receive the SCTP notifications
+  if (itti_create_task (TASK_S1AP, &s1ap_mme_thread, NULL) < 0) {
+    OAILOG_ERROR (LOG_S1AP, "Error while creating S1AP task\n");
     return RETURNerror;
   }
 
@@ -301,6 +662,17 @@ void s1ap_mme_exit (void)
   if (hashtable_ts_destroy(&g_s1ap_mme_id2assoc_id_coll) != HASH_TABLE_OK) {
     OAI_FPRINTF_ERR("An error occured while destroying assoc_id hash table");
   }
+  if (hashtable_ts_destroy(&g_s1ap_ue_mme_id_coll) != HASH_TABLE_OK) {
+    OAI_FPRINTF_ERR("An error occured while destroying UE mme_ue_s1ap_id hash table");
+  }
+  if (hashtable_ts_destroy(&g_s1ap_ue_s11_teid_coll) != HASH_TABLE_OK) {
+    OAI_FPRINTF_ERR("An error occured while destroying UE S11 TEID hash table");
+  }
+  // UE descriptors still waiting for the end of the epoch read sections return to the slab first
+  for (int i = 0; (epoch_reclaim ()) && (i < S1AP_EXIT_RECLAIM_ROUNDS); i++) {
+    usleep (1000);
+  }
+  slab_destroy (&g_s1ap_ue_slab);
   OAILOG_DEBUG (LOG_S1AP, "Cleaning S1AP: DONE\n");
 }
 
@@ -347,7 +719,7 @@ s1ap_dump_enb (
   eNB_LIST_OUT ("SCTP outstreams:   %d", enb_ref->outstreams);
   eNB_LIST_OUT ("UE attache to eNB: %d", enb_ref->nb_ue_associated);
   indent++;
-  hashtable_ts_apply_callback_on_elements((hash_table_ts_t * const)&enb_ref->ue_coll, s1ap_dump_ue_hash_cb, NULL, NULL);
+  hashtable_oa_ts_apply_callback_on_elements(enb_ref->ue_coll, s1ap_dump_ue_hash_cb, NULL, NULL);
   indent--;
   eNB_LIST_OUT ("");
 #  else
@@ -440,88 +812,133 @@ s1ap_is_ue_enb_id_in_list (
   const enb_ue_s1ap_id_t enb_ue_s1ap_id)
 {
   ue_description_t                       *ue_ref = NULL;
-  hashtable_ts_get ((hash_table_ts_t * const)&enb_ref->ue_coll, (const hash_key_t)enb_ue_s1ap_id, (void **)&ue_ref);
+  hashtable_oa_ts_get (enb_ref->ue_coll, (const hash_key_t)enb_ue_s1ap_id, (void **)&ue_ref);
   return ue_ref;
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_ue_compare_by_mme_ue_id_cb (__attribute__((unused)) const hash_key_t keyP,
-                                      void * const elementP, void * parameterP, void **resultP)
+ue_description_t                       *
+s1ap_is_ue_mme_id_in_list (
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id)
 {
-  mme_ue_s1ap_id_t                      * mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t*)parameterP;
-  ue_description_t                       *ue_ref           = (ue_description_t*)elementP;
-  if ( *mme_ue_s1ap_id_p == ue_ref->mme_ue_s1ap_id ) {
-    *resultP = elementP;
-    OAILOG_TRACE(LOG_S1AP, "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n", ue_ref, ue_ref->mme_ue_s1ap_id);
-    return true;
+  ue_description_t                       *ue_ref = NULL;
+
+  /*
+   * The UE may belong to an eNB served by another worker, which releases it
+   * at any time: the epoch read section keeps the UE and its eNB readable
+   * while the owner is checked, and only the owning worker gets the UE.
+   */
+  epoch_read_lock ();
+  if ((HASH_TABLE_OK == hashtable_ts_get (&g_s1ap_ue_mme_id_coll, (const hash_key_t)mme_ue_s1ap_id, (void **)&ue_ref)) &&
+      (TASK_UNKNOWN != s1ap_worker_task_id) &&
+      (s1ap_mme_worker_for_assoc (ue_ref->enb->sctp_assoc_id) != s1ap_worker_task_id)) {
+    OAILOG_WARNING (LOG_S1AP, "UE " MME_UE_S1AP_ID_FMT " is served by %s, not by %s\n", mme_ue_s1ap_id,
+        itti_get_task_name (s1ap_mme_worker_for_assoc (ue_ref->enb->sctp_assoc_id)), itti_get_task_name (s1ap_worker_task_id));
+    ue_ref = NULL;
   }
-  return false;
+  epoch_read_unlock ();
+  OAILOG_TRACE(LOG_S1AP, "Return ue_ref %p \n", ue_ref);
+  return ue_ref;
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_enb_find_ue_by_mme_ue_id_cb (__attribute__((unused))const hash_key_t keyP,
-                                       void * const elementP, void * parameterP, void **resultP)
+ue_description_t                       *
+s1ap_is_ue_mme_id_in_assoc (
+  const sctp_assoc_id_t  sctp_assoc_id,
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id)
 {
-  enb_description_t                      *enb_ref = (enb_description_t*)elementP;
+  ue_description_t                       *ue_ref = NULL;
 
-  hashtable_ts_apply_callback_on_elements((hash_table_ts_t * const)&enb_ref->ue_coll, s1ap_ue_compare_by_mme_ue_id_cb, parameterP, resultP);
-  if (*resultP) {
-    OAILOG_TRACE(LOG_S1AP, "Found ue_ref %p mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "\n", *resultP, ((ue_description_t*)(*resultP))->mme_ue_s1ap_id);
-    return true;
+  epoch_read_lock ();
+  ue_ref = s1ap_is_ue_mme_id_in_list (mme_ue_s1ap_id);
+  if ((ue_ref) && (ue_ref->enb->sctp_assoc_id != sctp_assoc_id)) {
+    OAILOG_WARNING (LOG_S1AP, "UE " MME_UE_S1AP_ID_FMT " is attached to sctp_assoc_id %d, not to %d\n",
+        mme_ue_s1ap_id, ue_ref->enb->sctp_assoc_id, sctp_assoc_id);
+    ue_ref = NULL;
   }
-  return false;
+  epoch_read_unlock ();
+  return ue_ref;
 }
+
 //------------------------------------------------------------------------------
-bool s1ap_ue_compare_by_s11_sgw_teid_cb (__attribute__((unused))const hash_key_t keyP,
-                                         void * const elementP,
-                                         void *parameterP, void **resultP)
+ue_description_t                       *
+s1ap_is_s11_sgw_teid_in_list (
+  const s11_teid_t teid)
 {
-  s11_teid_t                       * s11_sgw_teid_p = (s11_teid_t*)parameterP;
-  ue_description_t                  *ue_ref         = (ue_description_t*)elementP;
-  if ( *s11_sgw_teid_p == ue_ref->s11_sgw_teid ) {
-    *resultP = elementP;
-    return true;
-  }
-  return false;
+  ue_description_t                       *ue_ref = NULL;
+
+  hashtable_ts_get (&g_s1ap_ue_s11_teid_coll, (const hash_key_t)teid, (void **)&ue_ref);
+  return ue_ref;
 }
 
 //------------------------------------------------------------------------------
-bool s1ap_enb_find_ue_by_s11_sgw_teid_cb (__attribute((unused)) const hash_key_t keyP,
-                                          void * const elementP, void * parameterP, void **resultP)
+void s1ap_set_ue_s11_sgw_teid (
+    ue_description_t * const ue_ref,
+    const s11_teid_t         s11_sgw_teid)
 {
-  enb_description_t                      *enb_ref = (enb_description_t*)elementP;
+  ue_description_t                       *indexed_ue_ref = NULL;
 
-  hashtable_ts_apply_callback_on_elements((hash_table_ts_t * const)&enb_ref->ue_coll, s1ap_ue_compare_by_s11_sgw_teid_cb, parameterP, resultP);
-  if (*resultP) {
-    return true;
+  if ((ue_ref->s11_sgw_teid) &&
+      (HASH_TABLE_OK == hashtable_ts_get (&g_s1ap_ue_s11_teid_coll, (const hash_key_t)ue_ref->s11_sgw_teid, (void **)&indexed_ue_ref)) &&
+      (indexed_ue_ref == ue_ref)) {
+    hashtable_ts_free (&g_s1ap_ue_s11_teid_coll, (const hash_key_t)ue_ref->s11_sgw_teid);
+  }
+  ue_ref->s11_sgw_teid = s11_sgw_teid;
+  if (s11_sgw_teid) {
+    hashtable_ts_free (&g_s1ap_ue_s11_teid_coll, (const hash_key_t)s11_sgw_teid);
+    hashtable_ts_insert (&g_s1ap_ue_s11_teid_coll, (const hash_key_t)s11_sgw_teid, (void *)ue_ref);
   }
-  return false;
 }
 
 //------------------------------------------------------------------------------
-ue_description_t                       *
-s1ap_is_ue_mme_id_in_list (
-  const mme_ue_s1ap_id_t mme_ue_s1ap_id)
+static void s1ap_unindex_ue (ue_description_t * const ue_ref)
 {
-  ue_description_t                       *ue_ref = NULL;
-  mme_ue_s1ap_id_t                       *mme_ue_s1ap_id_p = (mme_ue_s1ap_id_t*)&mme_ue_s1ap_id;
+  ue_description_t                       *indexed_ue_ref = NULL;
 
-  hashtable_ts_apply_callback_on_elements(&g_s1ap_enb_coll, s1ap_enb_find_ue_by_mme_ue_id_cb, (void*)mme_ue_s1ap_id_p, (void**)&ue_ref);
-  OAILOG_TRACE(LOG_S1AP, "Return ue_ref %p \n", ue_ref);
-  return ue_ref;
+  /*
+   * A newer UE descriptor may have been indexed with the same identifier
+   * (eNB reusing ids, MME reallocating mme_ue_s1ap_id), leave it untouched.
+   */
+  if ((HASH_TABLE_OK == hashtable_ts_get (&g_s1ap_ue_mme_id_coll, (const hash_key_t)ue_ref->mme_ue_s1ap_id, (void **)&indexed_ue_ref)) &&
+      (indexed_ue_ref == ue_ref)) {
+    hashtable_ts_free (&g_s1ap_ue_mme_id_coll, (const hash_key_t)ue_ref->mme_ue_s1ap_id);
+  }
+  indexed_ue_ref = NULL;
+  if ((ue_ref->s11_sgw_teid) &&
+      (HASH_TABLE_OK == hashtable_ts_get (&g_s1ap_ue_s11_teid_coll, (const hash_key_t)ue_ref->s11_sgw_teid, (void **)&indexed_ue_ref)) &&
+      (indexed_ue_ref == ue_ref)) {
+    hashtable_ts_free (&g_s1ap_ue_s11_teid_coll, (const hash_key_t)ue_ref->s11_sgw_teid);
+  }
 }
 
 //------------------------------------------------------------------------------
-// TODO(amar) unused function check with OAI.
-ue_description_t                       *
-s1ap_is_s11_sgw_teid_in_list (
-  const s11_teid_t teid)
+static bool s1ap_unindex_ue_cb (__attribute__((unused)) const hash_key_t keyP,
+               void * const ue_void,
+               void __attribute__((unused)) *unused_parameterP,
+               void __attribute__((unused)) **unused_resultP)
 {
-  ue_description_t                       *ue_ref = NULL;
-  s11_teid_t                             *teid_id_p = (s11_teid_t*)&teid;
+  if (ue_void) {
+    s1ap_unindex_ue ((ue_description_t *)ue_void);
+  }
+  return false;
+}
 
-  hashtable_ts_apply_callback_on_elements(&g_s1ap_enb_coll, s1ap_enb_find_ue_by_s11_sgw_teid_cb, (void *)teid_id_p, (void**)&ue_ref);
-  return ue_ref;
+//------------------------------------------------------------------------------
+sctp_stream_id_t s1ap_mme_ue_stream (const ue_description_t * const ue_ref)
+{
+  uint32_t                                key = 0;
+
+  /*
+   * Stream 0 is reserved for non UE associated signalling (S1 Setup, Reset,...),
+   * UE associated signalling is spread over streams 1..outstreams-1 so that a
+   * lost DATA chunk only delays the UEs sharing its stream (head of line blocking).
+   */
+  if ((!ue_ref->enb) || (ue_ref->enb->outstreams <= 1)) {
+    return 0;
+  }
+  key = (INVALID_MME_UE_S1AP_ID != ue_ref->mme_ue_s1ap_id) ? ue_ref->mme_ue_s1ap_id : ue_ref->enb_ue_s1ap_id;
+  // multiplicative hash, consecutive ids are allocated by MME_APP
+  return (sctp_stream_id_t)(1 + (((key * 2654435761u) >> 16) % (ue_ref->enb->outstreams - 1)));
 }
 
 //------------------------------------------------------------------------------
@@ -534,7 +951,15 @@ void s1ap_notified_new_ue_mme_s1ap_id_association (
   if (enb_ref) {
     ue_description_t   *ue_ref = s1ap_is_ue_enb_id_in_list (enb_ref,enb_ue_s1ap_id);
     if (ue_ref) {
+      s1ap_unindex_ue (ue_ref);
       ue_ref->mme_ue_s1ap_id = mme_ue_s1ap_id;
+      ue_ref->sctp_stream_send = s1ap_mme_ue_stream (ue_ref);
+      hashtable_ts_free (&g_s1ap_ue_mme_id_coll, (const hash_key_t) mme_ue_s1ap_id);
+      hashtable_ts_insert (&g_s1ap_ue_mme_id_coll, (const hash_key_t) mme_ue_s1ap_id, (void *)ue_ref);
+      if (ue_ref->s11_sgw_teid) {
+        hashtable_ts_free (&g_s1ap_ue_s11_teid_coll, (const hash_key_t) ue_ref->s11_sgw_teid);
+        hashtable_ts_insert (&g_s1ap_ue_s11_teid_coll, (const hash_key_t) ue_ref->s11_sgw_teid, (void *)ue_ref);
+      }
       hashtable_rc_t  h_rc = hashtable_ts_insert (&g_s1ap_mme_id2assoc_id_coll, (const hash_key_t) mme_ue_s1ap_id, (void *)(uintptr_t)sctp_assoc_id);
       OAILOG_DEBUG(LOG_S1AP, "Associated  sctp_assoc_id %d, enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT ", mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ":%s \n",
           sctp_assoc_id, enb_ue_s1ap_id, mme_ue_s1ap_id, hashtable_rc_code2string(h_rc));
@@ -546,6 +971,14 @@ void s1ap_notified_new_ue_mme_s1ap_id_association (
   OAILOG_DEBUG(LOG_S1AP, "Could not find  eNB with sctp_assoc_id %d \n", sctp_assoc_id);
 }
 
+//------------------------------------------------------------------------------
+// ue_coll free function, UE descriptors are allocated from the UE slab
+static void s1ap_free_ue_description (void **ue_pp)
+{
+  slab_free (g_s1ap_ue_slab, *ue_pp);
+  *ue_pp = NULL;
+}
+
 //------------------------------------------------------------------------------
 enb_description_t *s1ap_new_enb (void)
 {
@@ -558,11 +991,16 @@ enb_description_t *s1ap_new_enb (void)
    * * * * TODO: Notify eNB with a cause like Hardware Failure.
    */
   DevAssert (enb_ref != NULL);
-  // Update number of eNB associated
-  nb_enb_associated++;
+  // Update number of eNB associated, eNBs are created by several workers
+  __sync_fetch_and_add (&nb_enb_associated, 1);
+  /*
+   * Most eNBs serve a few UEs only, start small and let the table grow
+   * instead of reserving mme_config.max_ues slots for each of them.
+   */
   bstring bs = bfromcstr("s1ap_ue_coll");
-  hashtable_ts_init(&enb_ref->ue_coll, mme_config.max_ues, NULL, free_wrapper, bs);
+  enb_ref->ue_coll = hashtable_oa_ts_create (S1AP_ENB_UE_COLL_INITIAL_SIZE, NULL, s1ap_free_ue_description, bs);
   bdestroy_wrapper (&bs);
+  DevAssert (enb_ref->ue_coll != NULL);
   enb_ref->nb_ue_associated = 0;
   return enb_ref;
 }
@@ -577,7 +1015,7 @@ s1ap_new_ue (
 
   enb_ref = s1ap_is_enb_assoc_id_in_list (sctp_assoc_id);
   DevAssert (enb_ref != NULL);
-  ue_ref = calloc (1, sizeof (ue_description_t));
+  ue_ref = slab_alloc (g_s1ap_ue_slab);
   /*
    * Something bad happened during malloc...
    * * * * May be we are running out of memory.
@@ -587,10 +1025,10 @@ s1ap_new_ue (
   ue_ref->enb = enb_ref;
   ue_ref->enb_ue_s1ap_id = enb_ue_s1ap_id;
 
-  hashtable_rc_t  hashrc = hashtable_ts_insert (&enb_ref->ue_coll, (const hash_key_t) enb_ue_s1ap_id, (void *)ue_ref);
+  hashtable_rc_t  hashrc = hashtable_oa_ts_insert (enb_ref->ue_coll, (const hash_key_t) enb_ue_s1ap_id, (void *)ue_ref);
   if (HASH_TABLE_OK != hashrc) {
     OAILOG_ERROR(LOG_S1AP, "Could not insert UE descr in ue_coll: %s\n", hashtable_rc_code2string(hashrc));
-    free_wrapper((void**)&ue_ref);
+    slab_free (g_s1ap_ue_slab, ue_ref);
     return NULL;
   }
   MSC_LOG_EVENT (MSC_S1AP_MME, " Associating ue  (enb_ue_s1ap_id: " ENB_UE_S1AP_ID_FMT ") to eNB %s", ue_ref->mme_ue_s1ap_id, enb_ref->enb_name);
@@ -635,7 +1073,8 @@ s1ap_remove_ue (
       ue_ref->enb_ue_s1ap_id, ue_ref->mme_ue_s1ap_id, enb_ref->enb_id);
 
   ue_ref->s1_ue_state = S1AP_UE_INVALID_STATE;
-  hashtable_ts_free (&enb_ref->ue_coll, ue_ref->enb_ue_s1ap_id);
+  s1ap_unindex_ue (ue_ref);
+  hashtable_oa_ts_free (enb_ref->ue_coll, ue_ref->enb_ue_s1ap_id);
   hashtable_ts_free (&g_s1ap_mme_id2assoc_id_coll, mme_ue_s1ap_id);
   if (!enb_ref->nb_ue_associated) {
     if (enb_ref->s1_state == S1AP_RESETING) {
@@ -654,10 +1093,25 @@ void
 s1ap_remove_enb (
   enb_description_t * enb_ref)
 {
+  hashtable_key_array_t                  *keys = NULL;
+
   if (enb_ref == NULL)
     return;
-  hashtable_ts_destroy(&enb_ref->ue_coll);
+  hashtable_oa_ts_apply_callback_on_elements(enb_ref->ue_coll, s1ap_unindex_ue_cb, NULL, NULL);
+  /*
+   * Other workers may be reading the UEs in s1ap_is_ue_mme_id_in_list(),
+   * their release is deferred to the end of the epoch read sections.
+   */
+  if ((keys = hashtable_oa_ts_get_keys (enb_ref->ue_coll))) {
+    for (int i = 0; i < keys->num_keys; i++) {
+      hashtable_oa_ts_free (enb_ref->ue_coll, keys->keys[i]);
+    }
+    free_wrapper ((void**)&keys->keys);
+    free_wrapper ((void**)&keys);
+  }
+  hashtable_oa_ts_destroy(enb_ref->ue_coll);
+  enb_ref->ue_coll = NULL;
   hashtable_ts_free (&g_s1ap_enb_coll, enb_ref->sctp_assoc_id);
-  nb_enb_associated--;
+  __sync_fetch_and_sub (&nb_enb_associated, 1);
 }
 
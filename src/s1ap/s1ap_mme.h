@@ -113,13 +113,12 @@ typedef struct enb_description_s {
   /** UE list for this eNB **/
   /*@{*/
   uint32_t nb_ue_associated; ///< Number of NAS associated UE on this eNB
-  hash_table_ts_t  ue_coll; // contains ue_description_s, key is ue_description_s.?;
+  hash_table_oa_ts_t *ue_coll; ///< contains ue_description_t*, key is enb_ue_s1ap_id, grows with the UE population
   /*@}*/
 
   /** SCTP stuff **/
   /*@{*/
   sctp_assoc_id_t  sctp_assoc_id;    ///< SCTP association id on this machine
-  sctp_stream_id_t next_sctp_stream; ///< Next SCTP stream
   sctp_stream_id_t instreams;        ///< Number of streams avalaible on eNB -> MME
   sctp_stream_id_t outstreams;       ///< Number of streams avalaible on MME -> eNB
   /*@}*/
@@ -158,12 +157,41 @@ ue_description_t* s1ap_is_ue_enb_id_in_list(enb_description_t *enb_ref,
     const enb_ue_s1ap_id_t enb_ue_s1ap_id);
 
 /** \brief Look for given ue mme id in the list
+ * Single lookup in the MME wide mme_ue_s1ap_id index, whatever the number of eNBs.
  * \param enb_id The unique ue_mme_id to search in list
  * @returns NULL if no UE matchs the ue_mme_id, or reference to the ue element in list if matches
  **/
 ue_description_t* s1ap_is_ue_mme_id_in_list(const mme_ue_s1ap_id_t ue_mme_id);
+
+/** \brief Look for given ue mme id among the UEs of an eNB association
+ * Used for the UE associated messages received from an eNB, which must not
+ * reach a UE attached to another eNB.
+ * \param sctp_assoc_id The sctp association the message was received on
+ * \param ue_mme_id The unique ue_mme_id to search in list
+ * @returns NULL if no UE of the association matchs the ue_mme_id, or reference to the ue element in list if matches
+ **/
+ue_description_t* s1ap_is_ue_mme_id_in_assoc(const sctp_assoc_id_t sctp_assoc_id, const mme_ue_s1ap_id_t ue_mme_id);
+
+/** \brief Look for given S11 SGW TEID in the MME wide TEID index
+ * \param teid The S11 SGW TEID set with s1ap_set_ue_s11_sgw_teid()
+ * @returns NULL if no UE matchs the teid, or reference to the ue element in list if matches
+ **/
 ue_description_t* s1ap_is_s11_sgw_teid_in_list(const s11_teid_t teid);
 
+/** \brief Set the S11 SGW TEID of a UE and keep the TEID index up to date
+ * \param ue_ref UE structure reference
+ * \param s11_sgw_teid new TEID, 0 removes the UE from the TEID index
+ **/
+void s1ap_set_ue_s11_sgw_teid(ue_description_t * const ue_ref, const s11_teid_t s11_sgw_teid);
+
+/** \brief SCTP stream used for the UE associated signalling towards the eNB.
+ * Hash of mme_ue_s1ap_id (enb_ue_s1ap_id until the MME id is allocated) over
+ * the negotiated outbound streams, stream 0 is kept for non UE associated procedures.
+ * \param ue_ref UE descriptor, attached to its eNB
+ * @returns stream in [1, outstreams - 1], 0 if the association has a single outbound stream
+ **/
+sctp_stream_id_t s1ap_mme_ue_stream (const ue_description_t * const ue_ref);
+
 /** \brief associate mainly 2(3) identifiers in S1AP layer: {mme_ue_s1ap_id_t, sctp_assoc_id (,enb_ue_s1ap_id)}
  **/
 void s1ap_notified_new_ue_mme_s1ap_id_association (
@@ -0,0 +1,550 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_fast_codec.c
+  \brief Hand written APER codec for the most frequent S1AP procedures.
+
+  Layout of the PDUs handled here (X.691 aligned variant), every field
+  starts on an octet boundary:
+
+  S1AP-PDU         ext bit, 2 bits choice index, padding
+  procedureCode    1 octet
+  criticality      2 bits, padding
+  value            open type: length determinant, procedure message
+    ext bit, padding, 2 octets number of IEs
+    S1ap-IE        2 octets id, 2 bits criticality, padding,
+                   open type: length determinant, IE value
+
+  The bit fields inside the IE values:
+
+  UE-S1AP-IDs      choice ext bit, choice index (pair), ext bit,
+                   iE-Extensions bit, then both ids as below
+  Cause            choice ext bit, 3 bits choice index, enumerated ext
+                   bit, value on the bits needed for the root values
+
+  Length determinants are 1 octet below 128, 2 octets (10xxxxxx) below 16K.
+  Constrained integers wider than 16 bits are the number of octets minus 1
+  on 2 bits, padding, then the minimum number of octets.
+*/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+
+#include "assertions.h"
+#include "common_defs.h"
+#include "conversions.h"
+#include "dynamic_memory_check.h"
+#include "intertask_interface.h"
+#include "log.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_encoder.h"
+#include "s1ap_mme.h"
+#include "s1ap_mme_fast_codec.h"
+#include "s1ap_mme_handlers.h"
+
+#define S1AP_FAST_PDU_INITIATING_MESSAGE   0x00
+#define S1AP_FAST_CRITICALITY_REJECT       0x00
+#define S1AP_FAST_CRITICALITY_IGNORE       0x40
+/* Criticality is an enumerated of 3 values on 2 bits */
+#define S1AP_FAST_CRITICALITY_INVALID      0xc0
+
+#define S1AP_FAST_IE_MME_UE_S1AP_ID        0x01
+#define S1AP_FAST_IE_ENB_UE_S1AP_ID        0x02
+#define S1AP_FAST_IE_NAS_PDU               0x04
+#define S1AP_FAST_IE_EUTRAN_CGI            0x08
+#define S1AP_FAST_IE_TAI                   0x10
+#define S1AP_FAST_UPLINK_NAS_MANDATORY_IES 0x1f
+
+/* Largest length a 2 octets length determinant can carry */
+#define S1AP_FAST_MAX_LENGTH               16383
+
+/* IE id, criticality */
+#define S1AP_FAST_IE_HEADER_SIZE           3
+#define S1AP_FAST_TEMPLATE_MAX_IES         3
+
+/*
+ * Invariant part of an encoded procedure: PDU header and IE headers. The
+ * variable IE values are patched in between by the encoders.
+ */
+typedef struct s1ap_fast_template_s {
+  const char             *name;
+  uint8_t                 header[3];          ///< PDU choice, procedure code, criticality
+  uint8_t                 nb_ies;
+  uint8_t                 ie_headers[S1AP_FAST_TEMPLATE_MAX_IES][S1AP_FAST_IE_HEADER_SIZE];
+  bool                    enabled;            ///< cleared if the template does not match asn1c
+} s1ap_fast_template_t;
+
+static s1ap_fast_template_t s1ap_fast_downlink_nas_transport_template = {
+  .name = "DownlinkNASTransport",
+  .header = {S1AP_FAST_PDU_INITIATING_MESSAGE, S1ap_ProcedureCode_id_downlinkNASTransport, S1AP_FAST_CRITICALITY_REJECT},
+  .nb_ies = 3,
+  .ie_headers = {
+    {0, S1ap_ProtocolIE_ID_id_MME_UE_S1AP_ID, S1AP_FAST_CRITICALITY_REJECT},
+    {0, S1ap_ProtocolIE_ID_id_eNB_UE_S1AP_ID, S1AP_FAST_CRITICALITY_REJECT},
+    {0, S1ap_ProtocolIE_ID_id_NAS_PDU, S1AP_FAST_CRITICALITY_REJECT},
+  },
+  .enabled = true,
+};
+
+static s1ap_fast_template_t s1ap_fast_ue_context_release_command_template = {
+  .name = "UEContextReleaseCommand",
+  .header = {S1AP_FAST_PDU_INITIATING_MESSAGE, S1ap_ProcedureCode_id_UEContextRelease, S1AP_FAST_CRITICALITY_REJECT},
+  .nb_ies = 2,
+  .ie_headers = {
+    {0, S1ap_ProtocolIE_ID_id_UE_S1AP_IDs, S1AP_FAST_CRITICALITY_REJECT},
+    {0, S1ap_ProtocolIE_ID_id_Cause, S1AP_FAST_CRITICALITY_IGNORE},
+  },
+  .enabled = true,
+};
+
+/* Number of root values of the S1ap-Cause choices, radioNetwork first */
+static const long s1ap_fast_cause_root_values[] = {36, 2, 4, 7, 6};
+
+//------------------------------------------------------------------------------
+/*
+ * Reads a length determinant, returns the number of octets it takes or 0 if
+ * it does not fit in the buffer or is fragmented.
+ */
+static inline uint32_t s1ap_fast_get_length (const uint8_t * const buf, const uint32_t size, uint32_t * const length)
+{
+  if (size < 1) {
+    return 0;
+  }
+  if (!(buf[0] & 0x80)) {
+    *length = buf[0];
+    return 1;
+  }
+  if (((buf[0] & 0xc0) == 0x80) && (size >= 2)) {
+    *length = ((uint32_t)(buf[0] & 0x3f) << 8) | buf[1];
+    return 2;
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s1ap_fast_put_length (uint8_t * const buf, const uint32_t length)
+{
+  if (length < 128) {
+    buf[0] = (uint8_t)length;
+    return 1;
+  }
+  buf[0] = 0x80 | (uint8_t)(length >> 8);
+  buf[1] = (uint8_t)length;
+  return 2;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Constrained whole number wider than 16 bits, max_octets is 3 or 4.
+ */
+static inline int s1ap_fast_get_integer (const uint8_t * const buf, const uint32_t size, const uint32_t max_octets, uint32_t * const value)
+{
+  uint32_t                                nb_octets = 0;
+  uint32_t                                i = 0;
+
+  if (size < 2) {
+    return RETURNerror;
+  }
+  nb_octets = (buf[0] >> 6) + 1;
+  if ((nb_octets > max_octets) || (size != 1 + nb_octets)) {
+    return RETURNerror;
+  }
+  *value = 0;
+  for (i = 1; i <= nb_octets; i++) {
+    *value = (*value << 8) | buf[i];
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s1ap_fast_put_integer (uint8_t * const buf, const uint32_t value)
+{
+  uint32_t                                nb_octets = 1;
+  uint32_t                                i = 0;
+
+  while ((nb_octets < 4) && (value >> (8 * nb_octets))) {
+    nb_octets++;
+  }
+  buf[0] = (uint8_t)((nb_octets - 1) << 6);
+  for (i = 0; i < nb_octets; i++) {
+    buf[1 + i] = (uint8_t)(value >> (8 * (nb_octets - 1 - i)));
+  }
+  return 1 + nb_octets;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t s1ap_fast_ie_flag (const uint32_t id)
+{
+  switch (id) {
+  case S1ap_ProtocolIE_ID_id_MME_UE_S1AP_ID: return S1AP_FAST_IE_MME_UE_S1AP_ID;
+  case S1ap_ProtocolIE_ID_id_eNB_UE_S1AP_ID: return S1AP_FAST_IE_ENB_UE_S1AP_ID;
+  case S1ap_ProtocolIE_ID_id_NAS_PDU:        return S1AP_FAST_IE_NAS_PDU;
+  case S1ap_ProtocolIE_ID_id_EUTRAN_CGI:     return S1AP_FAST_IE_EUTRAN_CGI;
+  case S1ap_ProtocolIE_ID_id_TAI:            return S1AP_FAST_IE_TAI;
+  default:                                   return 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_fast_decode_uplink_nas_transport (const_bstring const raw, s1ap_uplink_nas_transport_t * const ul_nas_transport)
+{
+  const uint8_t                          *buf = NULL;
+  uint32_t                                size = 0;
+  uint32_t                                offset = 0;
+  uint32_t                                length = 0;
+  uint32_t                                n = 0;
+  uint32_t                                nb_ies = 0;
+  uint32_t                                ies_found = 0;
+  uint32_t                                i = 0;
+
+  if ((!raw) || (blength (raw) < 7)) {
+    return RETURNerror;
+  }
+  buf = (const uint8_t *)bdata (raw);
+  size = blength (raw);
+
+  // Not extended initiatingMessage, uplinkNASTransport
+  if (((buf[0] & 0xe0) != S1AP_FAST_PDU_INITIATING_MESSAGE) || (buf[1] != S1ap_ProcedureCode_id_uplinkNASTransport) ||
+      (buf[2] >= S1AP_FAST_CRITICALITY_INVALID)) {
+    return RETURNerror;
+  }
+  offset = 3;
+  if ((!(n = s1ap_fast_get_length (&buf[offset], size - offset, &length))) || (offset + n + length != size)) {
+    return RETURNerror;
+  }
+  offset += n;
+
+  // No extension in the IE container, number of IEs
+  if ((size - offset < 3) || (buf[offset] & 0x80)) {
+    return RETURNerror;
+  }
+  nb_ies = ((uint32_t)buf[offset + 1] << 8) | buf[offset + 2];
+  offset += 3;
+
+  memset (ul_nas_transport, 0, sizeof (*ul_nas_transport));
+
+  for (i = 0; i < nb_ies; i++) {
+    const uint8_t                          *value = NULL;
+    uint32_t                                id = 0;
+
+    if (size - offset < 4) {
+      return RETURNerror;
+    }
+    id = ((uint32_t)buf[offset] << 8) | buf[offset + 1];
+    if (buf[offset + 2] >= S1AP_FAST_CRITICALITY_INVALID) {
+      return RETURNerror;
+    }
+    offset += 3;
+    if ((!(n = s1ap_fast_get_length (&buf[offset], size - offset, &length))) || (length > size - offset - n)) {
+      return RETURNerror;
+    }
+    offset += n;
+    value = &buf[offset];
+    if (ies_found & s1ap_fast_ie_flag (id)) {
+      return RETURNerror;
+    }
+
+    switch (id) {
+    case S1ap_ProtocolIE_ID_id_MME_UE_S1AP_ID:
+      if (s1ap_fast_get_integer (value, length, 4, &ul_nas_transport->mme_ue_s1ap_id) != RETURNok) {
+        return RETURNerror;
+      }
+      ies_found |= S1AP_FAST_IE_MME_UE_S1AP_ID;
+      break;
+
+    case S1ap_ProtocolIE_ID_id_eNB_UE_S1AP_ID:
+      if (s1ap_fast_get_integer (value, length, 3, &ul_nas_transport->enb_ue_s1ap_id) != RETURNok) {
+        return RETURNerror;
+      }
+      ies_found |= S1AP_FAST_IE_ENB_UE_S1AP_ID;
+      break;
+
+    case S1ap_ProtocolIE_ID_id_NAS_PDU:{
+        uint32_t                                nas_length = 0;
+
+        if ((!(n = s1ap_fast_get_length (value, length, &nas_length))) || (n + nas_length != length)) {
+          return RETURNerror;
+        }
+        ul_nas_transport->nas_pdu_offset = offset + n;
+        ul_nas_transport->nas_pdu_length = nas_length;
+        ies_found |= S1AP_FAST_IE_NAS_PDU;
+      }
+      break;
+
+    case S1ap_ProtocolIE_ID_id_EUTRAN_CGI:{
+        // no extension, no iE-Extensions, 3 octets PLMN, 28 bits cell identity
+        OCTET_STRING_t                          plmn = {.buf = (uint8_t *)&value[1], .size = 3};
+        BIT_STRING_t                            cell_id = {.buf = (uint8_t *)&value[4], .size = 4, .bits_unused = 4};
+
+        if ((length != 8) || (value[0] & 0xc0)) {
+          return RETURNerror;
+        }
+        TBCD_TO_PLMN_T (&plmn, &ul_nas_transport->ecgi.plmn);
+        BIT_STRING_TO_CELL_IDENTITY (&cell_id, ul_nas_transport->ecgi.cell_identity);
+        ies_found |= S1AP_FAST_IE_EUTRAN_CGI;
+      }
+      break;
+
+    case S1ap_ProtocolIE_ID_id_TAI:{
+        // no extension, no iE-Extensions, 3 octets PLMN, 2 octets TAC
+        OCTET_STRING_t                          plmn = {.buf = (uint8_t *)&value[1], .size = 3};
+        OCTET_STRING_t                          tac = {.buf = (uint8_t *)&value[4], .size = 2};
+
+        if ((length != 6) || (value[0] & 0xc0)) {
+          return RETURNerror;
+        }
+        TBCD_TO_PLMN_T (&plmn, &ul_nas_transport->tai);
+        OCTET_STRING_TO_TAC (&tac, ul_nas_transport->tai.tac);
+        ies_found |= S1AP_FAST_IE_TAI;
+      }
+      break;
+
+    default:
+      // optional IEs (GW transport layer address) are left to asn1c
+      return RETURNerror;
+    }
+    offset += length;
+  }
+
+  if ((offset != size) || (ies_found != S1AP_FAST_UPLINK_NAS_MANDATORY_IES)) {
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Writes the invariant PDU header and the IE container header, returns the
+ * number of octets written.
+ */
+static inline uint32_t s1ap_fast_put_template_header (const s1ap_fast_template_t * const template, uint8_t * const buf, const uint32_t value_length)
+{
+  uint32_t                                offset = 0;
+
+  memcpy (buf, template->header, sizeof (template->header));
+  offset = sizeof (template->header);
+  offset += s1ap_fast_put_length (&buf[offset], value_length);
+  buf[offset++] = 0;
+  buf[offset++] = 0;
+  buf[offset++] = template->nb_ies;
+  return offset;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Writes the IE header of the ie_index-th IE of the template followed by the
+ * open type length of its value, returns the number of octets written.
+ */
+static inline uint32_t s1ap_fast_put_template_ie_header (const s1ap_fast_template_t * const template, const uint32_t ie_index, uint8_t * const buf,
+    const uint32_t ie_length)
+{
+  memcpy (buf, template->ie_headers[ie_index], S1AP_FAST_IE_HEADER_SIZE);
+  return S1AP_FAST_IE_HEADER_SIZE + s1ap_fast_put_length (&buf[S1AP_FAST_IE_HEADER_SIZE], ie_length);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Encodes the short IEs held in ies (IE values prefixed by their length, at
+ * most 127 octets) in a new PDU, leaving tail_length octets for the last IE.
+ * Returns a pointer past the short IEs or NULL on failure.
+ */
+static uint8_t *s1ap_fast_encode_template (const s1ap_fast_template_t * const template, const uint8_t * const ies, const uint32_t ies_length,
+    const uint32_t tail_length, bstring * const pdu)
+{
+  uint8_t                                *buf = NULL;
+  uint32_t                                value_length = 0;
+  uint32_t                                offset = 0;
+  uint32_t                                ies_offset = 0;
+  uint32_t                                i = 0;
+
+  // container header, IE headers, IE values
+  value_length = 3 + template->nb_ies * S1AP_FAST_IE_HEADER_SIZE + ies_length + tail_length;
+  if ((!template->enabled) || (value_length > S1AP_FAST_MAX_LENGTH)) {
+    return NULL;
+  }
+  if (!(*pdu = bfromcstralloc (sizeof (template->header) + 2 + value_length + 1, ""))) {
+    return NULL;
+  }
+  buf = (*pdu)->data;
+  offset = s1ap_fast_put_template_header (template, buf, value_length);
+  for (i = 0; ies_offset < ies_length; i++) {
+    offset += s1ap_fast_put_template_ie_header (template, i, &buf[offset], ies[ies_offset]);
+    memcpy (&buf[offset], &ies[ies_offset + 1], ies[ies_offset]);
+    offset += ies[ies_offset];
+    ies_offset += 1 + ies[ies_offset];
+  }
+  (*pdu)->slen = offset + tail_length;
+  (*pdu)->data[(*pdu)->slen] = '\0';
+  return &buf[offset];
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_fast_encode_downlink_nas_transport (const mme_ue_s1ap_id_t mme_ue_s1ap_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+    const_bstring const nas_pdu, bstring * const pdu)
+{
+  uint8_t                                 ies[16];
+  uint8_t                                *buf = NULL;
+  uint32_t                                ies_length = 0;
+  uint32_t                                nas_ie_length = 0;
+  uint32_t                                offset = 0;
+
+  if ((!nas_pdu) || (enb_ue_s1ap_id > 0x00ffffff)) {
+    return RETURNerror;
+  }
+  // NAS PDU length determinant + NAS PDU
+  nas_ie_length = ((blength (nas_pdu) < 128) ? 1 : 2) + blength (nas_pdu);
+  if (nas_ie_length > S1AP_FAST_MAX_LENGTH) {
+    return RETURNerror;
+  }
+
+  /*
+   * Only the UE ids and the NAS PDU vary, the rest comes from the template
+   */
+  ies[ies_length] = (uint8_t)s1ap_fast_put_integer (&ies[ies_length + 1], mme_ue_s1ap_id);
+  ies_length += 1 + ies[ies_length];
+  ies[ies_length] = (uint8_t)s1ap_fast_put_integer (&ies[ies_length + 1], enb_ue_s1ap_id);
+  ies_length += 1 + ies[ies_length];
+
+  if (!(buf = s1ap_fast_encode_template (&s1ap_fast_downlink_nas_transport_template, ies, ies_length,
+      S1AP_FAST_IE_HEADER_SIZE + ((nas_ie_length < 128) ? 1 : 2) + nas_ie_length, pdu))) {
+    return RETURNerror;
+  }
+  offset = s1ap_fast_put_template_ie_header (&s1ap_fast_downlink_nas_transport_template, 2, buf, nas_ie_length);
+  offset += s1ap_fast_put_length (&buf[offset], blength (nas_pdu));
+  memcpy (&buf[offset], nas_pdu->data, blength (nas_pdu));
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int s1ap_mme_fast_encode_ue_context_release_command (const mme_ue_s1ap_id_t mme_ue_s1ap_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+    const S1ap_Cause_PR cause_type, const long cause_value, bstring * const pdu)
+{
+  uint8_t                                 ies[16];
+  uint32_t                                ies_length = 0;
+  uint32_t                                n = 0;
+  uint32_t                                bits = 0;
+  uint32_t                                nb_bits = 0;
+
+  if ((enb_ue_s1ap_id > 0x00ffffff) || (cause_type < S1ap_Cause_PR_radioNetwork) || (cause_type > S1ap_Cause_PR_misc) ||
+      (cause_value < 0) || (cause_value >= s1ap_fast_cause_root_values[cause_type - S1ap_Cause_PR_radioNetwork])) {
+    // extension causes are left to asn1c
+    return RETURNerror;
+  }
+
+  /*
+   * UE-S1AP-IDs: choice extension bit, choice index (pair), sequence
+   * extension bit, iE-Extensions presence bit, then the two ids
+   */
+  n = s1ap_fast_put_integer (&ies[1], mme_ue_s1ap_id);
+  ies[1] >>= 4;
+  n += s1ap_fast_put_integer (&ies[1 + n], enb_ue_s1ap_id);
+  ies[0] = (uint8_t)n;
+  ies_length = 1 + n;
+
+  /*
+   * Cause: choice extension bit, 3 bits choice index, enumerated extension
+   * bit, enumerated value on the smallest number of bits for its root values
+   */
+  for (nb_bits = 1; (1 << nb_bits) < s1ap_fast_cause_root_values[cause_type - S1ap_Cause_PR_radioNetwork]; nb_bits++);
+  bits = ((uint32_t)(cause_type - S1ap_Cause_PR_radioNetwork) << 12) | ((uint32_t)cause_value << (11 - nb_bits));
+  n = (5 + nb_bits + 7) / 8;
+  ies[ies_length++] = (uint8_t)n;
+  ies[ies_length++] = (uint8_t)(bits >> 8);
+  if (n == 2) {
+    ies[ies_length++] = (uint8_t)bits;
+  }
+
+  if (!s1ap_fast_encode_template (&s1ap_fast_ue_context_release_command_template, ies, ies_length, 0, pdu)) {
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Compares the template encoding with the asn1c one for a few reference
+ * values, the template is disabled on mismatch.
+ */
+static void s1ap_fast_check_template (s1ap_fast_template_t * const template, s1ap_message * const message, const_bstring const pdu)
+{
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+
+  if (!template->enabled) {
+    return;
+  }
+  if ((!pdu) || (s1ap_mme_encode_pdu (message, &buffer, &length) < 0) || (blength (pdu) != length) ||
+      (memcmp (bdata (pdu), buffer, length))) {
+    OAILOG_WARNING (LOG_S1AP, "S1AP %s template does not match asn1c encoding, disabled\n", template->name);
+    template->enabled = false;
+  }
+  free_wrapper ((void**)&buffer);
+}
+
+//------------------------------------------------------------------------------
+void s1ap_mme_fast_codec_init (void)
+{
+  const mme_ue_s1ap_id_t                  mme_ue_s1ap_ids[] = {0, 0x7f, 0x1234, 0xfedcba, 0xffffffff};
+  const enb_ue_s1ap_id_t                  enb_ue_s1ap_ids[] = {0, 0x80, 0xffff, 0xffffff, 0x12};
+  const long                              cause_values[] = {S1ap_CauseRadioNetwork_release_due_to_eutran_generated_reason, S1ap_CauseTransport_unspecified,
+                                                            S1ap_CauseNas_detach, S1ap_CauseProtocol_unspecified, S1ap_CauseMisc_om_intervention};
+  uint8_t                                 nas[200] = {0};
+  s1ap_message                            message = {0};
+  bstring                                 nas_pdu = NULL;
+  bstring                                 pdu = NULL;
+  uint32_t                                i = 0;
+
+  for (i = 0; i < sizeof (mme_ue_s1ap_ids) / sizeof (mme_ue_s1ap_ids[0]); i++) {
+    // NAS PDU lengths on both sides of the 1 octet length determinant limit
+    nas_pdu = blk2bstr (nas, 60 + 35 * i);
+    memset (&message, 0, sizeof (message));
+    message.procedureCode = S1ap_ProcedureCode_id_downlinkNASTransport;
+    message.direction = S1AP_PDU_PR_initiatingMessage;
+    message.msg.s1ap_DownlinkNASTransportIEs.mme_ue_s1ap_id = mme_ue_s1ap_ids[i];
+    message.msg.s1ap_DownlinkNASTransportIEs.eNB_UE_S1AP_ID = enb_ue_s1ap_ids[i];
+    OCTET_STRING_fromBuf (&message.msg.s1ap_DownlinkNASTransportIEs.nas_pdu, (char *)bdata (nas_pdu), blength (nas_pdu));
+    pdu = NULL;
+    s1ap_mme_fast_encode_downlink_nas_transport (mme_ue_s1ap_ids[i], enb_ue_s1ap_ids[i], nas_pdu, &pdu);
+    s1ap_fast_check_template (&s1ap_fast_downlink_nas_transport_template, &message, pdu);
+    FREEMEM (message.msg.s1ap_DownlinkNASTransportIEs.nas_pdu.buf);
+    bdestroy_wrapper (&pdu);
+    bdestroy_wrapper (&nas_pdu);
+
+    memset (&message, 0, sizeof (message));
+    message.procedureCode = S1ap_ProcedureCode_id_UEContextRelease;
+    message.direction = S1AP_PDU_PR_initiatingMessage;
+    message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.present = S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair;
+    message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.choice.uE_S1AP_ID_pair.mME_UE_S1AP_ID = mme_ue_s1ap_ids[i];
+    message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.choice.uE_S1AP_ID_pair.eNB_UE_S1AP_ID = enb_ue_s1ap_ids[i];
+    s1ap_mme_set_cause (&message.msg.s1ap_UEContextReleaseCommandIEs.cause, S1ap_Cause_PR_radioNetwork + i, cause_values[i]);
+    pdu = NULL;
+    s1ap_mme_fast_encode_ue_context_release_command (mme_ue_s1ap_ids[i], enb_ue_s1ap_ids[i], S1ap_Cause_PR_radioNetwork + i, cause_values[i], &pdu);
+    s1ap_fast_check_template (&s1ap_fast_ue_context_release_command_template, &message, pdu);
+    bdestroy_wrapper (&pdu);
+  }
+  OAILOG_DEBUG (LOG_S1AP, "S1AP fast path templates: %s %s, %s %s\n",
+      s1ap_fast_downlink_nas_transport_template.name, (s1ap_fast_downlink_nas_transport_template.enabled) ? "enabled" : "disabled",
+      s1ap_fast_ue_context_release_command_template.name, (s1ap_fast_ue_context_release_command_template.enabled) ? "enabled" : "disabled");
+}
@@ -0,0 +1,89 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s1ap_mme_fast_codec.h
+  \brief Hand written APER codec for the most frequent S1AP procedures.
+
+  UplinkNASTransport and DownlinkNASTransport carry most of the S1AP traffic
+  once UEs are attached, UEContextReleaseCommand follows every idle mode
+  transition. Their APER encoding is simple enough to be walked directly,
+  without building the asn1c structures: the encoders copy the invariant
+  part of the PDU from a per procedure template and only write the UE ids,
+  NAS PDU and cause. Anything the fast path does not expect (extensions,
+  fragmented lengths, unknown procedures) is reported as an error and must
+  go through the asn1c codec.
+*/
+
+#ifndef FILE_S1AP_MME_FAST_CODEC_SEEN
+#define FILE_S1AP_MME_FAST_CODEC_SEEN
+
+#include "bstrlib.h"
+#include "3gpp_23.003.h"
+#include "3gpp_36.401.h"
+#include "TrackingAreaIdentity.h"
+#include "S1ap-Cause.h"
+
+typedef struct s1ap_uplink_nas_transport_s {
+  mme_ue_s1ap_id_t        mme_ue_s1ap_id;
+  enb_ue_s1ap_id_t        enb_ue_s1ap_id;
+  uint32_t                nas_pdu_offset;     ///< NAS PDU position in the decoded buffer
+  uint32_t                nas_pdu_length;
+  tai_t                   tai;
+  ecgi_t                  ecgi;
+} s1ap_uplink_nas_transport_t;
+
+/** \brief Decode an UplinkNASTransport PDU without the asn1c codec.
+ * The NAS PDU is not copied, its position in raw is returned.
+ * \param raw the S1AP PDU
+ * \param ul_nas_transport decoded IEs
+ * @returns RETURNok on success, RETURNerror if the PDU has to be decoded by asn1c
+ **/
+int s1ap_mme_fast_decode_uplink_nas_transport(const_bstring const raw, s1ap_uplink_nas_transport_t * const ul_nas_transport);
+
+/** \brief Encode a DownlinkNASTransport PDU without the asn1c codec.
+ * The encoding is the one asn1c would produce.
+ * \param mme_ue_s1ap_id MME UE S1AP ID IE
+ * \param enb_ue_s1ap_id eNB UE S1AP ID IE
+ * \param nas_pdu NAS PDU IE
+ * \param pdu allocated encoded PDU
+ * @returns RETURNok on success, RETURNerror if the PDU has to be encoded by asn1c
+ **/
+int s1ap_mme_fast_encode_downlink_nas_transport(const mme_ue_s1ap_id_t mme_ue_s1ap_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+    const_bstring const nas_pdu, bstring * const pdu);
+
+/** \brief Encode a UEContextReleaseCommand PDU with an UE S1AP id pair without the asn1c codec.
+ * The encoding is the one asn1c would produce.
+ * \param mme_ue_s1ap_id MME UE S1AP ID
+ * \param enb_ue_s1ap_id eNB UE S1AP ID
+ * \param cause_type Cause IE choice
+ * \param cause_value Cause IE value, extension values are not supported
+ * \param pdu allocated encoded PDU
+ * @returns RETURNok on success, RETURNerror if the PDU has to be encoded by asn1c
+ **/
+int s1ap_mme_fast_encode_ue_context_release_command(const mme_ue_s1ap_id_t mme_ue_s1ap_id, const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+    const S1ap_Cause_PR cause_type, const long cause_value, bstring * const pdu);
+
+/** \brief Check the encoding templates against asn1c, templates that do
+ * not match are disabled and their procedures encoded by asn1c.
+ **/
+void s1ap_mme_fast_codec_init(void);
+
+#endif /* FILE_S1AP_MME_FAST_CODEC_SEEN */
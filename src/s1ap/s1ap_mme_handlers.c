@@ -47,6 +47,7 @@
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
 #include "s1ap_mme_encoder.h"
+#include "s1ap_mme_fast_codec.h"
 #include "s1ap_mme_nas_procedures.h"
 #include "s1ap_mme_itti_messaging.h"
 #include "s1ap_mme.h"
@@ -513,7 +514,7 @@ s1ap_generate_s1_setup_response (
 //------------------------------------------------------------------------------
 int
 s1ap_mme_handle_ue_cap_indication (
-    __attribute__((unused)) const sctp_assoc_id_t assoc_id,
+    const sctp_assoc_id_t assoc_id,
     const sctp_stream_id_t stream,
     struct s1ap_message_s *message)
 {
@@ -529,7 +530,7 @@ s1ap_mme_handle_ue_cap_indication (
                       NULL, 0, "0 UECapabilityInfoIndication/%s enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ",
                       s1ap_direction2String[message->direction], ue_cap_p->eNB_UE_S1AP_ID, ue_cap_p->mme_ue_s1ap_id);
 
-  if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (ue_cap_p->mme_ue_s1ap_id)) == NULL) {
+  if ((ue_ref_p = s1ap_is_ue_mme_id_in_assoc (assoc_id, ue_cap_p->mme_ue_s1ap_id)) == NULL) {
     OAILOG_DEBUG (LOG_S1AP, "No UE is attached to this mme UE s1ap id: " MME_UE_S1AP_ID_FMT "\n", (uint32_t) ue_cap_p->mme_ue_s1ap_id);
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
   }
@@ -582,7 +583,7 @@ s1ap_mme_handle_ue_cap_indication (
 //------------------------------------------------------------------------------
 int
 s1ap_mme_handle_initial_context_setup_response (
-    __attribute__((unused)) const sctp_assoc_id_t assoc_id,
+    const sctp_assoc_id_t assoc_id,
     __attribute__((unused)) const sctp_stream_id_t stream,
     struct s1ap_message_s *message)
 {
@@ -600,7 +601,7 @@ s1ap_mme_handle_initial_context_setup_response (
                       "0 InitialContextSetup/%s enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " ",
                       s1ap_direction2String[message->direction], initialContextSetupResponseIEs_p->eNB_UE_S1AP_ID, initialContextSetupResponseIEs_p->mme_ue_s1ap_id);
 
-  if ((ue_ref_p = s1ap_is_ue_mme_id_in_list ((uint32_t) initialContextSetupResponseIEs_p->mme_ue_s1ap_id)) == NULL) {
+  if ((ue_ref_p = s1ap_is_ue_mme_id_in_assoc (assoc_id, (uint32_t) initialContextSetupResponseIEs_p->mme_ue_s1ap_id)) == NULL) {
     OAILOG_DEBUG (LOG_S1AP, "No UE is attached to this mme UE s1ap id: " MME_UE_S1AP_ID_FMT " %u(10)\n",
                       (uint32_t) initialContextSetupResponseIEs_p->mme_ue_s1ap_id, (uint32_t) initialContextSetupResponseIEs_p->mme_ue_s1ap_id);
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
@@ -649,7 +650,7 @@ s1ap_mme_handle_initial_context_setup_response (
 //------------------------------------------------------------------------------
 int
 s1ap_mme_handle_ue_context_release_request (
-    __attribute__((unused)) const sctp_assoc_id_t assoc_id,
+    const sctp_assoc_id_t assoc_id,
     __attribute__((unused)) const sctp_stream_id_t stream,
     struct s1ap_message_s *message)
 {
@@ -706,7 +707,7 @@ s1ap_mme_handle_ue_context_release_request (
   Cause can influence whether to preserve GBR bearers or not.Since, as of now EPC doesn't support dedicated bearers, it is don't care scenario till we add support for dedicated bearers.
   */ 
 
-  if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (ueContextReleaseRequest_p->mme_ue_s1ap_id)) == NULL) {
+  if ((ue_ref_p = s1ap_is_ue_mme_id_in_assoc (assoc_id, ueContextReleaseRequest_p->mme_ue_s1ap_id)) == NULL) {
     /*
      * MME doesn't know the MME UE S1AP ID provided.
      * No need to do anything. Ignore the message   
@@ -791,25 +792,29 @@ s1ap_mme_generate_ue_context_release_command (
     AssertFatal(false, "Unknown cause for context release");
     break;
   }
-  s1ap_mme_set_cause(&ueContextReleaseCommandIEs_p->cause, cause_type, cause_value);
+  bstring b = NULL;
 
-  if (s1ap_mme_encode_pdu (&message, &buffer, &length) < 0) {
-    MSC_LOG_EVENT (MSC_S1AP_MME, "0 UEContextRelease/initiatingMessage enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " encoding failed",
-            ue_ref_p->enb_ue_s1ap_id, ue_ref_p->mme_ue_s1ap_id);
-    OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+  if (s1ap_mme_fast_encode_ue_context_release_command (ue_ref_p->mme_ue_s1ap_id, ue_ref_p->enb_ue_s1ap_id, cause_type, cause_value, &b) != RETURNok) {
+    s1ap_mme_set_cause(&ueContextReleaseCommandIEs_p->cause, cause_type, cause_value);
+
+    if (s1ap_mme_encode_pdu (&message, &buffer, &length) < 0) {
+      MSC_LOG_EVENT (MSC_S1AP_MME, "0 UEContextRelease/initiatingMessage enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " encoding failed",
+              ue_ref_p->enb_ue_s1ap_id, ue_ref_p->mme_ue_s1ap_id);
+      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+    }
+    b = blk2bstr(buffer, length);
+    free(buffer);
   }
 
   MSC_LOG_TX_MESSAGE (MSC_S1AP_MME, MSC_S1AP_ENB, NULL, 0, "0 UEContextRelease/initiatingMessage enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT "",
           ue_ref_p->enb_ue_s1ap_id, ue_ref_p->mme_ue_s1ap_id);
 
-  bstring b = blk2bstr(buffer, length);
-  free(buffer);
   rc = s1ap_mme_itti_send_sctp_request (&b, ue_ref_p->enb->sctp_assoc_id, ue_ref_p->sctp_stream_send, ue_ref_p->mme_ue_s1ap_id);
   ue_ref_p->s1_ue_state = S1AP_UE_WAITING_CRR;
   
-  // Start timer to track UE context release complete from eNB
+  // Start timer to track UE context release complete from eNB, the UE id is passed by value: the expiry is dispatched by another thread
   if (timer_setup (ue_ref_p->s1ap_ue_context_rel_timer.sec, 0, 
-                TASK_S1AP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)&(ue_ref_p->mme_ue_s1ap_id), &(ue_ref_p->s1ap_ue_context_rel_timer.id)) < 0) { 
+                TASK_S1AP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, (void *)(uintptr_t)ue_ref_p->mme_ue_s1ap_id, &(ue_ref_p->s1ap_ue_context_rel_timer.id)) < 0) { 
     OAILOG_ERROR (LOG_S1AP, "Failed to start UE context release complete timer for UE id %d \n", ue_ref_p->mme_ue_s1ap_id);
     ue_ref_p->s1ap_ue_context_rel_timer.id = S1AP_TIMER_INACTIVE_ID;
   } else {
@@ -854,7 +859,7 @@ s1ap_handle_ue_context_release_command (
 //------------------------------------------------------------------------------
 int
 s1ap_mme_handle_ue_context_release_complete (
-    __attribute__((unused)) const sctp_assoc_id_t assoc_id,
+    const sctp_assoc_id_t assoc_id,
     __attribute__((unused)) const sctp_stream_id_t stream,
     struct s1ap_message_s *message)
 {
@@ -870,7 +875,7 @@ s1ap_mme_handle_ue_context_release_complete (
                       "0 UEContextRelease/%s enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " len %u",
                       s1ap_direction2String[message->direction], ueContextReleaseComplete_p->eNB_UE_S1AP_ID, ueContextReleaseComplete_p->mme_ue_s1ap_id);
 
-  if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (ueContextReleaseComplete_p->mme_ue_s1ap_id)) == NULL) {
+  if ((ue_ref_p = s1ap_is_ue_mme_id_in_assoc (assoc_id, ueContextReleaseComplete_p->mme_ue_s1ap_id)) == NULL) {
     /*
      * MME doesn't know the MME UE S1AP ID provided.
      * This implies that UE context has already been deleted on the expiry of timer
@@ -899,7 +904,7 @@ s1ap_mme_handle_ue_context_release_complete (
 //------------------------------------------------------------------------------
 int
 s1ap_mme_handle_initial_context_setup_failure (
-    __attribute__((unused)) const sctp_assoc_id_t assoc_id,
+    const sctp_assoc_id_t assoc_id,
     __attribute__((unused)) const sctp_stream_id_t stream,
     struct s1ap_message_s *message)
 {
@@ -918,7 +923,7 @@ s1ap_mme_handle_initial_context_setup_failure (
                       "0 InitialContextSetup/%s enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " len %u",
                       s1ap_direction2String[message->direction], initialContextSetupFailureIEs_p->eNB_UE_S1AP_ID, initialContextSetupFailureIEs_p->mme_ue_s1ap_id);
 
-  if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (initialContextSetupFailureIEs_p->mme_ue_s1ap_id)) == NULL) {
+  if ((ue_ref_p = s1ap_is_ue_mme_id_in_assoc (assoc_id, initialContextSetupFailureIEs_p->mme_ue_s1ap_id)) == NULL) {
     /*
      * MME doesn't know the MME UE S1AP ID provided.
      */
@@ -1137,7 +1142,7 @@ s1ap_handle_sctp_disconnection(
 
   MSC_LOG_EVENT (MSC_S1AP_MME, "0 Event SCTP_CLOSE_ASSOCIATION assoc_id: %d", assoc_id);
 
-  hashtable_ts_apply_callback_on_elements(&enb_association->ue_coll, s1ap_send_enb_deregistered_ind, (void*)&arg, (void**)&message_p);
+  hashtable_oa_ts_apply_callback_on_elements(enb_association->ue_coll, s1ap_send_enb_deregistered_ind, (void*)&arg, (void**)&message_p);
 
   // The last batch of messages needs to be sent here
   S1AP_ENB_DEREGISTERED_IND (message_p).nb_ue_to_deregister = (uint8_t) arg.current_ue_index;
@@ -1210,11 +1215,6 @@ s1ap_handle_new_association (
    */
   enb_association->instreams = (sctp_stream_id_t) sctp_new_peer_p->instreams;
   enb_association->outstreams = (sctp_stream_id_t) sctp_new_peer_p->outstreams;
-  /*
-   * initialize the next sctp stream to 1 as 0 is reserved for non
-   * * * * ue associated signalling.
-   */
-  enb_association->next_sctp_stream = 1;
   enb_association->s1_state = S1AP_INIT;
   MSC_LOG_EVENT (MSC_S1AP_MME, "0 Event SCTP_NEW_ASSOCIATION assoc_id: %d", enb_association->sctp_assoc_id);
   OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
@@ -1340,7 +1340,7 @@ s1ap_mme_handle_enb_reset (
                                                                                           sizeof (*(S1AP_ENB_INITIATED_RESET_REQ (message_p).ue_to_reset_list)));
     DevAssert(S1AP_ENB_INITIATED_RESET_REQ (message_p).ue_to_reset_list != NULL);
     arg.message_p = message_p;
-    hashtable_ts_apply_callback_on_elements(&enb_association->ue_coll, construct_s1ap_mme_full_reset_req, (void*)&arg, (void**) &message_p);
+    hashtable_oa_ts_apply_callback_on_elements(enb_association->ue_coll, construct_s1ap_mme_full_reset_req, (void*)&arg, (void**) &message_p);
   } else {
     // Partial Reset
     S1AP_ENB_INITIATED_RESET_REQ (message_p).num_ue = enb_reset_p->resetType.choice.partOfS1_Interface.list.count;
@@ -1353,7 +1353,7 @@ s1ap_mme_handle_enb_reset (
 
       if (s1_sig_conn_id_p->mME_UE_S1AP_ID != NULL) {
         mme_ue_s1ap_id = (mme_ue_s1ap_id_t) *(s1_sig_conn_id_p->mME_UE_S1AP_ID);
-        if ((ue_ref_p = s1ap_is_ue_mme_id_in_list (mme_ue_s1ap_id)) != NULL) {
+        if ((ue_ref_p = s1ap_is_ue_mme_id_in_assoc (assoc_id, mme_ue_s1ap_id)) != NULL) {
           if (s1_sig_conn_id_p->eNB_UE_S1AP_ID != NULL) {
             enb_ue_s1ap_id = (enb_ue_s1ap_id_t) *(s1_sig_conn_id_p->eNB_UE_S1AP_ID);
             if (ue_ref_p->enb_ue_s1ap_id == (enb_ue_s1ap_id & ENB_UE_S1AP_ID_MASK)) {
@@ -1480,7 +1480,7 @@ s1ap_mme_handle_erab_setup_response (
                       s1ap_direction2String[message->direction], s1ap_E_RABSetupResponseIEs_p->eNB_UE_S1AP_ID,
                       s1ap_E_RABSetupResponseIEs_p->mme_ue_s1ap_id);
 
-  if ((ue_ref_p = s1ap_is_ue_mme_id_in_list ((uint32_t) s1ap_E_RABSetupResponseIEs_p->mme_ue_s1ap_id)) == NULL) {
+  if ((ue_ref_p = s1ap_is_ue_mme_id_in_assoc (assoc_id, (uint32_t) s1ap_E_RABSetupResponseIEs_p->mme_ue_s1ap_id)) == NULL) {
     OAILOG_DEBUG (LOG_S1AP, "No UE is attached to this mme UE s1ap id: " MME_UE_S1AP_ID_FMT "\n", (mme_ue_s1ap_id_t)s1ap_E_RABSetupResponseIEs_p->mme_ue_s1ap_id);
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
   }
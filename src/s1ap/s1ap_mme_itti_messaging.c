@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <time.h>
 
 #include "bstrlib.h"
 
@@ -48,6 +49,7 @@ s1ap_mme_itti_send_sctp_request (
   const mme_ue_s1ap_id_t ue_id)
 {
   MessageDef                             *message_p = NULL;
+  struct timespec                         ts;
 
   message_p = itti_alloc_new_message (TASK_S1AP, SCTP_DATA_REQ);
   SCTP_DATA_REQ (message_p).payload = *payload;
@@ -55,6 +57,8 @@ s1ap_mme_itti_send_sctp_request (
   SCTP_DATA_REQ (message_p).assoc_id = assoc_id;
   SCTP_DATA_REQ (message_p).stream = stream;
   SCTP_DATA_REQ (message_p).mme_ue_s1ap_id = ue_id;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  SCTP_DATA_REQ (message_p).req_time_ns = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
   return itti_send_msg_to_task (TASK_SCTP, INSTANCE_DEFAULT, message_p);
 }
 
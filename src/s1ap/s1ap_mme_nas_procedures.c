@@ -44,6 +44,7 @@
 #include "s1ap_ies_defs.h"
 #include "s1ap_mme_encoder.h"
 #include "s1ap_mme.h"
+#include "s1ap_mme_fast_codec.h"
 #include "s1ap_mme_handlers.h"
 #include "s1ap_mme_nas_procedures.h"
 #include "s1ap_mme_retransmission.h"
@@ -120,22 +121,7 @@ s1ap_mme_handle_initial_ue_message (
 
     // On which stream we received the message
     ue_ref->sctp_stream_recv = stream;
-    ue_ref->sctp_stream_send = ue_ref->enb->next_sctp_stream;
-
-    /*
-     * Increment the sctp stream for the eNB association.
-     * If the next sctp stream is >= instream negociated between eNB and MME, wrap to first stream.
-     * TODO: search for the first available stream instead.
-     */
-
-    /* 
-     * TODO task#15456359.
-     * Below logic seems to be incorrect , revisit it.
-     */
-    ue_ref->enb->next_sctp_stream += 1;
-    if (ue_ref->enb->next_sctp_stream >= ue_ref->enb->instreams) {
-      ue_ref->enb->next_sctp_stream = 1;
-    }
+    ue_ref->sctp_stream_send = s1ap_mme_ue_stream (ue_ref);
     s1ap_dump_enb (ue_ref->enb);
     // TAI mandatory IE
     OCTET_STRING_TO_TAC (&initialUEMessage_p->tai.tAC, tai.tac);
@@ -205,38 +191,42 @@ s1ap_mme_handle_initial_ue_message (
 
 
 //------------------------------------------------------------------------------
-int
-s1ap_mme_handle_uplink_nas_transport (
+/*
+ * Common part of the asn1c and fast path UplinkNASTransport handlers.
+ */
+static int
+s1ap_mme_forward_uplink_nas_transport (
   const sctp_assoc_id_t assoc_id,
-  __attribute__((unused)) const sctp_stream_id_t stream,
-  struct s1ap_message_s *message)
+  const mme_ue_s1ap_id_t mme_ue_s1ap_id,
+  const enb_ue_s1ap_id_t enb_ue_s1ap_id,
+  const tai_t    * const tai,
+  const ecgi_t   * const ecgi,
+  STOLEN_REF bstring *nas_pdu)
 {
-  S1ap_UplinkNASTransportIEs_t           *uplinkNASTransport_p = NULL;
   ue_description_t                       *ue_ref = NULL;
   enb_description_t                      *enb_ref = NULL;
-  tai_t                                   tai = {0};
-  ecgi_t                                  ecgi = {.plmn = {0}, .cell_identity = {0}};
 
   OAILOG_FUNC_IN (LOG_S1AP);
-  uplinkNASTransport_p = &message->msg.s1ap_UplinkNASTransportIEs;
 
-  if (INVALID_MME_UE_S1AP_ID == uplinkNASTransport_p->mme_ue_s1ap_id) {
+  if (INVALID_MME_UE_S1AP_ID == mme_ue_s1ap_id) {
     OAILOG_WARNING (LOG_S1AP, "Received S1AP UPLINK_NAS_TRANSPORT message MME_UE_S1AP_ID unknown\n");
 
     enb_ref = s1ap_is_enb_assoc_id_in_list (assoc_id);
 
-    if (!(ue_ref = s1ap_is_ue_enb_id_in_list ( enb_ref, (enb_ue_s1ap_id_t)uplinkNASTransport_p->eNB_UE_S1AP_ID))) {
+    if (!(ue_ref = s1ap_is_ue_enb_id_in_list ( enb_ref, enb_ue_s1ap_id))) {
       OAILOG_WARNING (LOG_S1AP, "Received S1AP UPLINK_NAS_TRANSPORT No UE is attached to this enb_ue_s1ap_id: " ENB_UE_S1AP_ID_FMT "\n",
-          (enb_ue_s1ap_id_t)uplinkNASTransport_p->eNB_UE_S1AP_ID);
+          enb_ue_s1ap_id);
+      bdestroy_wrapper (nas_pdu);
       OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
     }
   } else {
     OAILOG_INFO (LOG_S1AP, "Received S1AP UPLINK_NAS_TRANSPORT message MME_UE_S1AP_ID " MME_UE_S1AP_ID_FMT "\n",
-        (mme_ue_s1ap_id_t)uplinkNASTransport_p->mme_ue_s1ap_id);
+        mme_ue_s1ap_id);
 
-    if (!(ue_ref = s1ap_is_ue_mme_id_in_list (uplinkNASTransport_p->mme_ue_s1ap_id))) {
+    if (!(ue_ref = s1ap_is_ue_mme_id_in_assoc (assoc_id, mme_ue_s1ap_id))) {
       OAILOG_WARNING (LOG_S1AP, "Received S1AP UPLINK_NAS_TRANSPORT No UE is attached to this mme_ue_s1ap_id: " MME_UE_S1AP_ID_FMT "\n",
-          (mme_ue_s1ap_id_t)uplinkNASTransport_p->mme_ue_s1ap_id);
+          mme_ue_s1ap_id);
+      bdestroy_wrapper (nas_pdu);
       OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
     }
   }
@@ -248,15 +238,48 @@ s1ap_mme_handle_uplink_nas_transport (
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S1AP_MME,
                         MSC_S1AP_ENB,
                         NULL, 0,
-                        "0 uplinkNASTransport/%s mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " nas len %u",
-                        s1ap_direction2String[message->direction],
-                        (mme_ue_s1ap_id_t)uplinkNASTransport_p->mme_ue_s1ap_id,
-                        (enb_ue_s1ap_id_t)uplinkNASTransport_p->eNB_UE_S1AP_ID,
-                        uplinkNASTransport_p->nas_pdu.size);
+                        "0 uplinkNASTransport/initiatingMessage mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " nas len %u",
+                        mme_ue_s1ap_id,
+                        enb_ue_s1ap_id,
+                        blength (*nas_pdu));
 
+    bdestroy_wrapper (nas_pdu);
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
   }
 
+  // TODO optional GW Transport Layer Address
+
+
+  MSC_LOG_RX_MESSAGE (MSC_S1AP_MME,
+                      MSC_S1AP_ENB,
+                      NULL, 0,
+                      "0 uplinkNASTransport/initiatingMessage mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " nas len %u",
+                      mme_ue_s1ap_id,
+                      enb_ue_s1ap_id,
+                      blength (*nas_pdu));
+
+  s1ap_mme_itti_nas_uplink_ind (mme_ue_s1ap_id,
+                                nas_pdu,
+                                tai,
+                                ecgi);
+  OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+int
+s1ap_mme_handle_uplink_nas_transport (
+  const sctp_assoc_id_t assoc_id,
+  __attribute__((unused)) const sctp_stream_id_t stream,
+  struct s1ap_message_s *message)
+{
+  S1ap_UplinkNASTransportIEs_t           *uplinkNASTransport_p = NULL;
+  tai_t                                   tai = {0};
+  ecgi_t                                  ecgi = {.plmn = {0}, .cell_identity = {0}};
+  bstring                                 b = NULL;
+
+  OAILOG_FUNC_IN (LOG_S1AP);
+  uplinkNASTransport_p = &message->msg.s1ap_UplinkNASTransportIEs;
+
   // TAI mandatory IE
   OCTET_STRING_TO_TAC (&uplinkNASTransport_p->tai.tAC, tai.tac);
   DevAssert (uplinkNASTransport_p->tai.pLMNidentity.size == 3);
@@ -267,31 +290,39 @@ s1ap_mme_handle_uplink_nas_transport (
   TBCD_TO_PLMN_T(&uplinkNASTransport_p->eutran_cgi.pLMNidentity, &ecgi.plmn);
   BIT_STRING_TO_CELL_IDENTITY (&uplinkNASTransport_p->eutran_cgi.cell_ID, ecgi.cell_identity);
 
-  // TODO optional GW Transport Layer Address
+  b = blk2bstr(uplinkNASTransport_p->nas_pdu.buf, uplinkNASTransport_p->nas_pdu.size);
+  OAILOG_FUNC_RETURN (LOG_S1AP, s1ap_mme_forward_uplink_nas_transport (assoc_id,
+      (mme_ue_s1ap_id_t)uplinkNASTransport_p->mme_ue_s1ap_id, (enb_ue_s1ap_id_t)uplinkNASTransport_p->eNB_UE_S1AP_ID, &tai, &ecgi, &b));
+}
+
+//------------------------------------------------------------------------------
+int
+s1ap_mme_handle_uplink_nas_transport_fast (
+  const sctp_assoc_id_t assoc_id,
+  __attribute__((unused)) const sctp_stream_id_t stream,
+  const s1ap_uplink_nas_transport_t * const ul_nas_transport,
+  STOLEN_REF bstring *payload)
+{
+  bstring                                 b = *payload;
 
+  OAILOG_FUNC_IN (LOG_S1AP);
+  *payload = NULL;
 
-  MSC_LOG_RX_MESSAGE (MSC_S1AP_MME,
-                      MSC_S1AP_ENB,
-                      NULL, 0,
-                      "0 uplinkNASTransport/%s mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT " nas len %u",
-                      s1ap_direction2String[message->direction],
-                      (mme_ue_s1ap_id_t)uplinkNASTransport_p->mme_ue_s1ap_id,
-                      (enb_ue_s1ap_id_t)uplinkNASTransport_p->eNB_UE_S1AP_ID,
-                      uplinkNASTransport_p->nas_pdu.size);
-
-  bstring b = blk2bstr(uplinkNASTransport_p->nas_pdu.buf, uplinkNASTransport_p->nas_pdu.size);
-  s1ap_mme_itti_nas_uplink_ind (uplinkNASTransport_p->mme_ue_s1ap_id,
-                                &b,
-                                &tai,
-                                &ecgi);
-  OAILOG_FUNC_RETURN (LOG_S1AP, RETURNok);
+  /*
+   * The NAS PDU is moved to the head of the SCTP buffer which is forwarded
+   * as is, no allocation nor copy to a new buffer
+   */
+  bdelete (b, 0, ul_nas_transport->nas_pdu_offset);
+  btrunc (b, ul_nas_transport->nas_pdu_length);
+  OAILOG_FUNC_RETURN (LOG_S1AP, s1ap_mme_forward_uplink_nas_transport (assoc_id,
+      ul_nas_transport->mme_ue_s1ap_id, ul_nas_transport->enb_ue_s1ap_id, &ul_nas_transport->tai, &ul_nas_transport->ecgi, &b));
 }
 
 
 //------------------------------------------------------------------------------
 int
 s1ap_mme_handle_nas_non_delivery (
-    __attribute__((unused)) sctp_assoc_id_t assoc_id,
+  sctp_assoc_id_t assoc_id,
   sctp_stream_id_t stream,
   struct s1ap_message_s *message)
 {
@@ -322,7 +353,7 @@ s1ap_mme_handle_nas_non_delivery (
                       nasNonDeliveryIndication_p->cause,
                       nasNonDeliveryIndication_p->nas_pdu.size);
 
-  if ((ue_ref = s1ap_is_ue_mme_id_in_list (nasNonDeliveryIndication_p->mme_ue_s1ap_id))
+  if ((ue_ref = s1ap_is_ue_mme_id_in_assoc (assoc_id, nasNonDeliveryIndication_p->mme_ue_s1ap_id))
       == NULL) {
     OAILOG_DEBUG (LOG_S1AP, "No UE is attached to this mme UE s1ap id: " MME_UE_S1AP_ID_FMT "\n", (mme_ue_s1ap_id_t)nasNonDeliveryIndication_p->mme_ue_s1ap_id);
     OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
@@ -397,12 +428,21 @@ s1ap_generate_downlink_nas_transport (
     /*eNB
      * Fill in the NAS pdu
      */
-    OCTET_STRING_fromBuf (&downlinkNasTransport->nas_pdu, (char *)bdata(*payload), blength(*payload));
-    bdestroy_wrapper (payload);
+    bstring b = NULL;
 
-    if (s1ap_mme_encode_pdu (&message, &buffer_p, &length) < 0) {
-      // TODO: handle something
-      OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+    if (s1ap_mme_fast_encode_downlink_nas_transport (ue_ref->mme_ue_s1ap_id, ue_ref->enb_ue_s1ap_id, *payload, &b) == RETURNok) {
+      length = blength (b);
+      bdestroy_wrapper (payload);
+    } else {
+      OCTET_STRING_fromBuf (&downlinkNasTransport->nas_pdu, (char *)bdata(*payload), blength(*payload));
+      bdestroy_wrapper (payload);
+
+      if (s1ap_mme_encode_pdu (&message, &buffer_p, &length) < 0) {
+        // TODO: handle something
+        OAILOG_FUNC_RETURN (LOG_S1AP, RETURNerror);
+      }
+      b = blk2bstr(buffer_p, length);
+      free(buffer_p);
     }
 
     OAILOG_NOTICE (LOG_S1AP, "Send S1AP DOWNLINK_NAS_TRANSPORT message ue_id = " MME_UE_S1AP_ID_FMT " MME_UE_S1AP_ID = " MME_UE_S1AP_ID_FMT " eNB_UE_S1AP_ID = " ENB_UE_S1AP_ID_FMT "\n",
@@ -412,8 +452,6 @@ s1ap_generate_downlink_nas_transport (
                         NULL, 0,
                         "0 downlinkNASTransport/initiatingMessage ue_id " MME_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id" ENB_UE_S1AP_ID_FMT " nas length %u",
                         ue_id, (mme_ue_s1ap_id_t)downlinkNasTransport->mme_ue_s1ap_id, (enb_ue_s1ap_id_t)downlinkNasTransport->eNB_UE_S1AP_ID, length);
-    bstring b = blk2bstr(buffer_p, length);
-    free(buffer_p);
     s1ap_mme_itti_send_sctp_request (&b , ue_ref->enb->sctp_assoc_id, ue_ref->sctp_stream_send, ue_ref->mme_ue_s1ap_id);
   }
 
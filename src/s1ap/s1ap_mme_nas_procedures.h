@@ -31,6 +31,7 @@
 #define FILE_S1AP_MME_NAS_PROCEDURES_SEEN
 
 #include "common_defs.h"
+#include "s1ap_mme_fast_codec.h"
 
 /** \brief Handle an Initial UE message.
  * \param assocId lower layer assoc id (SCTP)
@@ -53,6 +54,19 @@ int s1ap_mme_handle_uplink_nas_transport(const sctp_assoc_id_t assocId,
                                          const sctp_stream_id_t stream,
                                          struct s1ap_message_s *message);
 
+/** \brief Handle an Uplink NAS transport message decoded by the fast path codec.
+ * The NAS PDU is forwarded to NAS in the SCTP buffer.
+ * \param assocId lower layer assoc id (SCTP)
+ * \param stream SCTP stream on which data had been received
+ * \param ul_nas_transport The message as decoded by s1ap_mme_fast_decode_uplink_nas_transport()
+ * \param payload The SCTP buffer, stolen
+ * @returns -1 on failure, 0 otherwise
+ **/
+int s1ap_mme_handle_uplink_nas_transport_fast(const sctp_assoc_id_t assocId,
+                                              const sctp_stream_id_t stream,
+                                              const s1ap_uplink_nas_transport_t * const ul_nas_transport,
+                                              STOLEN_REF bstring *payload);
+
 /** \brief Handle a NAS non delivery indication message from eNB
  * \param assocId lower layer assoc id (SCTP)
  * \param stream SCTP stream on which data had been received
@@ -177,7 +177,13 @@ s6a_parse_authentication_info_avp (
 
     switch (hdr->avp_code) {
     case AVP_CODE_E_UTRAN_VECTOR:{
-      DevAssert (MAX_EPS_AUTH_VECTORS > authentication_info->nb_of_vectors);
+      if (MAX_EPS_AUTH_VECTORS_PER_REQUEST <= authentication_info->nb_of_vectors) {
+        /*
+         * The HSS may return more vectors than requested, keep the first ones
+         */
+        OAILOG_WARNING (LOG_S6A, "Ignoring E-UTRAN vector in excess of %d\n", MAX_EPS_AUTH_VECTORS_PER_REQUEST);
+        break;
+      }
       CHECK_FCT (s6a_parse_e_utran_vector (avp, &authentication_info->eutran_vector[authentication_info->nb_of_vectors]));
       authentication_info->nb_of_vectors++;
       }
@@ -413,13 +419,14 @@ s6a_generate_authentication_info_req (
     CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
 
     /*
-     * Re-synchronization information containing the AUTS computed at USIM
+     * Re-synchronization information: RAND || AUTS, the RAND of the challenge
+     * and the AUTS computed at USIM (TS 29.272 7.3.15), the HSS can not tell
+     * which vector of a batch the USIM rejected.
      */
     if (air_p->re_synchronization) {
       CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_re_synchronization_info, 0, &child_avp));
-      // TODO Fix after updating HSS
-      value.os.len = AUTS_LENGTH;
-      value.os.data = (air_p->resync_param + RAND_LENGTH_OCTETS);
+      value.os.len = RAND_LENGTH_OCTETS + AUTS_LENGTH;
+      value.os.data = air_p->resync_param;
       CHECK_FCT (fd_msg_avp_setvalue (child_avp, &value));
       CHECK_FCT (fd_msg_avp_add (avp, MSG_BRW_LAST_CHILD, child_avp));
     }
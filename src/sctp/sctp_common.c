@@ -143,6 +143,7 @@ int sctp_get_sockinfo (
 //------------------------------------------------------------------------------
 int sctp_get_peeraddresses (
   int sock,
+  sctp_assoc_id_t assoc_id,
   struct sockaddr **remote_addr,
   int *nb_remote_addresses)
 {
@@ -150,7 +151,7 @@ int sctp_get_peeraddresses (
                                           j = 0;
   struct sockaddr                        *temp_addr_p = NULL;
 
-  if ((nb = sctp_getpaddrs (sock, -1, &temp_addr_p)) <= 0) {
+  if ((nb = sctp_getpaddrs (sock, assoc_id, &temp_addr_p)) <= 0) {
     OAILOG_ERROR (LOG_SCTP, "Failed to retrieve peer addresses\n");
     return -1;
   }
@@ -198,6 +199,7 @@ int sctp_get_peeraddresses (
 //------------------------------------------------------------------------------
 int sctp_get_localaddresses (
   int sock,
+  sctp_assoc_id_t assoc_id,
   struct sockaddr **local_addr,
   int *nb_local_addresses)
 {
@@ -205,7 +207,7 @@ int sctp_get_localaddresses (
                                           j = 0;
   struct sockaddr                        *temp_addr_p = NULL;
 
-  if ((nb = sctp_getladdrs (sock, -1, &temp_addr_p)) <= 0) {
+  if ((nb = sctp_getladdrs (sock, assoc_id, &temp_addr_p)) <= 0) {
     OAILOG_ERROR (LOG_SCTP, "Failed to retrieve local addresses\n");
     return -1;
   }
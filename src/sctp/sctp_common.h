@@ -39,10 +39,10 @@ int sctp_set_init_opt(const int sd, const sctp_stream_id_t instreams, const sctp
 int sctp_get_sockinfo(int sock, sctp_stream_id_t *instream, sctp_stream_id_t *outstream,
     sctp_assoc_id_t *assoc_id);
 
-int sctp_get_peeraddresses(int sock, struct sockaddr **remote_addr,
+int sctp_get_peeraddresses(int sock, sctp_assoc_id_t assoc_id, struct sockaddr **remote_addr,
                            int *nb_remote_addresses);
 
-int sctp_get_localaddresses(int sock, struct sockaddr **local_addr,
+int sctp_get_localaddresses(int sock, sctp_assoc_id_t assoc_id, struct sockaddr **local_addr,
                             int *nb_local_addresses);
 
 #endif /* FILE_SCTP_COMMON_SEEN */
@@ -29,6 +29,8 @@
 #include <string.h>
 #include <stdbool.h>
 
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
 #include "intertask_interface.h"
 #include "sctp_itti_messaging.h"
 
@@ -80,7 +82,7 @@ int sctp_itti_send_new_message_ind(
     const sctp_stream_id_t instreams,
     const sctp_stream_id_t outstreams)
 {
-  MessageDef                             *message_p = itti_alloc_new_message (TASK_SCTP, SCTP_DATA_IND);
+  MessageDef                             *message_p = itti_try_alloc_new_message (TASK_SCTP, SCTP_DATA_IND);
   if (message_p) {
     SCTP_DATA_IND (message_p).payload    = *payload;
     STOLEN_REF *payload= NULL;
@@ -90,6 +92,8 @@ int sctp_itti_send_new_message_ind(
     SCTP_DATA_IND (message_p).outstreams = outstreams;
     return itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
   }
+  // memory pools exhausted, the message is dropped
+  bdestroy_wrapper (payload);
   return RETURNerror;
 }
 
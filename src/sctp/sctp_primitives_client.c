@@ -286,8 +286,8 @@ sctp_connect_to_remote_host (
    */
   sctp_get_sockinfo (sd, &sctp_data_p->instreams, &sctp_data_p->outstreams, &sctp_data_p->assoc_id);
   sctp_data_p->sd = sd;
-  sctp_get_peeraddresses (sd, &sctp_data_p->remote_ip_addresses, &sctp_data_p->nb_remote_addresses);
-  sctp_get_localaddresses (sd, NULL, NULL);
+  sctp_get_peeraddresses (sd, sctp_data_p->assoc_id, &sctp_data_p->remote_ip_addresses, &sctp_data_p->nb_remote_addresses);
+  sctp_get_localaddresses (sd, sctp_data_p->assoc_id, NULL, NULL);
   TAILQ_INIT (&sctp_data_p->sctp_queue);
   return sd;
 err:
@@ -28,13 +28,18 @@
     @ingroup _sctp
 */
 
+#define _GNU_SOURCE             // required for sendmmsg()
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/sctp.h>
@@ -50,35 +55,61 @@
 #include "conversions.h"
 #include "sctp_common.h"
 #include "sctp_itti_messaging.h"
+#include "hashtable.h"
+#include "epoch.h"
 
 
 #define SCTP_RC_ERROR       -1
 #define SCTP_RC_NORMAL_READ  0
 #define SCTP_RC_DISCONNECT   1
+#define SCTP_RC_WOULDBLOCK   2
+
+/* Maximum number of ITTI messages handled at once by TASK_SCTP, and of SCTP
+ * messages written by a single sendmmsg() */
+#define SCTP_SEND_BATCH_SIZE 64
 
 typedef struct sctp_association_s {
-  struct sctp_association_s              *next_assoc;   ///< Next association in the list
-  struct sctp_association_s              *previous_assoc;       ///< Previous association in the list
   int                                     sd;   ///< Socket descriptor
   uint32_t                                ppid; ///< Payload protocol Identifier
   uint16_t                                instreams;    ///< Number of input streams negociated for this connection
   uint16_t                                outstreams;   ///< Number of output strams negotiated for this connection
   sctp_assoc_id_t                         assoc_id;     ///< SCTP association id for the connection
-  uint32_t                                messages_recv;        ///< Number of messages received on this connection
-  uint32_t                                messages_sent;        ///< Number of messages sent on this connection
+
+  /*
+   * Counters, the receive ones are only written by the receiver thread,
+   * the send ones only by TASK_SCTP.
+   */
+  uint64_t                                messages_recv;        ///< Number of messages received on this connection
+  uint64_t                                bytes_recv;           ///< Number of payload bytes received on this connection
+  uint64_t                                messages_sent;        ///< Number of messages sent on this connection
+  uint64_t                                bytes_sent;           ///< Number of payload bytes sent on this connection
+  uint64_t                                send_failures;        ///< Number of messages that could not be sent
+  uint64_t                                send_batches;         ///< Number of sendmmsg() calls, messages_sent / send_batches is the coalescing factor
+  uint64_t                                send_latency_sum_ns;  ///< Sum of the SCTP_DATA_REQ queuing to send completion delays
+  uint64_t                                send_latency_max_ns;  ///< Largest SCTP_DATA_REQ queuing to send completion delay
+  uint64_t                                creation_time_ns;     ///< Association setup time, for the throughput
 
   struct sockaddr                        *peer_addresses;       ///< A list of peer addresses
   int                                     nb_peer_addresses;
 } sctp_association_t;
 
 typedef struct sctp_descriptor_s {
-  // List of connected peers
-  struct sctp_association_s              *available_connections_head;
-  struct sctp_association_s              *available_connections_tail;
+  /*
+   * Connected peers, indexed by association id and, for one-to-one sockets, by socket descriptor.
+   * Associations are only added and removed by the receiver thread, other threads
+   * look them up inside an epoch read section.
+   */
+  hash_table_oa_ts_t                     *associations;
+  hash_table_oa_ts_t                     *sd_associations;
 
   uint32_t                                number_of_connections;
   uint16_t                                nb_instreams;
   uint16_t                                nb_outstreams;
+
+  bool                                    one_to_many;  ///< All associations share the listening socket
+  int                                     listen_sd;    ///< Listening socket descriptor
+  int                                     epoll_fd;     ///< Receiver thread epoll instance
+  uint8_t                                *recv_buffer;  ///< Receiver thread buffer, SCTP_RECV_BUFFER_SIZE bytes
 } sctp_descriptor_t;
 
 typedef struct sctp_arg_s {
@@ -93,14 +124,14 @@ static pthread_t                        assoc_thread;
 
 // LOCAL FUNCTIONS prototypes
 void                                   *sctp_receiver_thread (void *args_p);
-static int sctp_send_msg (
-    sctp_assoc_id_t sctp_assoc_id,
-    uint16_t stream,
-    STOLEN_REF bstring *payload);
-
-// Association list related local functions prototypes
-static sctp_association_t              *sctp_is_assoc_in_list (sctp_assoc_id_t assoc_id);
-static sctp_association_t              *sctp_add_new_peer (void);
+static int sctp_send_msgs (
+    const sctp_assoc_id_t sctp_assoc_id,
+    MessageDef ** const data_reqs,
+    const int nb_data_reqs);
+
+// Association table related local functions prototypes
+static sctp_association_t              *sctp_get_assoc (sctp_assoc_id_t assoc_id);
+static int                              sctp_add_new_peer (sctp_association_t *assoc_desc);
 static int                              handle_assoc_change(int sd, uint32_t ppid,
                                                             struct sctp_assoc_change  *assoc_change);
 static int                              sctp_handle_com_down (sctp_assoc_id_t assoc_id);
@@ -109,97 +140,90 @@ static void                             sctp_dump_list (void);
 static void sctp_exit (void);
 
 //------------------------------------------------------------------------------
-static sctp_association_t *sctp_add_new_peer (void)
+static void sctp_free_association (void **assoc_desc_pp)
 {
-  sctp_association_t              *new_sctp_descriptor = calloc (1, sizeof (sctp_association_t));
+  sctp_association_t              *assoc_desc = (sctp_association_t *)*assoc_desc_pp;
 
-  if (new_sctp_descriptor == NULL) {
-    OAILOG_ERROR (LOG_SCTP, "Failed to allocate memory for new peer (%s:%d)\n", __FILE__, __LINE__);
-    return NULL;
+  if (assoc_desc->peer_addresses) {
+    int rv = sctp_freepaddrs(assoc_desc->peer_addresses);
+    if (rv) OAILOG_DEBUG (LOG_SCTP, "sctp_freepaddrs(%p) failed\n", assoc_desc->peer_addresses);
   }
+  free_wrapper (assoc_desc_pp);
+}
 
-  new_sctp_descriptor->next_assoc = NULL;
-  new_sctp_descriptor->previous_assoc = NULL;
+//------------------------------------------------------------------------------
+static int sctp_add_new_peer (sctp_association_t *assoc_desc)
+{
+  hashtable_rc_t                  h_rc = HASH_TABLE_OK;
 
-  if (sctp_desc.available_connections_tail == NULL) {
-    sctp_desc.available_connections_head = new_sctp_descriptor;
-    sctp_desc.available_connections_tail = sctp_desc.available_connections_head;
-  } else {
-    new_sctp_descriptor->previous_assoc = sctp_desc.available_connections_tail;
-    sctp_desc.available_connections_tail->next_assoc = new_sctp_descriptor;
-    sctp_desc.available_connections_tail = new_sctp_descriptor;
+  h_rc = hashtable_oa_ts_insert (sctp_desc.associations, (const hash_key_t)assoc_desc->assoc_id, (void *)assoc_desc);
+  if (HASH_TABLE_OK != h_rc) {
+    OAILOG_ERROR (LOG_SCTP, "Failed to insert association %d: %s\n", assoc_desc->assoc_id, hashtable_rc_code2string(h_rc));
+    return -1;
+  }
+
+  if (assoc_desc->sd != sctp_desc.listen_sd) {
+    h_rc = hashtable_oa_ts_insert (sctp_desc.sd_associations, (const hash_key_t)assoc_desc->sd, (void *)assoc_desc);
+    if (HASH_TABLE_OK != h_rc) {
+      OAILOG_ERROR (LOG_SCTP, "Failed to index association %d by sd %d: %s\n", assoc_desc->assoc_id, assoc_desc->sd, hashtable_rc_code2string(h_rc));
+    }
   }
 
   sctp_desc.number_of_connections++;
   sctp_dump_list ();
-  return new_sctp_descriptor;
+  return 0;
 }
 
 //------------------------------------------------------------------------------
-static sctp_association_t *sctp_is_assoc_in_list (sctp_assoc_id_t assoc_id)
+// Callers other than the receiver thread must be in an epoch read section.
+static sctp_association_t *sctp_get_assoc (sctp_assoc_id_t assoc_id)
 {
-  sctp_association_t              *assoc_desc = NULL;
+  void                            *assoc_desc = NULL;
 
   if (assoc_id < 0) {
     return NULL;
   }
 
-  for (assoc_desc = sctp_desc.available_connections_head; assoc_desc; assoc_desc = assoc_desc->next_assoc) {
-    if (assoc_desc->assoc_id == assoc_id) {
-      break;
-    }
+  if (HASH_TABLE_OK != hashtable_oa_ts_get (sctp_desc.associations, (const hash_key_t)assoc_id, &assoc_desc)) {
+    return NULL;
   }
 
-  return assoc_desc;
+  return (sctp_association_t *)assoc_desc;
+}
+
+//------------------------------------------------------------------------------
+static sctp_association_t *sctp_get_assoc_by_sd (int sd)
+{
+  void                            *assoc_desc = NULL;
+
+  if (HASH_TABLE_OK != hashtable_oa_ts_get (sctp_desc.sd_associations, (const hash_key_t)sd, &assoc_desc)) {
+    return NULL;
+  }
+
+  return (sctp_association_t *)assoc_desc;
 }
 
 //------------------------------------------------------------------------------
 static int sctp_remove_assoc_from_list (sctp_assoc_id_t assoc_id)
 {
-  sctp_association_t              *assoc_desc = NULL;
+  void                            *assoc_desc = NULL;
+  void                            *sd_assoc_desc = NULL;
 
   /*
-   * Association not in the list
+   * Association not in the table
    */
-  if ((assoc_desc = sctp_is_assoc_in_list (assoc_id)) == NULL) {
+  if ((assoc_id < 0) ||
+      (HASH_TABLE_OK != hashtable_oa_ts_remove (sctp_desc.associations, (const hash_key_t)assoc_id, &assoc_desc))) {
     return -1;
   }
 
-  if (assoc_desc->next_assoc == NULL) {
-    if (assoc_desc->previous_assoc == NULL) {
-      /*
-       * Head and tail
-       */
-      sctp_desc.available_connections_head = sctp_desc.available_connections_tail = NULL;
-    } else {
-      /*
-       * Not head but tail
-       */
-      sctp_desc.available_connections_tail = assoc_desc->previous_assoc;
-      assoc_desc->previous_assoc->next_assoc = NULL;
-    }
-  } else {
-    if (assoc_desc->previous_assoc == NULL) {
-      /*
-       * Head but not tail
-       */
-      sctp_desc.available_connections_head = assoc_desc->next_assoc;
-      assoc_desc->next_assoc->previous_assoc = NULL;
-    } else {
-      /*
-       * Not head and not tail
-       */
-      assoc_desc->previous_assoc->next_assoc = assoc_desc->next_assoc;
-      assoc_desc->next_assoc->previous_assoc = assoc_desc->previous_assoc;
-    }
+  if (((sctp_association_t *)assoc_desc)->sd != sctp_desc.listen_sd) {
+    hashtable_oa_ts_remove (sctp_desc.sd_associations, (const hash_key_t)((sctp_association_t *)assoc_desc)->sd, &sd_assoc_desc);
   }
 
-  if (assoc_desc->peer_addresses) {
-    int rv = sctp_freepaddrs(assoc_desc->peer_addresses);
-    if (rv) OAILOG_DEBUG (LOG_SCTP, "sctp_freepaddrs(%p) failed\n", assoc_desc->peer_addresses);
-  }
-  free_wrapper ((void**) &assoc_desc);
   sctp_desc.number_of_connections--;
+  // TASK_SCTP may be sending on it
+  epoch_defer_free (assoc_desc, sctp_free_association);
   return 0;
 }
 
@@ -234,63 +258,187 @@ static void sctp_dump_assoc (sctp_association_t *sctp_assoc_p)
 #endif
 }
 
+//------------------------------------------------------------------------------
+static bool sctp_dump_assoc_cb (__attribute__ ((unused)) const hash_key_t keyP, void * const assoc_desc,
+    __attribute__ ((unused)) void *parameterP, __attribute__ ((unused)) void **resultP)
+{
+  sctp_dump_assoc ((sctp_association_t *)assoc_desc);
+  return false;
+}
+
 //------------------------------------------------------------------------------
 static void sctp_dump_list (void)
 {
 #if SCTP_DUMP_LIST
-  sctp_association_t              *sctp_assoc_p = sctp_desc.available_connections_head;
-  OAILOG_DEBUG (LOG_SCTP, "SCTP list contains %d associations\n", sctp_desc.number_of_connections);
-
-  while (sctp_assoc_p != NULL) {
-    sctp_dump_assoc (sctp_assoc_p);
-    sctp_assoc_p = sctp_assoc_p->next_assoc;
-  }
-
+  OAILOG_DEBUG (LOG_SCTP, "SCTP table contains %d associations\n", sctp_desc.number_of_connections);
+  hashtable_oa_ts_apply_callback_on_elements (sctp_desc.associations, sctp_dump_assoc_cb, NULL, NULL);
 #else
+  sctp_dump_assoc_cb (0, NULL, NULL, NULL);
   sctp_dump_assoc (NULL);
 #endif
 }
 
 //------------------------------------------------------------------------------
-static int sctp_send_msg (
-    sctp_assoc_id_t sctp_assoc_id,
-    uint16_t stream,
-    STOLEN_REF bstring *payload)
+static inline uint64_t sctp_clock_ns (void)
 {
-  sctp_association_t              *assoc_desc = NULL;
+  struct timespec                         ts;
 
-  DevAssert (*payload);
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
 
-  if ((assoc_desc = sctp_is_assoc_in_list (sctp_assoc_id)) == NULL) {
+//------------------------------------------------------------------------------
+/*
+ * Writes the payloads of the SCTP_DATA_REQ messages data_reqs, all for the
+ * association sctp_assoc_id, with as few sendmmsg() calls as possible.
+ * Returns the number of messages sent, they are the first ones of data_reqs.
+ * The payloads are released with the messages.
+ */
+static int sctp_send_msgs (
+    const sctp_assoc_id_t sctp_assoc_id,
+    MessageDef ** const data_reqs,
+    const int nb_data_reqs)
+{
+  sctp_association_t              *assoc_desc = NULL;
+  struct mmsghdr                   msgs[SCTP_SEND_BATCH_SIZE];
+  struct iovec                     iovs[SCTP_SEND_BATCH_SIZE];
+  union {
+    char                           buf[CMSG_SPACE (sizeof (struct sctp_sndrcvinfo))];
+    struct cmsghdr                 align;
+  }                                cmsgs[SCTP_SEND_BATCH_SIZE];
+  uint64_t                         bytes = 0;
+  uint64_t                         latency = 0;
+  uint64_t                         now = 0;
+  int                              nb_sent = 0;
+  int                              rc = 0;
+  int                              i = 0;
+
+  DevAssert ((nb_data_reqs > 0) && (nb_data_reqs <= SCTP_SEND_BATCH_SIZE));
+
+  // the receiver thread may release the association concurrently
+  epoch_read_lock ();
+  if ((assoc_desc = sctp_get_assoc (sctp_assoc_id)) == NULL) {
+    epoch_read_unlock ();
     OAILOG_DEBUG (LOG_SCTP, "This assoc id has not been fount in list (%d)\n", sctp_assoc_id);
-    return -1;
+    return 0;
   }
 
   if (assoc_desc->sd == -1) {
     /*
      * The socket is invalid may be closed.
      */
+    assoc_desc->send_failures += nb_data_reqs;
+    epoch_read_unlock ();
     OAILOG_DEBUG (LOG_SCTP, "The socket is invalid may be closed (assoc id %d)\n", sctp_assoc_id);
-    return -1;
+    return 0;
   }
 
-  OAILOG_DEBUG (LOG_SCTP, "[%d][%d] Sending buffer %p of %d bytes on stream %d with ppid %d\n",
-      assoc_desc->sd, sctp_assoc_id, bdata(*payload), blength(*payload), stream, assoc_desc->ppid);
+  memset (msgs, 0, sizeof (msgs[0]) * nb_data_reqs);
+  for (i = 0; i < nb_data_reqs; i++) {
+    const sctp_data_req_t          * const data_req = &SCTP_DATA_REQ (data_reqs[i]);
+    struct cmsghdr                 *cmsg = &cmsgs[i].align;
+    struct sctp_sndrcvinfo         *sinfo = (struct sctp_sndrcvinfo *)CMSG_DATA (cmsg);
 
-  /*
-   * Send message_p on specified stream of the sd association
-   */
-  if (sctp_sendmsg (assoc_desc->sd, (const void *)bdata(*payload), (size_t) blength(*payload), NULL, 0, htonl
-      (assoc_desc->ppid), 0, stream, 0, 0) < 0) {
-    *payload = NULL;
-    OAILOG_ERROR (LOG_SCTP, "send: %s:%d\n", strerror (errno), errno);
-    return -1;
+    DevAssert (data_req->payload);
+    iovs[i].iov_base = bdata (data_req->payload);
+    iovs[i].iov_len = blength (data_req->payload);
+
+    /*
+     * Send message_p on specified stream of the sd association,
+     * the association id selects the peer when the socket is a one-to-many socket.
+     */
+    cmsg->cmsg_level = IPPROTO_SCTP;
+    cmsg->cmsg_type = SCTP_SNDRCV;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (struct sctp_sndrcvinfo));
+    memset (sinfo, 0, sizeof (*sinfo));
+    sinfo->sinfo_stream = data_req->stream;
+    sinfo->sinfo_ppid = htonl (assoc_desc->ppid);
+    sinfo->sinfo_assoc_id = sctp_assoc_id;
+
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_control = cmsgs[i].buf;
+    msgs[i].msg_hdr.msg_controllen = sizeof (cmsgs[i].buf);
   }
-  OAILOG_DEBUG (LOG_SCTP, "Successfully sent %d bytes on stream %d\n", blength(*payload), stream);
-  *payload = NULL;
 
-  assoc_desc->messages_sent++;
-  return 0;
+  while (nb_sent < nb_data_reqs) {
+    if ((rc = sendmmsg (assoc_desc->sd, &msgs[nb_sent], nb_data_reqs - nb_sent, 0)) < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      OAILOG_ERROR (LOG_SCTP, "sendmmsg: %s:%d\n", strerror (errno), errno);
+      break;
+    }
+    assoc_desc->send_batches++;
+    nb_sent += rc;
+  }
+
+  now = sctp_clock_ns ();
+  for (i = 0; i < nb_sent; i++) {
+    bytes += iovs[i].iov_len;
+    if (SCTP_DATA_REQ (data_reqs[i]).req_time_ns) {
+      latency = now - SCTP_DATA_REQ (data_reqs[i]).req_time_ns;
+      assoc_desc->send_latency_sum_ns += latency;
+      if (latency > assoc_desc->send_latency_max_ns) {
+        assoc_desc->send_latency_max_ns = latency;
+      }
+    }
+  }
+  assoc_desc->messages_sent += nb_sent;
+  assoc_desc->bytes_sent += bytes;
+  assoc_desc->send_failures += nb_data_reqs - nb_sent;
+  epoch_read_unlock ();
+
+  OAILOG_DEBUG (LOG_SCTP, "[%d] Successfully sent %d messages out of %d, %" PRIu64 " bytes\n", sctp_assoc_id, nb_sent, nb_data_reqs, bytes);
+  return nb_sent;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Sends the SCTP_DATA_REQ messages received at once, grouped by association.
+ * The order of the messages of one association is kept.
+ */
+static void sctp_send_data_reqs (
+    MessageDef ** const data_reqs,
+    const int nb_data_reqs)
+{
+  MessageDef                      *assoc_data_reqs[SCTP_SEND_BATCH_SIZE];
+  bool                             queued[SCTP_SEND_BATCH_SIZE] = {false};
+  sctp_assoc_id_t                  assoc_id = 0;
+  int                              nb_assoc_data_reqs = 0;
+  int                              nb_sent = 0;
+  int                              i = 0;
+  int                              j = 0;
+
+  for (i = 0; i < nb_data_reqs; i++) {
+    if (queued[i]) {
+      continue;
+    }
+    assoc_id = SCTP_DATA_REQ (data_reqs[i]).assoc_id;
+    nb_assoc_data_reqs = 0;
+    for (j = i; j < nb_data_reqs; j++) {
+      if ((!queued[j]) && (SCTP_DATA_REQ (data_reqs[j]).assoc_id == assoc_id)) {
+        assoc_data_reqs[nb_assoc_data_reqs++] = data_reqs[j];
+        queued[j] = true;
+      }
+    }
+
+    nb_sent = sctp_send_msgs (assoc_id, assoc_data_reqs, nb_assoc_data_reqs);
+
+    for (j = nb_sent; j < nb_assoc_data_reqs; j++) {
+      sctp_itti_send_lower_layer_conf(assoc_data_reqs[j]->ittiMsgHeader.originTaskId,
+          SCTP_DATA_REQ (assoc_data_reqs[j]).assoc_id,
+          SCTP_DATA_REQ (assoc_data_reqs[j]).stream,
+          SCTP_DATA_REQ (assoc_data_reqs[j]).mme_ue_s1ap_id,
+          false);
+    }
+    /* NO NEED FOR CONFIRM success yet */
+  }
+
+  for (i = 0; i < nb_data_reqs; i++) {
+    itti_free_msg_content(data_reqs[i]);
+    itti_free (ITTI_MSG_ORIGIN_ID (data_reqs[i]), data_reqs[i]);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -352,7 +500,7 @@ static int sctp_create_new_listener (SctpInit * init_p)
     }
   }
 
-  if ((sd = socket (AF_INET6, SOCK_STREAM, IPPROTO_SCTP)) < 0) {
+  if ((sd = socket (AF_INET6, (sctp_desc.one_to_many) ? SOCK_SEQPACKET : SOCK_STREAM, IPPROTO_SCTP)) < 0) {
     OAILOG_ERROR (LOG_SCTP, "socket: %s:%d\n", strerror (errno), errno);
     return -1;
   }
@@ -379,11 +527,22 @@ static int sctp_create_new_listener (SctpInit * init_p)
     goto err;
   }
 
-  if (listen (sd, 5) < 0) {
+  if (listen (sd, SOMAXCONN) < 0) {
     OAILOG_ERROR (LOG_SCTP, "listen: %s:%d\n", strerror (errno), errno);
     goto err;
   }
 
+  /*
+   * The edge triggered receiver thread accepts pending connections until EAGAIN.
+   * A one-to-many socket is never accepted on and is also used for sending, keep it blocking.
+   */
+  if ((!sctp_desc.one_to_many) && (fcntl (sd, F_SETFL, fcntl (sd, F_GETFL, 0) | O_NONBLOCK) < 0)) {
+    OAILOG_ERROR (LOG_SCTP, "fcntl O_NONBLOCK: %s:%d\n", strerror (errno), errno);
+    goto err;
+  }
+
+  sctp_desc.listen_sd = sd;
+
   if ((sctp_arg_p = malloc (sizeof (sctp_arg_t))) == NULL) {
     goto err;
   }
@@ -412,31 +571,86 @@ err:
   return -1;
 }
 
+//------------------------------------------------------------------------------
+// Non blocking sctp_recvmsg(): the sockets shared with the sending task stay in blocking mode.
+static int sctp_recvmsg_nowait (
+    int sd,
+    uint8_t *buffer,
+    size_t length,
+    struct sockaddr_in6 *addr,
+    struct sctp_sndrcvinfo *sinfo,
+    int *flags)
+{
+  struct iovec                            iov = {.iov_base = buffer, .iov_len = length};
+  char                                    cmsg_buffer[CMSG_SPACE (sizeof (struct sctp_sndrcvinfo))];
+  struct msghdr                           msg = {0};
+  struct cmsghdr                         *cmsg = NULL;
+  ssize_t                                 n = 0;
+
+  msg.msg_name = addr;
+  msg.msg_namelen = (socklen_t) sizeof (struct sockaddr_in6);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsg_buffer;
+  msg.msg_controllen = sizeof (cmsg_buffer);
+
+  if ((n = recvmsg (sd, &msg, MSG_DONTWAIT)) < 0) {
+    return -1;
+  }
+
+  *flags = msg.msg_flags;
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if ((IPPROTO_SCTP == cmsg->cmsg_level) && (SCTP_SNDRCV == cmsg->cmsg_type)) {
+      memcpy ((void *)sinfo, (void *)CMSG_DATA (cmsg), sizeof (struct sctp_sndrcvinfo));
+    }
+  }
+
+  return (int)n;
+}
+
 //------------------------------------------------------------------------------
 static inline int sctp_read_from_socket (int sd, uint32_t ppid)
 {
   int                                     flags = 0,
     n;
-  socklen_t                               from_len = 0;
   struct sctp_sndrcvinfo                  sinfo = {0};
   struct sockaddr_in6                     addr = {0};
-  uint8_t                                 buffer[SCTP_RECV_BUFFER_SIZE];
+  uint8_t                                *buffer = sctp_desc.recv_buffer;
 
   if (sd < 0) {
     return -1;
   }
 
   memset ((void *)&addr, 0, sizeof (struct sockaddr_in6));
-  from_len = (socklen_t) sizeof (struct sockaddr_in6);
   memset ((void *)&sinfo, 0, sizeof (struct sctp_sndrcvinfo));
-  n = sctp_recvmsg (sd, (void *)buffer, SCTP_RECV_BUFFER_SIZE, (struct sockaddr *)&addr, &from_len, &sinfo, &flags);
+  n = sctp_recvmsg_nowait (sd, buffer, SCTP_RECV_BUFFER_SIZE, &addr, &sinfo, &flags);
 
   if (n < 0) {
+    if ((EAGAIN == errno) || (EWOULDBLOCK == errno)) {
+      return SCTP_RC_WOULDBLOCK;
+    }
     OAILOG_DEBUG (LOG_SCTP, "An error occured during read\n");
     OAILOG_ERROR (LOG_SCTP, "sctp_recvmsg: %s:%d\n", strerror (errno), errno);
     return SCTP_RC_ERROR;
   }
 
+  if (0 == n) {
+    /*
+     * End of file: the peer closed a one-to-one socket without notification.
+     */
+    sctp_association_t              *assoc_desc = NULL;
+
+    if (sd == sctp_desc.listen_sd) {
+      return SCTP_RC_ERROR;
+    }
+    OAILOG_DEBUG (LOG_SCTP, "[%d] Connection closed by peer\n", sd);
+    if ((assoc_desc = sctp_get_assoc_by_sd (sd))) {
+      return sctp_handle_com_down (assoc_desc->assoc_id);
+    }
+    return SCTP_RC_DISCONNECT;
+  }
+
   if (flags & MSG_NOTIFICATION) {
     union sctp_notification                *snp = (union sctp_notification *)buffer;
 
@@ -447,7 +661,9 @@ static inline int sctp_read_from_socket (int sd, uint32_t ppid)
     }
     case SCTP_ASSOC_CHANGE: {
       OAILOG_DEBUG(LOG_SCTP, "SCTP association change event received\n");
-      return handle_assoc_change(sd, ppid, &snp->sn_assoc_change);
+      int rc = handle_assoc_change(sd, ppid, &snp->sn_assoc_change);
+      // the notification has been consumed, keep on draining the socket
+      return (SCTP_RC_ERROR == rc) ? SCTP_RC_NORMAL_READ : rc;
     }
     default: {
       OAILOG_WARNING(LOG_SCTP, "Unhandled notification type %u\n", snp->sn_header.sn_type);
@@ -460,12 +676,18 @@ static inline int sctp_read_from_socket (int sd, uint32_t ppid)
      */
     sctp_association_t              *association;
 
-    if ((association = sctp_is_assoc_in_list ((sctp_assoc_id_t) sinfo.sinfo_assoc_id)) == NULL) {
-      // TODO: handle this case
-      return SCTP_RC_ERROR;
+    if ((association = sctp_get_assoc ((sctp_assoc_id_t) sinfo.sinfo_assoc_id)) == NULL) {
+      /*
+       * Data of an association already closed (or not yet announced by
+       * SCTP_COMM_UP): the message is dropped and the socket still drained,
+       * the data of the other associations may be queued behind it.
+       */
+      OAILOG_ERROR (LOG_SCTP, "Discarding data received on unknown association %d\n", sinfo.sinfo_assoc_id);
+      return SCTP_RC_NORMAL_READ;
     }
 
     association->messages_recv++;
+    association->bytes_recv += n;
 
     if (ntohl (sinfo.sinfo_ppid) != association->ppid) {
       /*
@@ -473,7 +695,7 @@ static inline int sctp_read_from_socket (int sd, uint32_t ppid)
        * * * * may be we received unsollicited traffic from stack other than S1AP.
        */
       OAILOG_ERROR (LOG_SCTP, "Received data from peer with unsollicited PPID %d, expecting %d\n", ntohl (sinfo.sinfo_ppid), association->ppid);
-      return SCTP_RC_ERROR;
+      return SCTP_RC_NORMAL_READ;
     }
 
     OAILOG_DEBUG (LOG_SCTP, "[%d][%d] Msg of length %d received from port %u, on stream %d, PPID %d\n", sinfo.sinfo_assoc_id, sd, n, ntohs (addr.sin6_port), sinfo.sinfo_stream, ntohl (sinfo.sinfo_ppid));
@@ -507,33 +729,86 @@ static int sctp_handle_reset(const sctp_assoc_id_t assoc_id) {
     OAILOG_ERROR(LOG_SCTP, "Failed to send release message to TASK_S1AP\n");
     return SCTP_RC_ERROR;
   }
-  sctp_association_t *assoc = sctp_is_assoc_in_list(assoc_id);
+  sctp_association_t *assoc = sctp_get_assoc(assoc_id);
   DevAssert(assoc != NULL);
 
   return SCTP_RC_NORMAL_READ;
 }
 
 //------------------------------------------------------------------------------
-void *sctp_receiver_thread (void *args_p)
+// Read every message pending on a socket, the socket is registered in edge triggered mode.
+static void sctp_drain_socket (int sd, uint32_t ppid)
 {
-  sctp_arg_t                             sctp_arg_p;
+  int                                     rc = SCTP_RC_NORMAL_READ;
 
-  /*
-   * maximum file descriptor number
-   */
-  int                                     fdmax,
-                                          clientsock,
-                                          i;
+  do {
+    rc = sctp_read_from_socket (sd, ppid);
 
-  /*
-   * master file descriptor list
-   */
-  fd_set                                  master;
+    if ((SCTP_RC_ERROR == rc) && (sd != sctp_desc.listen_sd)) {
+      /*
+       * One-to-one socket failure without notification, release its association.
+       */
+      sctp_association_t            *assoc_desc = sctp_get_assoc_by_sd (sd);
 
-  /*
-   * temp file descriptor list for select()
-   */
-  fd_set                                  read_fds;
+      if (assoc_desc) {
+        rc = sctp_handle_com_down (assoc_desc->assoc_id);
+      } else {
+        /*
+         * No association was ever registered for this socket: nobody reads it.
+         */
+        rc = SCTP_RC_DISCONNECT;
+      }
+    }
+
+    if ((SCTP_RC_DISCONNECT == rc) && (sd != sctp_desc.listen_sd)) {
+      /*
+       * One-to-one socket: the association is gone with its socket,
+       * closing it also removes it from the epoll set.
+       */
+      close (sd);
+      return;
+    }
+    /*
+     * An error ends the draining, on the one-to-many socket a disconnection only
+     * releases one of its associations.
+     */
+  } while ((SCTP_RC_NORMAL_READ == rc) || (SCTP_RC_DISCONNECT == rc));
+}
+
+//------------------------------------------------------------------------------
+static void sctp_accept_connections (int listen_sd, uint32_t ppid)
+{
+  struct epoll_event                      event = {0};
+  int                                     clientsock = -1;
+
+  while ((clientsock = accept (listen_sd, NULL, NULL)) >= 0) {
+    event.events = EPOLLIN | EPOLLET;
+    event.data.fd = clientsock;
+
+    if (epoll_ctl (sctp_desc.epoll_fd, EPOLL_CTL_ADD, clientsock, &event) < 0) {
+      OAILOG_ERROR (LOG_SCTP, "[%d] epoll_ctl: %s:%d\n", clientsock, strerror (errno), errno);
+      close (clientsock);
+      continue;
+    }
+    /*
+     * The SCTP_COMM_UP notification may already be queued on the new socket.
+     */
+    sctp_drain_socket (clientsock, ppid);
+  }
+
+  if ((EAGAIN != errno) && (EWOULDBLOCK != errno)) {
+    OAILOG_ERROR (LOG_SCTP, "[%d] accept: %s:%d\n", listen_sd, strerror (errno), errno);
+  }
+}
+
+//------------------------------------------------------------------------------
+void *sctp_receiver_thread (void *args_p)
+{
+  sctp_arg_t                             sctp_arg_p;
+  struct epoll_event                     event = {0};
+  struct epoll_event                     events[SCTP_EPOLL_MAX_EVENTS];
+  int                                    nb_events = 0,
+                                         i = 0;
 
   if (args_p == NULL) {
     pthread_exit (NULL);
@@ -542,77 +817,46 @@ void *sctp_receiver_thread (void *args_p)
   memcpy(&sctp_arg_p, args_p, sizeof sctp_arg_p);
   free_wrapper (&args_p);
 
-  /*
-   * clear the master and temp sets
-   */
-  FD_ZERO (&master);
-  FD_ZERO (&read_fds);
-  FD_SET (sctp_arg_p.sd, &master);
-  fdmax = sctp_arg_p.sd;       /* so far, it's this one */
+  sctp_desc.recv_buffer = malloc (SCTP_RECV_BUFFER_SIZE);
+  sctp_desc.epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  event.events = EPOLLIN | EPOLLET;
+  event.data.fd = sctp_arg_p.sd;
+
+  if ((!sctp_desc.recv_buffer) || (sctp_desc.epoll_fd < 0) ||
+      (epoll_ctl (sctp_desc.epoll_fd, EPOLL_CTL_ADD, sctp_arg_p.sd, &event) < 0)) {
+    OAILOG_ERROR (LOG_SCTP, "[%d] Cannot setup receiver: %s\n", sctp_arg_p.sd, strerror (errno));
+    close(sctp_arg_p.sd);
+    pthread_exit (NULL);
+  }
 
   while (1) {
-    memcpy (&read_fds, &master, sizeof (master));
+    nb_events = epoll_wait (sctp_desc.epoll_fd, events, SCTP_EPOLL_MAX_EVENTS, -1);
 
-    if (select (fdmax + 1, &read_fds, NULL, NULL, NULL) == -1) {
-      OAILOG_ERROR (LOG_SCTP, "[%d] Select() error: %s\n", sctp_arg_p.sd, strerror (errno));
-      free_wrapper ((void**) &args_p);
+    if (nb_events < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      OAILOG_ERROR (LOG_SCTP, "[%d] epoll_wait() error: %s\n", sctp_arg_p.sd, strerror (errno));
       close(sctp_arg_p.sd);
-      args_p = NULL;
       pthread_exit (NULL);
     }
 
-    for (i = 0; i <= fdmax; i++) {
-      if (FD_ISSET (i, &read_fds)) {
-        if (i == sctp_arg_p.sd) {
-          /*
-           * There is data to read on listener socket. This means we have to accept
-           * * * * the connection.
-           */
-          if ((clientsock = accept (sctp_arg_p.sd, NULL, NULL)) < 0) {
-            OAILOG_ERROR (LOG_SCTP, "[%d] accept: %s:%d\n", sctp_arg_p.sd, strerror (errno), errno);
-            free_wrapper ((void**) &args_p);
-            close(sctp_arg_p.sd);
-            args_p = NULL;
-            pthread_exit (NULL);
-          } else {
-            FD_SET (clientsock, &master);       /* add to master set */
-
-            if (clientsock > fdmax) {
-              /*
-               * keep track of the maximum
-               */
-              fdmax = clientsock;
-            }
-          }
-        } else {
-          int                                     ret;
-
-          /*
-           * Read from socket
-           */
-          ret = sctp_read_from_socket (i, sctp_arg_p.ppid);
-
-          /*
-           * When the socket is disconnected we have to update
-           * * * * the fd_set.
-           */
-          if (ret == SCTP_RC_DISCONNECT) {
-            /*
-             * Remove the socket from the FD set and update the max sd
-             */
-            FD_CLR (i, &master);
-
-            if (i == fdmax) {
-              while (FD_ISSET (fdmax, &master) == false)
-                fdmax -= 1;
-            }
-          }
-        }
+    for (i = 0; i < nb_events; i++) {
+      if ((events[i].data.fd == sctp_arg_p.sd) && (!sctp_desc.one_to_many)) {
+        /*
+         * There is data to read on listener socket. This means we have to accept
+         * the connection(s).
+         */
+        sctp_accept_connections (sctp_arg_p.sd, sctp_arg_p.ppid);
+      } else {
+        /*
+         * Data or notifications on an association socket, or on the one-to-many socket
+         */
+        sctp_drain_socket (events[i].data.fd, sctp_arg_p.ppid);
       }
     }
   }
 
-
   return NULL;
 }
 
@@ -620,80 +864,83 @@ void *sctp_receiver_thread (void *args_p)
 static void * sctp_intertask_interface (
     __attribute__ ((unused)) void *args_p)
 {
+  MessageDef                             *received_messages_p[SCTP_SEND_BATCH_SIZE];
+  MessageDef                             *data_reqs[SCTP_SEND_BATCH_SIZE];
+  int                                     nb_messages = 0;
+  int                                     nb_data_reqs = 0;
+  int                                     i = 0;
   int sctp_sd = -1;
   itti_mark_task_ready (TASK_SCTP);
 
   while (1) {
-    MessageDef                             *received_message_p = NULL;
+    /*
+     * Drain the queue, the SCTP_DATA_REQs (paging, mass UE context release)
+     * are written per association with one sendmmsg().
+     */
+    nb_messages = itti_receive_msgs (TASK_SCTP, received_messages_p, SCTP_SEND_BATCH_SIZE);
+    nb_data_reqs = 0;
 
-    itti_receive_msg (TASK_SCTP, &received_message_p);
+    for (i = 0; i < nb_messages; i++) {
+      MessageDef                             *received_message_p = received_messages_p[i];
 
-    switch (ITTI_MSG_ID (received_message_p)) {
-    case SCTP_INIT_MSG:{
-        OAILOG_DEBUG (LOG_SCTP, "Received SCTP_INIT_MSG\n");
+      if (SCTP_DATA_REQ == ITTI_MSG_ID (received_message_p)) {
+        data_reqs[nb_data_reqs++] = received_message_p;
+        continue;
+      }
+      // the data requests queued before go first
+      if (nb_data_reqs) {
+        sctp_send_data_reqs (data_reqs, nb_data_reqs);
+        nb_data_reqs = 0;
+      }
+
+      switch (ITTI_MSG_ID (received_message_p)) {
+      case SCTP_INIT_MSG:{
+          OAILOG_DEBUG (LOG_SCTP, "Received SCTP_INIT_MSG\n");
 
-        /*
-         * We received a new connection request
-         */
-        if ((sctp_sd = sctp_create_new_listener (&received_message_p->ittiMsg.sctpInit)) < 0) {
           /*
-           * SCTP socket creation or bind failed...
-           * Die as this MME is not going to be useful.
+           * We received a new connection request
            */
-          AssertFatal(false, "Failed to create new SCTP listener\n");
+          if ((sctp_sd = sctp_create_new_listener (&received_message_p->ittiMsg.sctpInit)) < 0) {
+            /*
+             * SCTP socket creation or bind failed...
+             * Die as this MME is not going to be useful.
+             */
+            AssertFatal(false, "Failed to create new SCTP listener\n");
+          }
         }
-      }
-      break;
-
-    case SCTP_CLOSE_ASSOCIATION:{
-      }
-      break;
+        break;
 
-    case SCTP_DATA_REQ:{
-        if (sctp_send_msg (SCTP_DATA_REQ (received_message_p).assoc_id,
-            SCTP_DATA_REQ (received_message_p).stream,
-            &SCTP_DATA_REQ (received_message_p).payload) < 0) {
-
-          sctp_itti_send_lower_layer_conf(received_message_p->ittiMsgHeader.originTaskId,
-              SCTP_DATA_REQ (received_message_p).assoc_id,
-              SCTP_DATA_REQ (received_message_p).stream,
-              SCTP_DATA_REQ (received_message_p).mme_ue_s1ap_id,
-              false);
-        } /* NO NEED FOR CONFIRM success yet else {
-          if (INVALID_MME_UE_S1AP_ID != SCTP_DATA_REQ (received_message_p).mme_ue_s1ap_id) {
-            sctp_itti_send_lower_layer_conf(received_message_p->ittiMsgHeader.originTaskId,
-                SCTP_DATA_REQ (received_message_p).assoc_id,
-                SCTP_DATA_REQ (received_message_p).stream,
-                SCTP_DATA_REQ (received_message_p).mme_ue_s1ap_id,
-                true);
-          }
-        }*/
-      }
-      break;
+      case SCTP_CLOSE_ASSOCIATION:{
+        }
+        break;
 
-    case MESSAGE_TEST:{
-        OAI_FPRINTF_INFO("TASK_SCTP received MESSAGE_TEST\n");
-      }
-      break;
+      case MESSAGE_TEST:{
+          OAI_FPRINTF_INFO("TASK_SCTP received MESSAGE_TEST\n");
+        }
+        break;
+
+      case TERMINATE_MESSAGE:{
+          close(sctp_sd);
+          sctp_exit();
+          itti_free_msg_content(received_message_p);
+          itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+          itti_exit_task ();
+        }
+        break;
 
-    case TERMINATE_MESSAGE:{
-        close(sctp_sd);
-        sctp_exit();
-        itti_free_msg_content(received_message_p);
-        itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-        itti_exit_task ();
+      default:{
+          OAILOG_DEBUG (LOG_SCTP, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+        }
+        break;
       }
-      break;
 
-    default:{
-        OAILOG_DEBUG (LOG_SCTP, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
-      }
-      break;
+      itti_free_msg_content(received_message_p);
+      itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
     }
 
-    itti_free_msg_content(received_message_p);
-    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-    received_message_p = NULL;
+    if (nb_data_reqs) {
+      sctp_send_data_reqs (data_reqs, nb_data_reqs);
+    }
   }
 
   return NULL;
@@ -703,7 +950,7 @@ static void * sctp_intertask_interface (
 // Function adds a new association and sends a new association notification message.
 sctp_association_t* add_new_association(int sd, uint32_t ppid, struct sctp_assoc_change *sctp_assoc_changed) {
   sctp_association_t *new_association = NULL;
-  if ((new_association = sctp_add_new_peer()) == NULL) {
+  if ((new_association = calloc (1, sizeof (sctp_association_t))) == NULL) {
     OAILOG_ERROR (LOG_SCTP, "Failed to allocate new sctp peer \n");
     return NULL;
   }
@@ -713,13 +960,23 @@ sctp_association_t* add_new_association(int sd, uint32_t ppid, struct sctp_assoc
   new_association->instreams = sctp_assoc_changed->sac_inbound_streams;
   new_association->outstreams = sctp_assoc_changed->sac_outbound_streams;
   new_association->assoc_id = (sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id;
-  sctp_get_localaddresses(sd, NULL, NULL);
-  sctp_get_peeraddresses(sd, &new_association->peer_addresses, &new_association->nb_peer_addresses);
+  new_association->creation_time_ns = sctp_clock_ns ();
+  sctp_get_localaddresses(sd, new_association->assoc_id, NULL, NULL);
+  sctp_get_peeraddresses(sd, new_association->assoc_id, &new_association->peer_addresses, &new_association->nb_peer_addresses);
+
+  if (sctp_add_new_peer (new_association) < 0) {
+    sctp_free_association ((void **)&new_association);
+    return NULL;
+  }
 
   if (sctp_itti_send_new_association(new_association->assoc_id,
                                      new_association->instreams,
                                      new_association->outstreams) < 0) {
-    OAILOG_ERROR (LOG_SCTP, "Failed to send message to S1AP\n");
+    /*
+     * S1AP would never learn of the association, do not keep it registered
+     */
+    OAILOG_ERROR (LOG_SCTP, "Failed to send message to S1AP, association %d released\n", new_association->assoc_id);
+    sctp_remove_assoc_from_list (new_association->assoc_id);
     return NULL;
   }
   return new_association;
@@ -739,7 +996,7 @@ int handle_assoc_change(int sd, uint32_t ppid, struct sctp_assoc_change  *sctp_a
     break;
   }
   case SCTP_RESTART: {
-    DevAssert(sctp_is_assoc_in_list((sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id) != NULL);
+    DevAssert(sctp_get_assoc((sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id) != NULL);
     /* Don't remove the sctp assoc from the list of associations, just send remove the s1ap state */
     rc =  sctp_handle_reset((sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id);
     break;
@@ -747,7 +1004,14 @@ int handle_assoc_change(int sd, uint32_t ppid, struct sctp_assoc_change  *sctp_a
   case SCTP_COMM_LOST:
   case SCTP_SHUTDOWN_COMP:
   case SCTP_CANT_STR_ASSOC: {
-    DevAssert(sctp_is_assoc_in_list((sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id) != NULL);
+    if (sctp_get_assoc((sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id) == NULL) {
+      /*
+       * Already released on SCTP_SHUTDOWN_EVENT, the one-to-many socket keeps on
+       * delivering the notifications of the association.
+       */
+      OAILOG_DEBUG(LOG_SCTP, "Association %d already released\n", sctp_assoc_changed->sac_assoc_id);
+      break;
+    }
     rc = sctp_handle_com_down((sctp_assoc_id_t) sctp_assoc_changed->sac_assoc_id);
     break;
   }
@@ -758,6 +1022,40 @@ int handle_assoc_change(int sd, uint32_t ppid, struct sctp_assoc_change  *sctp_a
   return rc;
 }
 
+//------------------------------------------------------------------------------
+static bool sctp_statistics_display_cb (__attribute__ ((unused)) const hash_key_t keyP, void * const assoc_desc_p,
+    void *parameterP, __attribute__ ((unused)) void **resultP)
+{
+  sctp_association_t              *assoc_desc = (sctp_association_t *)assoc_desc_p;
+  const uint64_t                   now = *(uint64_t *)parameterP;
+  __attribute__ ((unused)) const double elapsed = (now > assoc_desc->creation_time_ns) ? (double)(now - assoc_desc->creation_time_ns) / 1e9 : 1;
+
+  OAILOG_DEBUG (LOG_SCTP, " %10d | %5d | %12" PRIu64 " | %14" PRIu64 " | %12" PRIu64 " | %14" PRIu64 " | %10" PRIu64 " | %5.1f | %9.1f | %9.1f | %9.0f | %9.0f |\n",
+      assoc_desc->assoc_id, assoc_desc->sd, assoc_desc->messages_recv, assoc_desc->bytes_recv,
+      assoc_desc->messages_sent, assoc_desc->bytes_sent, assoc_desc->send_failures,
+      (assoc_desc->send_batches) ? (double)assoc_desc->messages_sent / assoc_desc->send_batches : 0,
+      (assoc_desc->messages_sent) ? (double)assoc_desc->send_latency_sum_ns / assoc_desc->messages_sent / 1e3 : 0,
+      (double)assoc_desc->send_latency_max_ns / 1e3,
+      (double)assoc_desc->messages_sent / elapsed, (double)assoc_desc->bytes_sent / elapsed / 1e3);
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void sctp_statistics_display (void)
+{
+  uint64_t                         now = sctp_clock_ns ();
+
+  if (!sctp_desc.associations) {
+    return;
+  }
+  OAILOG_DEBUG (LOG_SCTP, "==================================== SCTP STATISTICS ==========================================\n\n");
+  OAILOG_DEBUG (LOG_SCTP, "Associations: %u\n", sctp_desc.number_of_connections);
+  OAILOG_DEBUG (LOG_SCTP, "   assoc id |    sd |    msgs recv |     bytes recv |    msgs sent |     bytes sent | send fails | batch | avg us tx | max us tx | msgs/s tx |   kB/s tx |\n");
+  // writers are blocked during the walk, the associations cannot be released
+  hashtable_oa_ts_apply_callback_on_elements (sctp_desc.associations, sctp_statistics_display_cb, &now, NULL);
+  OAILOG_DEBUG (LOG_SCTP, "==================================== SCTP STATISTICS ==========================================\n\n");
+}
+
 //------------------------------------------------------------------------------
 int sctp_init (const mme_config_t * mme_config_p)
 {
@@ -768,6 +1066,17 @@ int sctp_init (const mme_config_t * mme_config_p)
    */
   sctp_desc.nb_instreams = mme_config_p->sctp_config.in_streams;
   sctp_desc.nb_outstreams = mme_config_p->sctp_config.out_streams;
+  sctp_desc.one_to_many = mme_config_p->sctp_config.one_to_many;
+  sctp_desc.listen_sd = -1;
+  sctp_desc.epoll_fd = -1;
+
+  bstring b = bfromcstr ("sctp_associations");
+  sctp_desc.associations = hashtable_oa_ts_create (mme_config_p->max_enbs, NULL, sctp_free_association, b);
+  btrunc (b, 0);
+  bassigncstr (b, "sctp_sd_associations");
+  sctp_desc.sd_associations = hashtable_oa_ts_create (mme_config_p->max_enbs, NULL, hash_free_int_func, b);
+  bdestroy_wrapper (&b);
+  AssertFatal ((sctp_desc.associations) && (sctp_desc.sd_associations), "Failed to create SCTP association tables\n");
 
   if (itti_create_task (TASK_SCTP, &sctp_intertask_interface, NULL) < 0) {
     OAILOG_ERROR (LOG_SCTP, "create task failed\n");
@@ -779,6 +1088,16 @@ int sctp_init (const mme_config_t * mme_config_p)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+static bool sctp_close_assoc_cb (__attribute__ ((unused)) const hash_key_t keyP, void * const assoc_desc,
+    __attribute__ ((unused)) void *parameterP, __attribute__ ((unused)) void **resultP)
+{
+  if (((sctp_association_t *)assoc_desc)->sd != sctp_desc.listen_sd) {
+    close(((sctp_association_t *)assoc_desc)->sd);
+  }
+  return false;
+}
+
 //------------------------------------------------------------------------------
 static void sctp_exit (void)
 {
@@ -787,18 +1106,17 @@ static void sctp_exit (void)
   pthread_join(assoc_thread, NULL);
   if (rv) OAILOG_DEBUG (LOG_SCTP, "pthread_cancel(%08lX) failed: %d:%s\n", assoc_thread, rv, strerror(rv));;
 
-  sctp_association_t              *sctp_assoc_p = sctp_desc.available_connections_head;
-  sctp_association_t              *next_sctp_assoc_p = sctp_desc.available_connections_head;
-
-  while (next_sctp_assoc_p) {
-    next_sctp_assoc_p = sctp_assoc_p->next_assoc;
-    if (sctp_assoc_p->peer_addresses) {
-      close(sctp_assoc_p->sd);
-      rv = sctp_freepaddrs(sctp_assoc_p->peer_addresses);
-      if (rv) OAILOG_DEBUG (LOG_SCTP, "sctp_freepaddrs(%p) failed\n", sctp_assoc_p->peer_addresses);
-    }
-    free_wrapper ((void**) &sctp_assoc_p);
-    sctp_desc.number_of_connections--;
+  // associations are released with the table
+  hashtable_oa_ts_apply_callback_on_elements (sctp_desc.associations, sctp_close_assoc_cb, NULL, NULL);
+  hashtable_oa_ts_destroy (sctp_desc.sd_associations);
+  hashtable_oa_ts_destroy (sctp_desc.associations);
+  sctp_desc.sd_associations = NULL;
+  sctp_desc.associations = NULL;
+  sctp_desc.number_of_connections = 0;
+  if (sctp_desc.epoll_fd >= 0) {
+    close(sctp_desc.epoll_fd);
+    sctp_desc.epoll_fd = -1;
   }
+  free_wrapper ((void**) &sctp_desc.recv_buffer);
   OAI_FPRINTF_INFO("TASK_SCTP terminated\n");
 }
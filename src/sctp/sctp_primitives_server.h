@@ -56,6 +56,10 @@ typedef void (*sctp_recv_callback)(uint8_t *buffer, uint32_t length);
  **/
 int sctp_init(const mme_config_t *mme_config_p);
 
+/** \brief Log the per association counters (messages and bytes received and sent)
+ **/
+void sctp_statistics_display(void);
+
 #endif /* FILE_SCTP_PRIMITIVES_SERVER_SEEN */
 
 /* @} */
@@ -25,16 +25,12 @@
 #include <stdbool.h>
 #include <string.h>
 
-#include <nettle/nettle-meta.h>
-#include <nettle/aes.h>
-#include <nettle/ctr.h>
 #include "bstrlib.h"
 
 #include "assertions.h"
 #include "conversions.h"
 #include "secu_defs.h"
 #include "snow3g.h"
-#include "dynamic_memory_check.h"
 
 
 int
@@ -43,11 +39,8 @@ nas_stream_encrypt_eea1 (
   uint8_t * const out)
 {
   snow_3g_context_t                       snow_3g_context;
-  int                                     n;
-  int                                     i = 0;
   uint32_t                                zero_bit = 0;
-  //uint32_t                                byte_length;
-  uint32_t                               *KS;
+  uint32_t                                byte_length;
   uint32_t                                K[4],
                                           IV[4];
 
@@ -55,9 +48,8 @@ nas_stream_encrypt_eea1 (
   DevAssert (stream_cipher->key != NULL);
   DevAssert (stream_cipher->key_length == 16);
   DevAssert (out != NULL);
-  n = (stream_cipher->blength + 31) / 32;
   zero_bit = stream_cipher->blength & 0x7;
-  //byte_length = stream_cipher->blength >> 3;
+  byte_length = (stream_cipher->blength + 7) >> 3;
   memset (&snow_3g_context, 0, sizeof (snow_3g_context));
   /*
    * Initialisation
@@ -87,40 +79,14 @@ nas_stream_encrypt_eea1 (
   IV[1] = IV[3];
   IV[0] = IV[2];
   /*
-   * Run SNOW 3G algorithm to generate sequence of key stream bits KS
+   * Run SNOW 3G algorithm and exclusive-OR the input data with the key
+   * stream bits KS as they are generated, out may be the message itself.
    */
   snow3g_initialize (K, IV, &snow_3g_context);
-  KS = (uint32_t *) calloc (1, 4 * n);
-  snow3g_generate_key_stream (n, (uint32_t *) KS, &snow_3g_context);
+  snow3g_xor_key_stream (stream_cipher->message, out, byte_length, &snow_3g_context);
 
   if (zero_bit > 0) {
-    KS[n - 1] = KS[n - 1] & (uint32_t) (0xFFFFFFFF << (8 - zero_bit));
-  }
-
-  for (i = 0; i < n; i++) {
-    KS[i] = hton_int32 (KS[i]);
-  }
-
-  /*
-   * Exclusive-OR the input data with keystream to generate the output bit
-   * stream
-   */
-  for (i = 0; i < n * 4; i++) {
-    stream_cipher->message[i] ^= *(((uint8_t *) KS) + i);
-  }
-
-  int                                     ceil_index = 0;
-
-  if (zero_bit > 0) {
-    ceil_index = (stream_cipher->blength + 7) >> 3;
-    stream_cipher->message[ceil_index - 1] = stream_cipher->message[ceil_index - 1] & (uint8_t) (0xFF << (8 - zero_bit));
-  }
-
-  free_wrapper ((void**)&KS);
-  memcpy (out, stream_cipher->message, n * 4);
-
-  if (zero_bit > 0) {
-    out[ceil_index - 1] = stream_cipher->message[ceil_index - 1];
+    out[byte_length - 1] = out[byte_length - 1] & (uint8_t) (0xFF << (8 - zero_bit));
   }
 
   return 0;
@@ -80,3 +80,40 @@ nas_stream_encrypt_eea2 (
   free_wrapper ((void**)&ctx);
   return 0;
 }
+
+//------------------------------------------------------------------------------
+int
+nas_stream_encrypt_eea2_cached (
+  nas_stream_key_schedule_t * const schedule,
+  nas_stream_cipher_t * const stream_cipher,
+  uint8_t * const out)
+{
+  uint8_t                                 m[16] = {0};
+  uint32_t                                local_count = 0;
+  uint32_t                                zero_bit = 0;
+  uint32_t                                byte_length = 0;
+
+  DevAssert (schedule != NULL);
+  DevAssert (stream_cipher != NULL);
+  DevAssert (stream_cipher->key_length == sizeof (schedule->key));
+  DevAssert (out != NULL);
+  zero_bit = stream_cipher->blength & 0x7;
+  byte_length = stream_cipher->blength >> 3;
+
+  if (zero_bit > 0)
+    byte_length += 1;
+
+  nas_stream_key_schedule_update (schedule, stream_cipher->key);
+  local_count = hton_int32 (stream_cipher->count);
+  memcpy (&m[0], &local_count, 4);
+  m[4] = ((stream_cipher->bearer & 0x1F) << 3) | ((stream_cipher->direction & 0x01) << 2);
+  /*
+   * Other bits are 0, nettle CTR mode handles out == message
+   */
+  nettle_ctr_crypt (&schedule->aes, nettle_aes128.encrypt, nettle_aes128.block_size, m, byte_length, out, stream_cipher->message);
+
+  if (zero_bit > 0)
+    out[byte_length - 1] = out[byte_length - 1] & (uint8_t) (0xFF << (8 - zero_bit));
+
+  return 0;
+}
@@ -24,7 +24,6 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
-#include <math.h>               // double ceil(double x);
 
 #include "secu_defs.h"
 
@@ -32,13 +31,13 @@
 #include "conversions.h"
 #include "snow3g.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <wmmintrin.h>
+#endif
+
 uint64_t                                MUL64x (
   uint64_t V,
   uint64_t c);
-uint64_t                                MUL64xPOW (
-  uint64_t V,
-  uint32_t i,
-  uint64_t c);
 uint64_t                                MUL64 (
   uint64_t V,
   uint64_t P,
@@ -69,27 +68,6 @@ MUL64x (
     return V << 1;
 }
 
-/* MUL64xPOW.
-   Input V: a 64-bit input.
-   Input i: a positive integer.
-   Input c: a 64-bit input.
-   Output : a 64-bit output.
-   A 64-bit memory is allocated which is to be free_wrapperd by the calling
-  function.
-   See section 4.3.3 for details.
-*/
-uint64_t
-MUL64xPOW (
-  uint64_t V,
-  uint32_t i,
-  uint64_t c)
-{
-  if (i == 0)
-    return V;
-  else
-    return MUL64x (MUL64xPOW (V, i - 1, c), c);
-}
-
 /* MUL64.
    Input V: a 64-bit input.
    Input P: a 64-bit input.
@@ -108,34 +86,74 @@ MUL64 (
   uint64_t                                result = 0;
   int                                     i = 0;
 
-  for (i = 0; i < 64; i++) {
-    if ((P >> i) & 0x1)
-      result ^= MUL64xPOW (V, i, c);
+  /*
+   * Horner evaluation of sum(P_i * V * x^i): one MUL64x per bit of P
+   * instead of MUL64xPOW(V, i, c) for every bit set.
+   */
+  for (i = 63; i >= 0; i--) {
+    result = MUL64x (result, c);
+    result ^= V & (0 - ((P >> i) & 0x1));
   }
 
   return result;
 }
 
-/* mask32bit.
-  Input n: an integer in 1-32.
-  Output : a 32 bit mask.
-  Prepares a 32 bit mask with required number of 1 bits on the MSB side.
+#if defined(__GNUC__) && defined(__x86_64__)
+/* MUL64 with c = 0x1b (x^64 + x^4 + x^3 + x + 1) using the carry-less
+   multiply instruction, the 128 bit product is folded twice.
 */
-uint32_t
-mask32bit (
-  int n)
+__attribute__ ((target ("pclmul,sse2")))
+static uint64_t
+MUL64_clmul (
+  uint64_t V,
+  uint64_t P)
 {
-  uint32_t                                mask = 0x0;
-
-  if (n % 32 == 0)
-    return 0xffffffff;
+  const __m128i                           c = _mm_set_epi64x (0, 0x1b);
+  __m128i                                 product = _mm_clmulepi64_si128 (_mm_set_epi64x (0, V), _mm_set_epi64x (0, P), 0x00);
+  uint64_t                                lo = (uint64_t) _mm_cvtsi128_si64 (product);
+  uint64_t                                hi = (uint64_t) _mm_cvtsi128_si64 (_mm_unpackhi_epi64 (product, product));
 
-  while (n--)
-    mask = (mask >> 1) ^ 0x80000000;
+  product = _mm_clmulepi64_si128 (_mm_set_epi64x (0, hi), c, 0x00);
+  lo ^= (uint64_t) _mm_cvtsi128_si64 (product);
+  hi = (uint64_t) _mm_cvtsi128_si64 (_mm_unpackhi_epi64 (product, product));    /* at most 4 bits */
+  return lo ^ (hi << 4) ^ (hi << 3) ^ (hi << 1) ^ hi;
+}
+#endif
 
-  return mask;
+/* Multiplication in GF(2^64) of the UIA2 evaluation, carry-less multiply
+   when the CPU has it, portable MUL64 otherwise.
+*/
+static uint64_t
+nas_stream_eia1_mul64 (
+  uint64_t V,
+  uint64_t P,
+  bool clmul)
+{
+#if defined(__GNUC__) && defined(__x86_64__)
+  if (clmul)
+    return MUL64_clmul (V, P);
+#endif
+  return MUL64 (V, P, 0x1b);
 }
 
+/* Load up to 8 message bytes as a big endian 64-bit block, zero padded.
+*/
+static uint64_t
+nas_stream_eia1_load64 (
+  const uint8_t * const message,
+  uint32_t nb_bytes)
+{
+  uint64_t                                block = 0;
+  uint32_t                                i = 0;
+
+  for (i = 0; i < 8; i++) {
+    block <<= 8;
+    if (i < nb_bytes)
+      block |= message[i];
+  }
+
+  return block;
+}
 
 /*!
    @brief Create integrity cmac t for a given message.
@@ -151,20 +169,20 @@ nas_stream_encrypt_eia1 (
   uint32_t                                K[4],
                                           IV[4],
                                           z[5];
-  int                                     i = 0,
+  uint32_t                                i = 0,
     D;
   uint32_t                                MAC_I = 0;
+  uint32_t                                byte_length = 0;
+  uint32_t                                rem_bits = 0;
   uint64_t                                EVAL;
-  uint64_t                                V;
   uint64_t                                P;
   uint64_t                                Q;
-  uint64_t                                c;
-  uint64_t                                M_D_2;
-  int                                     rem_bits;
-  uint32_t                                mask = 0;
-  uint32_t                               *message;
+  uint64_t                                M_i;
+  bool                                    clmul = false;
 
-  message = (uint32_t *) stream_cipher->message;        /* To operate 32 bit message internally. */
+  DevAssert (stream_cipher != NULL);
+  DevAssert (stream_cipher->key != NULL);
+  DevAssert (out != NULL);
   /*
    * Load the Integrity Key for SNOW3G initialization as in section 4.4.
    */
@@ -188,68 +206,41 @@ nas_stream_encrypt_eia1 (
   IV[2] = ((((uint32_t) stream_cipher->bearer) & 0x0000001F) << 27);
   IV[1] = (uint32_t) (stream_cipher->count) ^ ((uint32_t) (stream_cipher->direction) << 31);
   IV[0] = ((((uint32_t) stream_cipher->bearer) & 0x0000001F) << 27) ^ ((uint32_t) (stream_cipher->direction & 0x00000001) << 15);
-  //printf ("K:\n");
-  //hexprint(K, 16);
-  //printf ("K[0]:%08X\n",K[0]);
-  //printf ("K[1]:%08X\n",K[1]);
-  //printf ("K[2]:%08X\n",K[2]);
-  //printf ("K[3]:%08X\n",K[3]);
-  //printf ("IV:\n");
-  //hexprint(IV, 16);
-  //printf ("IV[0]:%08X\n",IV[0]);
-  //printf ("IV[1]:%08X\n",IV[1]);
-  //printf ("IV[2]:%08X\n",IV[2]);
-  //printf ("IV[3]:%08X\n",IV[3]);
   z[0] = z[1] = z[2] = z[3] = z[4] = 0;
   /*
    * Run SNOW 3G to produce 5 keystream words z_1, z_2, z_3, z_4 and z_5.
    */
   snow3g_initialize (K, IV, &snow_3g_context);
   snow3g_generate_key_stream (5, z, &snow_3g_context);
-  //printf ("z[0]:%08X\n",z[0]);
-  //printf ("z[1]:%08X\n",z[1]);
-  //printf ("z[2]:%08X\n",z[2]);
-  //printf ("z[3]:%08X\n",z[3]);
-  //printf ("z[4]:%08X\n",z[4]);
   P = ((uint64_t) z[0] << 32) | (uint64_t) z[1];
   Q = ((uint64_t) z[2] << 32) | (uint64_t) z[3];
-  //printf ("P:%16lX\n",P);
-  //printf ("Q:%16lX\n",Q);
+#if defined(__GNUC__) && defined(__x86_64__)
+  clmul = __builtin_cpu_supports ("pclmul");
+#endif
   /*
-   * Calculation
+   * Calculation, the message is read 64 bits at a time, the last block
+   * M_D-2 is zero padded after the last message bit.
    */
-  D = ceil (stream_cipher->blength / 64.0) + 1;
-  //printf ("D:%d\n",D);
+  D = ((stream_cipher->blength + 63) >> 6) + 1;
+  byte_length = (stream_cipher->blength + 7) >> 3;
   EVAL = 0;
-  c = 0x1b;
-
-  /*
-   * for 0 <= i <= D-3
-   */
-  for (i = 0; i < D - 2; i++) {
-    V = EVAL ^ ((uint64_t) hton_int32 (message[2 * i]) << 32 | (uint64_t) hton_int32 (message[2 * i + 1]));
-    EVAL = MUL64 (V, P, c);
-    //printf ("Mi: %16X %16X\tEVAL: %16lX\n",hton_int32(message[2*i]),hton_int32(message[2*i+1]), EVAL);
-  }
 
   /*
-   * for D-2
+   * for 0 <= i <= D-2
    */
-  rem_bits = stream_cipher->blength % 64;
+  for (i = 0; i + 2 <= D; i++) {
+    M_i = nas_stream_eia1_load64 (&stream_cipher->message[8 * i], (byte_length - 8 * i) < 8 ? (byte_length - 8 * i) : 8);
 
-  if (rem_bits == 0)
-    rem_bits = 64;
+    if (i == D - 2) {
+      rem_bits = stream_cipher->blength - 64 * i;
 
-  mask = mask32bit (rem_bits % 32);
+      if (rem_bits < 64)
+        M_i &= ~(((uint64_t) 0xffffffffffffffff) >> rem_bits);
+    }
 
-  if (rem_bits > 32) {
-    M_D_2 = ((uint64_t) hton_int32 (message[2 * (D - 2)]) << 32) | (uint64_t) (hton_int32 (message[2 * (D - 2) + 1]) & mask);
-  } else {
-    M_D_2 = ((uint64_t) hton_int32 (message[2 * (D - 2)]) & mask) << 32;
+    EVAL = nas_stream_eia1_mul64 (EVAL ^ M_i, P, clmul);
   }
 
-  V = EVAL ^ M_D_2;
-  EVAL = MUL64 (V, P, c);
   /*
    * for D-1
    */
@@ -257,9 +248,8 @@ nas_stream_encrypt_eia1 (
   /*
    * Multiply by Q
    */
-  EVAL = MUL64 (EVAL, Q, c);
+  EVAL = nas_stream_eia1_mul64 (EVAL, Q, clmul);
   MAC_I = (uint32_t) (EVAL >> 32) ^ z[4];
-  //printf ("MAC_I:%16X\n",MAC_I);
   MAC_I = hton_int32 (MAC_I);
   memcpy ((void *)out, &MAC_I, 4);
   return 0;
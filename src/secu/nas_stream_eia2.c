@@ -25,6 +25,7 @@
 #include <stdbool.h>
 #include <string.h>
 
+#include <nettle/nettle-meta.h>
 #include "secu_defs.h"
 
 #include <openssl/aes.h>
@@ -93,3 +94,79 @@ nas_stream_encrypt_eia2 (
   free_wrapper ((void**)&m);
   return 0;
 }
+
+/*!
+   @brief Same MAC as nas_stream_encrypt_eia2() from the cached key schedule,
+          AES-CMAC (RFC 4493) is computed block by block without copying the message.
+   @param[in] schedule Key schedule of stream_cipher->key, (re)expanded if needed
+   @param[in] stream_cipher Structure containing various variables to setup encoding
+   @param[out] out For EIA2 the output string is 32 bits long
+*/
+int
+nas_stream_encrypt_eia2_cached (
+  nas_stream_key_schedule_t * const schedule,
+  nas_stream_cipher_t * const stream_cipher,
+  uint8_t out[4])
+{
+  uint8_t                                 header[8] = {0};
+  uint8_t                                 block[16] = {0};
+  uint8_t                                 x[16] = {0};
+  uint32_t                                local_count = 0;
+  uint32_t                                m_length = 0;
+  uint32_t                                total_length = 0;
+  uint32_t                                nb_blocks = 0;
+  uint32_t                                offset = 0;
+  uint32_t                                length = 0;
+  uint32_t                                i = 0;
+  uint32_t                                j = 0;
+
+  DevAssert (schedule != NULL);
+  DevAssert (stream_cipher != NULL);
+  DevAssert (stream_cipher->key != NULL);
+  DevAssert (stream_cipher->key_length == sizeof (schedule->key));
+  DevAssert (out != NULL);
+  m_length = stream_cipher->blength >> 3;
+
+  if (stream_cipher->blength & 0x7)
+    m_length += 1;
+
+  nas_stream_key_schedule_update (schedule, stream_cipher->key);
+  local_count = hton_int32 (stream_cipher->count);
+  memcpy (&header[0], &local_count, 4);
+  header[4] = ((stream_cipher->bearer & 0x1F) << 3) | ((stream_cipher->direction & 0x01) << 2);
+
+  // M = COUNT | BEARER | DIRECTION | 0^26 | MESSAGE, never empty
+  total_length = m_length + sizeof (header);
+  nb_blocks = (total_length + 15) >> 4;
+
+  for (i = 0; i < nb_blocks; i++) {
+    offset = i << 4;
+    length = ((total_length - offset) < 16) ? (total_length - offset) : 16;
+
+    if (i == 0) {
+      memcpy (&block[0], header, sizeof (header));
+      memcpy (&block[8], stream_cipher->message, length - sizeof (header));
+    } else {
+      memcpy (&block[0], &stream_cipher->message[offset - sizeof (header)], length);
+    }
+
+    if (i == nb_blocks - 1) {
+      if (length == 16) {
+        for (j = 0; j < 16; j++)
+          block[j] ^= schedule->k1[j];
+      } else {
+        block[length] = 0x80;
+        memset (&block[length + 1], 0, 15 - length);
+        for (j = 0; j < 16; j++)
+          block[j] ^= schedule->k2[j];
+      }
+    }
+
+    for (j = 0; j < 16; j++)
+      x[j] ^= block[j];
+    nettle_aes128.encrypt (&schedule->aes, sizeof (x), x, x);
+  }
+
+  memcpy (out, x, 4);
+  return 0;
+}
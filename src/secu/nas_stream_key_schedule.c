@@ -0,0 +1,73 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <nettle/nettle-meta.h>
+#include <nettle/aes.h>
+#include "assertions.h"
+#include "secu_defs.h"
+
+//------------------------------------------------------------------------------
+// CMAC subkey generation: left shift by one bit, xor Rb if the MSB was set
+static void nas_stream_cmac_double (const uint8_t in[16], uint8_t out[16])
+{
+  const uint8_t                           msb = in[0] & 0x80;
+  int                                     i = 0;
+
+  for (i = 0; i < 15; i++) {
+    out[i] = (uint8_t)((in[i] << 1) | (in[i + 1] >> 7));
+  }
+  out[15] = (uint8_t)(in[15] << 1);
+  if (msb) {
+    out[15] ^= 0x87;
+  }
+}
+
+//------------------------------------------------------------------------------
+void nas_stream_key_schedule_update (
+  nas_stream_key_schedule_t * const schedule,
+  const uint8_t * const key)
+{
+  uint8_t                                 l[16] = {0};
+
+  DevAssert (schedule != NULL);
+  DevAssert (key != NULL);
+
+  if ((schedule->expanded) && (0 == memcmp (schedule->key, key, sizeof (schedule->key)))) {
+    return;
+  }
+  memcpy (schedule->key, key, sizeof (schedule->key));
+#if NETTLE_VERSION_MAJOR < 3
+  nettle_aes128.set_encrypt_key (&schedule->aes, sizeof (schedule->key), schedule->key);
+#else
+  nettle_aes128.set_encrypt_key (&schedule->aes, schedule->key);
+#endif
+  // L = AES-128(K, 0^128), K1 = dbl(L), K2 = dbl(K1)
+  nettle_aes128.encrypt (&schedule->aes, sizeof (l), l, l);
+  nas_stream_cmac_double (l, schedule->k1);
+  nas_stream_cmac_double (schedule->k1, schedule->k2);
+  memset (l, 0, sizeof (l));
+  schedule->expanded = true;
+}
@@ -22,6 +22,9 @@
 #ifndef FILE_SECU_DEFS_SEEN
 #define FILE_SECU_DEFS_SEEN
 
+#include <stdbool.h>
+#include <nettle/aes.h>
+
 #include "security_types.h"
 
 
@@ -72,6 +75,25 @@ typedef struct {
   uint32_t  blength;
 } nas_stream_cipher_t;
 
+/* AES-128 key schedule of a NAS key (K_NASenc for EEA2, K_NASint for EIA2),
+ * expanded once and kept with the EPS NAS security context. It holds no
+ * pointer so that security contexts can still be copied or memset.
+ */
+typedef struct nas_stream_key_schedule_s {
+  uint8_t  key[16];          /* key the schedule was expanded from      */
+  bool     expanded;         /* false after memset: expand on first use */
+#if NETTLE_VERSION_MAJOR < 3
+  struct aes_ctx    aes;
+#else
+  struct aes128_ctx aes;
+#endif
+  uint8_t  k1[16];           /* CMAC subkeys, RFC 4493 section 2.3      */
+  uint8_t  k2[16];
+} nas_stream_key_schedule_t;
+
+/* Expand the schedule for key, nothing is done if it is already expanded for this key */
+void nas_stream_key_schedule_update(nas_stream_key_schedule_t * const schedule, const uint8_t * const key);
+
 int nas_stream_encrypt_eea1(nas_stream_cipher_t * const stream_cipher, uint8_t * const out);
 
 int nas_stream_encrypt_eia1(nas_stream_cipher_t * const stream_cipher, uint8_t const out[4]);
@@ -80,6 +102,14 @@ int nas_stream_encrypt_eea2(nas_stream_cipher_t * const stream_cipher, uint8_t *
 
 int nas_stream_encrypt_eia2(nas_stream_cipher_t * const stream_cipher, uint8_t const out[4]);
 
+/* Allocation free EEA2/EIA2, stream_cipher->key selects (and if needed
+ * re-expands) the cached schedule. out may be stream_cipher->message for
+ * EEA2 but must not partially overlap it.
+ */
+int nas_stream_encrypt_eea2_cached(nas_stream_key_schedule_t * const schedule, nas_stream_cipher_t * const stream_cipher, uint8_t * const out);
+
+int nas_stream_encrypt_eia2_cached(nas_stream_key_schedule_t * const schedule, nas_stream_cipher_t * const stream_cipher, uint8_t out[4]);
+
 #undef SECU_DEBUG
 
 #endif /* FILE_SECU_DEFS_SEEN */
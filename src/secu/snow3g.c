@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "rijndael.h"
 #include "snow3g.h"
@@ -42,6 +43,8 @@ static uint32_t                         _S1 (
   uint32_t w);
 static uint32_t                         _S2 (
   uint32_t w);
+static void                             _snow3g_init_tables (
+  void);
 static void                             _snow3g_clock_LFSR_initialization_mode (
   uint32_t F,
   snow_3g_context_t * s3g_ctx_pP);
@@ -59,6 +62,18 @@ void                                    snow3g_generate_key_stream (
   snow_3g_context_t * snow_3g_context_pP);
 
 
+/* Word oriented tables, filled once from the byte oriented definitions below:
+   MULalpha and DIValpha of the LFSR feedback, and the first column of the S1
+   and S2 MixColumn like S-Boxes, the other columns are byte rotations of it.
+*/
+static pthread_once_t                   _snow3g_tables_once = PTHREAD_ONCE_INIT;
+static uint32_t                         _snow3g_mul_alpha[256];
+static uint32_t                         _snow3g_div_alpha[256];
+static uint32_t                         _snow3g_s1_t0[256];
+static uint32_t                         _snow3g_s2_t0[256];
+
+#define SNOW3G_ROR32(wORD, bITS)        (((wORD) >> (bITS)) | ((wORD) << (32 - (bITS))))
+
 /* _MULx.
   Input V: an 8-bit input.
   Input c: an 8-bit input.
@@ -131,62 +146,55 @@ _DIValpha (
   The S-Box S1 maps a 32-bit input to a 32-bit output.
   w = w0 || w1 || w2 || w3 the 32-bit input with w0 the most and w3 the least significant byte.
   S1(w)= r0 || r1 || r2 || r3 with r0 the most and r3 the least significant byte.
+  r0 = MULx(SR(w0)) ^ SR(w1) ^ SR(w2) ^ MULx(SR(w3)) ^ SR(w3), the contribution
+  of w1, w2, w3 is the contribution of w0 rotated by 8, 16, 24 bits.
 */
 
 static                                  uint32_t
 _S1 (
   uint32_t w)
 {
-  uint8_t                                 r0 = 0,
-    r1 = 0,
-    r2 = 0,
-    r3 = 0;
-  uint8_t                                 srw0 = SR[(uint8_t) ((w >> 24) & 0xff)];
-  uint8_t                                 srw1 = SR[(uint8_t) ((w >> 16) & 0xff)];
-  uint8_t                                 srw2 = SR[(uint8_t) ((w >> 8) & 0xff)];
-  uint8_t                                 srw3 = SR[(uint8_t) ((w) & 0xff)];
-
-  r0 = ((_MULx (srw0, 0x1b)) ^ (srw1) ^ (srw2) ^ ((_MULx (srw3, 0x1b)) ^ srw3)
-    );
-  r1 = (((_MULx (srw0, 0x1b)) ^ srw0) ^ (_MULx (srw1, 0x1b)) ^ (srw2) ^ (srw3)
-    );
-  r2 = ((srw0) ^ ((_MULx (srw1, 0x1b)) ^ srw1) ^ (_MULx (srw2, 0x1b)) ^ (srw3)
-    );
-  r3 = ((srw0) ^ (srw1) ^ ((_MULx (srw2, 0x1b)) ^ srw2) ^ (_MULx (srw3, 0x1b))
-    );
-  return ((((uint32_t) r0) << 24) | (((uint32_t) r1) << 16) | (((uint32_t) r2) << 8) | (((uint32_t) r3)));
+  return _snow3g_s1_t0[(w >> 24) & 0xff] ^
+         SNOW3G_ROR32 (_snow3g_s1_t0[(w >> 16) & 0xff], 8) ^
+         SNOW3G_ROR32 (_snow3g_s1_t0[(w >> 8) & 0xff], 16) ^
+         SNOW3G_ROR32 (_snow3g_s1_t0[w & 0xff], 24);
 }
 
 /* The 32x32-bit S-Box S2
   Input: a 32-bit input.
   Output: a 32-bit output of S2 box.
-  The S-Box S2 maps a 32-bit input to a 32-bit output.
-  Let w = w0 || w1 || w2 || w3 the 32-bit input with w0 the most and w3 the least significant byte.
-  Let S2(w)= r0 || r1 || r2 || r3 with r0 the most and r3 the least significant byte.
+  Same as S1 with the S-box SQ and the polynomial 0x69.
 */
 
 static                                  uint32_t
 _S2 (
   uint32_t w)
 {
-  uint8_t                                 r0 = 0,
-    r1 = 0,
-    r2 = 0,
-    r3 = 0;
-  uint8_t                                 sqw0 = SQ[(uint8_t) ((w >> 24) & 0xff)];
-  uint8_t                                 sqw1 = SQ[(uint8_t) ((w >> 16) & 0xff)];
-  uint8_t                                 sqw2 = SQ[(uint8_t) ((w >> 8) & 0xff)];
-  uint8_t                                 sqw3 = SQ[(uint8_t) ((w) & 0xff)];
-
-  r0 = ((_MULx (sqw0, 0x69)) ^ (sqw1) ^ (sqw2) ^ ((_MULx (sqw3, 0x69)) ^ sqw3)
-    );
-  r1 = (((_MULx (sqw0, 0x69)) ^ sqw0) ^ (_MULx (sqw1, 0x69)) ^ (sqw2) ^ (sqw3)
-    );
-  r2 = ((sqw0) ^ ((_MULx (sqw1, 0x69)) ^ sqw1) ^ (_MULx (sqw2, 0x69)) ^ (sqw3)
-    );
-  r3 = ((sqw0) ^ (sqw1) ^ ((_MULx (sqw2, 0x69)) ^ sqw2) ^ (_MULx (sqw3, 0x69))
-    );
-  return ((((uint32_t) r0) << 24) | (((uint32_t) r1) << 16) | (((uint32_t) r2) << 8) | (((uint32_t) r3)));
+  return _snow3g_s2_t0[(w >> 24) & 0xff] ^
+         SNOW3G_ROR32 (_snow3g_s2_t0[(w >> 16) & 0xff], 8) ^
+         SNOW3G_ROR32 (_snow3g_s2_t0[(w >> 8) & 0xff], 16) ^
+         SNOW3G_ROR32 (_snow3g_s2_t0[w & 0xff], 24);
+}
+
+/* Fill the word oriented tables.
+*/
+
+static void
+_snow3g_init_tables (
+  void)
+{
+  uint32_t                                i = 0;
+  uint8_t                                 sr = 0;
+  uint8_t                                 sq = 0;
+
+  for (i = 0; i < 256; i++) {
+    _snow3g_mul_alpha[i] = _MULalpha ((uint8_t) i);
+    _snow3g_div_alpha[i] = _DIValpha ((uint8_t) i);
+    sr = SR[i];
+    sq = SQ[i];
+    _snow3g_s1_t0[i] = (((uint32_t) _MULx (sr, 0x1b)) << 24) | (((uint32_t) (_MULx (sr, 0x1b) ^ sr)) << 16) | (((uint32_t) sr) << 8) | ((uint32_t) sr);
+    _snow3g_s2_t0[i] = (((uint32_t) _MULx (sq, 0x69)) << 24) | (((uint32_t) (_MULx (sq, 0x69) ^ sq)) << 16) | (((uint32_t) sq) << 8) | ((uint32_t) sq);
+  }
 }
 
 /* Clocking LFSR in initialization mode.
@@ -201,7 +209,7 @@ _snow3g_clock_LFSR_initialization_mode (
   snow_3g_context_t * s3g_ctx_pP)
 {
   uint32_t                                v = (((s3g_ctx_pP->LFSR_S0 << 8) & 0xffffff00) ^
-                                               (_MULalpha ((uint8_t) ((s3g_ctx_pP->LFSR_S0 >> 24) & 0xff))) ^ (s3g_ctx_pP->LFSR_S2) ^ ((s3g_ctx_pP->LFSR_S11 >> 8) & 0x00ffffff) ^ (_DIValpha ((uint8_t) ((s3g_ctx_pP->LFSR_S11) & 0xff))) ^ (F)
+                                               (_snow3g_mul_alpha[(s3g_ctx_pP->LFSR_S0 >> 24) & 0xff]) ^ (s3g_ctx_pP->LFSR_S2) ^ ((s3g_ctx_pP->LFSR_S11 >> 8) & 0x00ffffff) ^ (_snow3g_div_alpha[s3g_ctx_pP->LFSR_S11 & 0xff]) ^ (F)
     );
 
   s3g_ctx_pP->LFSR_S0 = s3g_ctx_pP->LFSR_S1;
@@ -231,8 +239,8 @@ _snow3g_clock_LFSR_key_stream_mode (
   snow_3g_context_t * snow_3g_context_pP)
 {
   uint32_t                                v = (((snow_3g_context_pP->LFSR_S0 << 8) & 0xffffff00) ^
-                                               (_MULalpha ((uint8_t) ((snow_3g_context_pP->LFSR_S0 >> 24) & 0xff))) ^
-                                               (snow_3g_context_pP->LFSR_S2) ^ ((snow_3g_context_pP->LFSR_S11 >> 8) & 0x00ffffff) ^ (_DIValpha ((uint8_t) ((snow_3g_context_pP->LFSR_S11) & 0xff)))
+                                               (_snow3g_mul_alpha[(snow_3g_context_pP->LFSR_S0 >> 24) & 0xff]) ^
+                                               (snow_3g_context_pP->LFSR_S2) ^ ((snow_3g_context_pP->LFSR_S11 >> 8) & 0x00ffffff) ^ (_snow3g_div_alpha[snow_3g_context_pP->LFSR_S11 & 0xff])
     );
 
   snow_3g_context_pP->LFSR_S0 = snow_3g_context_pP->LFSR_S1;
@@ -288,6 +296,7 @@ snow3g_initialize (
   uint8_t                                 i = 0;
   uint32_t                                F = 0x0;
 
+  pthread_once (&_snow3g_tables_once, _snow3g_init_tables);
   snow_3g_context_pP->LFSR_S15 = k[3] ^ IV[0];
   snow_3g_context_pP->LFSR_S14 = k[2];
   snow_3g_context_pP->LFSR_S13 = k[1];
@@ -343,3 +352,43 @@ snow3g_generate_key_stream (
     _snow3g_clock_LFSR_key_stream_mode (snow_3g_context_pP);    /* STEP 3 */
   }
 }
+
+/*  Generation of Keystream xored with a byte stream.
+    input in: length bytes to cipher.
+    output out: in xor keystream, may be in.
+    The keystream words are consumed most significant byte first, as the
+    bit stream of section 4.2, no keystream buffer is needed.
+*/
+
+void
+snow3g_xor_key_stream (
+  const uint8_t * const in,
+  uint8_t * const out,
+  uint32_t length,
+  snow_3g_context_t * snow_3g_context_pP)
+{
+  uint32_t                                offset = 0;
+  uint32_t                                z = 0;
+  uint32_t                                F = 0x0;
+  uint32_t                                i = 0;
+
+  _snow3g_clock_fsm (snow_3g_context_pP);       /* Clock FSM once. Discard the output. */
+  _snow3g_clock_LFSR_key_stream_mode (snow_3g_context_pP);      /* Clock LFSR in keystream mode once. */
+
+  for (offset = 0; offset < length; offset += 4) {
+    F = _snow3g_clock_fsm (snow_3g_context_pP);
+    z = F ^ snow_3g_context_pP->LFSR_S0;
+    _snow3g_clock_LFSR_key_stream_mode (snow_3g_context_pP);
+
+    if (length - offset >= 4) {
+      out[offset] = in[offset] ^ (uint8_t) (z >> 24);
+      out[offset + 1] = in[offset + 1] ^ (uint8_t) (z >> 16);
+      out[offset + 2] = in[offset + 2] ^ (uint8_t) (z >> 8);
+      out[offset + 3] = in[offset + 3] ^ (uint8_t) z;
+    } else {
+      for (i = 0; i < length - offset; i++) {
+        out[offset + i] = in[offset + i] ^ (uint8_t) (z >> (24 - 8 * i));
+      }
+    }
+  }
+}
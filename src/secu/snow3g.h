@@ -74,4 +74,10 @@ void snow3g_initialize(uint32_t k[4], uint32_t IV[4], snow_3g_context_t *snow_3g
 
 void snow3g_generate_key_stream(uint32_t n, uint32_t *z, snow_3g_context_t *snow_3g_context_pP);
 
+/* Generation of Keystream xored with a byte stream.
+* input in: length bytes to cipher or decipher.
+* output out: in xor keystream, out may be in, no keystream buffer is allocated.
+*/
+void snow3g_xor_key_stream(const uint8_t * const in, uint8_t * const out, uint32_t length, snow_3g_context_t *snow_3g_context_pP);
+
 #endif
@@ -0,0 +1,278 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * UE index hash table micro benchmark: inserts nb_keys IMSI like keys, looks
+ * them all up (hits and misses) and removes them, with the chained
+ * hashtable_uint64_ts_* table (sized for max_ues) and with the open
+ * addressing hashtable_uint64_oa_ts_* table (started small, so that the
+ * incremental resizing is part of the measure). Contents are cross checked.
+ * Then reader threads look up keys that stay in the tables while the main
+ * thread inserts and removes other keys (growing and shrinking the open
+ * addressing table), readers of the open addressing table take no lock.
+ *
+ * usage: hashtable_benchmark [nb_keys] [max_ues] [nb_readers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "hashtable.h"
+
+#define HASHTABLE_BENCHMARK_NB_KEYS     (1000 * 1000)
+#define HASHTABLE_BENCHMARK_MAX_UES     (16 * 1024)
+#define HASHTABLE_BENCHMARK_NB_READERS  4
+#define HASHTABLE_BENCHMARK_MAX_READERS 64
+
+typedef struct hashtable_benchmark_reader_s {
+  pthread_t                               thread;
+  hash_table_uint64_ts_t                 *chained;
+  hash_table_uint64_oa_ts_t              *oa;
+  uint64_t                                nb_keys;
+  uint64_t                                nb_lookups;
+  uint64_t                                nb_errors;
+} hashtable_benchmark_reader_t;
+
+static volatile bool                    readers_stop = false;
+
+//------------------------------------------------------------------------------
+static double hashtable_benchmark_elapsed (struct timespec *start_time)
+{
+  struct timespec                         end_time;
+
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  return (double)(end_time.tv_sec - start_time->tv_sec) + (double)(end_time.tv_nsec - start_time->tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+static inline hash_key_t hashtable_benchmark_key (uint64_t i)
+{
+  // IMSI like keys: MCC MNC prefix and sequential MSIN
+  return 208930000000000ULL + i;
+}
+
+//------------------------------------------------------------------------------
+static void hashtable_benchmark_report (const char *name, const char *op, uint64_t nb_ops, double elapsed)
+{
+  fprintf (stdout, "%-8s %-8s %8" PRIu64 " ops in %.3f s, %6.1f ns/op\n", name, op, nb_ops, elapsed, elapsed * 1e9 / (double)nb_ops);
+}
+
+//------------------------------------------------------------------------------
+static void *hashtable_benchmark_reader (void *args_p)
+{
+  hashtable_benchmark_reader_t           *reader = (hashtable_benchmark_reader_t *)args_p;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  uint64_t                                data = 0;
+  uint64_t                                i = 1;
+
+  while (!readers_stop) {
+    // odd keys are never removed while readers run
+    if (reader->oa) {
+      rc = hashtable_uint64_oa_ts_get (reader->oa, hashtable_benchmark_key (i), &data);
+    } else {
+      rc = hashtable_uint64_ts_get (reader->chained, hashtable_benchmark_key (i), &data);
+    }
+
+    if ((rc != HASH_TABLE_OK) || (data != i)) {
+      reader->nb_errors++;
+    }
+    reader->nb_lookups++;
+    i += 2;
+
+    if (i >= reader->nb_keys) {
+      i = 1;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Tables must hold the odd keys, even keys are inserted then removed while readers run.
+*/
+static uint64_t hashtable_benchmark_concurrent (const char *name, hash_table_uint64_ts_t *chained, hash_table_uint64_oa_ts_t *oa,
+    uint64_t nb_keys, int nb_readers)
+{
+  hashtable_benchmark_reader_t            readers[HASHTABLE_BENCHMARK_MAX_READERS] = {{0}};
+  struct timespec                         start_time;
+  uint64_t                                nb_lookups = 0;
+  uint64_t                                nb_updates = 0;
+  uint64_t                                nb_errors = 0;
+  uint64_t                                i = 0;
+  double                                  elapsed = 0;
+  int                                     r = 0;
+
+  readers_stop = false;
+
+  for (r = 0; r < nb_readers; r++) {
+    readers[r].chained = chained;
+    readers[r].oa = oa;
+    readers[r].nb_keys = nb_keys;
+    pthread_create (&readers[r].thread, NULL, hashtable_benchmark_reader, &readers[r]);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_keys; i += 2) {
+    if (oa) {
+      hashtable_uint64_oa_ts_insert (oa, hashtable_benchmark_key (i), i);
+    } else {
+      hashtable_uint64_ts_insert (chained, hashtable_benchmark_key (i), i);
+    }
+    nb_updates++;
+  }
+  for (i = 0; i < nb_keys; i += 2) {
+    if (oa) {
+      hashtable_uint64_oa_ts_remove (oa, hashtable_benchmark_key (i));
+    } else {
+      hashtable_uint64_ts_remove (chained, hashtable_benchmark_key (i));
+    }
+    nb_updates++;
+  }
+  if (oa) {
+    hashtable_uint64_oa_ts_resize (oa, nb_keys / 2);
+  }
+  elapsed = hashtable_benchmark_elapsed (&start_time);
+  readers_stop = true;
+
+  for (r = 0; r < nb_readers; r++) {
+    pthread_join (readers[r].thread, NULL);
+    nb_lookups += readers[r].nb_lookups;
+    nb_errors += readers[r].nb_errors;
+  }
+  fprintf (stdout, "%-8s %d readers: %6.1f M lookups/s, writer %6.1f ns/update\n", name, nb_readers,
+      (double)nb_lookups / elapsed / 1e6, elapsed * 1e9 / (double)nb_updates);
+  return nb_errors;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  struct timespec                         start_time;
+  hash_table_uint64_ts_t                 *chained = NULL;
+  hash_table_uint64_oa_ts_t              *oa = NULL;
+  uint64_t                                nb_keys = HASHTABLE_BENCHMARK_NB_KEYS;
+  uint64_t                                max_ues = HASHTABLE_BENCHMARK_MAX_UES;
+  uint64_t                                data = 0;
+  uint64_t                                nb_errors = 0;
+  uint64_t                                i = 0;
+  int                                     nb_readers = HASHTABLE_BENCHMARK_NB_READERS;
+  bstring                                 b = NULL;
+
+  if (argc > 1) {
+    nb_keys = strtoull (argv[1], NULL, 0);
+
+    if (argc > 2) {
+      max_ues = strtoull (argv[2], NULL, 0);
+
+      if (argc > 3) {
+        nb_readers = atoi (argv[3]);
+      }
+    }
+  }
+
+  if ((nb_readers < 1) || (nb_readers > HASHTABLE_BENCHMARK_MAX_READERS)) {
+    fprintf (stderr, "nb_readers must be in [1..%d]\n", HASHTABLE_BENCHMARK_MAX_READERS);
+    return EXIT_FAILURE;
+  }
+
+  b = bfromcstr ("benchmark_chained_htbl");
+  chained = hashtable_uint64_ts_create (max_ues, NULL, b);
+  bassigncstr (b, "benchmark_oa_htbl");
+  oa = hashtable_uint64_oa_ts_create (max_ues, NULL, b);
+  bdestroy (b);
+
+  /*
+   * Chained table
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_keys; i++) {
+    hashtable_uint64_ts_insert (chained, hashtable_benchmark_key (i), i);
+  }
+  hashtable_benchmark_report ("chained", "insert", nb_keys, hashtable_benchmark_elapsed (&start_time));
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < 2 * nb_keys; i++) {
+    if ((hashtable_uint64_ts_get (chained, hashtable_benchmark_key (i), &data) == HASH_TABLE_OK) != (i < nb_keys)) {
+      nb_errors++;
+    }
+  }
+  hashtable_benchmark_report ("chained", "lookup", 2 * nb_keys, hashtable_benchmark_elapsed (&start_time));
+
+  /*
+   * Open addressing table
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_keys; i++) {
+    hashtable_uint64_oa_ts_insert (oa, hashtable_benchmark_key (i), i);
+  }
+  hashtable_benchmark_report ("oa", "insert", nb_keys, hashtable_benchmark_elapsed (&start_time));
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < 2 * nb_keys; i++) {
+    if ((hashtable_uint64_oa_ts_get (oa, hashtable_benchmark_key (i), &data) == HASH_TABLE_OK) != (i < nb_keys)) {
+      nb_errors++;
+    } else if ((i < nb_keys) && (data != i)) {
+      nb_errors++;
+    }
+  }
+  hashtable_benchmark_report ("oa", "lookup", 2 * nb_keys, hashtable_benchmark_elapsed (&start_time));
+
+  /*
+   * Removals, every other key first so that both tables keep live elements
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_keys; i += 2) {
+    hashtable_uint64_ts_remove (chained, hashtable_benchmark_key (i));
+  }
+  hashtable_benchmark_report ("chained", "remove", nb_keys / 2, hashtable_benchmark_elapsed (&start_time));
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_keys; i += 2) {
+    if (hashtable_uint64_oa_ts_remove (oa, hashtable_benchmark_key (i)) != HASH_TABLE_OK) {
+      nb_errors++;
+    }
+  }
+  hashtable_benchmark_report ("oa", "remove", nb_keys / 2, hashtable_benchmark_elapsed (&start_time));
+
+  for (i = 0; i < nb_keys; i++) {
+    if ((hashtable_uint64_oa_ts_is_key_exists (oa, hashtable_benchmark_key (i)) == HASH_TABLE_OK) !=
+        (hashtable_uint64_ts_is_key_exists (chained, hashtable_benchmark_key (i)) == HASH_TABLE_OK)) {
+      nb_errors++;
+    }
+  }
+
+  /*
+   * Concurrent lookups, both tables now hold the odd keys
+   */
+  nb_errors += hashtable_benchmark_concurrent ("chained", chained, NULL, nb_keys, nb_readers);
+  nb_errors += hashtable_benchmark_concurrent ("oa", NULL, oa, nb_keys, nb_readers);
+
+  fprintf (stdout, "%" PRIu64 " errors\n", nb_errors);
+  hashtable_uint64_ts_destroy (chained);
+  hashtable_uint64_oa_ts_destroy (oa);
+  return (nb_errors) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * ITTI throughput micro benchmark: the main thread (acting as TASK_S1AP)
+ * floods TASK_MME_APP with MESSAGE_TEST messages, the receiving task
+ * either gets them one by one with itti_receive_msg() or in bursts with
+ * itti_receive_msgs().
+ *
+ * usage: itti_benchmark [nb_messages] [batch_size]
+ *   batch_size 0 means itti_receive_msg(), default 64.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sched.h>
+
+#include "intertask_interface_init.h"
+
+#define ITTI_BENCHMARK_NB_MESSAGES   (1 << 22)
+#define ITTI_BENCHMARK_MAX_BATCH     256
+
+static uint64_t                         nb_messages = ITTI_BENCHMARK_NB_MESSAGES;
+static int                              batch_size = 64;
+static volatile uint64_t                nb_received = 0;
+static volatile bool                    done = false;
+static struct timespec                  end_time;
+
+//------------------------------------------------------------------------------
+static void *itti_benchmark_rx_task (__attribute__ ((unused)) void *args_p)
+{
+  MessageDef                             *received_msgs[ITTI_BENCHMARK_MAX_BATCH];
+  int                                     nb_msgs = 0;
+  int                                     i = 0;
+
+  itti_mark_task_ready (TASK_MME_APP);
+
+  while (nb_received < nb_messages) {
+    if (batch_size) {
+      nb_msgs = itti_receive_msgs (TASK_MME_APP, received_msgs, batch_size);
+    } else {
+      itti_receive_msg (TASK_MME_APP, &received_msgs[0]);
+      nb_msgs = (received_msgs[0]) ? 1 : 0;
+    }
+
+    for (i = 0; i < nb_msgs; i++) {
+      itti_free (ITTI_MSG_ORIGIN_ID (received_msgs[i]), received_msgs[i]);
+    }
+    nb_received += nb_msgs;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  done = true;
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  struct timespec                         start_time;
+  MessageDef                             *message_p = NULL;
+  uint64_t                                nb_queue_full = 0;
+  uint64_t                                i = 0;
+  double                                  elapsed = 0;
+
+  if (argc > 1) {
+    nb_messages = strtoull (argv[1], NULL, 0);
+
+    if (argc > 2) {
+      batch_size = atoi (argv[2]);
+    }
+  }
+
+  if ((batch_size < 0) || (batch_size > ITTI_BENCHMARK_MAX_BATCH)) {
+    fprintf (stderr, "batch_size must be in [0..%d]\n", ITTI_BENCHMARK_MAX_BATCH);
+    return EXIT_FAILURE;
+  }
+
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+
+  if (itti_create_task (TASK_MME_APP, &itti_benchmark_rx_task, NULL) < 0) {
+    fprintf (stderr, "Failed to create receiving task\n");
+    return EXIT_FAILURE;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+
+  for (i = 0; i < nb_messages; i++) {
+    do {
+      message_p = itti_alloc_new_message (TASK_S1AP, MESSAGE_TEST);
+      if (itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p) == 0) {
+        break;
+      }
+      // destination queue full, message has been released by ITTI
+      nb_queue_full++;
+      sched_yield ();
+    } while (1);
+  }
+
+  while (!done) {
+    sched_yield ();
+  }
+
+  elapsed = (double)(end_time.tv_sec - start_time.tv_sec) + (double)(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+  fprintf (stdout, "ITTI batch %d: %" PRIu64 " messages in %.3f s, %.0f msgs/s, %" PRIu64 " queue full retries\n",
+      batch_size, (uint64_t)nb_received, elapsed, (double)nb_received / elapsed, nb_queue_full);
+  return EXIT_SUCCESS;
+}
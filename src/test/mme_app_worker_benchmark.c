@@ -0,0 +1,302 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * MME_APP worker scaling benchmark: synthetic attaches are replayed against
+ * MME_APP and NAS running with nb_workers MME_APP workers. The main thread
+ * plays the eNBs and sends one S1AP_INITIAL_UE_MESSAGE with an IMSI Attach
+ * Request per UE. TASK_S6A is a stub HSS answering every AIR with the same
+ * vector, TASK_S1AP is a stub UE answering the Authentication Request with
+ * the expected RES. An attach is counted when the Security Mode Command of
+ * the UE reaches TASK_S1AP: initial UE message, AIR/AIA, Authentication
+ * Request, uplink Authentication Response and Security Mode Command are
+ * handled by MME_APP and NAS for each UE.
+ *
+ * usage: mme_app_worker_benchmark mme.conf [nb_workers] [nb_ues]
+ *   for w in 1 2 4 8; do mme_app_worker_benchmark etc/mme.conf $w; done
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
+#include "dynamic_memory_check.h"
+#include "common_defs.h"
+#include "mme_config.h"
+#include "mme_app_extern.h"
+#include "nas_defs.h"
+
+#define MME_APP_WORKER_BENCHMARK_NB_UES        100000
+#define MME_APP_WORKER_BENCHMARK_NB_ENBS       16
+#define MME_APP_WORKER_BENCHMARK_WINDOW        256
+#define MME_APP_WORKER_BENCHMARK_MAX_BATCH     64
+
+/* Attach Request, IMSI 20893xxxxxxxxxx set per UE, EEA0/1/2 EIA1/2, PDN connectivity request */
+static const uint8_t                    attach_request[] = {
+  0x07, 0x41, 0x71, 0x08, 0x29, 0x80, 0x39, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x02, 0xE0, 0x60, 0x00, 0x04, 0x02, 0x01, 0xD0, 0x11
+};
+#define ATTACH_REQUEST_IMSI_OFFSET      4
+
+static const uint8_t                    res[] = { 0x2d, 0xaf, 0x87, 0x3d, 0x73, 0xf3, 0x10, 0xc6 };
+
+static volatile uint64_t                nb_attached = 0;
+static volatile uint64_t                nb_failed = 0;
+static struct timespec                  end_time;
+
+//------------------------------------------------------------------------------
+static bstring *mme_app_worker_benchmark_payload (MessageDef * const message_p)
+{
+  switch (ITTI_MSG_ID (message_p)) {
+  case S1AP_INITIAL_UE_MESSAGE:
+    return &S1AP_INITIAL_UE_MESSAGE (message_p).nas;
+  case NAS_UPLINK_DATA_IND:
+    return &NAS_UL_DATA_IND (message_p).nas_msg;
+  default:
+    return NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_worker_benchmark_send (const task_id_t origin, const task_id_t destination, MessageDef * const message_p)
+{
+  MessageDef                             *retry_p = message_p;
+  MessageDef                              copy = *message_p;
+  bstring                                *payload = mme_app_worker_benchmark_payload (message_p);
+  bstring                                 saved = (payload) ? bstrcpy (*payload) : NULL;
+
+  // on queue full ITTI releases the message with its content, resend a copy
+  while (itti_send_msg_to_task (destination, INSTANCE_DEFAULT, retry_p) < 0) {
+    sched_yield ();
+    retry_p = itti_alloc_new_message (origin, ITTI_MSG_ID (&copy));
+    retry_p->ittiMsg = copy.ittiMsg;
+    if (saved) {
+      *mme_app_worker_benchmark_payload (retry_p) = bstrcpy (saved);
+    }
+  }
+  bdestroy_wrapper (&saved);
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_worker_benchmark_tai (tai_t * const tai)
+{
+  // TAI_LIST of etc/mme.conf
+  tai->mcc_digit1 = 2; tai->mcc_digit2 = 0; tai->mcc_digit3 = 8;
+  tai->mnc_digit1 = 9; tai->mnc_digit2 = 3; tai->mnc_digit3 = 0xF;
+  tai->tac = 1;
+}
+
+//------------------------------------------------------------------------------
+// TASK_S6A stub, the HSS
+static void *mme_app_worker_benchmark_s6a_task (__attribute__ ((unused)) void *args_p)
+{
+  MessageDef                             *received_message_p = NULL;
+  MessageDef                             *message_p = NULL;
+  s6a_auth_info_ans_t                    *aia = NULL;
+
+  itti_mark_task_ready (TASK_S6A);
+
+  while (1) {
+    itti_receive_msg (TASK_S6A, &received_message_p);
+    if (ITTI_MSG_ID (received_message_p) == S6A_AUTH_INFO_REQ) {
+      message_p = itti_alloc_new_message (TASK_S6A, S6A_AUTH_INFO_ANS);
+      aia = &S6A_AUTH_INFO_ANS (message_p);
+      memcpy (aia->imsi, received_message_p->ittiMsg.s6a_auth_info_req.imsi, sizeof (aia->imsi));
+      aia->imsi_length = received_message_p->ittiMsg.s6a_auth_info_req.imsi_length;
+      aia->result.present = S6A_RESULT_BASE;
+      aia->result.choice.base = DIAMETER_SUCCESS;
+      aia->auth_info.nb_of_vectors = received_message_p->ittiMsg.s6a_auth_info_req.nb_of_vectors;
+      for (int i = 0; i < aia->auth_info.nb_of_vectors; i++) {
+        memset (aia->auth_info.eutran_vector[i].rand, 0x5a + i, sizeof (aia->auth_info.eutran_vector[i].rand));
+        memset (aia->auth_info.eutran_vector[i].autn, 0xa5, sizeof (aia->auth_info.eutran_vector[i].autn));
+        memset (aia->auth_info.eutran_vector[i].kasme, 0x3c, sizeof (aia->auth_info.eutran_vector[i].kasme));
+        memcpy (aia->auth_info.eutran_vector[i].xres.data, res, sizeof (res));
+        aia->auth_info.eutran_vector[i].xres.size = sizeof (res);
+      }
+      mme_app_worker_benchmark_send (TASK_S6A, TASK_NAS_MME, message_p);
+    }
+    itti_free_msg_content (received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+// TASK_S1AP stub, the UEs
+static void *mme_app_worker_benchmark_s1ap_task (__attribute__ ((unused)) void *args_p)
+{
+  MessageDef                             *received_msgs[MME_APP_WORKER_BENCHMARK_MAX_BATCH];
+  MessageDef                             *message_p = NULL;
+  int                                     nb_msgs = 0;
+  int                                     i = 0;
+
+  itti_mark_task_ready (TASK_S1AP);
+
+  while (1) {
+    nb_msgs = itti_receive_msgs (TASK_S1AP, received_msgs, MME_APP_WORKER_BENCHMARK_MAX_BATCH);
+
+    for (i = 0; i < nb_msgs; i++) {
+      if (ITTI_MSG_ID (received_msgs[i]) == S1AP_NAS_DL_DATA_REQ) {
+        const_bstring                           nas = S1AP_NAS_DL_DATA_REQ (received_msgs[i]).nas_msg;
+
+        if ((blength (nas) >= 2) && (0x07 == nas->data[0]) && (0x52 == nas->data[1])) {
+          // Authentication Request, answered with RES
+          message_p = itti_alloc_new_message (TASK_S1AP, NAS_UPLINK_DATA_IND);
+          NAS_UL_DATA_IND (message_p).ue_id = S1AP_NAS_DL_DATA_REQ (received_msgs[i]).mme_ue_s1ap_id;
+          NAS_UL_DATA_IND (message_p).nas_msg = bfromcstralloc (3 + sizeof (res), "");
+          bconchar (NAS_UL_DATA_IND (message_p).nas_msg, 0x07);
+          bconchar (NAS_UL_DATA_IND (message_p).nas_msg, 0x53);
+          bconchar (NAS_UL_DATA_IND (message_p).nas_msg, sizeof (res));
+          bcatblk (NAS_UL_DATA_IND (message_p).nas_msg, res, sizeof (res));
+          mme_app_worker_benchmark_tai (&NAS_UL_DATA_IND (message_p).tai);
+          mme_app_worker_benchmark_send (TASK_S1AP, TASK_MME_APP, message_p);
+        } else if ((blength (nas) >= 2) && (0x30 == (nas->data[0] & 0xf0))) {
+          // Integrity protected with new EPS security context: Security Mode Command
+          __sync_fetch_and_add (&nb_attached, 1);
+          clock_gettime (CLOCK_MONOTONIC, &end_time);
+        } else {
+          // Attach Reject, Authentication Reject, ...
+          __sync_fetch_and_add (&nb_failed, 1);
+          clock_gettime (CLOCK_MONOTONIC, &end_time);
+        }
+      }
+      itti_free_msg_content (received_msgs[i]);
+      itti_free (ITTI_MSG_ORIGIN_ID (received_msgs[i]), received_msgs[i]);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static bstring mme_app_worker_benchmark_attach_request (const uint64_t ue)
+{
+  bstring                                 nas = blk2bstr (attach_request, sizeof (attach_request));
+  uint64_t                                msin = ue + 1;
+  int                                     digit = 15;
+
+  /*
+   * The 10 MSIN digits are IMSI digits 6..15 (counted from 1), IMSI digit d is
+   * in octet d / 2 of the identity value, in the high nibble when d is odd
+   */
+  for (int i = 0; i < 10; i++, digit--) {
+    uint8_t                                *octet = &nas->data[ATTACH_REQUEST_IMSI_OFFSET + (digit / 2)];
+
+    if (digit & 1) {
+      *octet = (*octet & 0x0f) | ((msin % 10) << 4);
+    } else {
+      *octet = (*octet & 0xf0) | (msin % 10);
+    }
+    msin /= 10;
+  }
+  return nas;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  char                                   *config_argv[] = { argv[0], "-c", NULL, NULL };
+  uint32_t                                nb_workers = 1;
+  uint64_t                                nb_ues = MME_APP_WORKER_BENCHMARK_NB_UES;
+  uint64_t                                nb_sent = 0;
+  MessageDef                             *message_p = NULL;
+  struct timespec                         start_time;
+  double                                  elapsed = 0;
+
+  if (argc < 2) {
+    fprintf (stderr, "usage: %s mme.conf [nb_workers] [nb_ues]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  config_argv[2] = argv[1];
+  if (argc > 2) {
+    nb_workers = strtoul (argv[2], NULL, 0);
+
+    if (argc > 3) {
+      nb_ues = strtoull (argv[3], NULL, 0);
+    }
+  }
+
+  if ((nb_workers == 0) || (nb_workers > MME_APP_NB_WORKERS_MAX) || (nb_ues == 0)) {
+    fprintf (stderr, "need 0 < nb_workers <= %d and 0 < nb_ues\n", MME_APP_NB_WORKERS_MAX);
+    return EXIT_FAILURE;
+  }
+
+  shared_log_init (MAX_LOG_PROTOS);
+  OAILOG_INIT (LOG_MME_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS);
+  if (mme_config_parse_opt_line (3, config_argv, &mme_config) < 0) {
+    fprintf (stderr, "Failed to parse %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  mme_config.max_ues = nb_ues;
+  mme_config.mme_app_nb_workers = nb_workers;
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+
+  if ((itti_create_task (TASK_S1AP, &mme_app_worker_benchmark_s1ap_task, NULL) < 0) ||
+      (itti_create_task (TASK_S6A, &mme_app_worker_benchmark_s6a_task, NULL) < 0)) {
+    fprintf (stderr, "Failed to create stub tasks\n");
+    return EXIT_FAILURE;
+  }
+  if ((nas_init (&mme_config) < 0) || (mme_app_init (&mme_config) < 0)) {
+    fprintf (stderr, "Failed to initialize NAS and MME_APP\n");
+    return EXIT_FAILURE;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+
+  for (nb_sent = 0; nb_sent < nb_ues; nb_sent++) {
+    while (nb_sent - (nb_attached + nb_failed) >= MME_APP_WORKER_BENCHMARK_WINDOW) {
+      sched_yield ();
+    }
+    message_p = itti_alloc_new_message (TASK_S1AP, S1AP_INITIAL_UE_MESSAGE);
+    S1AP_INITIAL_UE_MESSAGE (message_p).sctp_assoc_id = 1 + (nb_sent % MME_APP_WORKER_BENCHMARK_NB_ENBS);
+    S1AP_INITIAL_UE_MESSAGE (message_p).enb_id = 1 + (nb_sent % MME_APP_WORKER_BENCHMARK_NB_ENBS);
+    S1AP_INITIAL_UE_MESSAGE (message_p).enb_ue_s1ap_id = (nb_sent / MME_APP_WORKER_BENCHMARK_NB_ENBS) & ENB_UE_S1AP_ID_MASK;
+    S1AP_INITIAL_UE_MESSAGE (message_p).mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+    S1AP_INITIAL_UE_MESSAGE (message_p).nas = mme_app_worker_benchmark_attach_request (nb_sent);
+    mme_app_worker_benchmark_tai (&S1AP_INITIAL_UE_MESSAGE (message_p).tai);
+    S1AP_INITIAL_UE_MESSAGE (message_p).ecgi.plmn.mcc_digit1 = 2;
+    S1AP_INITIAL_UE_MESSAGE (message_p).ecgi.plmn.mcc_digit2 = 0;
+    S1AP_INITIAL_UE_MESSAGE (message_p).ecgi.plmn.mcc_digit3 = 8;
+    S1AP_INITIAL_UE_MESSAGE (message_p).ecgi.plmn.mnc_digit1 = 9;
+    S1AP_INITIAL_UE_MESSAGE (message_p).ecgi.plmn.mnc_digit2 = 3;
+    S1AP_INITIAL_UE_MESSAGE (message_p).ecgi.plmn.mnc_digit3 = 0xF;
+    S1AP_INITIAL_UE_MESSAGE (message_p).ecgi.cell_identity.enb_id = 1 + (nb_sent % MME_APP_WORKER_BENCHMARK_NB_ENBS);
+    S1AP_INITIAL_UE_MESSAGE (message_p).rrc_establishment_cause = MO_SIGNALLING;
+    mme_app_worker_benchmark_send (TASK_S1AP, TASK_MME_APP, message_p);
+  }
+
+  while ((nb_attached + nb_failed) < nb_ues) {
+    sched_yield ();
+  }
+
+  elapsed = (double)(end_time.tv_sec - start_time.tv_sec) + (double)(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+  fprintf (stdout, "MME_APP %u workers: %" PRIu64 " attaches up to Security Mode Command in %.3f s, %.0f attaches/s, %" PRIu64 " failed\n",
+      nb_workers, nb_ues, elapsed, (double)nb_ues / elapsed, nb_failed);
+  return (nb_failed) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
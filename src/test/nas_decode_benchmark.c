@@ -0,0 +1,233 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*
+ * NAS uplink message decode benchmark: recorded plain uplink EMM and ESM
+ * messages, header excluded, are decoded by their decode_xxx() message codec,
+ * the way emm_msg_decode() and esm_msg_decode() dispatch them, and by the
+ * codec nas_codec_gen.py generates from nas_messages.def. The benchmark
+ * reports decoded messages/s of both codecs for each message.
+ *
+ * usage: nas_decode_benchmark [nb_messages]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "common_defs.h"
+#include "common_types.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.008.h"
+#include "3gpp_36.331.h"
+#include "3gpp_36.401.h"
+#include "3gpp_29.274.h"
+#include "emm_msg.h"
+#include "esm_msg.h"
+#include "nas_codec.h"
+
+#define NAS_DECODE_BENCHMARK_NB_MESSAGES      1000000
+#define NAS_DECODE_BENCHMARK_MAX_LENGTH       256
+
+typedef union nas_decode_benchmark_msg_u {
+  EMM_msg                                 emm;
+  ESM_msg                                 esm;
+} nas_decode_benchmark_msg_t;
+
+typedef int (*nas_decode_benchmark_decoder_t) (nas_decode_benchmark_msg_t * msg, uint8_t * buffer, uint32_t len);
+
+#define NAS_DECODE_BENCHMARK_DECODER(uNION, mESSAGE)                                \
+  static int nas_decode_benchmark_decode_##mESSAGE (nas_decode_benchmark_msg_t * msg, uint8_t * buffer, uint32_t len) \
+  {                                                                                 \
+    return decode_##mESSAGE (&msg->uNION.mESSAGE, buffer, len);                     \
+  }
+
+NAS_DECODE_BENCHMARK_DECODER (emm, attach_request)
+NAS_DECODE_BENCHMARK_DECODER (emm, attach_complete)
+NAS_DECODE_BENCHMARK_DECODER (emm, authentication_response)
+NAS_DECODE_BENCHMARK_DECODER (emm, detach_request)
+NAS_DECODE_BENCHMARK_DECODER (emm, identity_response)
+NAS_DECODE_BENCHMARK_DECODER (emm, security_mode_complete)
+NAS_DECODE_BENCHMARK_DECODER (emm, tracking_area_update_request)
+NAS_DECODE_BENCHMARK_DECODER (emm, uplink_nas_transport)
+NAS_DECODE_BENCHMARK_DECODER (esm, esm_information_response)
+NAS_DECODE_BENCHMARK_DECODER (esm, pdn_connectivity_request)
+
+typedef struct nas_decode_benchmark_pdu_s {
+  const char                             *name;
+  nas_decode_benchmark_decoder_t          decode;
+  const char                             *pdu;      /* plain NAS PDU in hex, header included */
+} nas_decode_benchmark_pdu_t;
+
+#define NAS_DECODE_BENCHMARK_GUTI             "0b f6 02 f8 39 80 04 01 c0 00 00 01"
+#define NAS_DECODE_BENCHMARK_PCO              "27 0a 80 00 0d 00 00 03 00 00 0a 00"
+
+static const nas_decode_benchmark_pdu_t nas_decode_benchmark_pdus[] = {
+  {"Attach Request IMSI", nas_decode_benchmark_decode_attach_request,
+   "07 41 71 08 29 80 39 10 00 00 00 10 05 f0 f0 c0 40 19 00 04 02 01 d0 11"},
+  {"Attach Request GUTI", nas_decode_benchmark_decode_attach_request,
+   "07 41 21 " NAS_DECODE_BENCHMARK_GUTI " 02 e0 e0 00 04 02 01 d0 11 19 01 02 03 04 50 " NAS_DECODE_BENCHMARK_GUTI
+   " 52 02 f8 39 00 01 5c 0a 00 31 03 e5 e0 34 13 02 f8 39 00 01 90 11 03 57 58 a6 40 08 04 02 60 04 00 02 1f 02"
+   " f1 e0 5d 01 00 c1"},
+  {"Attach Complete", nas_decode_benchmark_decode_attach_complete, "07 43 00 03 52 00 c2"},
+  {"Authentication Response", nas_decode_benchmark_decode_authentication_response, "07 53 08 11 22 33 44 55 66 77 88"},
+  {"Security Mode Complete", nas_decode_benchmark_decode_security_mode_complete, "07 5e 23 08 29 80 39 10 00 00 00 10"},
+  {"Identity Response", nas_decode_benchmark_decode_identity_response, "07 56 08 29 80 39 10 00 00 00 10"},
+  {"TAU Request", nas_decode_benchmark_decode_tracking_area_update_request,
+   "07 48 71 " NAS_DECODE_BENCHMARK_GUTI " b0 80 19 01 02 03 04 50 " NAS_DECODE_BENCHMARK_GUTI " 55 01 02 03 04 58 02 e0 e0"
+   " 52 02 f8 39 00 01 5c 0a 00 a1 57 02 20 00 31 03 e5 e0 34 13 02 f8 39 00 01 90 11 03 57 58 a6 40 08 04 02 60 04 00 02 1f 02 e1"},
+  {"TAU Request periodic", nas_decode_benchmark_decode_tracking_area_update_request, "07 48 03 " NAS_DECODE_BENCHMARK_GUTI},
+  {"Uplink NAS Transport", nas_decode_benchmark_decode_uplink_nas_transport, "07 63 03 01 02 03"},
+  {"Detach Request", nas_decode_benchmark_decode_detach_request, "07 45 19 " NAS_DECODE_BENCHMARK_GUTI},
+  {"PDN Connectivity Request", nas_decode_benchmark_decode_pdn_connectivity_request,
+   "02 01 d0 11 d1 28 04 03 6f 61 69 " NAS_DECODE_BENCHMARK_PCO},
+  {"ESM Information Response", nas_decode_benchmark_decode_esm_information_response,
+   "02 01 da 28 04 03 6f 61 69 " NAS_DECODE_BENCHMARK_PCO},
+};
+
+//------------------------------------------------------------------------------
+static uint32_t nas_decode_benchmark_pdu (const char * hex, uint8_t * const pdu, const uint32_t len)
+{
+  uint32_t                                length = 0;
+  char                                   *end = NULL;
+
+  while (*hex && (length < len)) {
+    pdu[length++] = (uint8_t) strtoul (hex, &end, 16);
+    for (hex = end; *hex == ' '; hex++);
+  }
+  return length;
+}
+
+//------------------------------------------------------------------------------
+/* Free what the decoders allocate, like the EMM and ESM receive procedures do */
+static void nas_decode_benchmark_free (const uint8_t protocol_discriminator, nas_decode_benchmark_msg_t * const msg)
+{
+  if (EPS_MOBILITY_MANAGEMENT_MESSAGE == protocol_discriminator) {
+    switch (msg->emm.header.message_type) {
+    case ATTACH_REQUEST:
+      bdestroy_wrapper (&msg->emm.attach_request.esmmessagecontainer);
+      bdestroy_wrapper (&msg->emm.attach_request.supportedcodecs);
+      break;
+    case ATTACH_COMPLETE:
+      bdestroy_wrapper (&msg->emm.attach_complete.esmmessagecontainer);
+      break;
+    case AUTHENTICATION_RESPONSE:
+      bdestroy_wrapper (&msg->emm.authentication_response.authenticationresponseparameter);
+      break;
+    case TRACKING_AREA_UPDATE_REQUEST:
+      bdestroy_wrapper (&msg->emm.tracking_area_update_request.supportedcodecs);
+      break;
+    case UPLINK_NAS_TRANSPORT:
+      bdestroy_wrapper (&msg->emm.uplink_nas_transport.nasmessagecontainer);
+      break;
+    default:;
+    }
+  } else {
+    switch (msg->esm.header.message_type) {
+    case PDN_CONNECTIVITY_REQUEST:
+      bdestroy_wrapper (&msg->esm.pdn_connectivity_request.accesspointname);
+      clear_protocol_configuration_options (&msg->esm.pdn_connectivity_request.protocolconfigurationoptions);
+      break;
+    case ESM_INFORMATION_RESPONSE:
+      bdestroy_wrapper (&msg->esm.esm_information_response.accesspointname);
+      clear_protocol_configuration_options (&msg->esm.esm_information_response.protocolconfigurationoptions);
+      break;
+    default:;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static double nas_decode_benchmark_run (
+  const nas_decode_benchmark_pdu_t * const benchmark,
+  uint8_t * const pdu,
+  const uint32_t pdu_length,
+  const bool generated,
+  const uint64_t nb_messages,
+  uint64_t * const nb_failed)
+{
+  const uint8_t                           protocol_discriminator = pdu[0] & 0x0f;
+  const uint32_t                          header_length = (EPS_MOBILITY_MANAGEMENT_MESSAGE == protocol_discriminator) ? 2 : 3;
+  const uint8_t                           message_type = pdu[header_length - 1];
+  uint8_t                                *body = &pdu[header_length];
+  const uint32_t                          length = pdu_length - header_length;
+  nas_decode_benchmark_msg_t              msg;
+  struct timespec                         start_time;
+  struct timespec                         end_time;
+  uint64_t                                i = 0;
+  int                                     decoder_rc = 0;
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_messages; i++) {
+    memset (&msg, 0, sizeof (msg));
+    if (EPS_MOBILITY_MANAGEMENT_MESSAGE == protocol_discriminator) {
+      msg.emm.header.message_type = message_type;
+      decoder_rc = generated ? nas_codec_decode_emm (&msg.emm, body, length) : benchmark->decode (&msg, body, length);
+    } else {
+      msg.esm.header.message_type = message_type;
+      decoder_rc = generated ? nas_codec_decode_esm (&msg.esm, body, length) : benchmark->decode (&msg, body, length);
+    }
+    if (decoder_rc != (int)length) {
+      (*nb_failed)++;
+    }
+    nas_decode_benchmark_free (protocol_discriminator, &msg);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  return (double)(end_time.tv_sec - start_time.tv_sec) + (double)(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint64_t                                nb_messages = NAS_DECODE_BENCHMARK_NB_MESSAGES;
+  uint8_t                                 pdu[NAS_DECODE_BENCHMARK_MAX_LENGTH];
+  uint32_t                                pdu_length = 0;
+  uint64_t                                nb_failed = 0;
+  double                                  hand_elapsed = 0;
+  double                                  generated_elapsed = 0;
+  int                                     i = 0;
+
+  if (argc > 1) {
+    nb_messages = strtoull (argv[1], NULL, 0);
+  }
+  if (nb_messages == 0) {
+    fprintf (stderr, "need 0 < nb_messages\n");
+    return EXIT_FAILURE;
+  }
+
+  for (i = 0; i < sizeof (nas_decode_benchmark_pdus) / sizeof (nas_decode_benchmark_pdus[0]); i++) {
+    pdu_length = nas_decode_benchmark_pdu (nas_decode_benchmark_pdus[i].pdu, pdu, sizeof (pdu));
+    nb_failed = 0;
+    hand_elapsed = nas_decode_benchmark_run (&nas_decode_benchmark_pdus[i], pdu, pdu_length, false, nb_messages, &nb_failed);
+    generated_elapsed = nas_decode_benchmark_run (&nas_decode_benchmark_pdus[i], pdu, pdu_length, true, nb_messages, &nb_failed);
+    fprintf (stdout, "  %-26s %3u bytes: decode_xxx() %9.0f messages/s, generated %9.0f messages/s (x%.2f), %" PRIu64 " failed\n",
+        nas_decode_benchmark_pdus[i].name, pdu_length, nb_messages / hand_elapsed, nb_messages / generated_elapsed,
+        hand_elapsed / generated_elapsed, nb_failed);
+  }
+  return EXIT_SUCCESS;
+}
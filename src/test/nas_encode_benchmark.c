@@ -0,0 +1,299 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * NAS downlink path allocation benchmark: Security Mode Command (integrity
+ * protected with the new EPS security context) and Attach Accept (ciphered
+ * with EEA2/EIA2) messages are built with emm_as_send() the way the EMM
+ * procedures do, and travel through the MME_APP tasks up to a stub TASK_S1AP
+ * receiving S1AP_NAS_DL_DATA_REQ. malloc(), calloc() and realloc() are
+ * interposed to count the heap allocations of all threads, the benchmark
+ * reports heap allocations per downlink NAS message, from the EMMAS-SAP
+ * primitive to S1AP, and messages/s. The first PDU of each run is deciphered
+ * and decoded with the UE side of the security context.
+ *
+ * usage: nas_encode_benchmark mme.conf [nb_messages]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
+#include "dynamic_memory_check.h"
+#include "common_defs.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.008.h"
+#include "3gpp_24.301.h"
+#include "3gpp_29.274.h"
+#include "mme_config.h"
+#include "mme_app_extern.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "secu_defs.h"
+#include "emm_data.h"
+#include "emm_proc.h"
+#include "emm_as.h"
+#include "nas_message.h"
+#include "nas_defs.h"
+
+#define NAS_ENCODE_BENCHMARK_NB_MESSAGES      1000000
+#define NAS_ENCODE_BENCHMARK_WINDOW           256
+#define NAS_ENCODE_BENCHMARK_MAX_LENGTH       256
+
+extern void                            *__libc_malloc (size_t size);
+extern void                            *__libc_calloc (size_t nmemb, size_t size);
+extern void                            *__libc_realloc (void *ptr, size_t size);
+
+/* Activate Default EPS Bearer Context Request, EBI 5, QCI 9, APN internet, 192.168.12.2, DNS and MTU PCO */
+static const uint8_t                    activate_default_eps_bearer_context_request[] = {
+  0x52, 0x01, 0xC1, 0x01, 0x09, 0x09, 0x08, 0x69, 0x6E, 0x74, 0x65, 0x72,
+  0x6E, 0x65, 0x74, 0x05, 0x01, 0xC0, 0xA8, 0x0C, 0x02, 0x5E, 0x04, 0xFE,
+  0xFE, 0xDE, 0x9E, 0x27, 0x0D, 0x80, 0x00, 0x0D, 0x04, 0x08, 0x08, 0x08,
+  0x08, 0x00, 0x10, 0x02, 0x05, 0xDC
+};
+
+static volatile uint64_t                nb_heap_allocations = 0;
+static volatile uint64_t                nb_received = 0;
+static uint8_t                          first_pdu[NAS_ENCODE_BENCHMARK_MAX_LENGTH];
+static volatile int                     first_pdu_length = 0;
+
+//------------------------------------------------------------------------------
+void *malloc (size_t size)
+{
+  __sync_fetch_and_add (&nb_heap_allocations, 1);
+  return __libc_malloc (size);
+}
+
+//------------------------------------------------------------------------------
+void *calloc (size_t nmemb, size_t size)
+{
+  __sync_fetch_and_add (&nb_heap_allocations, 1);
+  return __libc_calloc (nmemb, size);
+}
+
+//------------------------------------------------------------------------------
+void *realloc (void *ptr, size_t size)
+{
+  __sync_fetch_and_add (&nb_heap_allocations, 1);
+  return __libc_realloc (ptr, size);
+}
+
+//------------------------------------------------------------------------------
+// TASK_S1AP stub, keeps the first downlink NAS PDU of a run
+static void *nas_encode_benchmark_s1ap_task (__attribute__ ((unused)) void *args_p)
+{
+  MessageDef                             *received_message_p = NULL;
+
+  itti_mark_task_ready (TASK_S1AP);
+
+  while (1) {
+    itti_receive_msg (TASK_S1AP, &received_message_p);
+    if (ITTI_MSG_ID (received_message_p) == S1AP_NAS_DL_DATA_REQ) {
+      const_bstring                           nas = S1AP_NAS_DL_DATA_REQ (received_message_p).nas_msg;
+
+      if ((0 == first_pdu_length) && (blength (nas) > 0) && (blength (nas) <= sizeof (first_pdu))) {
+        memcpy (first_pdu, nas->data, blength (nas));
+        first_pdu_length = blength (nas);
+      }
+      __sync_fetch_and_add (&nb_received, 1);
+    }
+    itti_free_msg_content (received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void nas_encode_benchmark_run (
+  const char * const name,
+  emm_as_t * const emm_as,
+  emm_security_context_t * const mme_security,
+  const uint8_t message_type,
+  const uint64_t nb_messages)
+{
+  emm_security_context_t                  ue_security = *mme_security;
+  nas_message_t                           nas_msg = {.security_protected.header = {0},
+                                                     .security_protected.plain.emm.header = {0},
+                                                     .security_protected.plain.esm.header = {0}};
+  nas_message_decode_status_t             decode_status = {0};
+  uint64_t                                nb_allocations = 0;
+  uint64_t                                nb_failed = 0;
+  uint64_t                                nb_sent = 0;
+  struct timespec                         start_time;
+  struct timespec                         end_time;
+  double                                  elapsed = 0;
+  int                                     decoder_rc = 0;
+
+  // the UE side of the security context, decoding downlink messages
+  ue_security.direction_decode = SECU_DIRECTION_DOWNLINK;
+  memset (&ue_security.knas_enc_schedule, 0, sizeof (ue_security.knas_enc_schedule));
+  memset (&ue_security.knas_int_schedule, 0, sizeof (ue_security.knas_int_schedule));
+  first_pdu_length = 0;
+  nb_received = 0;
+
+  nb_allocations = nb_heap_allocations;
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+
+  while (nb_sent < nb_messages) {
+    if ((nb_sent - nb_failed - nb_received) >= NAS_ENCODE_BENCHMARK_WINDOW) {
+      sched_yield ();
+      continue;
+    }
+    if (emm_as_send (emm_as) != RETURNok) {
+      nb_failed++;
+    }
+    nb_sent++;
+  }
+  while (nb_received + nb_failed < nb_messages) {
+    sched_yield ();
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  nb_allocations = nb_heap_allocations - nb_allocations;
+  elapsed = (double)(end_time.tv_sec - start_time.tv_sec) + (double)(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+
+  decoder_rc = nas_message_decode (first_pdu, &nas_msg, first_pdu_length, &ue_security, &decode_status);
+  if ((decoder_rc < 0) || !decode_status.mac_matched || (nas_msg.plain.emm.header.message_type != message_type)) {
+    fprintf (stderr, "  %s: first PDU does not decode (rc %d, MAC %s, message type 0x%02x)\n",
+        name, decoder_rc, decode_status.mac_matched ? "matched" : "mismatch", nas_msg.plain.emm.header.message_type);
+    nb_failed++;
+  }
+  if (ATTACH_ACCEPT == message_type) {
+    bdestroy_wrapper (&nas_msg.plain.emm.attach_accept.esmmessagecontainer);
+  }
+
+  fprintf (stdout, "  %-26s %3d bytes: %6.2f heap allocations/message, %9.0f messages/s, %" PRIu64 " failed\n",
+      name, first_pdu_length, (double)nb_allocations / nb_messages, nb_messages / elapsed, nb_failed);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  char                                   *config_argv[] = { argv[0], "-c", NULL, NULL };
+  uint64_t                                nb_messages = NAS_ENCODE_BENCHMARK_NB_MESSAGES;
+  ue_mm_context_t                        *ue_context_p = NULL;
+  emm_security_context_t                 *security = NULL;
+  mme_ue_s1ap_id_t                        ue_id = INVALID_MME_UE_S1AP_ID;
+  emm_as_t                                emm_as = {0};
+  guti_t                                  guti = {.gummei = {.plmn = {.mcc_digit1 = 2, .mcc_digit2 = 0, .mcc_digit3 = 8,
+                                                                      .mnc_digit1 = 9, .mnc_digit2 = 3, .mnc_digit3 = 0xF},
+                                                             .mme_gid = 4, .mme_code = 1},
+                                                  .m_tmsi = 0x2bd0e2a1};
+
+  if (argc < 2) {
+    fprintf (stderr, "usage: %s mme.conf [nb_messages]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  config_argv[2] = argv[1];
+  if (argc > 2) {
+    nb_messages = strtoull (argv[2], NULL, 0);
+  }
+  if (nb_messages == 0) {
+    fprintf (stderr, "need 0 < nb_messages\n");
+    return EXIT_FAILURE;
+  }
+
+  shared_log_init (MAX_LOG_PROTOS);
+  OAILOG_INIT (LOG_MME_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS);
+  if (mme_config_parse_opt_line (3, config_argv, &mme_config) < 0) {
+    fprintf (stderr, "Failed to parse %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+  if ((nas_init (&mme_config) < 0) || (mme_app_init (&mme_config) < 0)) {
+    fprintf (stderr, "Failed to initialize NAS and MME_APP\n");
+    return EXIT_FAILURE;
+  }
+  if (itti_create_task (TASK_S1AP, &nas_encode_benchmark_s1ap_task, NULL) < 0) {
+    fprintf (stderr, "Failed to create the stub S1AP task\n");
+    return EXIT_FAILURE;
+  }
+
+  // A UE in ECM connected state with the NAS security context of the Security Mode Control procedure
+  if ((ue_context_p = mme_create_new_ue_context ()) == NULL) {
+    fprintf (stderr, "Failed to create UE context\n");
+    return EXIT_FAILURE;
+  }
+  ue_id = mme_app_ctx_get_new_ue_id ();
+  ue_context_p->mme_ue_s1ap_id = ue_id;
+  ue_context_p->enb_ue_s1ap_id = 1;
+  MME_APP_ENB_S1AP_ID_KEY (ue_context_p->enb_s1ap_id_key, 1, 1);
+  if (mme_insert_ue_context (&mme_app_desc.mme_ue_contexts, ue_context_p) != RETURNok) {
+    fprintf (stderr, "Failed to insert UE context\n");
+    return EXIT_FAILURE;
+  }
+  ue_context_p->ecm_state = ECM_CONNECTED;
+  ue_context_p->emm_context.attach_type = EMM_ATTACH_TYPE_EPS;
+  security = &ue_context_p->emm_context._security;
+  emm_ctx_set_security_type (&ue_context_p->emm_context, SECURITY_CTX_TYPE_FULL_NATIVE);
+  memset (security->knas_enc, 0x2b, sizeof (security->knas_enc));
+  memset (security->knas_int, 0x7e, sizeof (security->knas_int));
+  security->selected_algorithms.encryption = NAS_SECURITY_ALGORITHMS_EEA2;
+  security->selected_algorithms.integrity = NAS_SECURITY_ALGORITHMS_EIA2;
+  security->direction_encode = SECU_DIRECTION_DOWNLINK;
+  security->direction_decode = SECU_DIRECTION_UPLINK;
+  security->activated = 1;
+  emm_ctx_set_attribute_present (&ue_context_p->emm_context, EMM_CTXT_MEMBER_SECURITY);
+  unlock_ue_contexts (ue_context_p);
+
+  fprintf (stdout, "%" PRIu64 " downlink NAS messages through emm_as_send() and MME_APP to S1AP\n", nb_messages);
+
+  // _security_request() of the Security Mode Control procedure
+  emm_as.primitive = _EMMAS_SECURITY_REQ;
+  emm_as.u.security.ue_id = ue_id;
+  emm_as.u.security.msg_type = EMM_AS_MSG_TYPE_SMC;
+  emm_as.u.security.sctx.ksi = 0;
+  emm_as.u.security.sctx.is_new = true;
+  emm_as.u.security.sctx.is_knas_int_present = true;
+  emm_as.u.security.eea = 0xE0;
+  emm_as.u.security.eia = 0x60;
+  emm_as.u.security.selected_eea = NAS_SECURITY_ALGORITHMS_EEA2;
+  emm_as.u.security.selected_eia = NAS_SECURITY_ALGORITHMS_EIA2;
+  nas_encode_benchmark_run ("Security Mode Command", &emm_as, security, SECURITY_MODE_COMMAND, nb_messages);
+
+  // _emm_attach_accept() of a UE in connected mode, ESM message container included
+  memset (&emm_as, 0, sizeof (emm_as));
+  emm_as.primitive = _EMMAS_DATA_REQ;
+  emm_as.u.data.ue_id = ue_id;
+  emm_as.u.data.nas_info = EMM_AS_NAS_DATA_ATTACH_ACCEPT;
+  emm_as.u.data.new_guti = &guti;
+  emm_as.u.data.sctx.ksi = 0;
+  emm_as.u.data.sctx.is_knas_int_present = true;
+  emm_as.u.data.sctx.is_knas_enc_present = true;
+  emm_as.u.data.tai_list.numberoflists = 1;
+  emm_as.u.data.tai_list.partial_tai_list[0].typeoflist = TRACKING_AREA_IDENTITY_LIST_ONE_PLMN_CONSECUTIVE_TACS;
+  emm_as.u.data.tai_list.partial_tai_list[0].numberofelements = 0;
+  emm_as.u.data.tai_list.partial_tai_list[0].u.tai_one_plmn_consecutive_tacs = (tai_t) {.mcc_digit1 = 2, .mcc_digit2 = 0, .mcc_digit3 = 8,
+                                                                                         .mnc_digit1 = 9, .mnc_digit2 = 3, .mnc_digit3 = 0xF, .tac = 1};
+  emm_as.u.data.nas_msg = blk2bstr (activate_default_eps_bearer_context_request, sizeof (activate_default_eps_bearer_context_request));
+  nas_encode_benchmark_run ("Attach Accept EEA2/EIA2", &emm_as, security, ATTACH_ACCEPT, nb_messages);
+  bdestroy_wrapper (&emm_as.u.data.nas_msg);
+  return EXIT_SUCCESS;
+}
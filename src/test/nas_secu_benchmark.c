@@ -0,0 +1,184 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*
+ * NAS ciphering and integrity micro benchmark: per message cost of
+ * EEA1/EIA1 (SNOW 3G), and of EEA2/EIA2 with the per call key setup
+ * (nas_stream_encrypt_eea2/eia2) and with the key schedule cached in the EPS
+ * NAS security context (nas_stream_encrypt_eea2_cached/eia2_cached), for
+ * typical NAS message sizes. Both EEA2/EIA2 paths must produce identical outputs.
+ *
+ * usage: nas_secu_benchmark [nb_messages]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "shared_ts_log.h"
+#include "secu_defs.h"
+
+#define NAS_SECU_BENCHMARK_NB_MESSAGES   100000
+#define NAS_SECU_BENCHMARK_MAX_LENGTH    1024
+
+typedef int (*nas_secu_benchmark_cipher_t) (nas_stream_key_schedule_t * const schedule,
+    nas_stream_cipher_t * const stream_cipher, uint8_t * const out);
+
+//------------------------------------------------------------------------------
+static uint64_t nas_secu_benchmark_clock_ns (void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+// adapters so that all algorithms can be timed by the same loop
+static int nas_secu_benchmark_eea1 (nas_stream_key_schedule_t * const schedule, nas_stream_cipher_t * const stream_cipher, uint8_t * const out)
+{
+  return nas_stream_encrypt_eea1 (stream_cipher, out);
+}
+
+static int nas_secu_benchmark_eia1 (nas_stream_key_schedule_t * const schedule, nas_stream_cipher_t * const stream_cipher, uint8_t * const out)
+{
+  return nas_stream_encrypt_eia1 (stream_cipher, out);
+}
+
+static int nas_secu_benchmark_eea2 (nas_stream_key_schedule_t * const schedule, nas_stream_cipher_t * const stream_cipher, uint8_t * const out)
+{
+  return nas_stream_encrypt_eea2 (stream_cipher, out);
+}
+
+static int nas_secu_benchmark_eea2_cached (nas_stream_key_schedule_t * const schedule, nas_stream_cipher_t * const stream_cipher, uint8_t * const out)
+{
+  return nas_stream_encrypt_eea2_cached (schedule, stream_cipher, out);
+}
+
+static int nas_secu_benchmark_eia2 (nas_stream_key_schedule_t * const schedule, nas_stream_cipher_t * const stream_cipher, uint8_t * const out)
+{
+  return nas_stream_encrypt_eia2 (stream_cipher, out);
+}
+
+static int nas_secu_benchmark_eia2_cached (nas_stream_key_schedule_t * const schedule, nas_stream_cipher_t * const stream_cipher, uint8_t * const out)
+{
+  return nas_stream_encrypt_eia2_cached (schedule, stream_cipher, out);
+}
+
+//------------------------------------------------------------------------------
+static double nas_secu_benchmark_run (
+  nas_secu_benchmark_cipher_t cipher,
+  nas_stream_key_schedule_t * const schedule,
+  nas_stream_cipher_t * const stream_cipher,
+  uint8_t * const out,
+  const uint32_t nb_messages)
+{
+  uint64_t                                start = 0;
+  uint32_t                                i = 0;
+
+  start = nas_secu_benchmark_clock_ns ();
+  for (i = 0; i < nb_messages; i++) {
+    // NAS COUNT changes with every message, the key does not
+    stream_cipher->count = i;
+    cipher (schedule, stream_cipher, out);
+  }
+  return (double)(nas_secu_benchmark_clock_ns () - start) / nb_messages;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  const uint32_t                          lengths[] = {16, 64, 100, 256, NAS_SECU_BENCHMARK_MAX_LENGTH};
+  uint8_t                                 key[16] = {0};
+  uint8_t                                 message[NAS_SECU_BENCHMARK_MAX_LENGTH] = {0};
+  uint8_t                                 out[NAS_SECU_BENCHMARK_MAX_LENGTH] = {0};
+  uint8_t                                 out_cached[NAS_SECU_BENCHMARK_MAX_LENGTH] = {0};
+  nas_stream_key_schedule_t               schedule = {0};
+  nas_stream_cipher_t                     stream_cipher = {0};
+  uint32_t                                nb_messages = NAS_SECU_BENCHMARK_NB_MESSAGES;
+  double                                  eea1_ns = 0;
+  double                                  eia1_ns = 0;
+  double                                  eea2_ns = 0;
+  double                                  eea2_cached_ns = 0;
+  double                                  eia2_ns = 0;
+  double                                  eia2_cached_ns = 0;
+  uint32_t                                i = 0;
+
+  if (argc > 1) {
+    nb_messages = strtoul (argv[1], NULL, 0);
+  }
+  if (nb_messages == 0) {
+    fprintf (stderr, "need nb_messages > 0\n");
+    return EXIT_FAILURE;
+  }
+
+  shared_log_init (MAX_LOG_PROTOS);
+  OAILOG_INIT (LOG_MME_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS);
+
+  for (i = 0; i < sizeof (key); i++) {
+    key[i] = (uint8_t)(0x2b + 7 * i);
+  }
+  for (i = 0; i < sizeof (message); i++) {
+    message[i] = (uint8_t)(i * 31);
+  }
+  stream_cipher.key = key;
+  stream_cipher.key_length = sizeof (key);
+  stream_cipher.bearer = 0;
+  stream_cipher.direction = SECU_DIRECTION_DOWNLINK;
+  stream_cipher.message = message;
+
+  fprintf (stdout, "%u messages per run, ns per message\n", nb_messages);
+  fprintf (stdout, "%6s %12s %12s %12s %12s %12s %12s\n", "bytes", "EEA1", "EIA1", "EEA2", "EEA2 cached", "EIA2", "EIA2 cached");
+
+  for (i = 0; i < sizeof (lengths) / sizeof (lengths[0]); i++) {
+    stream_cipher.blength = lengths[i] << 3;
+    stream_cipher.count = 0x1234;
+
+    nas_stream_encrypt_eea2 (&stream_cipher, out);
+    nas_stream_encrypt_eea2_cached (&schedule, &stream_cipher, out_cached);
+    if (memcmp (out, out_cached, lengths[i])) {
+      fprintf (stderr, "EEA2 cached output differs for %u bytes\n", lengths[i]);
+      return EXIT_FAILURE;
+    }
+    nas_stream_encrypt_eia2 (&stream_cipher, out);
+    nas_stream_encrypt_eia2_cached (&schedule, &stream_cipher, out_cached);
+    if (memcmp (out, out_cached, 4)) {
+      fprintf (stderr, "EIA2 cached MAC differs for %u bytes\n", lengths[i]);
+      return EXIT_FAILURE;
+    }
+
+    eea1_ns = nas_secu_benchmark_run (nas_secu_benchmark_eea1, &schedule, &stream_cipher, out, nb_messages);
+    eia1_ns = nas_secu_benchmark_run (nas_secu_benchmark_eia1, &schedule, &stream_cipher, out, nb_messages);
+    eea2_ns = nas_secu_benchmark_run (nas_secu_benchmark_eea2, &schedule, &stream_cipher, out, nb_messages);
+    eea2_cached_ns = nas_secu_benchmark_run (nas_secu_benchmark_eea2_cached, &schedule, &stream_cipher, out, nb_messages);
+    eia2_ns = nas_secu_benchmark_run (nas_secu_benchmark_eia2, &schedule, &stream_cipher, out, nb_messages);
+    eia2_cached_ns = nas_secu_benchmark_run (nas_secu_benchmark_eia2_cached, &schedule, &stream_cipher, out, nb_messages);
+    fprintf (stdout, "%6u %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n", lengths[i], eea1_ns, eia1_ns, eea2_ns, eea2_cached_ns, eia2_ns, eia2_cached_ns);
+  }
+  return EXIT_SUCCESS;
+}
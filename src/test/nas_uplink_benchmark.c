@@ -0,0 +1,217 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * NAS uplink path allocation benchmark: security protected Tracking Area
+ * Update Complete messages of an attached UE are handed to
+ * nas_proc_ul_transfer_ind() the way the MME_APP workers do with the buffer
+ * received from S1AP, integrity protected only (EEA0/EIA2) then ciphered
+ * (EEA2/EIA2). malloc(), calloc() and realloc() are interposed to count the
+ * heap allocations of the calling thread, the benchmark reports heap
+ * allocations per uplink NAS message and messages/s.
+ *
+ * usage: nas_uplink_benchmark mme.conf [nb_messages]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "intertask_interface_init.h"
+#include "common_defs.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.008.h"
+#include "3gpp_24.301.h"
+#include "3gpp_29.274.h"
+#include "mme_config.h"
+#include "mme_app_extern.h"
+#include "mme_app_ue_context.h"
+#include "mme_app_defs.h"
+#include "secu_defs.h"
+#include "emm_data.h"
+#include "nas_message.h"
+#include "nas_proc.h"
+#include "nas_defs.h"
+
+#define NAS_UPLINK_BENCHMARK_NB_MESSAGES      1000000
+#define NAS_UPLINK_BENCHMARK_MAX_LENGTH       128
+
+extern void                            *__libc_malloc (size_t size);
+extern void                            *__libc_calloc (size_t nmemb, size_t size);
+extern void                            *__libc_realloc (void *ptr, size_t size);
+
+static __thread uint64_t                nb_heap_allocations = 0;
+
+//------------------------------------------------------------------------------
+void *malloc (size_t size)
+{
+  nb_heap_allocations++;
+  return __libc_malloc (size);
+}
+
+//------------------------------------------------------------------------------
+void *calloc (size_t nmemb, size_t size)
+{
+  nb_heap_allocations++;
+  return __libc_calloc (nmemb, size);
+}
+
+//------------------------------------------------------------------------------
+void *realloc (void *ptr, size_t size)
+{
+  nb_heap_allocations++;
+  return __libc_realloc (ptr, size);
+}
+
+//------------------------------------------------------------------------------
+static void nas_uplink_benchmark_run (
+  const mme_ue_s1ap_id_t ue_id,
+  emm_security_context_t * const mme_security,
+  const uint8_t eea,
+  const uint64_t nb_messages)
+{
+  emm_security_context_t                  ue_security = *mme_security;
+  nas_message_t                           nas_msg = {.security_protected.header = {0},
+                                                     .security_protected.plain.emm.header = {0},
+                                                     .security_protected.plain.esm.header = {0}};
+  unsigned char                           buffer[NAS_UPLINK_BENCHMARK_MAX_LENGTH];
+  tai_t                                   tai = {.mcc_digit1 = 2, .mcc_digit2 = 0, .mcc_digit3 = 8,
+                                                 .mnc_digit1 = 9, .mnc_digit2 = 3, .mnc_digit3 = 0xF, .tac = 1};
+  ecgi_t                                  ecgi = {.plmn = {0}, .cell_identity = {0}};
+  uint64_t                                nb_allocations = 0;
+  uint64_t                                nb_failed = 0;
+  struct timespec                         start_time;
+  struct timespec                         end_time;
+  double                                  elapsed = 0;
+
+  mme_security->selected_algorithms.encryption = eea;
+  ue_security.selected_algorithms.encryption = eea;
+  // the UE side of the security context, encoding uplink messages
+  ue_security.direction_encode = SECU_DIRECTION_UPLINK;
+  memset (&ue_security.knas_enc_schedule, 0, sizeof (ue_security.knas_enc_schedule));
+  memset (&ue_security.knas_int_schedule, 0, sizeof (ue_security.knas_int_schedule));
+
+  nas_msg.header.protocol_discriminator = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  nas_msg.header.security_header_type = SECURITY_HEADER_TYPE_INTEGRITY_PROTECTED_CYPHERED;
+  nas_msg.security_protected.plain.emm.header.protocol_discriminator = EPS_MOBILITY_MANAGEMENT_MESSAGE;
+  nas_msg.security_protected.plain.emm.header.security_header_type = SECURITY_HEADER_TYPE_NOT_PROTECTED;
+  nas_msg.security_protected.plain.emm.header.message_type = TRACKING_AREA_UPDATE_COMPLETE;
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+
+  for (uint64_t i = 0; i < nb_messages; i++) {
+    ue_mm_context_t                        *ue_context_p = NULL;
+    bstring                                 nas_pdu = NULL;
+    uint64_t                                nb_allocations_before = 0;
+    int                                     length = 0;
+
+    nas_msg.header.sequence_number = ue_security.ul_count.seq_num;
+    if ((length = nas_message_encode (buffer, &nas_msg, sizeof (buffer), &ue_security)) <= 0) {
+      nb_failed++;
+      continue;
+    }
+    // the buffer S1AP hands over with NAS_UPLINK_DATA_IND
+    nas_pdu = blk2bstr (buffer, length);
+
+    nb_allocations_before = nb_heap_allocations;
+    ue_context_p = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue_id);
+    if (nas_proc_ul_transfer_ind (ue_id, tai, ecgi, &nas_pdu) != RETURNok) {
+      nb_failed++;
+    }
+    unlock_ue_contexts (ue_context_p);
+    nb_allocations += nb_heap_allocations - nb_allocations_before;
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  elapsed = (double)(end_time.tv_sec - start_time.tv_sec) + (double)(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+  fprintf (stdout, "  EEA%u/EIA2 uplink NAS: %6.2f heap allocations/message, %9.0f messages/s, %" PRIu64 " failed\n",
+      eea, (double)nb_allocations / nb_messages, nb_messages / elapsed, nb_failed);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  char                                   *config_argv[] = { argv[0], "-c", NULL, NULL };
+  uint64_t                                nb_messages = NAS_UPLINK_BENCHMARK_NB_MESSAGES;
+  ue_mm_context_t                        *ue_context_p = NULL;
+  emm_security_context_t                 *security = NULL;
+  mme_ue_s1ap_id_t                        ue_id = INVALID_MME_UE_S1AP_ID;
+
+  if (argc < 2) {
+    fprintf (stderr, "usage: %s mme.conf [nb_messages]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  config_argv[2] = argv[1];
+  if (argc > 2) {
+    nb_messages = strtoull (argv[2], NULL, 0);
+  }
+  if (nb_messages == 0) {
+    fprintf (stderr, "need 0 < nb_messages\n");
+    return EXIT_FAILURE;
+  }
+
+  shared_log_init (MAX_LOG_PROTOS);
+  OAILOG_INIT (LOG_MME_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS);
+  if (mme_config_parse_opt_line (3, config_argv, &mme_config) < 0) {
+    fprintf (stderr, "Failed to parse %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+  if ((nas_init (&mme_config) < 0) || (mme_app_init (&mme_config) < 0)) {
+    fprintf (stderr, "Failed to initialize NAS and MME_APP\n");
+    return EXIT_FAILURE;
+  }
+
+  // An attached UE, with the NAS security context the Security Mode Control procedure would set up
+  if ((ue_context_p = mme_create_new_ue_context ()) == NULL) {
+    fprintf (stderr, "Failed to create UE context\n");
+    return EXIT_FAILURE;
+  }
+  ue_id = mme_app_ctx_get_new_ue_id ();
+  ue_context_p->mme_ue_s1ap_id = ue_id;
+  ue_context_p->enb_ue_s1ap_id = 1;
+  MME_APP_ENB_S1AP_ID_KEY (ue_context_p->enb_s1ap_id_key, 1, 1);
+  if (mme_insert_ue_context (&mme_app_desc.mme_ue_contexts, ue_context_p) != RETURNok) {
+    fprintf (stderr, "Failed to insert UE context\n");
+    return EXIT_FAILURE;
+  }
+  security = &ue_context_p->emm_context._security;
+  emm_ctx_set_security_type (&ue_context_p->emm_context, SECURITY_CTX_TYPE_FULL_NATIVE);
+  memset (security->knas_enc, 0x2b, sizeof (security->knas_enc));
+  memset (security->knas_int, 0x7e, sizeof (security->knas_int));
+  security->selected_algorithms.integrity = NAS_SECURITY_ALGORITHMS_EIA2;
+  security->direction_encode = SECU_DIRECTION_DOWNLINK;
+  security->direction_decode = SECU_DIRECTION_UPLINK;
+  security->activated = 1;
+  emm_ctx_set_attribute_present (&ue_context_p->emm_context, EMM_CTXT_MEMBER_SECURITY);
+  unlock_ue_contexts (ue_context_p);
+
+  fprintf (stdout, "%" PRIu64 " Tracking Area Update Complete through nas_proc_ul_transfer_ind()\n", nb_messages);
+  nas_uplink_benchmark_run (ue_id, security, NAS_SECURITY_ALGORITHMS_EEA0, nb_messages);
+  nas_uplink_benchmark_run (ue_id, security, NAS_SECURITY_ALGORITHMS_EEA2, nb_messages);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,271 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * S1AP codec allocation benchmark: encodes and decodes InitialUEMessage,
+ * UplinkNASTransport and InitialContextSetupResponse PDUs with the asn1c
+ * allocations served by the C library, then by an arena reset after each
+ * PDU as the S1AP workers do. Reports the heap allocations per PDU and the
+ * PDUs per second.
+ *
+ * usage: s1ap_arena_benchmark [nb_pdus]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "arena.h"
+#include "dynamic_memory_check.h"
+#include "intertask_interface.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_decoder.h"
+
+#define S1AP_ARENA_BENCHMARK_NB_PDUS       (1 << 18)
+#define S1AP_ARENA_BENCHMARK_CHUNK_SIZE    (16 * 1024)
+
+typedef enum {
+  S1AP_ARENA_BENCHMARK_INITIAL_UE_MESSAGE = 0,
+  S1AP_ARENA_BENCHMARK_UPLINK_NAS_TRANSPORT,
+  S1AP_ARENA_BENCHMARK_INITIAL_CONTEXT_SETUP_RESPONSE,
+  S1AP_ARENA_BENCHMARK_MAX
+} s1ap_arena_benchmark_pdu_t;
+
+static const char * const               pdu_names[S1AP_ARENA_BENCHMARK_MAX] = {
+  "InitialUEMessage", "UplinkNASTransport", "InitialContextSetupResponse"
+};
+
+static uint8_t                          cell_id[] = { 0x03, 0x56, 0xf0, 0xd8 };
+static uint8_t                          plmn_identity[] = { 0x02, 0x08, 0x34 };
+static uint8_t                          tac[] = { 0x00, 0x01 };
+static uint8_t                          sgw_address[] = { 0x7f, 0x00, 0x00, 0x01 };
+static uint8_t                          enb_teid[] = { 0x00, 0x00, 0x00, 0x01 };
+
+static uint8_t                          attach_request[] = { 0x07, 0x42, 0x01, 0xE0, 0x06, 0x00, 0x00, 0xF1, 0x10, 0x00, 0x01, 0x00, 0x2C,
+  0x52, 0x01, 0xC1, 0x01, 0x09, 0x10, 0x03, 0x77, 0x77, 0x77, 0x07, 0x61, 0x6E, 0x72, 0x69, 0x74,
+  0x73, 0x75, 0x03, 0x63, 0x6F, 0x6D, 0x05, 0x01, 0x0A, 0x01, 0x20, 0x37, 0x27, 0x0E, 0x80, 0x80,
+  0x21, 0x0A, 0x03, 0x00, 0x00, 0x0A, 0x81, 0x06, 0x0A, 0x00, 0x00, 0x01, 0x50, 0x0B, 0xF6,
+  0x00, 0xF1, 0x10, 0x80, 0x01, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+// Authentication Response
+static uint8_t                          uplink_nas[] = { 0x07, 0x53, 0x08, 0x66, 0x39, 0x86, 0x8c, 0x4b, 0x3c, 0x2e, 0x04 };
+
+//------------------------------------------------------------------------------
+static int s1ap_arena_benchmark_encode (const s1ap_arena_benchmark_pdu_t pdu, uint8_t ** buffer, uint32_t * length)
+{
+  switch (pdu) {
+  case S1AP_ARENA_BENCHMARK_INITIAL_UE_MESSAGE:{
+      S1ap_InitialUEMessageIEs_t              ies;
+      S1ap_InitialUEMessage_t                 msg;
+
+      memset (&ies, 0, sizeof (ies));
+      memset (&msg, 0, sizeof (msg));
+      ies.eNB_UE_S1AP_ID = 1;
+      ies.nas_pdu.buf = attach_request;
+      ies.nas_pdu.size = sizeof (attach_request);
+      ies.tai.tAC.buf = tac;
+      ies.tai.tAC.size = sizeof (tac);
+      ies.tai.pLMNidentity.buf = plmn_identity;
+      ies.tai.pLMNidentity.size = sizeof (plmn_identity);
+      ies.eutran_cgi.pLMNidentity.buf = plmn_identity;
+      ies.eutran_cgi.pLMNidentity.size = sizeof (plmn_identity);
+      ies.eutran_cgi.cell_ID.buf = cell_id;
+      ies.eutran_cgi.cell_ID.size = sizeof (cell_id);
+      ies.eutran_cgi.cell_ID.bits_unused = 4;
+      ies.rrC_Establishment_Cause = S1ap_RRC_Establishment_Cause_mo_Data;
+      if (s1ap_encode_s1ap_initialuemessageies (&msg, &ies) < 0) {
+        return -1;
+      }
+      return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_initialUEMessage, S1ap_Criticality_ignore,
+                                               &asn_DEF_S1ap_InitialUEMessage, &msg);
+    }
+
+  case S1AP_ARENA_BENCHMARK_UPLINK_NAS_TRANSPORT:{
+      S1ap_UplinkNASTransportIEs_t            ies;
+      S1ap_UplinkNASTransport_t               msg;
+
+      memset (&ies, 0, sizeof (ies));
+      memset (&msg, 0, sizeof (msg));
+      ies.mme_ue_s1ap_id = 1;
+      ies.eNB_UE_S1AP_ID = 1;
+      ies.nas_pdu.buf = uplink_nas;
+      ies.nas_pdu.size = sizeof (uplink_nas);
+      ies.eutran_cgi.pLMNidentity.buf = plmn_identity;
+      ies.eutran_cgi.pLMNidentity.size = sizeof (plmn_identity);
+      ies.eutran_cgi.cell_ID.buf = cell_id;
+      ies.eutran_cgi.cell_ID.size = sizeof (cell_id);
+      ies.eutran_cgi.cell_ID.bits_unused = 4;
+      ies.tai.tAC.buf = tac;
+      ies.tai.tAC.size = sizeof (tac);
+      ies.tai.pLMNidentity.buf = plmn_identity;
+      ies.tai.pLMNidentity.size = sizeof (plmn_identity);
+      if (s1ap_encode_s1ap_uplinknastransporties (&msg, &ies) < 0) {
+        return -1;
+      }
+      return s1ap_generate_initiating_message (buffer, length, S1ap_ProcedureCode_id_uplinkNASTransport, S1ap_Criticality_ignore,
+                                               &asn_DEF_S1ap_UplinkNASTransport, &msg);
+    }
+
+  case S1AP_ARENA_BENCHMARK_INITIAL_CONTEXT_SETUP_RESPONSE:{
+      S1ap_InitialContextSetupResponseIEs_t   ies;
+      S1ap_InitialContextSetupResponse_t      msg;
+      S1ap_E_RABSetupItemCtxtSURes_t          item;
+      int                                     rc = 0;
+
+      memset (&ies, 0, sizeof (ies));
+      memset (&msg, 0, sizeof (msg));
+      memset (&item, 0, sizeof (item));
+      ies.mme_ue_s1ap_id = 1;
+      ies.eNB_UE_S1AP_ID = 1;
+      item.e_RAB_ID = 5;
+      item.transportLayerAddress.buf = sgw_address;
+      item.transportLayerAddress.size = sizeof (sgw_address);
+      item.gTP_TEID.buf = enb_teid;
+      item.gTP_TEID.size = sizeof (enb_teid);
+      ASN_SEQUENCE_ADD (&ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes, &item);
+      if (s1ap_encode_s1ap_initialcontextsetupresponseies (&msg, &ies) < 0) {
+        rc = -1;
+      } else {
+        rc = s1ap_generate_successfull_outcome (buffer, length, S1ap_ProcedureCode_id_InitialContextSetup, S1ap_Criticality_reject,
+                                                &asn_DEF_S1ap_InitialContextSetupResponse, &msg);
+      }
+      // the item is on the stack, only the list array has to go
+      ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes.count = 0;
+      FREEMEM (ies.e_RABSetupListCtxtSURes.s1ap_E_RABSetupItemCtxtSURes.array);
+      return rc;
+    }
+
+  default:
+    return -1;
+  }
+}
+
+//------------------------------------------------------------------------------
+static double s1ap_arena_benchmark_elapsed (const struct timespec * const start_time)
+{
+  struct timespec                         end_time;
+
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  return (double)(end_time.tv_sec - start_time->tv_sec) + (double)(end_time.tv_nsec - start_time->tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_arena_benchmark_run (const s1ap_arena_benchmark_pdu_t pdu, const uint64_t nb_pdus, arena_t * const arena)
+{
+  struct timespec                         start_time;
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  bstring                                 raw = NULL;
+  s1ap_message                            message = {0};
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  uint64_t                                nb_heap_allocations = 0;
+  uint64_t                                nb_chunk_allocations = 0;
+  double                                  elapsed = 0;
+  uint64_t                                i = 0;
+
+  s1ap_asn_arena = arena;
+
+  // encode
+  nb_heap_allocations = s1ap_asn_nb_heap_allocations;
+  nb_chunk_allocations = (arena) ? arena->nb_chunk_allocations : 0;
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_pdus; i++) {
+    if (s1ap_arena_benchmark_encode (pdu, &buffer, &length) < 0) {
+      fprintf (stderr, "Failed to encode %s\n", pdu_names[pdu]);
+      exit (EXIT_FAILURE);
+    }
+    if (i < nb_pdus - 1) {
+      free_wrapper ((void**)&buffer);
+    }
+    if (arena) {
+      arena_reset (arena);
+    }
+  }
+  elapsed = s1ap_arena_benchmark_elapsed (&start_time);
+  nb_heap_allocations = s1ap_asn_nb_heap_allocations - nb_heap_allocations;
+  nb_chunk_allocations = ((arena) ? arena->nb_chunk_allocations : 0) - nb_chunk_allocations;
+  fprintf (stdout, "  %-28s %-5s encode: %6.2f heap allocations/PDU (%" PRIu64 " arena chunks), %9.0f PDUs/s\n",
+      pdu_names[pdu], (arena) ? "arena" : "heap", (double)nb_heap_allocations / nb_pdus, nb_chunk_allocations, nb_pdus / elapsed);
+
+  // decode, the encoded buffer of the last round is decoded over and over
+  raw = blk2bstr (buffer, length);
+  free_wrapper ((void**)&buffer);
+  nb_heap_allocations = s1ap_asn_nb_heap_allocations;
+  nb_chunk_allocations = (arena) ? arena->nb_chunk_allocations : 0;
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_pdus; i++) {
+    memset (&message, 0, sizeof (message));
+    message_id = MESSAGES_ID_MAX;
+    if (s1ap_mme_decode_pdu (&message, raw, &message_id) < 0) {
+      fprintf (stderr, "Failed to decode %s\n", pdu_names[pdu]);
+      exit (EXIT_FAILURE);
+    }
+    s1ap_free_mme_decode_pdu (&message, message_id);
+    if (arena) {
+      arena_reset (arena);
+    }
+  }
+  elapsed = s1ap_arena_benchmark_elapsed (&start_time);
+  nb_heap_allocations = s1ap_asn_nb_heap_allocations - nb_heap_allocations;
+  nb_chunk_allocations = ((arena) ? arena->nb_chunk_allocations : 0) - nb_chunk_allocations;
+  fprintf (stdout, "  %-28s %-5s decode: %6.2f heap allocations/PDU (%" PRIu64 " arena chunks), %9.0f PDUs/s\n",
+      pdu_names[pdu], (arena) ? "arena" : "heap", (double)nb_heap_allocations / nb_pdus, nb_chunk_allocations, nb_pdus / elapsed);
+  bdestroy (raw);
+
+  s1ap_asn_arena = NULL;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint64_t                                nb_pdus = S1AP_ARENA_BENCHMARK_NB_PDUS;
+  arena_t                                *arena = NULL;
+  s1ap_arena_benchmark_pdu_t              pdu = S1AP_ARENA_BENCHMARK_INITIAL_UE_MESSAGE;
+
+  if (argc > 1) {
+    nb_pdus = strtoull (argv[1], NULL, 0);
+  }
+  if (nb_pdus == 0) {
+    fprintf (stderr, "need nb_pdus > 0\n");
+    return EXIT_FAILURE;
+  }
+
+  if ((arena = arena_create ("s1ap_arena_benchmark", S1AP_ARENA_BENCHMARK_CHUNK_SIZE)) == NULL) {
+    fprintf (stderr, "Cannot create arena\n");
+    return EXIT_FAILURE;
+  }
+
+  fprintf (stdout, "S1AP codec, %" PRIu64 " PDUs per run\n", nb_pdus);
+  for (pdu = S1AP_ARENA_BENCHMARK_INITIAL_UE_MESSAGE; pdu < S1AP_ARENA_BENCHMARK_MAX; pdu++) {
+    s1ap_arena_benchmark_run (pdu, nb_pdus, NULL);
+    s1ap_arena_benchmark_run (pdu, nb_pdus, arena);
+  }
+  fprintf (stdout, "arena footprint %zu kB\n", arena_get_memory_size (arena) >> 10);
+  arena_destroy (&arena);
+  return EXIT_SUCCESS;
+}
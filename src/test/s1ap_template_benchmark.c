@@ -0,0 +1,190 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * S1AP template encoder benchmark: DownlinkNASTransport and
+ * UEContextReleaseCommand PDUs are encoded by asn1c and by the fast path
+ * templates, the encodings are compared byte for byte then both encoders are
+ * timed.
+ *
+ * usage: s1ap_template_benchmark [nb_pdus]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "intertask_interface.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme.h"
+#include "s1ap_mme_encoder.h"
+#include "s1ap_mme_fast_codec.h"
+#include "s1ap_mme_handlers.h"
+
+#define S1AP_TEMPLATE_BENCHMARK_NB_PDUS    (1 << 20)
+#define S1AP_TEMPLATE_BENCHMARK_NB_CHECKS  10000
+
+typedef enum {
+  S1AP_TEMPLATE_BENCHMARK_DOWNLINK_NAS_TRANSPORT = 0,
+  S1AP_TEMPLATE_BENCHMARK_UE_CONTEXT_RELEASE_COMMAND,
+  S1AP_TEMPLATE_BENCHMARK_MAX
+} s1ap_template_benchmark_pdu_t;
+
+static const char * const               pdu_names[S1AP_TEMPLATE_BENCHMARK_MAX] = {
+  "DownlinkNASTransport", "UEContextReleaseCommand"
+};
+
+// Security Mode Command
+static uint8_t                          downlink_nas[] = { 0x37, 0x4b, 0x5c, 0x8e, 0x16, 0x00, 0x07, 0x5d, 0x02, 0x01, 0x02, 0xe0, 0xe0 };
+
+//------------------------------------------------------------------------------
+static bstring s1ap_template_benchmark_encode_asn1c (const s1ap_template_benchmark_pdu_t pdu, const mme_ue_s1ap_id_t mme_ue_s1ap_id,
+    const enb_ue_s1ap_id_t enb_ue_s1ap_id, const_bstring const nas_pdu)
+{
+  s1ap_message                            message = {0};
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  bstring                                 b = NULL;
+
+  message.direction = S1AP_PDU_PR_initiatingMessage;
+  if (pdu == S1AP_TEMPLATE_BENCHMARK_DOWNLINK_NAS_TRANSPORT) {
+    message.procedureCode = S1ap_ProcedureCode_id_downlinkNASTransport;
+    message.msg.s1ap_DownlinkNASTransportIEs.mme_ue_s1ap_id = mme_ue_s1ap_id;
+    message.msg.s1ap_DownlinkNASTransportIEs.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+    OCTET_STRING_fromBuf (&message.msg.s1ap_DownlinkNASTransportIEs.nas_pdu, (char *)bdata (nas_pdu), blength (nas_pdu));
+  } else {
+    message.procedureCode = S1ap_ProcedureCode_id_UEContextRelease;
+    message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.present = S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair;
+    message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.choice.uE_S1AP_ID_pair.mME_UE_S1AP_ID = mme_ue_s1ap_id;
+    message.msg.s1ap_UEContextReleaseCommandIEs.uE_S1AP_IDs.choice.uE_S1AP_ID_pair.eNB_UE_S1AP_ID = enb_ue_s1ap_id;
+    s1ap_mme_set_cause (&message.msg.s1ap_UEContextReleaseCommandIEs.cause, S1ap_Cause_PR_nas, S1ap_CauseNas_detach);
+  }
+  if (s1ap_mme_encode_pdu (&message, &buffer, &length) < 0) {
+    fprintf (stderr, "Failed to encode %s with asn1c\n", pdu_names[pdu]);
+    exit (EXIT_FAILURE);
+  }
+  if (pdu == S1AP_TEMPLATE_BENCHMARK_DOWNLINK_NAS_TRANSPORT) {
+    FREEMEM (message.msg.s1ap_DownlinkNASTransportIEs.nas_pdu.buf);
+  }
+  // as s1ap_generate_downlink_nas_transport() does before sending
+  b = blk2bstr (buffer, length);
+  free_wrapper ((void**)&buffer);
+  return b;
+}
+
+//------------------------------------------------------------------------------
+static bstring s1ap_template_benchmark_encode_template (const s1ap_template_benchmark_pdu_t pdu, const mme_ue_s1ap_id_t mme_ue_s1ap_id,
+    const enb_ue_s1ap_id_t enb_ue_s1ap_id, const_bstring const nas_pdu)
+{
+  bstring                                 b = NULL;
+  int                                     rc = RETURNerror;
+
+  if (pdu == S1AP_TEMPLATE_BENCHMARK_DOWNLINK_NAS_TRANSPORT) {
+    rc = s1ap_mme_fast_encode_downlink_nas_transport (mme_ue_s1ap_id, enb_ue_s1ap_id, nas_pdu, &b);
+  } else {
+    rc = s1ap_mme_fast_encode_ue_context_release_command (mme_ue_s1ap_id, enb_ue_s1ap_id, S1ap_Cause_PR_nas, S1ap_CauseNas_detach, &b);
+  }
+  if (rc != RETURNok) {
+    fprintf (stderr, "Failed to encode %s with the template\n", pdu_names[pdu]);
+    exit (EXIT_FAILURE);
+  }
+  return b;
+}
+
+//------------------------------------------------------------------------------
+static double s1ap_template_benchmark_elapsed (const struct timespec * const start_time)
+{
+  struct timespec                         end_time;
+
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  return (double)(end_time.tv_sec - start_time->tv_sec) + (double)(end_time.tv_nsec - start_time->tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+static double s1ap_template_benchmark_run (const s1ap_template_benchmark_pdu_t pdu, const uint64_t nb_pdus, const bool template,
+    const_bstring const nas_pdu)
+{
+  struct timespec                         start_time;
+  bstring                                 b = NULL;
+  uint64_t                                i = 0;
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_pdus; i++) {
+    if (template) {
+      b = s1ap_template_benchmark_encode_template (pdu, (mme_ue_s1ap_id_t)i, (enb_ue_s1ap_id_t)(i & 0x00ffffff), nas_pdu);
+    } else {
+      b = s1ap_template_benchmark_encode_asn1c (pdu, (mme_ue_s1ap_id_t)i, (enb_ue_s1ap_id_t)(i & 0x00ffffff), nas_pdu);
+    }
+    bdestroy (b);
+  }
+  return nb_pdus / s1ap_template_benchmark_elapsed (&start_time);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint64_t                                nb_pdus = S1AP_TEMPLATE_BENCHMARK_NB_PDUS;
+  bstring                                 nas_pdu = NULL;
+  bstring                                 b1 = NULL;
+  bstring                                 b2 = NULL;
+  double                                  asn1c_rate = 0;
+  double                                  template_rate = 0;
+  mme_ue_s1ap_id_t                        mme_ue_s1ap_id = 0;
+  enb_ue_s1ap_id_t                        enb_ue_s1ap_id = 0;
+  uint32_t                                i = 0;
+  int                                     pdu = 0;
+
+  if (argc > 1) {
+    nb_pdus = strtoull (argv[1], NULL, 0);
+  }
+
+  nas_pdu = blk2bstr (downlink_nas, sizeof (downlink_nas));
+  srandom (1);
+  for (pdu = 0; pdu < S1AP_TEMPLATE_BENCHMARK_MAX; pdu++) {
+    // byte for byte check over the whole id ranges
+    for (i = 0; i < S1AP_TEMPLATE_BENCHMARK_NB_CHECKS; i++) {
+      mme_ue_s1ap_id = (mme_ue_s1ap_id_t)((uint32_t)random () >> (random () % 32));
+      enb_ue_s1ap_id = (enb_ue_s1ap_id_t)(((uint32_t)random () & 0x00ffffff) >> (random () % 24));
+      b1 = s1ap_template_benchmark_encode_asn1c (pdu, mme_ue_s1ap_id, enb_ue_s1ap_id, nas_pdu);
+      b2 = s1ap_template_benchmark_encode_template (pdu, mme_ue_s1ap_id, enb_ue_s1ap_id, nas_pdu);
+      if (biseq (b1, b2) != 1) {
+        fprintf (stderr, "%s template encoding differs from asn1c for mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT " enb_ue_s1ap_id " ENB_UE_S1AP_ID_FMT "\n",
+            pdu_names[pdu], mme_ue_s1ap_id, enb_ue_s1ap_id);
+        return EXIT_FAILURE;
+      }
+      bdestroy (b1);
+      bdestroy (b2);
+    }
+
+    asn1c_rate = s1ap_template_benchmark_run (pdu, nb_pdus, false, nas_pdu);
+    template_rate = s1ap_template_benchmark_run (pdu, nb_pdus, true, nas_pdu);
+    fprintf (stdout, "  %-24s asn1c %9.0f PDUs/s, template %9.0f PDUs/s, x%.1f (%u PDUs identical)\n",
+        pdu_names[pdu], asn1c_rate, template_rate, template_rate / asn1c_rate, S1AP_TEMPLATE_BENCHMARK_NB_CHECKS);
+  }
+  bdestroy (nas_pdu);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * S1AP eNB/UE memory benchmark: registers nb_enbs eNBs serving
+ * nb_ues_per_enb UEs each, as in a dense small cell deployment, and reports
+ * the resident memory growth. For comparison the footprint of one chained
+ * hashtable_ts_t sized for max_ues, the former per eNB UE collection, is
+ * measured and extrapolated to nb_enbs eNBs.
+ *
+ * usage: s1ap_ue_memory_benchmark [nb_enbs] [nb_ues_per_enb] [max_ues]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "hashtable.h"
+#include "mme_config.h"
+#include "s1ap_mme.h"
+#include "slab.h"
+
+#define S1AP_MEMORY_BENCHMARK_NB_ENBS          1000
+#define S1AP_MEMORY_BENCHMARK_NB_UES_PER_ENB   8
+#define S1AP_MEMORY_BENCHMARK_MAX_UES          100000
+
+extern hash_table_ts_t g_s1ap_enb_coll;
+extern hash_table_ts_t g_s1ap_mme_id2assoc_id_coll;
+extern hash_table_ts_t g_s1ap_ue_mme_id_coll;
+extern hash_table_ts_t g_s1ap_ue_s11_teid_coll;
+extern slab_t         *g_s1ap_ue_slab;
+
+//------------------------------------------------------------------------------
+static size_t s1ap_memory_benchmark_rss (void)
+{
+  FILE                                   *fp = NULL;
+  unsigned long                           size = 0;
+  unsigned long                           resident = 0;
+
+  if ((fp = fopen ("/proc/self/statm", "r")) == NULL) {
+    return 0;
+  }
+  if (fscanf (fp, "%lu %lu", &size, &resident) != 2) {
+    resident = 0;
+  }
+  fclose (fp);
+  return (size_t)resident * (size_t)sysconf (_SC_PAGESIZE);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint32_t                                nb_enbs = S1AP_MEMORY_BENCHMARK_NB_ENBS;
+  uint32_t                                nb_ues_per_enb = S1AP_MEMORY_BENCHMARK_NB_UES_PER_ENB;
+  uint32_t                                max_ues = S1AP_MEMORY_BENCHMARK_MAX_UES;
+  enb_description_t                      *enb_ref = NULL;
+  ue_description_t                       *ue_ref = NULL;
+  hash_table_ts_t                         legacy_coll = {0};
+  size_t                                  rss_start = 0;
+  size_t                                  rss_enbs = 0;
+  size_t                                  rss_legacy = 0;
+  uint32_t                                i = 0;
+  uint32_t                                j = 0;
+  bstring                                 bs = NULL;
+
+  if (argc > 1) {
+    nb_enbs = strtoul (argv[1], NULL, 0);
+
+    if (argc > 2) {
+      nb_ues_per_enb = strtoul (argv[2], NULL, 0);
+
+      if (argc > 3) {
+        max_ues = strtoul (argv[3], NULL, 0);
+      }
+    }
+  }
+
+  if ((nb_enbs == 0) || ((uint64_t)nb_enbs * nb_ues_per_enb > max_ues)) {
+    fprintf (stderr, "need 0 < nb_enbs and nb_enbs * nb_ues_per_enb <= max_ues\n");
+    return EXIT_FAILURE;
+  }
+
+  mme_config.max_enbs = nb_enbs;
+  mme_config.max_ues = max_ues;
+  bs = bfromcstr ("benchmark_s1ap_eNB_coll");
+  hashtable_ts_init (&g_s1ap_enb_coll, nb_enbs, NULL, free_wrapper, bs);
+  btrunc (bs, 0);
+  bcatcstr (bs, "benchmark_s1ap_mme_id2assoc_id_coll");
+  hashtable_ts_init (&g_s1ap_mme_id2assoc_id_coll, max_ues, NULL, hash_free_int_func, bs);
+  btrunc (bs, 0);
+  bcatcstr (bs, "benchmark_s1ap_ue_mme_id_coll");
+  hashtable_ts_init (&g_s1ap_ue_mme_id_coll, max_ues, NULL, hash_free_int_func, bs);
+  btrunc (bs, 0);
+  bcatcstr (bs, "benchmark_s1ap_ue_s11_teid_coll");
+  hashtable_ts_init (&g_s1ap_ue_s11_teid_coll, max_ues, NULL, hash_free_int_func, bs);
+  g_s1ap_ue_slab = slab_create ("benchmark_s1ap_ue_slab", sizeof (ue_description_t), 1024);
+  if (!g_s1ap_ue_slab) {
+    fprintf (stderr, "Cannot create UE slab\n");
+    return EXIT_FAILURE;
+  }
+
+  rss_start = s1ap_memory_benchmark_rss ();
+
+  for (i = 0; i < nb_enbs; i++) {
+    enb_ref = s1ap_new_enb ();
+    enb_ref->sctp_assoc_id = i + 1;
+    enb_ref->enb_id = i + 1;
+    enb_ref->s1_state = S1AP_READY;
+    hashtable_ts_insert (&g_s1ap_enb_coll, (const hash_key_t)enb_ref->sctp_assoc_id, (void *)enb_ref);
+
+    for (j = 0; j < nb_ues_per_enb; j++) {
+      ue_ref = s1ap_new_ue (enb_ref->sctp_assoc_id, j);
+      ue_ref->s1ap_ue_context_rel_timer.id = S1AP_TIMER_INACTIVE_ID;
+      s1ap_notified_new_ue_mme_s1ap_id_association (enb_ref->sctp_assoc_id, j, i * nb_ues_per_enb + j + 1);
+    }
+  }
+
+  rss_enbs = s1ap_memory_benchmark_rss ();
+
+  btrunc (bs, 0);
+  bcatcstr (bs, "benchmark_legacy_ue_coll");
+  hashtable_ts_init (&legacy_coll, max_ues, NULL, free_wrapper, bs);
+  rss_legacy = s1ap_memory_benchmark_rss () - rss_enbs;
+  hashtable_ts_destroy (&legacy_coll);
+  bdestroy (bs);
+
+  fprintf (stdout, "%u eNBs, %u UEs per eNB, max_ues %u\n", nb_enbs, nb_ues_per_enb, max_ues);
+  fprintf (stdout, "  eNB and UE descriptors:          %10zu kB RSS (%zu kB in UE slab)\n",
+      (rss_enbs - rss_start) >> 10, slab_get_memory_size (g_s1ap_ue_slab) >> 10);
+  fprintf (stdout, "  max_ues sized UE collections:    %10zu kB RSS for one eNB, %zu MB for %u eNBs\n",
+      rss_legacy >> 10, (rss_legacy * nb_enbs) >> 20, nb_enbs);
+
+  for (i = 0; i < nb_enbs; i++) {
+    s1ap_remove_enb (s1ap_is_enb_assoc_id_in_list (i + 1));
+  }
+  hashtable_ts_destroy (&g_s1ap_enb_coll);
+  hashtable_ts_destroy (&g_s1ap_mme_id2assoc_id_coll);
+  hashtable_ts_destroy (&g_s1ap_ue_mme_id_coll);
+  hashtable_ts_destroy (&g_s1ap_ue_s11_teid_coll);
+  slab_destroy (&g_s1ap_ue_slab);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * S1AP worker scaling benchmark: the main thread plays nb_enbs eNBs (one SCTP
+ * association each) and feeds TASK_S1AP with one InitialUEMessage per UE, as
+ * oaisim_mme_list_benchmark does over SCTP, but in process through ITTI so
+ * that only the S1AP decode and handling cost is measured. The S1AP task
+ * dispatches the PDUs to nb_workers workers, TASK_MME_APP is a sink counting
+ * the S1AP_INITIAL_UE_MESSAGE it receives.
+ *
+ * usage: s1ap_worker_benchmark [nb_workers] [nb_enbs] [nb_ues_per_enb]
+ *   for w in 1 2 4 8; do s1ap_worker_benchmark $w; done
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+
+#include "bstrlib.h"
+#include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
+#include "dynamic_memory_check.h"
+#include "mme_config.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme.h"
+
+#define S1AP_WORKER_BENCHMARK_NB_ENBS          64
+#define S1AP_WORKER_BENCHMARK_NB_UES_PER_ENB   1000
+#define S1AP_WORKER_BENCHMARK_WINDOW           128
+#define S1AP_WORKER_BENCHMARK_MAX_BATCH        64
+
+static uint8_t                          cell_id[] = { 0x03, 0x56, 0xf0, 0xd8 };
+static uint8_t                          plmn_identity[] = { 0x02, 0x08, 0x34 };
+static uint8_t                          tac[] = { 0x00, 0x01 };
+
+static uint8_t                          attach_request[] = { 0x07, 0x42, 0x01, 0xE0, 0x06, 0x00, 0x00, 0xF1, 0x10, 0x00, 0x01, 0x00, 0x2C,
+  0x52, 0x01, 0xC1, 0x01, 0x09, 0x10, 0x03, 0x77, 0x77, 0x77, 0x07, 0x61, 0x6E, 0x72, 0x69, 0x74,
+  0x73, 0x75, 0x03, 0x63, 0x6F, 0x6D, 0x05, 0x01, 0x0A, 0x01, 0x20, 0x37, 0x27, 0x0E, 0x80, 0x80,
+  0x21, 0x0A, 0x03, 0x00, 0x00, 0x0A, 0x81, 0x06, 0x0A, 0x00, 0x00, 0x01, 0x50, 0x0B, 0xF6,
+  0x00, 0xF1, 0x10, 0x80, 0x01, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static volatile bool                    s1ap_ready = false;
+static volatile uint64_t                nb_received = 0;
+static struct timespec                  end_time;
+
+//------------------------------------------------------------------------------
+// TASK_SCTP stub, S1AP sends SCTP_INIT_MSG once its workers are ready
+static void *s1ap_worker_benchmark_sctp_task (__attribute__ ((unused)) void *args_p)
+{
+  MessageDef                             *received_message_p = NULL;
+
+  itti_mark_task_ready (TASK_SCTP);
+
+  while (1) {
+    itti_receive_msg (TASK_SCTP, &received_message_p);
+    if (ITTI_MSG_ID (received_message_p) == SCTP_INIT_MSG) {
+      s1ap_ready = true;
+    }
+    itti_free_msg_content (received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+// TASK_MME_APP stub, counts the UEs S1AP reported
+static void *s1ap_worker_benchmark_mme_app_task (__attribute__ ((unused)) void *args_p)
+{
+  MessageDef                             *received_msgs[S1AP_WORKER_BENCHMARK_MAX_BATCH];
+  int                                     nb_msgs = 0;
+  int                                     i = 0;
+
+  itti_mark_task_ready (TASK_MME_APP);
+
+  while (1) {
+    nb_msgs = itti_receive_msgs (TASK_MME_APP, received_msgs, S1AP_WORKER_BENCHMARK_MAX_BATCH);
+
+    for (i = 0; i < nb_msgs; i++) {
+      if (ITTI_MSG_ID (received_msgs[i]) == S1AP_INITIAL_UE_MESSAGE) {
+        bdestroy_wrapper (&S1AP_INITIAL_UE_MESSAGE (received_msgs[i]).nas);
+        nb_received++;
+        clock_gettime (CLOCK_MONOTONIC, &end_time);
+      }
+      itti_free (ITTI_MSG_ORIGIN_ID (received_msgs[i]), received_msgs[i]);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static bstring s1ap_worker_benchmark_initial_ue_message (const enb_ue_s1ap_id_t enb_ue_s1ap_id)
+{
+  S1ap_InitialUEMessageIEs_t              initialUEMessageIEs;
+  S1ap_InitialUEMessage_t                 initialUEMessage;
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  bstring                                 pdu = NULL;
+
+  memset (&initialUEMessageIEs, 0, sizeof (initialUEMessageIEs));
+  memset (&initialUEMessage, 0, sizeof (initialUEMessage));
+  initialUEMessageIEs.eNB_UE_S1AP_ID = enb_ue_s1ap_id & 0x00ffffff;
+  initialUEMessageIEs.nas_pdu.buf = attach_request;
+  initialUEMessageIEs.nas_pdu.size = sizeof (attach_request);
+  initialUEMessageIEs.tai.tAC.buf = tac;
+  initialUEMessageIEs.tai.tAC.size = sizeof (tac);
+  initialUEMessageIEs.tai.pLMNidentity.buf = plmn_identity;
+  initialUEMessageIEs.tai.pLMNidentity.size = sizeof (plmn_identity);
+  initialUEMessageIEs.eutran_cgi.pLMNidentity.buf = plmn_identity;
+  initialUEMessageIEs.eutran_cgi.pLMNidentity.size = sizeof (plmn_identity);
+  initialUEMessageIEs.eutran_cgi.cell_ID.buf = cell_id;
+  initialUEMessageIEs.eutran_cgi.cell_ID.size = sizeof (cell_id);
+  initialUEMessageIEs.eutran_cgi.cell_ID.bits_unused = 4;
+  initialUEMessageIEs.rrC_Establishment_Cause = S1ap_RRC_Establishment_Cause_mo_Data;
+
+  if ((s1ap_encode_s1ap_initialuemessageies (&initialUEMessage, &initialUEMessageIEs) < 0) ||
+      (s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_initialUEMessage, S1ap_Criticality_ignore,
+                                         &asn_DEF_S1ap_InitialUEMessage, &initialUEMessage) < 0)) {
+    return NULL;
+  }
+  pdu = blk2bstr (buffer, length);
+  free_wrapper ((void**)&buffer);
+  return pdu;
+}
+
+//------------------------------------------------------------------------------
+static void s1ap_worker_benchmark_send (const task_id_t origin, MessageDef * const message_p)
+{
+  MessageDef                             *retry_p = message_p;
+  MessageDef                              copy = *message_p;
+  bstring                                 saved = (ITTI_MSG_ID (message_p) == SCTP_DATA_IND) ? bstrcpy (SCTP_DATA_IND (message_p).payload) : NULL;
+
+  // on queue full ITTI releases the message with its content, resend a copy
+  while (itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, retry_p) < 0) {
+    sched_yield ();
+    retry_p = itti_alloc_new_message (origin, ITTI_MSG_ID (&copy));
+    retry_p->ittiMsg = copy.ittiMsg;
+    if (saved) {
+      SCTP_DATA_IND (retry_p).payload = bstrcpy (saved);
+    }
+  }
+  bdestroy_wrapper (&saved);
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint32_t                                nb_workers = 1;
+  uint32_t                                nb_enbs = S1AP_WORKER_BENCHMARK_NB_ENBS;
+  uint32_t                                nb_ues_per_enb = S1AP_WORKER_BENCHMARK_NB_UES_PER_ENB;
+  uint64_t                                nb_ues = 0;
+  uint64_t                                nb_sent = 0;
+  bstring                                *pdus = NULL;
+  MessageDef                             *message_p = NULL;
+  struct timespec                         start_time;
+  double                                  elapsed = 0;
+  uint32_t                                i = 0;
+  uint32_t                                j = 0;
+
+  if (argc > 1) {
+    nb_workers = strtoul (argv[1], NULL, 0);
+
+    if (argc > 2) {
+      nb_enbs = strtoul (argv[2], NULL, 0);
+
+      if (argc > 3) {
+        nb_ues_per_enb = strtoul (argv[3], NULL, 0);
+      }
+    }
+  }
+
+  if ((nb_workers == 0) || (nb_workers > S1AP_NB_WORKERS_MAX) || (nb_enbs == 0) || (nb_ues_per_enb == 0)) {
+    fprintf (stderr, "need 0 < nb_workers <= %d, 0 < nb_enbs and 0 < nb_ues_per_enb\n", S1AP_NB_WORKERS_MAX);
+    return EXIT_FAILURE;
+  }
+  nb_ues = (uint64_t)nb_enbs * nb_ues_per_enb;
+
+  // eNB UE S1AP ids are per eNB, one PDU per UE of an eNB serves every eNB
+  pdus = calloc (nb_ues_per_enb, sizeof (bstring));
+  for (j = 0; j < nb_ues_per_enb; j++) {
+    if ((pdus[j] = s1ap_worker_benchmark_initial_ue_message (j)) == NULL) {
+      fprintf (stderr, "Failed to encode InitialUEMessage\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  mme_config.max_enbs = nb_enbs;
+  mme_config.max_ues = nb_ues;
+  mme_config.s1ap_config.nb_workers = nb_workers;
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+
+  if ((itti_create_task (TASK_SCTP, &s1ap_worker_benchmark_sctp_task, NULL) < 0) ||
+      (itti_create_task (TASK_MME_APP, &s1ap_worker_benchmark_mme_app_task, NULL) < 0)) {
+    fprintf (stderr, "Failed to create stub tasks\n");
+    return EXIT_FAILURE;
+  }
+  if (s1ap_mme_init () < 0) {
+    fprintf (stderr, "Failed to initialize S1AP\n");
+    return EXIT_FAILURE;
+  }
+  while (!s1ap_ready) {
+    sched_yield ();
+  }
+
+  for (i = 0; i < nb_enbs; i++) {
+    message_p = itti_alloc_new_message (TASK_SCTP, SCTP_NEW_ASSOCIATION);
+    SCTP_NEW_ASSOCIATION (message_p).assoc_id = i + 1;
+    SCTP_NEW_ASSOCIATION (message_p).instreams = 32;
+    SCTP_NEW_ASSOCIATION (message_p).outstreams = 32;
+    s1ap_worker_benchmark_send (TASK_SCTP, message_p);
+  }
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+
+  // UEs of the eNBs attach interleaved, as they would over SCTP
+  for (j = 0; j < nb_ues_per_enb; j++) {
+    for (i = 0; i < nb_enbs; i++) {
+      while (nb_sent - nb_received >= S1AP_WORKER_BENCHMARK_WINDOW) {
+        sched_yield ();
+      }
+      message_p = itti_alloc_new_message (TASK_SCTP, SCTP_DATA_IND);
+      SCTP_DATA_IND (message_p).payload = bstrcpy (pdus[j]);
+      SCTP_DATA_IND (message_p).assoc_id = i + 1;
+      SCTP_DATA_IND (message_p).stream = 1;
+      SCTP_DATA_IND (message_p).instreams = 32;
+      SCTP_DATA_IND (message_p).outstreams = 32;
+      s1ap_worker_benchmark_send (TASK_SCTP, message_p);
+      nb_sent++;
+    }
+  }
+
+  while (nb_received < nb_ues) {
+    sched_yield ();
+  }
+
+  elapsed = (double)(end_time.tv_sec - start_time.tv_sec) + (double)(end_time.tv_nsec - start_time.tv_nsec) / 1e9;
+  fprintf (stdout, "S1AP %u workers: %u eNBs, %" PRIu64 " InitialUEMessage in %.3f s, %.0f msgs/s\n",
+      nb_workers, nb_enbs, nb_ues, elapsed, (double)nb_ues / elapsed);
+
+  for (j = 0; j < nb_ues_per_enb; j++) {
+    bdestroy (pdus[j]);
+  }
+  free_wrapper ((void**)&pdus);
+  return EXIT_SUCCESS;
+}
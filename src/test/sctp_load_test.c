@@ -0,0 +1,362 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * SCTP server load test: N simulated eNBs connect over loopback SCTP to the
+ * TASK_SCTP server, each one sends nb_messages S1AP sized payloads, the main
+ * thread acting as TASK_S1AP counts the new associations, the data
+ * indications and the association releases. Then nb_messages SCTP_DATA_REQs
+ * per eNB are queued to TASK_SCTP, as during paging, and read back by the
+ * eNBs.
+ *
+ * usage: sctp_load_test [nb_enbs] [nb_messages_per_enb] [one_to_many]
+ *   one_to_many 1 makes the server use a single SOCK_SEQPACKET socket.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/sctp.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "shared_ts_log.h"
+#include "intertask_interface_init.h"
+#include "itti_free_defined_msg.h"
+#include "sctp_primitives_server.h"
+
+#define SCTP_LOAD_TEST_PORT          36412
+#define SCTP_LOAD_TEST_PPID          18
+#define SCTP_LOAD_TEST_STREAMS       8
+#define SCTP_LOAD_TEST_PAYLOAD_SIZE  96
+#define SCTP_LOAD_TEST_TIMEOUT_SEC   30
+#define SCTP_LOAD_TEST_MAX_BATCH     64
+
+static uint32_t                         nb_enbs = 128;
+static uint32_t                         nb_messages = 1000;
+static volatile uint64_t                nb_associations = 0;
+static volatile uint64_t                nb_data_ind = 0;
+static volatile uint64_t                nb_releases = 0;
+static volatile uint64_t                nb_bytes = 0;
+static volatile uint64_t                nb_data_cnf_failures = 0;
+static sctp_assoc_id_t                 *assoc_ids = NULL;
+static volatile uint32_t                nb_assoc_ids = 0;
+
+//------------------------------------------------------------------------------
+// The test does not link the whole MME, release only the messages TASK_SCTP emits.
+void itti_free_msg_content (MessageDef * const message_p)
+{
+  switch (ITTI_MSG_ID (message_p)) {
+  case SCTP_DATA_REQ:
+    bdestroy_wrapper (&message_p->ittiMsg.sctp_data_req.payload);
+    break;
+
+  case SCTP_DATA_IND:
+    bdestroy_wrapper (&message_p->ittiMsg.sctp_data_ind.payload);
+    break;
+
+  default:
+    ;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void *sctp_load_test_s1ap_task (__attribute__ ((unused)) void *args_p)
+{
+  MessageDef                             *received_msgs[SCTP_LOAD_TEST_MAX_BATCH];
+  int                                     nb_msgs = 0;
+  int                                     i = 0;
+
+  itti_mark_task_ready (TASK_S1AP);
+
+  while (1) {
+    nb_msgs = itti_receive_msgs (TASK_S1AP, received_msgs, SCTP_LOAD_TEST_MAX_BATCH);
+
+    for (i = 0; i < nb_msgs; i++) {
+      switch (ITTI_MSG_ID (received_msgs[i])) {
+      case SCTP_NEW_ASSOCIATION:
+        if (nb_assoc_ids < nb_enbs) {
+          assoc_ids[nb_assoc_ids++] = SCTP_NEW_ASSOCIATION (received_msgs[i]).assoc_id;
+        }
+        __sync_fetch_and_add (&nb_associations, 1);
+        break;
+
+      case SCTP_DATA_CNF:
+        if (!SCTP_DATA_CNF (received_msgs[i]).is_success) {
+          __sync_fetch_and_add (&nb_data_cnf_failures, 1);
+        }
+        break;
+
+      case SCTP_DATA_IND:
+        nb_bytes += blength (SCTP_DATA_IND (received_msgs[i]).payload);
+        __sync_fetch_and_add (&nb_data_ind, 1);
+        break;
+
+      case SCTP_CLOSE_ASSOCIATION:
+        __sync_fetch_and_add (&nb_releases, 1);
+        break;
+
+      default:
+        ;
+      }
+      itti_free_msg_content (received_msgs[i]);
+      itti_free (ITTI_MSG_ORIGIN_ID (received_msgs[i]), received_msgs[i]);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static double sctp_load_test_elapsed (const struct timespec * const start)
+{
+  struct timespec                         now;
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+static bool sctp_load_test_wait (volatile uint64_t * const counter, const uint64_t expected)
+{
+  struct timespec                         start;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  while (*counter < expected) {
+    if (sctp_load_test_elapsed (&start) > SCTP_LOAD_TEST_TIMEOUT_SEC) {
+      return false;
+    }
+    usleep (100);
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Reads what the server sent to the eNBs without blocking, returns the number
+ * of messages read.
+ */
+static uint64_t sctp_load_test_enb_receive (const int * const enb_sds)
+{
+  uint8_t                                 buffer[SCTP_LOAD_TEST_PAYLOAD_SIZE * 2];
+  uint64_t                                nb_received = 0;
+  uint32_t                                i = 0;
+
+  for (i = 0; i < nb_enbs; i++) {
+    while (recv (enb_sds[i], buffer, sizeof (buffer), MSG_DONTWAIT) > 0) {
+      nb_received++;
+    }
+  }
+  return nb_received;
+}
+
+//------------------------------------------------------------------------------
+static int sctp_load_test_connect_enb (void)
+{
+  struct sctp_initmsg                     init = {0};
+  struct sockaddr_in                      addr = {0};
+  int                                     sd = -1;
+  int                                     retry = 0;
+
+  if ((sd = socket (AF_INET, SOCK_STREAM, IPPROTO_SCTP)) < 0) {
+    fprintf (stderr, "socket: %s\n", strerror (errno));
+    return -1;
+  }
+
+  init.sinit_num_ostreams = SCTP_LOAD_TEST_STREAMS;
+  init.sinit_max_instreams = SCTP_LOAD_TEST_STREAMS;
+  if (setsockopt (sd, IPPROTO_SCTP, SCTP_INITMSG, &init, sizeof (init)) < 0) {
+    fprintf (stderr, "setsockopt SCTP_INITMSG: %s\n", strerror (errno));
+    close (sd);
+    return -1;
+  }
+
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (SCTP_LOAD_TEST_PORT);
+  addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+
+  // the listener is created asynchronously by TASK_SCTP
+  while (connect (sd, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+    if ((ECONNREFUSED != errno) || (++retry > 1000)) {
+      fprintf (stderr, "connect: %s\n", strerror (errno));
+      close (sd);
+      return -1;
+    }
+    usleep (1000);
+  }
+  return sd;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  mme_config_t                            config = {0};
+  struct rlimit                           rlim = {0};
+  struct timespec                         start_time;
+  MessageDef                             *message_p = NULL;
+  uint8_t                                 payload[SCTP_LOAD_TEST_PAYLOAD_SIZE];
+  int                                    *enb_sds = NULL;
+  uint64_t                                nb_send_errors = 0;
+  uint64_t                                nb_enb_received = 0;
+  uint64_t                                nb_data_reqs = 0;
+  uint32_t                                i = 0,
+                                          m = 0;
+  double                                  elapsed = 0;
+  int                                     rc = EXIT_SUCCESS;
+
+  if (argc > 1) {
+    nb_enbs = (uint32_t)strtoul (argv[1], NULL, 0);
+
+    if (argc > 2) {
+      nb_messages = (uint32_t)strtoul (argv[2], NULL, 0);
+
+      if (argc > 3) {
+        config.sctp_config.one_to_many = (atoi (argv[3]) != 0);
+      }
+    }
+  }
+
+  // one socket per eNB on both sides
+  if (getrlimit (RLIMIT_NOFILE, &rlim) == 0) {
+    if (rlim.rlim_cur < (2 * nb_enbs + 64)) {
+      rlim.rlim_cur = (rlim.rlim_max < (2 * nb_enbs + 64)) ? rlim.rlim_max : (2 * nb_enbs + 64);
+      setrlimit (RLIMIT_NOFILE, &rlim);
+    }
+  }
+
+  shared_log_init (MAX_LOG_PROTOS);
+  OAILOG_INIT (LOG_MME_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS);
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+
+  if (itti_create_task (TASK_S1AP, &sctp_load_test_s1ap_task, NULL) < 0) {
+    fprintf (stderr, "Failed to create TASK_S1AP\n");
+    return EXIT_FAILURE;
+  }
+
+  config.max_enbs = nb_enbs;
+  config.sctp_config.in_streams = SCTP_LOAD_TEST_STREAMS;
+  config.sctp_config.out_streams = SCTP_LOAD_TEST_STREAMS;
+  if (sctp_init (&config) < 0) {
+    fprintf (stderr, "Failed to initialize TASK_SCTP\n");
+    return EXIT_FAILURE;
+  }
+
+  message_p = itti_alloc_new_message (TASK_S1AP, SCTP_INIT_MSG);
+  SCTP_INIT_MSG (message_p).port = SCTP_LOAD_TEST_PORT;
+  SCTP_INIT_MSG (message_p).ppid = SCTP_LOAD_TEST_PPID;
+  SCTP_INIT_MSG (message_p).ipv4 = 1;
+  SCTP_INIT_MSG (message_p).nb_ipv4_addr = 1;
+  SCTP_INIT_MSG (message_p).ipv4_address[0].s_addr = htonl (INADDR_LOOPBACK);
+  itti_send_msg_to_task (TASK_SCTP, INSTANCE_DEFAULT, message_p);
+
+  enb_sds = calloc (nb_enbs, sizeof (int));
+  assoc_ids = calloc (nb_enbs, sizeof (sctp_assoc_id_t));
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_enbs; i++) {
+    if ((enb_sds[i] = sctp_load_test_connect_enb ()) < 0) {
+      fprintf (stderr, "Failed to connect eNB %u\n", i);
+      return EXIT_FAILURE;
+    }
+  }
+  if (!sctp_load_test_wait (&nb_associations, nb_enbs)) {
+    fprintf (stderr, "Only %" PRIu64 " associations out of %u reported\n", (uint64_t)nb_associations, nb_enbs);
+    return EXIT_FAILURE;
+  }
+  elapsed = sctp_load_test_elapsed (&start_time);
+  fprintf (stdout, "SCTP %s: %u eNBs associated in %.3f s\n",
+      (config.sctp_config.one_to_many) ? "one-to-many" : "one-to-one", nb_enbs, elapsed);
+
+  memset (payload, 0x5a, sizeof (payload));
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  // every eNB sends its burst in turn, so that the server always has many ready sockets
+  for (m = 0; m < nb_messages; m++) {
+    for (i = 0; i < nb_enbs; i++) {
+      if (sctp_sendmsg (enb_sds[i], payload, sizeof (payload), NULL, 0, htonl (SCTP_LOAD_TEST_PPID), 0,
+          (uint16_t)(m % SCTP_LOAD_TEST_STREAMS), 0, 0) < 0) {
+        nb_send_errors++;
+      }
+    }
+  }
+  if (!sctp_load_test_wait (&nb_data_ind, (uint64_t)nb_enbs * nb_messages - nb_send_errors)) {
+    rc = EXIT_FAILURE;
+  }
+  elapsed = sctp_load_test_elapsed (&start_time);
+  fprintf (stdout, "SCTP %s: %" PRIu64 " messages (%" PRIu64 " bytes) received in %.3f s, %.0f msgs/s, %" PRIu64 " send errors\n",
+      (config.sctp_config.one_to_many) ? "one-to-many" : "one-to-one",
+      (uint64_t)nb_data_ind, (uint64_t)nb_bytes, elapsed, (double)nb_data_ind / elapsed, nb_send_errors);
+
+  /*
+   * Downlink: every round queues one SCTP_DATA_REQ per association, TASK_SCTP
+   * drains them in batches and writes each association's share with one call.
+   */
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (m = 0; m < nb_messages; m++) {
+    for (i = 0; i < nb_enbs; i++) {
+      message_p = itti_alloc_new_message (TASK_S1AP, SCTP_DATA_REQ);
+      SCTP_DATA_REQ (message_p).payload = blk2bstr (payload, sizeof (payload));
+      SCTP_DATA_REQ (message_p).assoc_id = assoc_ids[i];
+      SCTP_DATA_REQ (message_p).stream = (sctp_stream_id_t)(m % SCTP_LOAD_TEST_STREAMS);
+      SCTP_DATA_REQ (message_p).mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+      if (itti_send_msg_to_task (TASK_SCTP, INSTANCE_DEFAULT, message_p) == 0) {
+        nb_data_reqs++;
+      }
+    }
+    nb_enb_received += sctp_load_test_enb_receive (enb_sds);
+  }
+  while ((nb_enb_received + nb_data_cnf_failures < nb_data_reqs) && (sctp_load_test_elapsed (&start_time) < SCTP_LOAD_TEST_TIMEOUT_SEC)) {
+    nb_enb_received += sctp_load_test_enb_receive (enb_sds);
+  }
+  elapsed = sctp_load_test_elapsed (&start_time);
+  fprintf (stdout, "SCTP %s: %" PRIu64 " messages sent out of %" PRIu64 " requests in %.3f s, %.0f msgs/s, %" PRIu64 " send failures\n",
+      (config.sctp_config.one_to_many) ? "one-to-many" : "one-to-one",
+      nb_enb_received, (uint64_t)nb_enbs * nb_messages, elapsed, (double)nb_enb_received / elapsed, (uint64_t)nb_data_cnf_failures);
+  if ((nb_enb_received != (uint64_t)nb_enbs * nb_messages) || (nb_data_cnf_failures)) {
+    fprintf (stderr, "Expected %" PRIu64 " messages on the eNB side, got %" PRIu64 "\n", (uint64_t)nb_enbs * nb_messages, nb_enb_received);
+    rc = EXIT_FAILURE;
+  }
+
+  for (i = 0; i < nb_enbs; i++) {
+    close (enb_sds[i]);
+  }
+  if (!sctp_load_test_wait (&nb_releases, nb_enbs)) {
+    fprintf (stderr, "Only %" PRIu64 " association releases out of %u reported\n", (uint64_t)nb_releases, nb_enbs);
+    rc = EXIT_FAILURE;
+  }
+  free_wrapper ((void **)&enb_sds);
+  free_wrapper ((void **)&assoc_ids);
+
+  if ((nb_data_ind != (uint64_t)nb_enbs * nb_messages) || (nb_send_errors)) {
+    fprintf (stderr, "Expected %" PRIu64 " data indications, got %" PRIu64 "\n", (uint64_t)nb_enbs * nb_messages, (uint64_t)nb_data_ind);
+    rc = EXIT_FAILURE;
+  }
+  return rc;
+}
@@ -0,0 +1,277 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Authentication vector cache tests. nas_itti_auth_info_req() is replaced by
+ * a stub HSS that counts the AIRs and generates vectors with a per IMSI
+ * increasing SQN, written in the first RAND octets. Repeated attaches of a
+ * population of UEs, with the UE context released in between, are run the
+ * way Authentication.c and nas_proc.c use the cache: an attach without
+ * cached vector waits for the AIA, refills are answered before the next
+ * round of attaches.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bstrlib.h"
+#include "log.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "emm_auth_vector_cache.h"
+
+#define TEST_AUTH_NB_UES             1000
+#define TEST_AUTH_NB_ATTACHES        20
+
+typedef struct test_auth_hss_s {
+  imsi_t          imsi[TEST_AUTH_NB_UES];
+  uint64_t        sqn[TEST_AUTH_NB_UES];         // next SQN generated by the HSS
+  uint64_t        used_sqn[TEST_AUTH_NB_UES];    // last SQN presented to the UE
+  uint8_t         pending[TEST_AUTH_NB_UES];     // vectors requested, not yet answered
+  uint32_t        nb_airs;
+} test_auth_hss_t;
+
+static test_auth_hss_t                    _hss;
+
+//------------------------------------------------------------------------------
+// stub HSS, the AIR is answered by test_auth_hss_answer()
+void nas_itti_auth_info_req(
+  const mme_ue_s1ap_id_t ue_idP,
+  const imsi_t   * const imsiP,
+  const bool             is_initial_reqP,
+  plmn_t         * const visited_plmnP,
+  const uint8_t          num_vectorsP,
+  const_bstring    const auts_pP)
+{
+  const int                               ue = imsiP - _hss.imsi;
+
+  ck_assert ((ue >= 0) && (ue < TEST_AUTH_NB_UES));
+  ck_assert ((num_vectorsP > 0) && (num_vectorsP <= MAX_EPS_AUTH_VECTORS_PER_REQUEST));
+  ck_assert (_hss.pending[ue] == 0);
+  _hss.pending[ue] = num_vectorsP;
+  _hss.nb_airs++;
+}
+
+//------------------------------------------------------------------------------
+static void test_auth_hss_answer (const int ue)
+{
+  eutran_vector_t                         vectors[MAX_EPS_AUTH_VECTORS_PER_REQUEST];
+
+  memset (vectors, 0, sizeof (vectors));
+  for (int i = 0; i < _hss.pending[ue]; i++) {
+    memcpy (vectors[i].rand, &_hss.sqn[ue], sizeof (_hss.sqn[ue]));
+    vectors[i].xres.size = 8;
+    _hss.sqn[ue] += 32;
+  }
+  emm_auth_vector_cache_store (ue + 1, _hss.pending[ue], vectors);
+  _hss.pending[ue] = 0;
+}
+
+//------------------------------------------------------------------------------
+static void test_auth_use_vector (const int ue, const eutran_vector_t * const vector)
+{
+  uint64_t                                sqn = 0;
+
+  // the USIM only accepts increasing SQNs, a vector is never used twice
+  memcpy (&sqn, vector->rand, sizeof (sqn));
+  ck_assert_msg ((_hss.used_sqn[ue] == UINT64_MAX) || (sqn > _hss.used_sqn[ue]), "UE %d SQN %" PRIu64 " after %" PRIu64, ue, sqn, _hss.used_sqn[ue]);
+  _hss.used_sqn[ue] = sqn;
+}
+
+//------------------------------------------------------------------------------
+static void test_auth_init (const uint8_t nb_vectors_per_request, const uint8_t low_water_mark, const uint32_t ttl_sec)
+{
+  memset (&_hss, 0, sizeof (_hss));
+  for (int ue = 0; ue < TEST_AUTH_NB_UES; ue++) {
+    _hss.used_sqn[ue] = UINT64_MAX;
+  }
+  ck_assert (emm_auth_vector_cache_init (nb_vectors_per_request, low_water_mark, ttl_sec, TEST_AUTH_NB_UES) == RETURNok);
+}
+
+//------------------------------------------------------------------------------
+// returns true if the attach had to wait for the HSS
+static bool test_auth_attach (const int ue)
+{
+  eutran_vector_t                         vector = {0};
+  plmn_t                                  plmn = {0};
+  bool                                    waited = false;
+
+  if (!emm_auth_vector_cache_pop (ue + 1, &vector)) {
+    // _start_authentication_information_procedure() then nas_proc_authentication_info_answer()
+    nas_itti_auth_info_req (ue + 1, &_hss.imsi[ue], true, &plmn, emm_auth_vector_cache_nb_vectors_per_request (), NULL);
+    test_auth_hss_answer (ue);
+    ck_assert (emm_auth_vector_cache_pop (ue + 1, &vector));
+    waited = true;
+  }
+  test_auth_use_vector (ue, &vector);
+  emm_auth_vector_cache_refill (ue + 1, &_hss.imsi[ue], &plmn);
+  return waited;
+}
+
+//------------------------------------------------------------------------------
+static void test_auth_run (uint32_t * const nb_airs, uint32_t * const nb_waits)
+{
+  *nb_waits = 0;
+  for (int round = 0; round < TEST_AUTH_NB_ATTACHES; round++) {
+    for (int ue = 0; ue < TEST_AUTH_NB_UES; ue++) {
+      *nb_waits += test_auth_attach (ue);
+    }
+    // UE contexts are released, refill AIAs arrive before the next attaches
+    for (int ue = 0; ue < TEST_AUTH_NB_UES; ue++) {
+      if (_hss.pending[ue]) {
+        test_auth_hss_answer (ue);
+      }
+    }
+  }
+  *nb_airs = _hss.nb_airs;
+}
+
+START_TEST(auth_vector_cache_order_test)
+{
+  eutran_vector_t                         vector = {0};
+  plmn_t                                  plmn = {0};
+
+  test_auth_init (4, 1, 3600);
+
+  _hss.pending[0] = 4;
+  test_auth_hss_answer (0);
+  _hss.pending[1] = 2;
+  test_auth_hss_answer (1);
+  ck_assert (emm_auth_vector_cache_nb_vectors (1) == 4);
+  ck_assert (emm_auth_vector_cache_nb_vectors (2) == 2);
+
+  // vectors come out in the order the HSS generated them, once
+  for (int i = 0; i < 4; i++) {
+    ck_assert (emm_auth_vector_cache_pop (1, &vector));
+    test_auth_use_vector (0, &vector);
+  }
+  ck_assert (!emm_auth_vector_cache_pop (1, &vector));
+  ck_assert (emm_auth_vector_cache_nb_vectors (2) == 2);
+
+  // refill below the low water mark only, one refill at a time
+  emm_auth_vector_cache_refill (2, &_hss.imsi[1], &plmn);
+  ck_assert (_hss.nb_airs == 0);
+  ck_assert (emm_auth_vector_cache_pop (2, &vector));
+  ck_assert (emm_auth_vector_cache_pop (2, &vector));
+  emm_auth_vector_cache_refill (2, &_hss.imsi[1], &plmn);
+  emm_auth_vector_cache_refill (2, &_hss.imsi[1], &plmn);
+  ck_assert (_hss.nb_airs == 1);
+  test_auth_hss_answer (1);
+  ck_assert (emm_auth_vector_cache_nb_vectors (2) == 4);
+
+  // synchronisation failure
+  emm_auth_vector_cache_purge (2);
+  ck_assert (emm_auth_vector_cache_nb_vectors (2) == 0);
+  ck_assert (!emm_auth_vector_cache_pop (2, &vector));
+
+  emm_auth_vector_cache_exit ();
+}
+END_TEST
+
+START_TEST(auth_vector_cache_ttl_test)
+{
+  eutran_vector_t                         vector = {0};
+
+  test_auth_init (4, 1, 1);
+  _hss.pending[0] = 4;
+  test_auth_hss_answer (0);
+  ck_assert (emm_auth_vector_cache_pop (1, &vector));
+  sleep (3);
+  ck_assert (emm_auth_vector_cache_nb_vectors (1) == 0);
+  ck_assert (!emm_auth_vector_cache_pop (1, &vector));
+  emm_auth_vector_cache_exit ();
+}
+END_TEST
+
+START_TEST(auth_vector_cache_air_count_test)
+{
+  const uint32_t                          nb_attaches = TEST_AUTH_NB_UES * TEST_AUTH_NB_ATTACHES;
+  uint32_t                                nb_airs_single = 0;
+  uint32_t                                nb_waits_single = 0;
+  uint32_t                                nb_airs = 0;
+  uint32_t                                nb_waits = 0;
+
+  // one vector per AIR, no cache: the former behaviour
+  test_auth_init (1, 0, 3600);
+  test_auth_run (&nb_airs_single, &nb_waits_single);
+  emm_auth_vector_cache_exit ();
+  printf ("1 vector per AIR:            %6u AIRs, %6u attaches waiting for the HSS, %u attaches\n", nb_airs_single, nb_waits_single, nb_attaches);
+  ck_assert (nb_airs_single == nb_attaches);
+  ck_assert (nb_waits_single == nb_attaches);
+
+  test_auth_init (4, 1, 3600);
+  test_auth_run (&nb_airs, &nb_waits);
+  emm_auth_vector_cache_exit ();
+  printf ("4 vectors per AIR, refill 1: %6u AIRs, %6u attaches waiting for the HSS, %u attaches\n", nb_airs, nb_waits, nb_attaches);
+  // only the first attach of each UE waits, then one AIR every 4 attaches
+  ck_assert (nb_waits == TEST_AUTH_NB_UES);
+  ck_assert (nb_airs <= (nb_attaches / 4) + TEST_AUTH_NB_UES);
+
+  test_auth_init (5, 2, 3600);
+  test_auth_run (&nb_airs, &nb_waits);
+  emm_auth_vector_cache_exit ();
+  printf ("5 vectors per AIR, refill 2: %6u AIRs, %6u attaches waiting for the HSS, %u attaches\n", nb_airs, nb_waits, nb_attaches);
+  ck_assert (nb_waits == TEST_AUTH_NB_UES);
+  ck_assert (nb_airs <= (nb_attaches / 5) + TEST_AUTH_NB_UES);
+}
+END_TEST
+
+Suite * auth_vector_cache_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Authentication vector cache tests");
+
+    /* Core test case */
+    tc_core = tcase_create("Authentication vector cache test");
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, auth_vector_cache_order_test);
+    tcase_add_test(tc_core, auth_vector_cache_ttl_test);
+    tcase_add_test(tc_core, auth_vector_cache_air_count_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    shared_log_init (MAX_LOG_PROTOS);
+    OAILOG_INIT (LOG_MME_ENV, OAILOG_LEVEL_ERROR, MAX_LOG_PROTOS);
+
+    s = auth_vector_cache_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,656 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Generated NAS codec tests: recorded plain EMM and ESM PDUs, one at least per
+ * message of nas_messages.def, are decoded by both the decode_xxx() message
+ * codecs and the generated codec, which must return the same value, then
+ * encoded by both the encode_xxx() message codecs and the generated codec,
+ * which must be byte identical.
+ * Mutated PDUs must be decoded the same way by both codecs.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "TLVDecoder.h"
+#include "TLVEncoder.h"
+#include "common_types.h"
+#include "3gpp_24.007.h"
+#include "3gpp_24.008.h"
+#include "3gpp_36.331.h"
+#include "3gpp_36.401.h"
+#include "3gpp_29.274.h"
+#include "emm_msg.h"
+#include "esm_msg.h"
+#include "nas_codec.h"
+
+#define TEST_NAS_CODEC_NB_MUTATIONS     100000
+#define TEST_NAS_CODEC_MAX_LENGTH       512
+
+#define TEST_NAS_CODEC_PCO              "27 0a 80 00 0d 00 00 03 00 00 0a 00"
+#define TEST_NAS_CODEC_GUTI             "0b f6 02 f8 39 80 04 01 c0 00 00 01"
+#define TEST_NAS_CODEC_TAI_LIST         "06 20 02 f8 39 00 01"
+#define TEST_NAS_CODEC_TFT              "02 a1 01"
+
+typedef int (*test_nas_codec_emm_fn_t) (EMM_msg *, uint8_t *, uint32_t);
+typedef int (*test_nas_codec_esm_fn_t) (ESM_msg *, uint8_t *, uint32_t);
+
+typedef struct test_nas_codec_emm_s {
+  test_nas_codec_emm_fn_t                 decode;
+  test_nas_codec_emm_fn_t                 encode;
+} test_nas_codec_emm_t;
+
+typedef struct test_nas_codec_esm_s {
+  test_nas_codec_esm_fn_t                 decode;
+  test_nas_codec_esm_fn_t                 encode;
+} test_nas_codec_esm_t;
+
+/*
+ * decode_xxx() and encode_xxx() message codecs, the way emm_msg_decode(),
+ * emm_msg_encode(), esm_msg_decode() and esm_msg_encode() call them.
+ */
+#define TEST_NAS_CODEC_MESSAGE(uNION, mESSAGE)                                      \
+  static int test_nas_codec_decode_##mESSAGE (uNION * msg, uint8_t * buffer, uint32_t len) \
+  {                                                                                 \
+    return decode_##mESSAGE (&msg->mESSAGE, buffer, len);                           \
+  }                                                                                 \
+  static int test_nas_codec_encode_##mESSAGE (uNION * msg, uint8_t * buffer, uint32_t len) \
+  {                                                                                 \
+    return encode_##mESSAGE (&msg->mESSAGE, buffer, len);                           \
+  }
+
+#define TEST_NAS_CODEC_CODECS(mESSAGE) {test_nas_codec_decode_##mESSAGE, test_nas_codec_encode_##mESSAGE}
+
+TEST_NAS_CODEC_MESSAGE (EMM_msg, attach_accept)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, attach_complete)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, attach_reject)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, attach_request)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, authentication_failure)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, authentication_reject)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, authentication_request)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, authentication_response)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, cs_service_notification)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, detach_accept)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, detach_request)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, downlink_nas_transport)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, emm_information)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, emm_status)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, extended_service_request)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, guti_reallocation_command)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, guti_reallocation_complete)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, identity_request)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, identity_response)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, security_mode_command)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, security_mode_complete)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, security_mode_reject)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, service_reject)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, tracking_area_update_accept)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, tracking_area_update_complete)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, tracking_area_update_reject)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, tracking_area_update_request)
+TEST_NAS_CODEC_MESSAGE (EMM_msg, uplink_nas_transport)
+
+TEST_NAS_CODEC_MESSAGE (ESM_msg, activate_dedicated_eps_bearer_context_accept)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, activate_dedicated_eps_bearer_context_reject)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, activate_dedicated_eps_bearer_context_request)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, activate_default_eps_bearer_context_accept)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, activate_default_eps_bearer_context_reject)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, activate_default_eps_bearer_context_request)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, bearer_resource_allocation_reject)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, bearer_resource_allocation_request)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, bearer_resource_modification_reject)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, bearer_resource_modification_request)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, deactivate_eps_bearer_context_accept)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, deactivate_eps_bearer_context_request)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, esm_information_request)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, esm_information_response)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, esm_status)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, modify_eps_bearer_context_accept)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, modify_eps_bearer_context_reject)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, modify_eps_bearer_context_request)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, pdn_connectivity_reject)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, pdn_connectivity_request)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, pdn_disconnect_reject)
+TEST_NAS_CODEC_MESSAGE (ESM_msg, pdn_disconnect_request)
+
+static const test_nas_codec_emm_t       test_nas_codec_emm[256] = {
+  [ATTACH_ACCEPT]                        = TEST_NAS_CODEC_CODECS (attach_accept),
+  [ATTACH_COMPLETE]                      = TEST_NAS_CODEC_CODECS (attach_complete),
+  [ATTACH_REJECT]                        = TEST_NAS_CODEC_CODECS (attach_reject),
+  [ATTACH_REQUEST]                       = TEST_NAS_CODEC_CODECS (attach_request),
+  [AUTHENTICATION_FAILURE]               = TEST_NAS_CODEC_CODECS (authentication_failure),
+  [AUTHENTICATION_REJECT]                = TEST_NAS_CODEC_CODECS (authentication_reject),
+  [AUTHENTICATION_REQUEST]               = TEST_NAS_CODEC_CODECS (authentication_request),
+  [AUTHENTICATION_RESPONSE]              = TEST_NAS_CODEC_CODECS (authentication_response),
+  [CS_SERVICE_NOTIFICATION]              = TEST_NAS_CODEC_CODECS (cs_service_notification),
+  [DETACH_ACCEPT]                        = TEST_NAS_CODEC_CODECS (detach_accept),
+  [DETACH_REQUEST]                       = TEST_NAS_CODEC_CODECS (detach_request),
+  [DOWNLINK_NAS_TRANSPORT]               = TEST_NAS_CODEC_CODECS (downlink_nas_transport),
+  [EMM_INFORMATION]                      = TEST_NAS_CODEC_CODECS (emm_information),
+  [EMM_STATUS]                           = TEST_NAS_CODEC_CODECS (emm_status),
+  [EXTENDED_SERVICE_REQUEST]             = TEST_NAS_CODEC_CODECS (extended_service_request),
+  [GUTI_REALLOCATION_COMMAND]            = TEST_NAS_CODEC_CODECS (guti_reallocation_command),
+  [GUTI_REALLOCATION_COMPLETE]           = TEST_NAS_CODEC_CODECS (guti_reallocation_complete),
+  [IDENTITY_REQUEST]                     = TEST_NAS_CODEC_CODECS (identity_request),
+  [IDENTITY_RESPONSE]                    = TEST_NAS_CODEC_CODECS (identity_response),
+  [SECURITY_MODE_COMMAND]                = TEST_NAS_CODEC_CODECS (security_mode_command),
+  [SECURITY_MODE_COMPLETE]               = TEST_NAS_CODEC_CODECS (security_mode_complete),
+  [SECURITY_MODE_REJECT]                 = TEST_NAS_CODEC_CODECS (security_mode_reject),
+  [SERVICE_REJECT]                       = TEST_NAS_CODEC_CODECS (service_reject),
+  [TRACKING_AREA_UPDATE_ACCEPT]          = TEST_NAS_CODEC_CODECS (tracking_area_update_accept),
+  [TRACKING_AREA_UPDATE_COMPLETE]        = TEST_NAS_CODEC_CODECS (tracking_area_update_complete),
+  [TRACKING_AREA_UPDATE_REJECT]          = TEST_NAS_CODEC_CODECS (tracking_area_update_reject),
+  [TRACKING_AREA_UPDATE_REQUEST]         = TEST_NAS_CODEC_CODECS (tracking_area_update_request),
+  [UPLINK_NAS_TRANSPORT]                 = TEST_NAS_CODEC_CODECS (uplink_nas_transport),
+};
+
+static const test_nas_codec_esm_t       test_nas_codec_esm[256] = {
+  [ACTIVATE_DEDICATED_EPS_BEARER_CONTEXT_ACCEPT]  = TEST_NAS_CODEC_CODECS (activate_dedicated_eps_bearer_context_accept),
+  [ACTIVATE_DEDICATED_EPS_BEARER_CONTEXT_REJECT]  = TEST_NAS_CODEC_CODECS (activate_dedicated_eps_bearer_context_reject),
+  [ACTIVATE_DEDICATED_EPS_BEARER_CONTEXT_REQUEST] = TEST_NAS_CODEC_CODECS (activate_dedicated_eps_bearer_context_request),
+  [ACTIVATE_DEFAULT_EPS_BEARER_CONTEXT_ACCEPT]    = TEST_NAS_CODEC_CODECS (activate_default_eps_bearer_context_accept),
+  [ACTIVATE_DEFAULT_EPS_BEARER_CONTEXT_REJECT]    = TEST_NAS_CODEC_CODECS (activate_default_eps_bearer_context_reject),
+  [ACTIVATE_DEFAULT_EPS_BEARER_CONTEXT_REQUEST]   = TEST_NAS_CODEC_CODECS (activate_default_eps_bearer_context_request),
+  [BEARER_RESOURCE_ALLOCATION_REJECT]             = TEST_NAS_CODEC_CODECS (bearer_resource_allocation_reject),
+  [BEARER_RESOURCE_ALLOCATION_REQUEST]            = TEST_NAS_CODEC_CODECS (bearer_resource_allocation_request),
+  [BEARER_RESOURCE_MODIFICATION_REJECT]           = TEST_NAS_CODEC_CODECS (bearer_resource_modification_reject),
+  [BEARER_RESOURCE_MODIFICATION_REQUEST]          = TEST_NAS_CODEC_CODECS (bearer_resource_modification_request),
+  [DEACTIVATE_EPS_BEARER_CONTEXT_ACCEPT]          = TEST_NAS_CODEC_CODECS (deactivate_eps_bearer_context_accept),
+  [DEACTIVATE_EPS_BEARER_CONTEXT_REQUEST]         = TEST_NAS_CODEC_CODECS (deactivate_eps_bearer_context_request),
+  [ESM_INFORMATION_REQUEST]                       = TEST_NAS_CODEC_CODECS (esm_information_request),
+  [ESM_INFORMATION_RESPONSE]                      = TEST_NAS_CODEC_CODECS (esm_information_response),
+  [ESM_STATUS]                                    = TEST_NAS_CODEC_CODECS (esm_status),
+  [MODIFY_EPS_BEARER_CONTEXT_ACCEPT]              = TEST_NAS_CODEC_CODECS (modify_eps_bearer_context_accept),
+  [MODIFY_EPS_BEARER_CONTEXT_REJECT]              = TEST_NAS_CODEC_CODECS (modify_eps_bearer_context_reject),
+  [MODIFY_EPS_BEARER_CONTEXT_REQUEST]             = TEST_NAS_CODEC_CODECS (modify_eps_bearer_context_request),
+  [PDN_CONNECTIVITY_REJECT]                       = TEST_NAS_CODEC_CODECS (pdn_connectivity_reject),
+  [PDN_CONNECTIVITY_REQUEST]                      = TEST_NAS_CODEC_CODECS (pdn_connectivity_request),
+  [PDN_DISCONNECT_REJECT]                         = TEST_NAS_CODEC_CODECS (pdn_disconnect_reject),
+  [PDN_DISCONNECT_REQUEST]                        = TEST_NAS_CODEC_CODECS (pdn_disconnect_request),
+};
+
+/*
+ * Plain NAS PDUs, header included. IEs are ordered so that the decode_xxx()
+ * IE codecs which read up to the end of the message rather than up to the
+ * end of the IE, e.g. the PLMN list, come last.
+ */
+static const char                      *test_nas_codec_pdus[] = {
+  // Attach Accept, Activate Default EPS Bearer Context Request in the ESM message container
+  "07 42 01 23 " TEST_NAS_CODEC_TAI_LIST " 00 20 52 01 c1 01 09 04 03 6f 61 69 05 01 0a 00 00 02 5e 02 fe fe " TEST_NAS_CODEC_PCO
+    " 50 " TEST_NAS_CODEC_GUTI " 13 02 f8 39 00 01 23 05 f4 c0 00 00 01 53 10 17 2c 59 23 64 01 01 f1 4a 03 02 f8 39",
+  "07 42 01 23 " TEST_NAS_CODEC_TAI_LIST " 00 03 52 01 c1",
+  // Attach Complete
+  "07 43 00 03 52 00 c2",
+  // Attach Reject
+  "07 44 11 78 00 04 02 01 d1 1b",
+  "07 44 0f",
+  // Attach Request, PDN Connectivity Request in the ESM message container
+  "07 41 71 08 29 80 39 10 00 00 00 10 05 f0 f0 c0 40 19 00 04 02 01 d0 11",
+  "07 41 21 " TEST_NAS_CODEC_GUTI " 02 e0 e0 00 04 02 01 d0 11 19 01 02 03 04 50 " TEST_NAS_CODEC_GUTI
+    " 52 02 f8 39 00 01 5c 0a 00 31 03 e5 e0 34 13 02 f8 39 00 01 90 11 03 57 58 a6 40 08 04 02 60 04 00 02 1f 02"
+    " f1 e0 5d 01 00 c1",
+  // Authentication Failure
+  "07 5c 15 30 0e 01 02 03 04 05 06 07 08 09 0a 0b 0c 0d 0e",
+  "07 5c 14",
+  // Authentication Reject
+  "07 54",
+  // Authentication Request
+  "07 52 30 00 11 22 33 44 55 66 77 88 99 aa bb cc dd ee ff 10 00 11 22 33 44 55 66 77 88 99 aa bb cc dd ee ff",
+  // Authentication Response
+  "07 53 08 11 22 33 44 55 66 77 88",
+  // CS Service Notification
+  "07 64 00 60 03 21 43 65 61 11 62 01 63 03 01 02 03",
+  // Detach Accept
+  "07 46",
+  // Detach Request
+  "07 45 19 " TEST_NAS_CODEC_GUTI,
+  "07 45 01 08 29 80 39 10 00 00 00 10",
+  // Downlink NAS Transport
+  "07 62 03 01 02 03",
+  // EMM Information
+  "07 61 46 40 47 61 01 01 21 43 65 40 49 01 00",
+  "07 61",
+  // EMM Status
+  "07 60 6f",
+  // Extended Service Request
+  "07 4c 12 05 f4 c0 00 00 01",
+  // GUTI Reallocation Command
+  "07 50 " TEST_NAS_CODEC_GUTI " 54 " TEST_NAS_CODEC_TAI_LIST,
+  // GUTI Reallocation Complete
+  "07 51",
+  // Identity Request
+  "07 55 01",
+  // Identity Response
+  "07 56 08 29 80 39 10 00 00 00 10",
+  // Security Mode Command
+  "07 5d 02 01 05 e0 e0 c0 40 70 c1 55 01 02 03 04 56 05 06 07 08",
+  "07 5d 12 03 05 e0 e0 c0 40 70",
+  // Security Mode Complete
+  "07 5e 23 08 29 80 39 10 00 00 00 10",
+  "07 5e",
+  // Security Mode Reject
+  "07 5f 18",
+  // Service Reject
+  "07 4e 0a",
+  // Tracking Area Update Accept
+  "07 49 10 5a 23 50 " TEST_NAS_CODEC_GUTI " 54 " TEST_NAS_CODEC_TAI_LIST " 57 02 20 00 13 02 f8 39 00 01 23 05 f4 c0 00 00 01"
+    " 53 10 17 2c 59 23 64 01 01 f1 4a 03 02 f8 39",
+  "07 49 00",
+  // Tracking Area Update Complete
+  "07 4a",
+  // Tracking Area Update Reject
+  "07 4b 09",
+  // Tracking Area Update Request
+  "07 48 71 " TEST_NAS_CODEC_GUTI " b0 80 19 01 02 03 04 50 " TEST_NAS_CODEC_GUTI " 55 01 02 03 04 58 02 e0 e0 52 02 f8 39 00 01"
+    " 5c 0a 00 a1 57 02 20 00 31 03 e5 e0 34 13 02 f8 39 00 01 90 11 03 57 58 a6 40 08 04 02 60 04 00 02 1f 02 e1",
+  "07 48 00 " TEST_NAS_CODEC_GUTI,
+  // Uplink NAS Transport
+  "07 63 03 01 02 03",
+  // Activate Dedicated EPS Bearer Context Accept
+  "62 00 c6 " TEST_NAS_CODEC_PCO,
+  "62 00 c6",
+  // Activate Dedicated EPS Bearer Context Reject
+  "62 00 c7 1f " TEST_NAS_CODEC_PCO,
+  // Activate Dedicated EPS Bearer Context Request
+  "62 00 c5 05 05 01 40 40 40 40 " TEST_NAS_CODEC_TFT " 32 00 81 34 01 00 " TEST_NAS_CODEC_PCO,
+  "62 00 c5 05 01 09 " TEST_NAS_CODEC_TFT,
+  // Activate Default EPS Bearer Context Accept
+  "52 00 c2 " TEST_NAS_CODEC_PCO,
+  // Activate Default EPS Bearer Context Reject
+  "52 00 c3 1a",
+  // Activate Default EPS Bearer Context Request
+  "52 01 c1 01 09 04 03 6f 61 69 05 01 0a 00 00 02 32 00 81 34 01 00 5e 02 fe fe 58 32 " TEST_NAS_CODEC_PCO,
+  // Bearer Resource Allocation Reject
+  "02 01 d5 1e " TEST_NAS_CODEC_PCO,
+  // Bearer Resource Allocation Request
+  "02 01 d4 50 " TEST_NAS_CODEC_TFT " 05 01 40 40 40 40 " TEST_NAS_CODEC_PCO,
+  // Bearer Resource Modification Reject
+  "02 01 d7 1e",
+  // Bearer Resource Modification Request
+  "02 01 d6 50 " TEST_NAS_CODEC_TFT " 5b 01 09 58 24 " TEST_NAS_CODEC_PCO,
+  // Deactivate EPS Bearer Context Accept
+  "52 00 ce " TEST_NAS_CODEC_PCO,
+  // Deactivate EPS Bearer Context Request
+  "52 00 cd 24 " TEST_NAS_CODEC_PCO,
+  // ESM Information Request
+  "02 01 d9",
+  // ESM Information Response
+  "02 01 da 28 04 03 6f 61 69 " TEST_NAS_CODEC_PCO,
+  // ESM Status
+  "02 01 e8 51",
+  // Modify EPS Bearer Context Accept
+  "52 00 ca " TEST_NAS_CODEC_PCO,
+  // Modify EPS Bearer Context Reject
+  "52 00 cb 1f",
+  // Modify EPS Bearer Context Request
+  "52 00 c9 5b 01 09 32 00 81 34 01 00 5e 02 fe fe " TEST_NAS_CODEC_PCO,
+  // PDN Connectivity Reject
+  "02 01 d1 1b " TEST_NAS_CODEC_PCO,
+  // PDN Connectivity Request
+  "02 01 d0 11 d1 28 04 03 6f 61 69 " TEST_NAS_CODEC_PCO,
+  "02 01 d0 31",
+  // PDN Disconnect Reject
+  "02 01 d3 31 " TEST_NAS_CODEC_PCO,
+  // PDN Disconnect Request
+  "02 01 d2 05 " TEST_NAS_CODEC_PCO,
+  NULL
+};
+
+//------------------------------------------------------------------------------
+static bstring test_nas_codec_pdu (const char *hex)
+{
+  bstring                                 pdu = bfromcstralloc (TEST_NAS_CODEC_MAX_LENGTH, "");
+  char                                   *end = NULL;
+
+  while (*hex) {
+    uint8_t                                 octet = (uint8_t)strtoul (hex, &end, 16);
+
+    ck_assert (end != hex);
+    bconchar (pdu, octet);
+    for (hex = end; *hex == ' '; hex++);
+  }
+  return pdu;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The Tracking Area Update Request and the Extended Service Request are uplink
+ * only messages, their encode_xxx() codecs do not write the same octets as
+ * their decode_xxx() codecs read, the generated codec follows the decoders.
+ */
+static bool test_nas_codec_same_encoding (const uint8_t message_type)
+{
+  return (message_type != TRACKING_AREA_UPDATE_REQUEST) && (message_type != EXTENDED_SERVICE_REQUEST);
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Decodes the EMM PDU with both codecs, returns the decode result.
+ */
+static int test_nas_codec_compare_emm (uint8_t * const pdu, const uint32_t pdu_length, const bool recorded)
+{
+  const test_nas_codec_emm_t             *codecs = NULL;
+  EMM_msg                                 hand;
+  EMM_msg                                 generated;
+  uint8_t                                 hand_buffer[TEST_NAS_CODEC_MAX_LENGTH];
+  uint8_t                                 generated_buffer[TEST_NAS_CODEC_MAX_LENGTH];
+  uint8_t                                 message_type = 0;
+  uint8_t                                *body = NULL;
+  uint32_t                                length = 0;
+  int                                     hand_result = 0;
+  int                                     generated_result = 0;
+
+  if (pdu_length < 2) {
+    return TLV_BUFFER_TOO_SHORT;
+  }
+  message_type = pdu[1];
+  body = &pdu[2];
+  length = pdu_length - 2;
+  codecs = &test_nas_codec_emm[message_type];
+  memset (&generated, 0, sizeof (generated));
+  generated.header.message_type = message_type;
+  if (!codecs->decode) {
+    ck_assert_int_eq (nas_codec_decode_emm (&generated, body, length), TLV_WRONG_MESSAGE_TYPE);
+    return TLV_WRONG_MESSAGE_TYPE;
+  }
+
+  memset (&hand, 0, sizeof (hand));
+  hand.header.message_type = message_type;
+  hand_result = codecs->decode (&hand, body, length);
+  generated_result = nas_codec_decode_emm (&generated, body, length);
+  if ((generated_result == TLV_BUFFER_TOO_SHORT) && ((hand_result < 0) || (hand_result > (int)length))) {
+    // an IE ran past the message end, the decode_xxx() codec read on
+    return generated_result;
+  }
+  ck_assert_msg (hand_result == generated_result, "EMM message 0x%02x decoded %d by hand, %d by the generated codec", message_type, hand_result, generated_result);
+  if (recorded) {
+    ck_assert_msg (hand_result == (int)length, "recorded EMM message 0x%02x decoded %d out of %u", message_type, hand_result, length);
+  }
+  if (hand_result < 0) {
+    return hand_result;
+  }
+
+  hand_result = codecs->encode (&hand, hand_buffer, sizeof (hand_buffer));
+  generated_result = nas_codec_encode_emm (&generated, generated_buffer, sizeof (generated_buffer));
+  if (test_nas_codec_same_encoding (message_type)) {
+    ck_assert_msg (hand_result == generated_result, "EMM message 0x%02x encoded %d by hand, %d by the generated codec", message_type, hand_result, generated_result);
+    ck_assert_msg ((hand_result <= 0) || !memcmp (hand_buffer, generated_buffer, hand_result), "EMM message 0x%02x encodings differ", message_type);
+  } else if (recorded) {
+    ck_assert_msg ((generated_result == (int)length) && !memcmp (body, generated_buffer, length), "EMM message 0x%02x not encoded back", message_type);
+  }
+  return length;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Decodes the ESM PDU with both codecs, returns the decode result.
+ */
+static int test_nas_codec_compare_esm (uint8_t * const pdu, const uint32_t pdu_length, const bool recorded)
+{
+  const test_nas_codec_esm_t             *codecs = NULL;
+  ESM_msg                                 hand;
+  ESM_msg                                 generated;
+  uint8_t                                 hand_buffer[TEST_NAS_CODEC_MAX_LENGTH];
+  uint8_t                                 generated_buffer[TEST_NAS_CODEC_MAX_LENGTH];
+  uint8_t                                 message_type = 0;
+  uint8_t                                *body = NULL;
+  uint32_t                                length = 0;
+  int                                     hand_result = 0;
+  int                                     generated_result = 0;
+
+  if (pdu_length < 3) {
+    return TLV_BUFFER_TOO_SHORT;
+  }
+  message_type = pdu[2];
+  body = &pdu[3];
+  length = pdu_length - 3;
+  codecs = &test_nas_codec_esm[message_type];
+  memset (&generated, 0, sizeof (generated));
+  generated.header.message_type = message_type;
+  if (!codecs->decode) {
+    ck_assert_int_eq (nas_codec_decode_esm (&generated, body, length), TLV_WRONG_MESSAGE_TYPE);
+    return TLV_WRONG_MESSAGE_TYPE;
+  }
+
+  memset (&hand, 0, sizeof (hand));
+  hand.header.message_type = message_type;
+  hand_result = codecs->decode (&hand, body, length);
+  generated_result = nas_codec_decode_esm (&generated, body, length);
+  if ((generated_result == TLV_BUFFER_TOO_SHORT) && ((hand_result < 0) || (hand_result > (int)length))) {
+    // an IE ran past the message end, the decode_xxx() codec read on
+    return generated_result;
+  }
+  ck_assert_msg (hand_result == generated_result, "ESM message 0x%02x decoded %d by hand, %d by the generated codec", message_type, hand_result, generated_result);
+  if (recorded) {
+    ck_assert_msg (hand_result == (int)length, "recorded ESM message 0x%02x decoded %d out of %u", message_type, hand_result, length);
+  }
+  if (hand_result < 0) {
+    return hand_result;
+  }
+
+  hand_result = codecs->encode (&hand, hand_buffer, sizeof (hand_buffer));
+  generated_result = nas_codec_encode_esm (&generated, generated_buffer, sizeof (generated_buffer));
+  ck_assert_msg (hand_result == generated_result, "ESM message 0x%02x encoded %d by hand, %d by the generated codec", message_type, hand_result, generated_result);
+  ck_assert_msg ((hand_result <= 0) || !memcmp (hand_buffer, generated_buffer, hand_result), "ESM message 0x%02x encodings differ", message_type);
+  return length;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * The decode_xxx() codecs may read past the message end, up to the 64K an LV-E
+ * length reaches, the PDU is decoded from a zero padded buffer.
+ */
+static int test_nas_codec_compare (bstring pdu, const bool recorded)
+{
+  static uint8_t                          padded[TEST_NAS_CODEC_MAX_LENGTH + 0x20000];
+  int                                     result = 0;
+
+  if (blength (pdu) < 1) {
+    return TLV_BUFFER_TOO_SHORT;
+  }
+  memcpy (padded, pdu->data, blength (pdu));
+  if ((padded[0] & 0x0f) == EPS_SESSION_MANAGEMENT_MESSAGE) {
+    result = test_nas_codec_compare_esm (padded, blength (pdu), recorded);
+  } else {
+    result = test_nas_codec_compare_emm (padded, blength (pdu), recorded);
+  }
+  memset (padded, 0, blength (pdu));
+  return result;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Some IE codecs abort on the IE, whatever its value, like the Linked TI and
+ * the Emergency Number List ones, or on malformed IE values, like the Access
+ * Point Name one. Mutated PDUs which may reach them are left out.
+ */
+static bool test_nas_codec_may_abort (bstring pdu)
+{
+  uint8_t                                 abort_iei = 0;
+  int                                     i = 0;
+
+  if (blength (pdu) < 3) {
+    return false;
+  }
+  if ((pdu->data[0] & 0x0f) == EPS_SESSION_MANAGEMENT_MESSAGE) {
+    switch (pdu->data[2]) {
+    case ACTIVATE_DEFAULT_EPS_BEARER_CONTEXT_REQUEST:
+    case ESM_INFORMATION_RESPONSE:
+    case PDN_CONNECTIVITY_REQUEST:
+      return true;
+    case ACTIVATE_DEDICATED_EPS_BEARER_CONTEXT_REQUEST:
+      abort_iei = SM_LINKED_TI_IEI;
+      break;
+    default:
+      return false;
+    }
+  } else {
+    switch (pdu->data[1]) {
+    case ATTACH_ACCEPT:
+    case TRACKING_AREA_UPDATE_ACCEPT:
+      abort_iei = MM_EMERGENCY_NUMBER_LIST_IEI;
+      break;
+    default:
+      return false;
+    }
+  }
+  for (i = 0; i < blength (pdu); i++) {
+    if (pdu->data[i] == abort_iei) {
+      return true;
+    }
+  }
+  return false;
+}
+
+START_TEST(nas_codec_recorded_test)
+{
+  bool                                    emm_covered[256] = {false};
+  bool                                    esm_covered[256] = {false};
+  int                                     i = 0;
+
+  for (i = 0; test_nas_codec_pdus[i]; i++) {
+    bstring                                 pdu = test_nas_codec_pdu (test_nas_codec_pdus[i]);
+
+    ck_assert_msg (test_nas_codec_compare (pdu, true) >= 0, "recorded PDU %d rejected", i);
+    if ((pdu->data[0] & 0x0f) == EPS_SESSION_MANAGEMENT_MESSAGE) {
+      esm_covered[pdu->data[2]] = true;
+    } else {
+      emm_covered[pdu->data[1]] = true;
+    }
+    bdestroy (pdu);
+  }
+  for (i = 0; i < 256; i++) {
+    ck_assert_msg (!test_nas_codec_emm[i].decode || emm_covered[i], "no recorded PDU for EMM message 0x%02x", i);
+    ck_assert_msg (!test_nas_codec_esm[i].decode || esm_covered[i], "no recorded PDU for ESM message 0x%02x", i);
+  }
+}
+END_TEST
+
+/*
+ * The Service Request is not a standard L3 message, emm_msg_decode() does not
+ * decode it, it is only encoded by both codecs.
+ */
+START_TEST(nas_codec_service_request_test)
+{
+  EMM_msg                                 msg;
+  uint8_t                                 hand_buffer[TEST_NAS_CODEC_MAX_LENGTH];
+  uint8_t                                 generated_buffer[TEST_NAS_CODEC_MAX_LENGTH];
+  int                                     hand_result = 0;
+  int                                     generated_result = 0;
+
+  memset (&msg, 0, sizeof (msg));
+  msg.header.message_type = SERVICE_REQUEST;
+  msg.service_request.ksiandsequencenumber.ksi = 1;
+  msg.service_request.ksiandsequencenumber.sequencenumber = 0x15;
+  msg.service_request.messageauthenticationcode = 0xabcd;
+  hand_result = encode_service_request (&msg.service_request, hand_buffer, sizeof (hand_buffer));
+  generated_result = nas_codec_encode_emm (&msg, generated_buffer, sizeof (generated_buffer));
+  ck_assert_int_eq (hand_result, 3);
+  ck_assert_int_eq (generated_result, hand_result);
+  ck_assert (memcmp (hand_buffer, generated_buffer, hand_result) == 0);
+  ck_assert_int_eq (nas_codec_decode_emm (&msg, hand_buffer, hand_result), TLV_WRONG_MESSAGE_TYPE);
+}
+END_TEST
+
+START_TEST(nas_codec_fuzz_test)
+{
+  bstring                                 mutated = NULL;
+  uint32_t                                nb_pdus = 0;
+  uint32_t                                nb_accepted = 0;
+  uint32_t                                nb_skipped = 0;
+  uint32_t                                i = 0;
+  uint32_t                                j = 0;
+
+  srandom (1);
+  for (nb_pdus = 0; test_nas_codec_pdus[nb_pdus]; nb_pdus++);
+  for (i = 0; i < TEST_NAS_CODEC_NB_MUTATIONS; i++) {
+    mutated = test_nas_codec_pdu (test_nas_codec_pdus[random () % nb_pdus]);
+    switch (random () % 4) {
+    case 0:
+      // flip a few bits of the message body
+      for (j = 1 + random () % 4; j > 0; j--) {
+        mutated->data[random () % blength (mutated)] ^= (uint8_t)(1 << (random () % 8));
+      }
+      break;
+    case 1:
+      // truncate
+      btrunc (mutated, random () % blength (mutated));
+      break;
+    case 2:
+      // random IEI or length octet
+      mutated->data[random () % blength (mutated)] = (uint8_t)random ();
+      break;
+    default:
+      // unknown or repeated optional IE appended
+      bconchar (mutated, (char)random ());
+      bconchar (mutated, (char)(random () % 4));
+      bconchar (mutated, (char)random ());
+      break;
+    }
+    if (test_nas_codec_may_abort (mutated)) {
+      nb_skipped++;
+    } else if (test_nas_codec_compare (mutated, false) > 0) {
+      nb_accepted++;
+    }
+    bdestroy (mutated);
+  }
+  printf ("%u mutated NAS PDUs out of %u decoded by both codecs, %u left out\n", nb_accepted, TEST_NAS_CODEC_NB_MUTATIONS, nb_skipped);
+}
+END_TEST
+
+Suite * nas_codec_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("NAS generated codec tests");
+
+    /* Core test case */
+    tc_core = tcase_create("NAS generated codec test");
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, nas_codec_recorded_test);
+    tcase_add_test(tc_core, nas_codec_service_request_test);
+    tcase_add_test(tc_core, nas_codec_fuzz_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = nas_codec_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
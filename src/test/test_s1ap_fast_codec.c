@@ -0,0 +1,359 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * S1AP fast path codec tests: UplinkNASTransport PDUs encoded by asn1c with
+ * random IE values are decoded by both codecs and must agree, DownlinkNASTransport
+ * and UEContextReleaseCommand PDUs encoded by the fast path templates must be
+ * byte identical to the asn1c ones.
+ * Mutated PDUs must either be rejected by the fast path or decoded the same
+ * way by both codecs.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "intertask_interface.h"
+#include "conversions.h"
+#include "s1ap_common.h"
+#include "s1ap_ies_defs.h"
+#include "s1ap_mme_decoder.h"
+#include "s1ap_mme_encoder.h"
+#include "s1ap_mme.h"
+#include "s1ap_mme_fast_codec.h"
+#include "s1ap_mme_handlers.h"
+
+#define TEST_S1AP_FAST_CODEC_NB_PDUS       10000
+#define TEST_S1AP_FAST_CODEC_NB_MUTATIONS  100000
+#define TEST_S1AP_FAST_CODEC_MAX_NAS       1000
+
+static uint8_t                          nas_pdu[TEST_S1AP_FAST_CODEC_MAX_NAS];
+
+//------------------------------------------------------------------------------
+static uint32_t test_s1ap_fast_codec_random (const uint32_t max)
+{
+  return (uint32_t)(((uint64_t)random () << 16 ^ (uint64_t)random ()) % ((uint64_t)max + 1));
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Random UplinkNASTransport encoded by asn1c, NAS PDU length spans both
+ * length determinant sizes.
+ */
+static bstring test_s1ap_fast_codec_encode_uplink (void)
+{
+  S1ap_UplinkNASTransportIEs_t            ies;
+  S1ap_UplinkNASTransport_t               msg;
+  uint8_t                                 plmn_identity[3];
+  uint8_t                                 tai_plmn_identity[3];
+  uint8_t                                 tac[2];
+  uint8_t                                 cell_id[4];
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  bstring                                 raw = NULL;
+  uint32_t                                i = 0;
+
+  memset (&ies, 0, sizeof (ies));
+  memset (&msg, 0, sizeof (msg));
+  // 0, small and full width ids
+  ies.mme_ue_s1ap_id = (random () & 1) ? test_s1ap_fast_codec_random (0xffffffff) : test_s1ap_fast_codec_random (300);
+  ies.eNB_UE_S1AP_ID = (random () & 1) ? test_s1ap_fast_codec_random (0x00ffffff) : test_s1ap_fast_codec_random (300);
+  for (i = 0; i < 3; i++) {
+    plmn_identity[i] = (uint8_t)random ();
+    tai_plmn_identity[i] = (uint8_t)random ();
+  }
+  tac[0] = (uint8_t)random ();
+  tac[1] = (uint8_t)random ();
+  for (i = 0; i < 4; i++) {
+    cell_id[i] = (uint8_t)random ();
+  }
+  cell_id[3] &= 0xf0;
+  ies.nas_pdu.size = 1 + test_s1ap_fast_codec_random (TEST_S1AP_FAST_CODEC_MAX_NAS - 1);
+  for (i = 0; i < ies.nas_pdu.size; i++) {
+    nas_pdu[i] = (uint8_t)random ();
+  }
+  ies.nas_pdu.buf = nas_pdu;
+  ies.eutran_cgi.pLMNidentity.buf = plmn_identity;
+  ies.eutran_cgi.pLMNidentity.size = sizeof (plmn_identity);
+  ies.eutran_cgi.cell_ID.buf = cell_id;
+  ies.eutran_cgi.cell_ID.size = sizeof (cell_id);
+  ies.eutran_cgi.cell_ID.bits_unused = 4;
+  ies.tai.tAC.buf = tac;
+  ies.tai.tAC.size = sizeof (tac);
+  ies.tai.pLMNidentity.buf = tai_plmn_identity;
+  ies.tai.pLMNidentity.size = sizeof (tai_plmn_identity);
+  ck_assert (s1ap_encode_s1ap_uplinknastransporties (&msg, &ies) == 0);
+  ck_assert (s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_uplinkNASTransport, S1ap_Criticality_ignore,
+                                               &asn_DEF_S1ap_UplinkNASTransport, &msg) == 0);
+  raw = blk2bstr (buffer, length);
+  free_wrapper ((void**)&buffer);
+  return raw;
+}
+
+//------------------------------------------------------------------------------
+/*
+ * Decodes raw with both codecs, returns false if the fast path rejected it.
+ */
+static bool test_s1ap_fast_codec_compare_uplink (const_bstring const raw)
+{
+  s1ap_uplink_nas_transport_t             fast = {0};
+  s1ap_message                            message = {0};
+  MessagesIds                             message_id = MESSAGES_ID_MAX;
+  S1ap_UplinkNASTransportIEs_t           *ies = NULL;
+  tai_t                                   tai = {0};
+  ecgi_t                                  ecgi = {.plmn = {0}, .cell_identity = {0}};
+
+  if (s1ap_mme_fast_decode_uplink_nas_transport (raw, &fast) != RETURNok) {
+    return false;
+  }
+
+  ck_assert_msg (s1ap_mme_decode_pdu (&message, raw, &message_id) == 0, "PDU accepted by the fast path only");
+  ck_assert (message.procedureCode == S1ap_ProcedureCode_id_uplinkNASTransport);
+  ck_assert (message.direction == S1AP_PDU_PR_initiatingMessage);
+  ies = &message.msg.s1ap_UplinkNASTransportIEs;
+  ck_assert_uint_eq (fast.mme_ue_s1ap_id, ies->mme_ue_s1ap_id);
+  ck_assert_uint_eq (fast.enb_ue_s1ap_id, ies->eNB_UE_S1AP_ID);
+  ck_assert_uint_eq (fast.nas_pdu_length, ies->nas_pdu.size);
+  ck_assert (fast.nas_pdu_offset + fast.nas_pdu_length <= (uint32_t)blength (raw));
+  ck_assert (memcmp (&raw->data[fast.nas_pdu_offset], ies->nas_pdu.buf, ies->nas_pdu.size) == 0);
+  OCTET_STRING_TO_TAC (&ies->tai.tAC, tai.tac);
+  TBCD_TO_PLMN_T (&ies->tai.pLMNidentity, &tai);
+  TBCD_TO_PLMN_T (&ies->eutran_cgi.pLMNidentity, &ecgi.plmn);
+  BIT_STRING_TO_CELL_IDENTITY (&ies->eutran_cgi.cell_ID, ecgi.cell_identity);
+  ck_assert (memcmp (&fast.tai, &tai, sizeof (tai)) == 0);
+  ck_assert (memcmp (&fast.ecgi, &ecgi, sizeof (ecgi)) == 0);
+  s1ap_free_mme_decode_pdu (&message, message_id);
+  return true;
+}
+
+START_TEST(s1ap_fast_codec_uplink_test)
+{
+  bstring                                 raw = NULL;
+  uint32_t                                i = 0;
+
+  srandom (1);
+  for (i = 0; i < TEST_S1AP_FAST_CODEC_NB_PDUS; i++) {
+    raw = test_s1ap_fast_codec_encode_uplink ();
+    ck_assert_msg (test_s1ap_fast_codec_compare_uplink (raw), "asn1c encoded UplinkNASTransport rejected by the fast path");
+    bdestroy (raw);
+  }
+}
+END_TEST
+
+START_TEST(s1ap_fast_codec_uplink_fuzz_test)
+{
+  bstring                                 raw = NULL;
+  bstring                                 mutated = NULL;
+  uint32_t                                nb_accepted = 0;
+  uint32_t                                i = 0;
+  uint32_t                                j = 0;
+
+  srandom (2);
+  raw = test_s1ap_fast_codec_encode_uplink ();
+  for (i = 0; i < TEST_S1AP_FAST_CODEC_NB_MUTATIONS; i++) {
+    if (!(i % 1000)) {
+      bdestroy (raw);
+      raw = test_s1ap_fast_codec_encode_uplink ();
+    }
+    mutated = bstrcpy (raw);
+    switch (random () % 3) {
+    case 0:
+      // flip a few bits
+      for (j = 1 + random () % 4; j > 0; j--) {
+        mutated->data[random () % blength (mutated)] ^= (uint8_t)(1 << (random () % 8));
+      }
+      break;
+    case 1:
+      // truncate
+      btrunc (mutated, random () % blength (mutated));
+      break;
+    default:
+      // random byte in the header part
+      mutated->data[random () % ((blength (mutated) < 64) ? blength (mutated) : 64)] = (uint8_t)random ();
+      break;
+    }
+    if (test_s1ap_fast_codec_compare_uplink (mutated)) {
+      nb_accepted++;
+    }
+    bdestroy (mutated);
+  }
+  bdestroy (raw);
+  printf ("%u mutated UplinkNASTransport PDUs out of %u decoded by the fast path\n", nb_accepted, TEST_S1AP_FAST_CODEC_NB_MUTATIONS);
+}
+END_TEST
+
+START_TEST(s1ap_fast_codec_downlink_test)
+{
+  s1ap_message                            message = {0};
+  S1ap_DownlinkNASTransportIEs_t         *ies = NULL;
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  bstring                                 nas = NULL;
+  bstring                                 pdu = NULL;
+  uint32_t                                i = 0;
+  uint32_t                                j = 0;
+
+  srandom (3);
+  for (i = 0; i < TEST_S1AP_FAST_CODEC_NB_PDUS; i++) {
+    memset (&message, 0, sizeof (message));
+    message.procedureCode = S1ap_ProcedureCode_id_downlinkNASTransport;
+    message.direction = S1AP_PDU_PR_initiatingMessage;
+    ies = &message.msg.s1ap_DownlinkNASTransportIEs;
+    ies->mme_ue_s1ap_id = (random () & 1) ? test_s1ap_fast_codec_random (0xffffffff) : test_s1ap_fast_codec_random (300);
+    ies->eNB_UE_S1AP_ID = (random () & 1) ? test_s1ap_fast_codec_random (0x00ffffff) : test_s1ap_fast_codec_random (300);
+    nas = bfromcstralloc (TEST_S1AP_FAST_CODEC_MAX_NAS, "");
+    for (j = 1 + test_s1ap_fast_codec_random (TEST_S1AP_FAST_CODEC_MAX_NAS - 2); j > 0; j--) {
+      bconchar (nas, (char)random ());
+    }
+    OCTET_STRING_fromBuf (&ies->nas_pdu, (char *)bdata (nas), blength (nas));
+    ck_assert (s1ap_mme_encode_pdu (&message, &buffer, &length) == 0);
+
+    ck_assert (s1ap_mme_fast_encode_downlink_nas_transport (ies->mme_ue_s1ap_id, ies->eNB_UE_S1AP_ID, nas, &pdu) == RETURNok);
+    ck_assert_uint_eq (blength (pdu), length);
+    ck_assert_msg (memcmp (bdata (pdu), buffer, length) == 0, "fast path DownlinkNASTransport differs from asn1c, NAS length %d", blength (nas));
+
+    free_wrapper ((void**)&buffer);
+    bdestroy (pdu);
+    bdestroy (nas);
+  }
+}
+END_TEST
+
+START_TEST(s1ap_fast_codec_ue_context_release_test)
+{
+  // root values of the cause choices, radioNetwork first
+  const long                              nb_cause_values[] = {36, 2, 4, 7, 6};
+  s1ap_message                            message = {0};
+  S1ap_UEContextReleaseCommandIEs_t      *ies = NULL;
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  bstring                                 pdu = NULL;
+  uint32_t                                i = 0;
+  long                                    cause_value = 0;
+
+  srandom (4);
+  for (i = 0; i < sizeof (nb_cause_values) / sizeof (nb_cause_values[0]); i++) {
+    for (cause_value = 0; cause_value < nb_cause_values[i]; cause_value++) {
+      memset (&message, 0, sizeof (message));
+      message.procedureCode = S1ap_ProcedureCode_id_UEContextRelease;
+      message.direction = S1AP_PDU_PR_initiatingMessage;
+      ies = &message.msg.s1ap_UEContextReleaseCommandIEs;
+      ies->uE_S1AP_IDs.present = S1ap_UE_S1AP_IDs_PR_uE_S1AP_ID_pair;
+      ies->uE_S1AP_IDs.choice.uE_S1AP_ID_pair.mME_UE_S1AP_ID = test_s1ap_fast_codec_random (0xffffffff) >> (random () % 32);
+      ies->uE_S1AP_IDs.choice.uE_S1AP_ID_pair.eNB_UE_S1AP_ID = test_s1ap_fast_codec_random (0x00ffffff) >> (random () % 24);
+      s1ap_mme_set_cause (&ies->cause, S1ap_Cause_PR_radioNetwork + i, cause_value);
+      ck_assert (s1ap_mme_encode_pdu (&message, &buffer, &length) == 0);
+
+      ck_assert (s1ap_mme_fast_encode_ue_context_release_command (ies->uE_S1AP_IDs.choice.uE_S1AP_ID_pair.mME_UE_S1AP_ID,
+          ies->uE_S1AP_IDs.choice.uE_S1AP_ID_pair.eNB_UE_S1AP_ID, S1ap_Cause_PR_radioNetwork + i, cause_value, &pdu) == RETURNok);
+      ck_assert_uint_eq (blength (pdu), length);
+      ck_assert_msg (memcmp (bdata (pdu), buffer, length) == 0, "fast path UEContextReleaseCommand differs from asn1c, cause %u/%ld", i, cause_value);
+      free_wrapper ((void**)&buffer);
+      bdestroy (pdu);
+    }
+    // extension values go to asn1c
+    ck_assert (s1ap_mme_fast_encode_ue_context_release_command (1, 1, S1ap_Cause_PR_radioNetwork + i, nb_cause_values[i], &pdu) == RETURNerror);
+  }
+}
+END_TEST
+
+START_TEST(s1ap_fast_codec_fallback_test)
+{
+  S1ap_InitialUEMessageIEs_t              ies;
+  S1ap_InitialUEMessage_t                 msg;
+  s1ap_uplink_nas_transport_t             fast = {0};
+  uint8_t                                 plmn_identity[] = { 0x02, 0x08, 0x34 };
+  uint8_t                                 tac[] = { 0x00, 0x01 };
+  uint8_t                                 cell_id[] = { 0x03, 0x56, 0xf0, 0xd0 };
+  uint8_t                                 attach_request[] = { 0x07, 0x41, 0x71, 0x08, 0x29, 0x80, 0x43, 0x21, 0x43, 0x65, 0x87, 0xf9 };
+  uint8_t                                *buffer = NULL;
+  uint32_t                                length = 0;
+  bstring                                 raw = NULL;
+
+  // Other procedures go to asn1c
+  memset (&ies, 0, sizeof (ies));
+  memset (&msg, 0, sizeof (msg));
+  ies.eNB_UE_S1AP_ID = 1;
+  ies.nas_pdu.buf = attach_request;
+  ies.nas_pdu.size = sizeof (attach_request);
+  ies.tai.tAC.buf = tac;
+  ies.tai.tAC.size = sizeof (tac);
+  ies.tai.pLMNidentity.buf = plmn_identity;
+  ies.tai.pLMNidentity.size = sizeof (plmn_identity);
+  ies.eutran_cgi.pLMNidentity.buf = plmn_identity;
+  ies.eutran_cgi.pLMNidentity.size = sizeof (plmn_identity);
+  ies.eutran_cgi.cell_ID.buf = cell_id;
+  ies.eutran_cgi.cell_ID.size = sizeof (cell_id);
+  ies.eutran_cgi.cell_ID.bits_unused = 4;
+  ies.rrC_Establishment_Cause = S1ap_RRC_Establishment_Cause_mo_Signalling;
+  ck_assert (s1ap_encode_s1ap_initialuemessageies (&msg, &ies) == 0);
+  ck_assert (s1ap_generate_initiating_message (&buffer, &length, S1ap_ProcedureCode_id_initialUEMessage, S1ap_Criticality_ignore,
+                                               &asn_DEF_S1ap_InitialUEMessage, &msg) == 0);
+  raw = blk2bstr (buffer, length);
+  free_wrapper ((void**)&buffer);
+  ck_assert (s1ap_mme_fast_decode_uplink_nas_transport (raw, &fast) == RETURNerror);
+  bdestroy (raw);
+
+  ck_assert (s1ap_mme_fast_decode_uplink_nas_transport (NULL, &fast) == RETURNerror);
+  ck_assert (s1ap_mme_fast_encode_downlink_nas_transport (1, 0x01000000, NULL, &raw) == RETURNerror);
+}
+END_TEST
+
+Suite * s1ap_fast_codec_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S1AP fast codec tests");
+
+    /* Core test case */
+    tc_core = tcase_create("S1AP fast codec test");
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, s1ap_fast_codec_uplink_test);
+    tcase_add_test(tc_core, s1ap_fast_codec_uplink_fuzz_test);
+    tcase_add_test(tc_core, s1ap_fast_codec_downlink_test);
+    tcase_add_test(tc_core, s1ap_fast_codec_ue_context_release_test);
+    tcase_add_test(tc_core, s1ap_fast_codec_fallback_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s1ap_fast_codec_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,214 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*
+ * S1AP SCTP stream selection tests: UE associated signalling is hashed over
+ * the negotiated outbound streams, stream 0 stays reserved for non UE
+ * associated procedures. The second test runs the downlink S1AP traffic of
+ * one eNB through a model of a lossy SCTP association (per stream ordered
+ * delivery, lost DATA chunks retransmitted after an RTO) and compares the
+ * tail latency of a single UE stream with the hashed stream selection.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+#include "s1ap_mme.h"
+
+#define TEST_S1AP_STREAM_OUTSTREAMS      32
+#define TEST_S1AP_STREAM_NB_UES          1000
+#define TEST_S1AP_STREAM_NB_MSGS         100000
+#define TEST_S1AP_STREAM_MSG_PERIOD_US   100       // 10000 S1AP PDUs per second towards the eNB
+#define TEST_S1AP_STREAM_DELAY_US        500       // one way delay
+#define TEST_S1AP_STREAM_RTO_US          20000     // retransmission of a lost DATA chunk
+#define TEST_S1AP_STREAM_LOSS            0.001
+
+//------------------------------------------------------------------------------
+// xorshift64, deterministic loss and UE patterns
+static uint64_t test_s1ap_stream_random_state = 88172645463325252ULL;
+
+static double test_s1ap_stream_random (void)
+{
+  test_s1ap_stream_random_state ^= test_s1ap_stream_random_state << 13;
+  test_s1ap_stream_random_state ^= test_s1ap_stream_random_state >> 7;
+  test_s1ap_stream_random_state ^= test_s1ap_stream_random_state << 17;
+  return (double)(test_s1ap_stream_random_state >> 11) / (double)(1ULL << 53);
+}
+
+//------------------------------------------------------------------------------
+static int test_s1ap_stream_compare_latency (const void *a, const void *b)
+{
+  const uint32_t                          la = *(const uint32_t *)a;
+  const uint32_t                          lb = *(const uint32_t *)b;
+
+  return (la < lb) ? -1 : (la > lb);
+}
+
+//------------------------------------------------------------------------------
+// returns the p99 delivery latency in microseconds
+static uint32_t test_s1ap_stream_lossy_association (ue_description_t * const ues, const bool hashed)
+{
+  uint64_t                                last_delivery[TEST_S1AP_STREAM_OUTSTREAMS] = {0};
+  uint32_t                               *latencies = NULL;
+  uint64_t                                send_time = 0;
+  uint64_t                                delivery = 0;
+  sctp_stream_id_t                        stream = 0;
+  uint32_t                                ue = 0;
+  uint32_t                                i = 0;
+  uint32_t                                p99 = 0;
+
+  latencies = calloc (TEST_S1AP_STREAM_NB_MSGS, sizeof (uint32_t));
+  ck_assert (latencies != NULL);
+  test_s1ap_stream_random_state = 88172645463325252ULL;
+
+  for (i = 0; i < TEST_S1AP_STREAM_NB_MSGS; i++) {
+    send_time = (uint64_t)i * TEST_S1AP_STREAM_MSG_PERIOD_US;
+    ue = (uint32_t)(test_s1ap_stream_random () * TEST_S1AP_STREAM_NB_UES);
+    stream = hashed ? s1ap_mme_ue_stream (&ues[ue]) : 1;
+    ck_assert (stream < TEST_S1AP_STREAM_OUTSTREAMS);
+
+    delivery = send_time + TEST_S1AP_STREAM_DELAY_US;
+    while (test_s1ap_stream_random () < TEST_S1AP_STREAM_LOSS) {
+      delivery += TEST_S1AP_STREAM_RTO_US;
+    }
+    // ordered delivery: a chunk waits for every chunk sent before it on the same stream
+    if (delivery < last_delivery[stream]) {
+      delivery = last_delivery[stream];
+    }
+    last_delivery[stream] = delivery;
+    latencies[i] = (uint32_t)(delivery - send_time);
+  }
+
+  qsort (latencies, TEST_S1AP_STREAM_NB_MSGS, sizeof (uint32_t), test_s1ap_stream_compare_latency);
+  p99 = latencies[(TEST_S1AP_STREAM_NB_MSGS * 99) / 100];
+  printf ("%s: p50 %u us, p99 %u us, max %u us\n", hashed ? "hashed streams" : "single stream ",
+      latencies[TEST_S1AP_STREAM_NB_MSGS / 2], p99, latencies[TEST_S1AP_STREAM_NB_MSGS - 1]);
+  free (latencies);
+  return p99;
+}
+
+START_TEST(s1ap_stream_selection_policy_test)
+{
+  enb_description_t                       enb = {0};
+  ue_description_t                        ue = {0};
+  uint32_t                                count[TEST_S1AP_STREAM_OUTSTREAMS] = {0};
+  sctp_stream_id_t                        stream = 0;
+  uint32_t                                i = 0;
+
+  ue.enb = &enb;
+  ue.enb_ue_s1ap_id = 7;
+  ue.mme_ue_s1ap_id = INVALID_MME_UE_S1AP_ID;
+
+  // a single outbound stream is shared with non UE associated signalling
+  enb.outstreams = 1;
+  ck_assert (s1ap_mme_ue_stream (&ue) == 0);
+  enb.outstreams = 2;
+  ck_assert (s1ap_mme_ue_stream (&ue) == 1);
+
+  // enb_ue_s1ap_id is used until MME_APP allocates the mme_ue_s1ap_id
+  enb.outstreams = TEST_S1AP_STREAM_OUTSTREAMS;
+  stream = s1ap_mme_ue_stream (&ue);
+  ck_assert (stream > 0);
+  ue.enb_ue_s1ap_id = 8;
+  ue.mme_ue_s1ap_id = 7;
+  ck_assert (s1ap_mme_ue_stream (&ue) == stream);
+  ue.enb_ue_s1ap_id = 9;
+  ck_assert (s1ap_mme_ue_stream (&ue) == stream);
+
+  // consecutive mme_ue_s1ap_id spread evenly over streams 1..outstreams-1
+  for (i = 1; i <= 1000 * (TEST_S1AP_STREAM_OUTSTREAMS - 1); i++) {
+    ue.mme_ue_s1ap_id = i;
+    stream = s1ap_mme_ue_stream (&ue);
+    ck_assert (stream > 0);
+    ck_assert (stream < TEST_S1AP_STREAM_OUTSTREAMS);
+    count[stream]++;
+  }
+  ck_assert (count[0] == 0);
+  for (i = 1; i < TEST_S1AP_STREAM_OUTSTREAMS; i++) {
+    ck_assert_msg ((count[i] > 800) && (count[i] < 1200), "stream %u carries %u UEs out of %u", i, count[i],
+        1000 * (TEST_S1AP_STREAM_OUTSTREAMS - 1));
+  }
+}
+END_TEST
+
+START_TEST(s1ap_stream_selection_lossy_association_test)
+{
+  enb_description_t                       enb = {0};
+  ue_description_t                       *ues = NULL;
+  uint32_t                                p99_single = 0;
+  uint32_t                                p99_hashed = 0;
+  uint32_t                                i = 0;
+
+  enb.outstreams = TEST_S1AP_STREAM_OUTSTREAMS;
+  ues = calloc (TEST_S1AP_STREAM_NB_UES, sizeof (ue_description_t));
+  ck_assert (ues != NULL);
+  for (i = 0; i < TEST_S1AP_STREAM_NB_UES; i++) {
+    ues[i].enb = &enb;
+    ues[i].enb_ue_s1ap_id = i;
+    ues[i].mme_ue_s1ap_id = i + 1;
+  }
+
+  p99_single = test_s1ap_stream_lossy_association (ues, false);
+  p99_hashed = test_s1ap_stream_lossy_association (ues, true);
+  free (ues);
+
+  // a lost chunk only holds back the UEs hashed on its stream
+  ck_assert_msg (4 * p99_hashed < p99_single, "p99 latency %u us with hashed streams, %u us with a single stream", p99_hashed, p99_single);
+}
+END_TEST
+
+Suite * s1ap_stream_selection_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S1AP stream selection tests");
+
+    /* Core test case */
+    tc_core = tcase_create("S1AP stream selection test");
+    tcase_add_test(tc_core, s1ap_stream_selection_policy_test);
+    tcase_add_test(tc_core, s1ap_stream_selection_lossy_association_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s1ap_stream_selection_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
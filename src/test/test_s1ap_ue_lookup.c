@@ -0,0 +1,239 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * S1AP UE lookup tests: UE descriptors are spread over several eNBs, looked
+ * up by mme_ue_s1ap_id and by S11 SGW TEID, then removed UE by UE and eNB by
+ * eNB. The lookup cost is measured for growing UE counts and must stay flat.
+ */
+
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "dynamic_memory_check.h"
+#include "epoch.h"
+#include "hashtable.h"
+#include "mme_config.h"
+#include "s1ap_mme.h"
+#include "slab.h"
+
+#define TEST_S1AP_UES_PER_ENB        1000
+#define TEST_S1AP_NB_LOOKUPS         (1 << 20)
+#define TEST_S1AP_MAX_COST_RATIO     4.0
+
+extern hash_table_ts_t g_s1ap_enb_coll;
+extern hash_table_ts_t g_s1ap_mme_id2assoc_id_coll;
+extern hash_table_ts_t g_s1ap_ue_mme_id_coll;
+extern hash_table_ts_t g_s1ap_ue_s11_teid_coll;
+extern slab_t         *g_s1ap_ue_slab;
+
+//------------------------------------------------------------------------------
+static void test_s1ap_init_collections (const uint32_t nb_ues, const uint32_t nb_enbs)
+{
+  bstring                                 bs = NULL;
+
+  mme_config.max_enbs = nb_enbs;
+  mme_config.max_ues = nb_ues;
+  bs = bfromcstr ("test_s1ap_eNB_coll");
+  ck_assert (hashtable_ts_init (&g_s1ap_enb_coll, nb_enbs, NULL, free_wrapper, bs) != NULL);
+  btrunc (bs, 0);
+  bcatcstr (bs, "test_s1ap_mme_id2assoc_id_coll");
+  ck_assert (hashtable_ts_init (&g_s1ap_mme_id2assoc_id_coll, nb_ues, NULL, hash_free_int_func, bs) != NULL);
+  btrunc (bs, 0);
+  bcatcstr (bs, "test_s1ap_ue_mme_id_coll");
+  ck_assert (hashtable_ts_init (&g_s1ap_ue_mme_id_coll, nb_ues, NULL, hash_free_int_func, bs) != NULL);
+  btrunc (bs, 0);
+  bcatcstr (bs, "test_s1ap_ue_s11_teid_coll");
+  ck_assert (hashtable_ts_init (&g_s1ap_ue_s11_teid_coll, nb_ues, NULL, hash_free_int_func, bs) != NULL);
+  bdestroy (bs);
+  g_s1ap_ue_slab = slab_create ("test_s1ap_ue_slab", sizeof (ue_description_t), TEST_S1AP_UES_PER_ENB);
+  ck_assert (g_s1ap_ue_slab != NULL);
+}
+
+//------------------------------------------------------------------------------
+static void test_s1ap_populate (const uint32_t nb_ues, const uint32_t nb_enbs)
+{
+  enb_description_t                      *enb_ref = NULL;
+  ue_description_t                       *ue_ref = NULL;
+  uint32_t                                i = 0;
+
+  for (i = 0; i < nb_enbs; i++) {
+    enb_ref = s1ap_new_enb ();
+    enb_ref->sctp_assoc_id = i + 1;
+    enb_ref->enb_id = i + 1;
+    enb_ref->s1_state = S1AP_READY;
+    ck_assert (hashtable_ts_insert (&g_s1ap_enb_coll, (const hash_key_t)enb_ref->sctp_assoc_id, (void *)enb_ref) == HASH_TABLE_OK);
+  }
+
+  for (i = 0; i < nb_ues; i++) {
+    // enb_ue_s1ap_id values overlap between eNBs, mme_ue_s1ap_id values are MME wide
+    ue_ref = s1ap_new_ue ((i % nb_enbs) + 1, i / nb_enbs);
+    ck_assert (ue_ref != NULL);
+    ue_ref->s1ap_ue_context_rel_timer.id = S1AP_TIMER_INACTIVE_ID;
+    s1ap_notified_new_ue_mme_s1ap_id_association ((i % nb_enbs) + 1, i / nb_enbs, i + 1);
+    s1ap_set_ue_s11_sgw_teid (ue_ref, 0x80000000 + i);
+  }
+}
+
+//------------------------------------------------------------------------------
+static double test_s1ap_lookup_cost (const uint32_t nb_ues)
+{
+  struct timespec                         start_time;
+  struct timespec                         end_time;
+  ue_description_t                       *ue_ref = NULL;
+  uint32_t                                i = 0;
+  uint32_t                                id = 0;
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < TEST_S1AP_NB_LOOKUPS; i++) {
+    // spread lookups over the whole id range, multiplicative hash of the loop counter
+    id = ((i * 2654435761u) % nb_ues) + 1;
+    ue_ref = s1ap_is_ue_mme_id_in_list (id);
+    ck_assert (ue_ref != NULL);
+  }
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  return ((double)(end_time.tv_sec - start_time.tv_sec) * 1e9 + (double)(end_time.tv_nsec - start_time.tv_nsec)) / TEST_S1AP_NB_LOOKUPS;
+}
+
+//------------------------------------------------------------------------------
+static void test_s1ap_destroy_collections (void)
+{
+  hashtable_ts_destroy (&g_s1ap_enb_coll);
+  hashtable_ts_destroy (&g_s1ap_mme_id2assoc_id_coll);
+  hashtable_ts_destroy (&g_s1ap_ue_mme_id_coll);
+  hashtable_ts_destroy (&g_s1ap_ue_s11_teid_coll);
+  // released UE descriptors are deferred, no reader is left to wait for
+  while (epoch_reclaim ());
+  slab_destroy (&g_s1ap_ue_slab);
+}
+
+START_TEST(s1ap_ue_lookup_index_test)
+{
+  const uint32_t                          nb_ues = 4 * TEST_S1AP_UES_PER_ENB;
+  const uint32_t                          nb_enbs = 4;
+  enb_description_t                      *enb_ref = NULL;
+  ue_description_t                       *ue_ref = NULL;
+  uint32_t                                i = 0;
+
+  test_s1ap_init_collections (nb_ues, nb_enbs);
+  test_s1ap_populate (nb_ues, nb_enbs);
+
+  for (i = 0; i < nb_ues; i++) {
+    ue_ref = s1ap_is_ue_mme_id_in_list (i + 1);
+    ck_assert (ue_ref != NULL);
+    ck_assert (ue_ref->mme_ue_s1ap_id == i + 1);
+    ck_assert (ue_ref->enb->sctp_assoc_id == (i % nb_enbs) + 1);
+    ck_assert (ue_ref->enb_ue_s1ap_id == i / nb_enbs);
+    ck_assert (s1ap_is_s11_sgw_teid_in_list (0x80000000 + i) == ue_ref);
+  }
+  ck_assert (s1ap_is_ue_mme_id_in_list (nb_ues + 1) == NULL);
+
+  // TEID change moves the UE in the TEID index
+  ue_ref = s1ap_is_ue_mme_id_in_list (1);
+  s1ap_set_ue_s11_sgw_teid (ue_ref, 0x12345678);
+  ck_assert (s1ap_is_s11_sgw_teid_in_list (0x80000000) == NULL);
+  ck_assert (s1ap_is_s11_sgw_teid_in_list (0x12345678) == ue_ref);
+
+  // remove even UEs one by one, odd UEs with their eNB
+  for (i = 0; i < nb_ues; i += 2) {
+    s1ap_remove_ue (s1ap_is_ue_mme_id_in_list (i + 1));
+    ck_assert (s1ap_is_ue_mme_id_in_list (i + 1) == NULL);
+    ck_assert (s1ap_is_ue_mme_id_in_list (i + 2) != NULL);
+  }
+  ck_assert (s1ap_is_s11_sgw_teid_in_list (0x12345678) == NULL);
+
+  for (i = 0; i < nb_enbs; i++) {
+    enb_ref = s1ap_is_enb_assoc_id_in_list (i + 1);
+    ck_assert (enb_ref != NULL);
+    s1ap_remove_enb (enb_ref);
+  }
+  for (i = 0; i < nb_ues; i++) {
+    ck_assert (s1ap_is_ue_mme_id_in_list (i + 1) == NULL);
+    ck_assert (s1ap_is_s11_sgw_teid_in_list (0x80000000 + i) == NULL);
+  }
+
+  test_s1ap_destroy_collections ();
+}
+END_TEST
+
+START_TEST(s1ap_ue_lookup_flat_cost_test)
+{
+  const uint32_t                          nb_ues[] = {1000, 10000, 100000};
+  double                                  cost[3] = {0};
+  uint32_t                                nb_enbs = 0;
+  uint32_t                                i = 0;
+  uint32_t                                j = 0;
+
+  for (i = 0; i < sizeof (nb_ues) / sizeof (nb_ues[0]); i++) {
+    nb_enbs = nb_ues[i] / TEST_S1AP_UES_PER_ENB;
+    test_s1ap_init_collections (nb_ues[i], nb_enbs);
+    test_s1ap_populate (nb_ues[i], nb_enbs);
+    cost[i] = test_s1ap_lookup_cost (nb_ues[i]);
+    printf ("%6u UEs on %3u eNBs: %.1f ns per mme_ue_s1ap_id lookup\n", nb_ues[i], nb_enbs, cost[i]);
+    for (j = 0; j < nb_enbs; j++) {
+      s1ap_remove_enb (s1ap_is_enb_assoc_id_in_list (j + 1));
+    }
+    test_s1ap_destroy_collections ();
+  }
+
+  // a scan of every eNB would be 100 times slower for 100 times more UEs
+  ck_assert_msg (cost[2] < TEST_S1AP_MAX_COST_RATIO * cost[0],
+      "lookup cost grows with the number of UEs: %.1f ns for %u UEs, %.1f ns for %u UEs", cost[0], nb_ues[0], cost[2], nb_ues[2]);
+}
+END_TEST
+
+Suite * s1ap_ue_lookup_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S1AP UE lookup tests");
+
+    /* Core test case */
+    tc_core = tcase_create("S1AP UE lookup test");
+    tcase_set_timeout(tc_core, 60);
+    tcase_add_test(tc_core, s1ap_ue_lookup_index_test);
+    tcase_add_test(tc_core, s1ap_ue_lookup_flat_cost_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s1ap_ue_lookup_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
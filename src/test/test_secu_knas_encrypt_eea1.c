@@ -57,7 +57,9 @@ eea1_encrypt (
   nas_cipher->blength = length;
   nas_cipher->message = message;
 
-  if (nas_stream_encrypt_eea1 (nas_cipher, &result) != 0)
+  result = calloc (1, byte_length);
+
+  if (nas_stream_encrypt_eea1 (nas_cipher, result) != 0)
     fail ("Fail: nas_stream_encrypt_eea1\n");
 
   if (compare_buffer (result, byte_length, expected, byte_length) != 0) {
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "test_util.h"
@@ -41,6 +42,7 @@ eea2_encrypt (
   uint8_t * expected)
 {
   nas_stream_cipher_t                    *nas_cipher;
+  nas_stream_key_schedule_t               schedule = {0};
   uint8_t                                *result;
   uint32_t                                zero_bits = length & 7;
   uint32_t                                byte_length = length >> 3;
@@ -57,13 +59,24 @@ eea2_encrypt (
   nas_cipher->blength = length;
   nas_cipher->message = message;
 
-  if (nas_stream_encrypt_eea2 (nas_cipher, &result) != 0)
+  result = calloc (1, byte_length);
+
+  if (nas_stream_encrypt_eea2 (nas_cipher, result) != 0)
     fail ("Fail: nas_stream_encrypt_eea2\n");
 
   if (compare_buffer (result, byte_length, expected, byte_length) != 0) {
     fail ("Fail: eea2_encrypt\n");
   }
 
+  memset (result, 0, byte_length);
+
+  if (nas_stream_encrypt_eea2_cached (&schedule, nas_cipher, result) != 0)
+    fail ("Fail: nas_stream_encrypt_eea2_cached\n");
+
+  if (compare_buffer (result, byte_length, expected, byte_length) != 0) {
+    fail ("Fail: eea2_encrypt cached\n");
+  }
+
   free (nas_cipher);
   free (result);
 }
@@ -42,6 +42,7 @@ eia2_encrypt (
   uint32_t length_expected)
 {
   nas_stream_cipher_t                     nas_cipher;
+  nas_stream_key_schedule_t               schedule = {0};
   uint8_t                                 result[4];
 
   nas_cipher.direction = direction;
@@ -59,6 +60,14 @@ eia2_encrypt (
   if (compare_buffer (result, 4, expected, length_expected) != 0) {
     fail ("Fail: eia2_encrypt\n");
   }
+
+  if (nas_stream_encrypt_eia2_cached (&schedule, &nas_cipher, result) != 0) {
+    fail ("Fail: nas_stream_encrypt_eia2_cached\n");
+  }
+
+  if (compare_buffer (result, 4, expected, length_expected) != 0) {
+    fail ("Fail: eia2_encrypt cached\n");
+  }
 }
 
 void
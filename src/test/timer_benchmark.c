@@ -0,0 +1,140 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * ITTI timer micro benchmark: arms nb_timers one shot timers (spread over
+ * a few minutes like NAS/S1AP guard timers), then cancels all of them, and
+ * finally checks that a burst of short timers expires to TASK_MME_APP.
+ *
+ * usage: timer_benchmark [nb_timers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "intertask_interface_init.h"
+#include "timer.h"
+
+#define TIMER_BENCHMARK_NB_TIMERS       (1000 * 1000)
+#define TIMER_BENCHMARK_NB_EXPIRIES     (10 * 1000)
+/* Expiries are spread over this many 10 ms ticks, not to overflow the task queue at once */
+#define TIMER_BENCHMARK_EXPIRY_TICKS    100
+/* Time given to the expiries to reach the task once the last one is due */
+#define TIMER_BENCHMARK_EXPIRY_MARGIN_S 5
+
+//------------------------------------------------------------------------------
+static double timer_benchmark_elapsed (struct timespec *start_time)
+{
+  struct timespec                         end_time;
+
+  clock_gettime (CLOCK_MONOTONIC, &end_time);
+  return (double)(end_time.tv_sec - start_time->tv_sec) + (double)(end_time.tv_nsec - start_time->tv_nsec) / 1e9;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  struct timespec                         start_time;
+  MessageDef                             *received_msg = NULL;
+  long                                   *timer_ids = NULL;
+  uint32_t                                nb_timers = TIMER_BENCHMARK_NB_TIMERS;
+  uint32_t                                nb_failures = 0;
+  uint32_t                                nb_expired = 0;
+  uint32_t                                i = 0;
+  double                                  elapsed = 0;
+
+  if (argc > 1) {
+    nb_timers = strtoul (argv[1], NULL, 0);
+  }
+
+  timer_ids = calloc (nb_timers, sizeof (long));
+
+  if (timer_ids == NULL) {
+    fprintf (stderr, "Failed to allocate %u timer ids\n", nb_timers);
+    return EXIT_FAILURE;
+  }
+
+  itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL);
+  // the main thread is TASK_MME_APP, the destination of the expiries
+  itti_mark_task_ready (TASK_MME_APP);
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_timers; i++) {
+    if (timer_setup (30 + (i % 300), 0, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_ids[i]) < 0) {
+      nb_failures++;
+    }
+  }
+  elapsed = timer_benchmark_elapsed (&start_time);
+  fprintf (stdout, "Armed %u timers in %.3f s, %.0f timers/s, %u failures\n", nb_timers, elapsed, (double)nb_timers / elapsed, nb_failures);
+
+  nb_failures = 0;
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < nb_timers; i++) {
+    if (timer_remove (timer_ids[i], NULL) < 0) {
+      nb_failures++;
+    }
+  }
+  elapsed = timer_benchmark_elapsed (&start_time);
+  fprintf (stdout, "Cancelled %u timers in %.3f s, %.0f timers/s, %u failures\n", nb_timers, elapsed, (double)nb_timers / elapsed, nb_failures);
+
+  /*
+   * Expiry path: short timers, received by the main thread acting as TASK_MME_APP
+   */
+  nb_failures = 0;
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+  for (i = 0; i < TIMER_BENCHMARK_NB_EXPIRIES; i++) {
+    if (timer_setup (0, 100000 + (i % TIMER_BENCHMARK_EXPIRY_TICKS) * 10000, TASK_MME_APP, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_ids[0]) < 0) {
+      nb_failures++;
+    }
+  }
+  while ((nb_expired + nb_failures) < TIMER_BENCHMARK_NB_EXPIRIES) {
+    itti_poll_msg (TASK_MME_APP, &received_msg);
+
+    if (received_msg == NULL) {
+      // expiries still missing that long after the last one was due were lost
+      if (timer_benchmark_elapsed (&start_time) > (0.1 + TIMER_BENCHMARK_EXPIRY_TICKS * 0.01 + TIMER_BENCHMARK_EXPIRY_MARGIN_S)) {
+        break;
+      }
+      usleep (1000);
+      continue;
+    }
+
+    if (ITTI_MSG_ID (received_msg) == TIMER_HAS_EXPIRED) {
+      nb_expired++;
+    }
+    itti_free (ITTI_MSG_ORIGIN_ID (received_msg), received_msg);
+  }
+  elapsed = timer_benchmark_elapsed (&start_time);
+  fprintf (stdout, "%u timers of 100 to %u ms expired after %.3f s, %u failures\n", nb_expired,
+           100 + (TIMER_BENCHMARK_EXPIRY_TICKS - 1) * 10, elapsed, nb_failures);
+  free (timer_ids);
+
+  if (nb_expired < TIMER_BENCHMARK_NB_EXPIRIES) {
+    fprintf (stderr, "%u timer expiries were not received\n", TIMER_BENCHMARK_NB_EXPIRIES - nb_expired);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
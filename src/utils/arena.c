@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file arena.c
+  \brief Bump allocator for short lived allocations.
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "arena.h"
+
+/* Chunk and allocation headers are padded to keep allocations aligned */
+#define ARENA_CHUNK_HEADER_SIZE  ((sizeof (arena_chunk_t) + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1))
+#define ARENA_ALLOC_HEADER_SIZE  ARENA_ALIGNMENT
+#define ARENA_ROUND_UP(sIZE)     (((sIZE) + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1))
+
+//------------------------------------------------------------------------------
+static int arena_grow (arena_t * const arena, const size_t min_size)
+{
+  arena_chunk_t                          *chunk = NULL;
+  size_t                                  size = (min_size > arena->chunk_size) ? ARENA_ROUND_UP (min_size) : arena->chunk_size;
+
+  if (posix_memalign ((void **)&chunk, ARENA_ALIGNMENT, ARENA_CHUNK_HEADER_SIZE + size)) {
+    return -1;
+  }
+  chunk->size = size;
+  chunk->next = arena->chunks;
+  arena->chunks = chunk;
+  arena->cursor = (uint8_t *)chunk + ARENA_CHUNK_HEADER_SIZE;
+  arena->end = arena->cursor + size;
+  arena->nb_chunk_allocations++;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+arena_t *arena_create (const char * const name, const size_t chunk_size)
+{
+  arena_t                                *arena = calloc (1, sizeof (arena_t));
+
+  if (!arena) {
+    return NULL;
+  }
+  arena->chunk_size = ARENA_ROUND_UP ((chunk_size) ? chunk_size : 4096);
+  arena->name = bfromcstr ((name) ? name : "arena");
+
+  if (arena_grow (arena, arena->chunk_size)) {
+    arena_destroy (&arena);
+    return NULL;
+  }
+  return arena;
+}
+
+//------------------------------------------------------------------------------
+void arena_destroy (arena_t ** const arena)
+{
+  arena_chunk_t                          *chunk = NULL;
+
+  if ((!arena) || (!*arena)) {
+    return;
+  }
+
+  while ((chunk = (*arena)->chunks)) {
+    (*arena)->chunks = chunk->next;
+    free (chunk);
+  }
+  bdestroy_wrapper (&(*arena)->name);
+  free_wrapper ((void **)arena);
+}
+
+//------------------------------------------------------------------------------
+void *arena_alloc (arena_t * const arena, const size_t size)
+{
+  size_t                                  needed = ARENA_ALLOC_HEADER_SIZE + ARENA_ROUND_UP (size);
+  uint8_t                                *ptr = NULL;
+
+  if ((size_t)(arena->end - arena->cursor) < needed) {
+    if (arena_grow (arena, needed)) {
+      return NULL;
+    }
+  }
+  *(size_t *)arena->cursor = size;
+  ptr = arena->cursor + ARENA_ALLOC_HEADER_SIZE;
+  arena->cursor += needed;
+  arena->nb_allocations++;
+  return ptr;
+}
+
+//------------------------------------------------------------------------------
+void *arena_calloc (arena_t * const arena, const size_t nmemb, const size_t size)
+{
+  void                                   *ptr = NULL;
+
+  if ((size) && (nmemb > SIZE_MAX / size)) {
+    return NULL;
+  }
+  if ((ptr = arena_alloc (arena, nmemb * size))) {
+    memset (ptr, 0, nmemb * size);
+  }
+  return ptr;
+}
+
+//------------------------------------------------------------------------------
+void *arena_realloc (arena_t * const arena, void * const ptr, const size_t size)
+{
+  size_t                                 *old_size = NULL;
+  void                                   *new_ptr = NULL;
+
+  if (!ptr) {
+    return arena_alloc (arena, size);
+  }
+  old_size = (size_t *)((uint8_t *)ptr - ARENA_ALLOC_HEADER_SIZE);
+
+  /*
+   * The last allocation grows in place
+   */
+  if (((uint8_t *)ptr + ARENA_ROUND_UP (*old_size) == arena->cursor) &&
+      ((size_t)(arena->end - (uint8_t *)ptr) >= ARENA_ROUND_UP (size))) {
+    arena->cursor = (uint8_t *)ptr + ARENA_ROUND_UP (size);
+    *old_size = size;
+    return ptr;
+  }
+  if (size <= *old_size) {
+    return ptr;
+  }
+  if ((new_ptr = arena_alloc (arena, size))) {
+    memcpy (new_ptr, ptr, *old_size);
+  }
+  return new_ptr;
+}
+
+//------------------------------------------------------------------------------
+bool arena_owns (const arena_t * const arena, const void * const ptr)
+{
+  const arena_chunk_t                    *chunk = arena->chunks;
+
+  for (; chunk; chunk = chunk->next) {
+    if (((const uint8_t *)ptr > (const uint8_t *)chunk) &&
+        ((const uint8_t *)ptr < (const uint8_t *)chunk + ARENA_CHUNK_HEADER_SIZE + chunk->size)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+void arena_reset (arena_t * const arena)
+{
+  arena_chunk_t                          *chunk = NULL;
+  arena_chunk_t                          *old_chunks = NULL;
+  size_t                                  total_size = 0;
+
+  arena->nb_resets++;
+
+  if (!arena->chunks->next) {
+    arena->cursor = (uint8_t *)arena->chunks + ARENA_CHUNK_HEADER_SIZE;
+    return;
+  }
+
+  /*
+   * Last unit of work needed several chunks, replace them by a single one
+   * big enough for all of them, or keep the most recent one if it can not
+   * be allocated
+   */
+  for (chunk = arena->chunks; chunk; chunk = chunk->next) {
+    total_size += chunk->size;
+  }
+
+  if (arena_grow (arena, total_size)) {
+    chunk = arena->chunks;
+    arena->cursor = (uint8_t *)chunk + ARENA_CHUNK_HEADER_SIZE;
+    arena->end = arena->cursor + chunk->size;
+  } else {
+    chunk = arena->chunks;
+  }
+  old_chunks = chunk->next;
+  chunk->next = NULL;
+
+  while ((chunk = old_chunks)) {
+    old_chunks = chunk->next;
+    free (chunk);
+  }
+}
+
+//------------------------------------------------------------------------------
+size_t arena_get_memory_size (const arena_t * const arena)
+{
+  const arena_chunk_t                    *chunk = arena->chunks;
+  size_t                                  size = sizeof (arena_t);
+
+  for (; chunk; chunk = chunk->next) {
+    size += ARENA_CHUNK_HEADER_SIZE + chunk->size;
+  }
+  return size;
+}
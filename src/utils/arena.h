@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file arena.h
+  \brief Bump allocator for short lived allocations.
+
+  Allocations are carved out of chunks by advancing a cursor and are all
+  released at once by arena_reset(). A reset keeps the memory: when the
+  allocations did not fit in one chunk, the chunks are merged into a single
+  bigger one, so an arena reset after each unit of work quickly stops calling
+  malloc at all. An arena is not thread safe, it is meant to be owned by one
+  thread.
+*/
+#ifndef FILE_ARENA_SEEN
+#define FILE_ARENA_SEEN
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "bstrlib.h"
+
+#define ARENA_ALIGNMENT 16
+
+typedef struct arena_chunk_s {
+  struct arena_chunk_s    *next;
+  size_t                   size;                 // usable bytes after the header
+} arena_chunk_t;
+
+typedef struct arena_s {
+  arena_chunk_t           *chunks;               // current chunk first
+  uint8_t                 *cursor;
+  uint8_t                 *end;
+  size_t                   chunk_size;
+  uint64_t                 nb_allocations;       // since creation
+  uint64_t                 nb_chunk_allocations; // malloc calls since creation
+  uint64_t                 nb_resets;
+  bstring                  name;
+} arena_t;
+
+/*
+ * Returns NULL if the first chunk cannot be allocated.
+ */
+arena_t *arena_create(const char * const name, const size_t chunk_size);
+
+void arena_destroy(arena_t ** const arena);
+
+/*
+ * Returns NULL if a new chunk is needed and cannot be allocated.
+ */
+void *arena_alloc(arena_t * const arena, const size_t size);
+
+/*
+ * Zeroed allocation.
+ */
+void *arena_calloc(arena_t * const arena, const size_t nmemb, const size_t size);
+
+/*
+ * ptr must be NULL or have been allocated from the arena.
+ */
+void *arena_realloc(arena_t * const arena, void * const ptr, const size_t size);
+
+/*
+ * True if ptr lies in one of the arena chunks.
+ */
+bool arena_owns(const arena_t * const arena, const void * const ptr);
+
+/*
+ * Release all allocations.
+ */
+void arena_reset(arena_t * const arena);
+
+/*
+ * Memory footprint of the arena, in bytes.
+ */
+size_t arena_get_memory_size(const arena_t * const arena);
+
+#endif /* FILE_ARENA_SEEN */
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2017, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+/*! \file epoch.c
+  \brief Epoch based deferred reclamation for lock-free readers.
+
+  A global epoch counter is advanced when every thread inside a read section
+  has observed its current value. An object deferred during epoch E may still
+  be referenced by readers that entered during E or E-1 (they may have read
+  the global epoch just before its increment), it is released once the global
+  epoch reaches E+2.
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "assertions.h"
+#include "epoch.h"
+
+typedef struct epoch_thread_s {
+  uint64_t                 epoch;        // global epoch observed when entering the read section, 0 outside
+  unsigned int             nesting;
+  struct epoch_thread_s   *next;
+} epoch_thread_t;
+
+typedef struct epoch_deferred_s {
+  void                    *ptr;
+  void                   (*free_func)(void **);
+  uint64_t                 epoch;        // global epoch when the object was deferred
+  struct epoch_deferred_s *next;
+} epoch_deferred_t;
+
+typedef struct epoch_desc_s {
+  pthread_mutex_t          lock;         // protects threads and deferred list, never taken by readers
+  uint64_t                 epoch;        // global epoch, starts at 1 (0 means quiescent)
+  epoch_thread_t          *threads;
+  epoch_deferred_t        *deferred_head;
+  epoch_deferred_t        *deferred_tail;
+  unsigned int             deferred_number;
+} epoch_desc_t;
+
+static epoch_desc_t                     epoch_desc = {
+  .lock = PTHREAD_MUTEX_INITIALIZER,
+  .epoch = 1,
+};
+
+static pthread_once_t                   epoch_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t                    epoch_key;
+static __thread epoch_thread_t         *epoch_thread_p = NULL;
+
+//------------------------------------------------------------------------------
+static void epoch_unregister_thread (void *arg)
+{
+  epoch_thread_t                         *thread_p = (epoch_thread_t *)arg;
+  epoch_thread_t                        **pp = NULL;
+
+  pthread_mutex_lock (&epoch_desc.lock);
+
+  for (pp = &epoch_desc.threads; *pp; pp = &(*pp)->next) {
+    if (*pp == thread_p) {
+      *pp = thread_p->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock (&epoch_desc.lock);
+  free (thread_p);
+}
+
+//------------------------------------------------------------------------------
+static void epoch_create_key (void)
+{
+  AssertFatal (pthread_key_create (&epoch_key, epoch_unregister_thread) == 0, "Cannot create epoch thread key\n");
+}
+
+//------------------------------------------------------------------------------
+static epoch_thread_t *epoch_register_thread (void)
+{
+  epoch_thread_t                         *thread_p = calloc (1, sizeof (epoch_thread_t));
+
+  AssertFatal (thread_p, "Cannot allocate epoch thread record\n");
+  pthread_once (&epoch_key_once, epoch_create_key);
+  pthread_mutex_lock (&epoch_desc.lock);
+  thread_p->next = epoch_desc.threads;
+  epoch_desc.threads = thread_p;
+  pthread_mutex_unlock (&epoch_desc.lock);
+  pthread_setspecific (epoch_key, thread_p);
+  epoch_thread_p = thread_p;
+  return thread_p;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Advance the global epoch if every thread in a read section has observed it.
+   Must be called with epoch_desc.lock held.
+*/
+static bool epoch_try_advance (void)
+{
+  uint64_t                                epoch = epoch_desc.epoch;
+  uint64_t                                thread_epoch = 0;
+  epoch_thread_t                         *thread_p = NULL;
+
+  /*
+   * Unlinks done before deferring the objects must be visible before the scan
+   */
+  __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+  for (thread_p = epoch_desc.threads; thread_p; thread_p = thread_p->next) {
+    thread_epoch = __atomic_load_n (&thread_p->epoch, __ATOMIC_ACQUIRE);
+
+    if ((thread_epoch) && (thread_epoch != epoch)) {
+      return false;
+    }
+  }
+  __atomic_store_n (&epoch_desc.epoch, epoch + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void epoch_read_lock (void)
+{
+  epoch_thread_t                         *thread_p = epoch_thread_p;
+
+  if (!thread_p) {
+    thread_p = epoch_register_thread ();
+  }
+
+  if (!thread_p->nesting++) {
+    __atomic_store_n (&thread_p->epoch, __atomic_load_n (&epoch_desc.epoch, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+    /*
+     * The announced epoch must be visible before any shared pointer is read
+     */
+    __atomic_thread_fence (__ATOMIC_SEQ_CST);
+  }
+}
+
+//------------------------------------------------------------------------------
+void epoch_read_unlock (void)
+{
+  epoch_thread_t                         *thread_p = epoch_thread_p;
+
+  if ((thread_p) && (thread_p->nesting) && (!--thread_p->nesting)) {
+    __atomic_store_n (&thread_p->epoch, 0, __ATOMIC_RELEASE);
+  }
+}
+
+//------------------------------------------------------------------------------
+void epoch_defer_free (void *ptr, void (*free_func)(void **))
+{
+  epoch_deferred_t                       *deferred_p = NULL;
+
+  if (!ptr) {
+    return;
+  }
+  deferred_p = calloc (1, sizeof (epoch_deferred_t));
+  AssertFatal (deferred_p, "Cannot allocate epoch deferred record\n");
+  deferred_p->ptr = ptr;
+  deferred_p->free_func = free_func;
+  pthread_mutex_lock (&epoch_desc.lock);
+  deferred_p->epoch = epoch_desc.epoch;
+
+  if (epoch_desc.deferred_tail) {
+    epoch_desc.deferred_tail->next = deferred_p;
+  } else {
+    epoch_desc.deferred_head = deferred_p;
+  }
+  epoch_desc.deferred_tail = deferred_p;
+  epoch_desc.deferred_number++;
+  pthread_mutex_unlock (&epoch_desc.lock);
+  epoch_reclaim ();
+}
+
+//------------------------------------------------------------------------------
+unsigned int epoch_reclaim (void)
+{
+  epoch_deferred_t                       *ready_p = NULL;
+  epoch_deferred_t                      **ready_tail_pp = &ready_p;
+  epoch_deferred_t                       *deferred_p = NULL;
+  unsigned int                            deferred_number = 0;
+
+  pthread_mutex_lock (&epoch_desc.lock);
+
+  if (epoch_desc.deferred_head) {
+    epoch_try_advance ();
+
+    /*
+     * Deferred objects are ordered by epoch
+     */
+    while ((epoch_desc.deferred_head) && ((epoch_desc.deferred_head->epoch + 2) <= epoch_desc.epoch)) {
+      deferred_p = epoch_desc.deferred_head;
+      epoch_desc.deferred_head = deferred_p->next;
+      epoch_desc.deferred_number--;
+      deferred_p->next = NULL;
+      *ready_tail_pp = deferred_p;
+      ready_tail_pp = &deferred_p->next;
+    }
+
+    if (!epoch_desc.deferred_head) {
+      epoch_desc.deferred_tail = NULL;
+    }
+  }
+  deferred_number = epoch_desc.deferred_number;
+  pthread_mutex_unlock (&epoch_desc.lock);
+
+  /*
+   * Free functions may defer other objects
+   */
+  while (ready_p) {
+    deferred_p = ready_p;
+    ready_p = deferred_p->next;
+
+    if (deferred_p->free_func) {
+      deferred_p->free_func (&deferred_p->ptr);
+    } else {
+      free (deferred_p->ptr);
+    }
+    free (deferred_p);
+  }
+  return deferred_number;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2017, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file epoch.h
+  \brief Epoch based deferred reclamation for lock-free readers.
+
+  Readers bracket their accesses to shared objects with epoch_read_lock() /
+  epoch_read_unlock(), they never block and never write shared memory.
+  Writers unlink objects from the shared structures and hand them to
+  epoch_defer_free(), the objects are released once every reader that
+  could still hold a reference on them has left its read section.
+*/
+#ifndef FILE_EPOCH_SEEN
+#define FILE_EPOCH_SEEN
+
+/*
+ * Enter a read section, read sections can be nested.
+ */
+void epoch_read_lock(void);
+
+/*
+ * Leave a read section.
+ */
+void epoch_read_unlock(void);
+
+/*
+ * Release ptr with free_func(&ptr) when no reader can reference it anymore.
+ * ptr must already be unreachable for new readers.
+ */
+void epoch_defer_free(void *ptr, void (*free_func)(void **));
+
+/*
+ * Release all deferred objects that are safe to release, returns the number
+ * of objects still waiting.
+ */
+unsigned int epoch_reclaim(void);
+
+#endif /* FILE_EPOCH_SEEN */
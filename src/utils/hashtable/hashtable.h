@@ -115,6 +115,47 @@ typedef struct hash_table_uint64_ts_s {
     bool                log_enabled;
 } hash_table_uint64_ts_t;
 
+/*
+ * Open addressing (Robin Hood) thread safe hash table: keys and data are stored
+ * inline in a power of two slot array, the probe distance of each slot is kept
+ * in a separate array so that probing only touches keys of candidate slots.
+ * The table doubles when it is 7/8 full, elements of the previous array are
+ * migrated a few slots at a time by the following insertions/removals.
+ * Data is either a pointer (hashtable_oa_ts_*) or an uint64_t (hashtable_uint64_oa_ts_*).
+ */
+typedef struct hash_slot_oa_s {
+    hash_key_t          key;
+    uint64_t            data;
+} hash_slot_oa_t;
+
+typedef struct hash_array_oa_s {
+    hash_size_t         size;        // number of slots, power of two
+    hash_slot_oa_t     *slots;       // allocated with the array
+    uint32_t           *distances;   // probe distance + 1 of the element in the slot, 0 if slot is empty
+} hash_array_oa_t;
+
+/*
+ * Lookups do not take any lock: they run in an epoch read section and are
+ * validated by the sequence counter (odd while a writer is modifying the
+ * arrays). Writers are serialized by lock, replaced arrays and released
+ * data are reclaimed once no reader can reference them anymore (epoch.h).
+ */
+typedef struct hash_table_oa_ts_s {
+    pthread_mutex_t     lock;        // writers only
+    uint32_t            seq;
+    hash_size_t         num_elements;
+    hash_array_oa_t    *array;
+    hash_array_oa_t    *old_array;   // previous array while resizing, NULL otherwise
+    hash_size_t         old_index;   // next slot of old_array to migrate
+    hash_size_t       (*hashfunc)(const hash_key_t);
+    void              (*freefunc)(void**);
+    bstring             name;
+    bool                is_allocated_by_malloc;
+    bool                log_enabled;
+} hash_table_oa_ts_t;
+
+typedef hash_table_oa_ts_t hash_table_uint64_oa_ts_t;
+
 typedef struct hashtable_key_array_s {
     int                 num_keys;
     hash_key_t         *keys;
@@ -181,5 +222,39 @@ hashtable_rc_t  hashtable_uint64_ts_remove(hash_table_uint64_ts_t * const hashtb
 hashtable_rc_t  hashtable_uint64_ts_get    (const hash_table_uint64_ts_t * const hashtbl, const hash_key_t key, uint64_t * const dataP) __attribute__ ((hot));
 hashtable_rc_t  hashtable_uint64_ts_resize (hash_table_uint64_ts_t * const hashtbl, const hash_size_t size);
 
+// Open addressing thread-safe functions
+hash_table_oa_ts_t * hashtable_oa_ts_init (hash_table_oa_ts_t * const hashtbl,const hash_size_t size,hash_size_t (*hashfunc) (const hash_key_t),void (*freefunc) (void **),bstring display_name_p);
+__attribute__ ((malloc)) hash_table_oa_ts_t   *hashtable_oa_ts_create (const hash_size_t   size, hash_size_t (*hashfunc)(const hash_key_t ), void (*freefunc)(void **), bstring name_p);
+hashtable_rc_t  hashtable_oa_ts_destroy(hash_table_oa_ts_t * hashtbl);
+hashtable_rc_t  hashtable_oa_ts_is_key_exists (const hash_table_oa_ts_t * const hashtbl, const hash_key_t key) __attribute__ ((hot, warn_unused_result));
+hashtable_key_array_t * hashtable_oa_ts_get_keys (hash_table_oa_ts_t * const hashtblP);
+hashtable_element_array_t* hashtable_oa_ts_get_elements (hash_table_oa_ts_t * const hashtblP);
+hashtable_rc_t  hashtable_oa_ts_apply_callback_on_elements (hash_table_oa_ts_t * const hashtbl,
+                                                      bool func_cb(const hash_key_t key, void* const element, void* parameter, void**result),
+                                                      void* parameter,
+                                                      void**result);
+hashtable_rc_t  hashtable_oa_ts_dump_content (const hash_table_oa_ts_t * const hashtbl, bstring str);
+hashtable_rc_t  hashtable_oa_ts_insert (hash_table_oa_ts_t * const hashtbl, const hash_key_t key, void *element);
+hashtable_rc_t  hashtable_oa_ts_free (hash_table_oa_ts_t * const hashtbl, const hash_key_t key);
+hashtable_rc_t  hashtable_oa_ts_remove(hash_table_oa_ts_t * const hashtbl, const hash_key_t key, void** element);
+hashtable_rc_t  hashtable_oa_ts_get    (const hash_table_oa_ts_t * const hashtbl, const hash_key_t key, void **element) __attribute__ ((hot));
+hashtable_rc_t  hashtable_oa_ts_resize (hash_table_oa_ts_t * const hashtbl, const hash_size_t size);
+hash_table_uint64_oa_ts_t * hashtable_uint64_oa_ts_init (hash_table_uint64_oa_ts_t * const hashtbl, const hash_size_t size, hash_size_t (*hashfunc) (const hash_key_t),bstring display_name_p);
+__attribute__ ((malloc)) hash_table_uint64_oa_ts_t   *hashtable_uint64_oa_ts_create (const hash_size_t   size, hash_size_t (*hashfunc)(const hash_key_t ), bstring name_p);
+hashtable_rc_t  hashtable_uint64_oa_ts_destroy(hash_table_uint64_oa_ts_t * hashtbl);
+hashtable_rc_t  hashtable_uint64_oa_ts_is_key_exists (const hash_table_uint64_oa_ts_t * const hashtbl, const hash_key_t key) __attribute__ ((hot, warn_unused_result));
+hashtable_key_array_t * hashtable_uint64_oa_ts_get_keys (hash_table_uint64_oa_ts_t * const hashtblP);
+hashtable_uint64_element_array_t * hashtable_uint64_oa_ts_get_elements (hash_table_uint64_oa_ts_t * const hashtblP);
+hashtable_rc_t  hashtable_uint64_oa_ts_apply_callback_on_elements (hash_table_uint64_oa_ts_t * const hashtbl,
+                                                      bool func_cb(const hash_key_t key, const uint64_t element, void* parameter, void**result),
+                                                      void* parameter,
+                                                      void**result);
+hashtable_rc_t  hashtable_uint64_oa_ts_dump_content (const hash_table_uint64_oa_ts_t * const hashtbl, bstring str);
+hashtable_rc_t  hashtable_uint64_oa_ts_insert (hash_table_uint64_oa_ts_t * const hashtbl, const hash_key_t key, const uint64_t dataP);
+hashtable_rc_t  hashtable_uint64_oa_ts_free (hash_table_uint64_oa_ts_t * const hashtbl, const hash_key_t key);
+hashtable_rc_t  hashtable_uint64_oa_ts_remove(hash_table_uint64_oa_ts_t * const hashtbl, const hash_key_t key);
+hashtable_rc_t  hashtable_uint64_oa_ts_get    (const hash_table_uint64_oa_ts_t * const hashtbl, const hash_key_t key, uint64_t * const dataP) __attribute__ ((hot));
+hashtable_rc_t  hashtable_uint64_oa_ts_resize (hash_table_uint64_oa_ts_t * const hashtbl, const hash_size_t size);
+
 #endif
 
@@ -0,0 +1,1053 @@
+/*
+ * Copyright (c) 2017, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+/*! \file hashtable_oa.c
+  \brief Open addressing (Robin Hood) thread safe hash tables, with incremental resizing and lock-free lookups.
+*/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "hashtable.h"
+#include "epoch.h"
+#include "assertions.h"
+#include "log.h"
+
+#if TRACE_HASHTABLE
+#  define PRINT_HASHTABLE(hTbLe, ...)  do {if (hTbLe->log_enabled) OAILOG_TRACE(LOG_UTIL, ##__VA_ARGS__);} while (0)
+#else
+#  define PRINT_HASHTABLE(...)
+#endif
+
+#define HASHTABLE_OA_MIN_SIZE           16
+/* Number of slots of the previous array migrated by each insertion or removal while resizing */
+#define HASHTABLE_OA_MIGRATION_STEP     64
+
+/* Table is grown when it becomes 7/8 full */
+#define HASHTABLE_OA_IS_FULL(nUMeLEMENTS, sIZE) (((nUMeLEMENTS) * 8) >= ((sIZE) * 7))
+
+#define HASHTABLE_OA_NOT_FOUND          ((hash_size_t)-1)
+
+#if defined(__x86_64__) || defined(__i386__)
+#  define HASHTABLE_OA_CPU_RELAX()      __builtin_ia32_pause()
+#else
+#  define HASHTABLE_OA_CPU_RELAX()
+#endif
+
+//------------------------------------------------------------------------------
+/*
+   Default hash function
+   A 64 bit finalizer (MurmurHash3 fmix64), all key bits influence the slot index.
+   It is also applied on the result of a user hash function since slots are
+   selected with the low order bits of the hash.
+*/
+static inline hash_size_t def_hashfunc (const uint64_t keyP)
+{
+  uint64_t                                h = keyP;
+
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return (hash_size_t) h;
+}
+
+//------------------------------------------------------------------------------
+static inline hash_size_t hashtable_oa_hash (const hash_table_oa_ts_t * const hashtblP, const hash_key_t keyP)
+{
+  if (hashtblP->hashfunc) {
+    return def_hashfunc (hashtblP->hashfunc (keyP));
+  }
+  return def_hashfunc (keyP);
+}
+
+//------------------------------------------------------------------------------
+static hash_size_t hashtable_oa_round_size (const hash_size_t sizeP)
+{
+  hash_size_t size = HASHTABLE_OA_MIN_SIZE;
+
+  while (size < sizeP) {
+    size <<= 1;
+  }
+  return size;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Slots and distances are allocated with the array descriptor so that an
+   array is published, and reclaimed, through a single pointer.
+*/
+static hash_array_oa_t *hashtable_oa_array_alloc (const hash_size_t sizeP)
+{
+  hash_array_oa_t                        *array = calloc (1, sizeof (hash_array_oa_t) + sizeP * (sizeof (hash_slot_oa_t) + sizeof (uint32_t)));
+
+  if (array) {
+    array->size = sizeP;
+    array->slots = (hash_slot_oa_t *)(array + 1);
+    array->distances = (uint32_t *)(array->slots + sizeP);
+  }
+  return array;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Readers are not synchronized with writers, they may see an array being
+   modified: loads are atomic, the probe length is bounded and the result is
+   discarded if the sequence counter changed (see hashtable_oa_get()).
+*/
+static inline uint32_t hashtable_oa_read_begin (const hash_table_oa_ts_t * const hashtblP)
+{
+  uint32_t                                seq = 0;
+
+  while ((seq = __atomic_load_n (&hashtblP->seq, __ATOMIC_ACQUIRE)) & 1) {
+    HASHTABLE_OA_CPU_RELAX ();
+  }
+  return seq;
+}
+
+//------------------------------------------------------------------------------
+static inline bool hashtable_oa_read_retry (const hash_table_oa_ts_t * const hashtblP, const uint32_t seqP)
+{
+  __atomic_thread_fence (__ATOMIC_ACQUIRE);
+  return (__atomic_load_n (&hashtblP->seq, __ATOMIC_RELAXED) != seqP);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Must be called with the write lock held.
+*/
+static inline void hashtable_oa_write_begin (hash_table_oa_ts_t * const hashtblP)
+{
+  __atomic_store_n (&hashtblP->seq, hashtblP->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence (__ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+static inline void hashtable_oa_write_end (hash_table_oa_ts_t * const hashtblP)
+{
+  __atomic_store_n (&hashtblP->seq, hashtblP->seq + 1, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Search a key in an array.
+   Robin Hood invariant: elements are ordered by probe distance along a probe
+   sequence, so the search stops on an empty slot or on a slot holding an
+   element closer to its home slot than the searched key would be. A key
+   can only be in a slot whose distance is the current probe distance, other
+   slots are skipped without reading their key.
+*/
+static inline hash_size_t hashtable_oa_array_find (const hash_array_oa_t * const arrayP, const hash_key_t keyP, const hash_size_t hash)
+{
+  hash_size_t                             mask = 0;
+  hash_size_t                             i = 0;
+  uint32_t                                distance = 1;
+  uint32_t                                slot_distance = 0;
+
+  if (!arrayP) {
+    return HASHTABLE_OA_NOT_FOUND;
+  }
+  mask = arrayP->size - 1;
+  i = hash & mask;
+
+  while (distance <= arrayP->size) {
+    slot_distance = __atomic_load_n (&arrayP->distances[i], __ATOMIC_RELAXED);
+
+    if (slot_distance < distance) {
+      break;
+    }
+
+    if ((slot_distance == distance) && (__atomic_load_n (&arrayP->slots[i].key, __ATOMIC_RELAXED) == keyP)) {
+      return i;
+    }
+    i = (i + 1) & mask;
+    distance++;
+  }
+  return HASHTABLE_OA_NOT_FOUND;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Insert a key known to be absent from the array, the array must have a free slot.
+   Richer elements (shorter probe distance) are displaced by poorer ones.
+*/
+static inline void hashtable_oa_array_insert (hash_array_oa_t * const arrayP, const hash_key_t keyP, const uint64_t dataP, const hash_size_t hash)
+{
+  hash_size_t                             mask = arrayP->size - 1;
+  hash_size_t                             i = hash & mask;
+  hash_slot_oa_t                          slot = {.key = keyP, .data = dataP};
+  hash_slot_oa_t                          tmp_slot;
+  uint32_t                                distance = 1;
+  uint32_t                                tmp_distance = 0;
+
+  while (arrayP->distances[i]) {
+    if (arrayP->distances[i] < distance) {
+      tmp_slot = arrayP->slots[i];
+      tmp_distance = arrayP->distances[i];
+      arrayP->slots[i] = slot;
+      arrayP->distances[i] = distance;
+      slot = tmp_slot;
+      distance = tmp_distance;
+    }
+    i = (i + 1) & mask;
+    distance++;
+  }
+  arrayP->slots[i] = slot;
+  arrayP->distances[i] = distance;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Remove the element of a slot, following elements are shifted back (no tombstone).
+*/
+static inline void hashtable_oa_array_remove (hash_array_oa_t * const arrayP, hash_size_t i)
+{
+  hash_size_t                             mask = arrayP->size - 1;
+  hash_size_t                             next = (i + 1) & mask;
+
+  while (arrayP->distances[next] > 1) {
+    arrayP->slots[i] = arrayP->slots[next];
+    arrayP->distances[i] = arrayP->distances[next] - 1;
+    i = next;
+    next = (next + 1) & mask;
+  }
+  arrayP->distances[i] = 0;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Move some elements of the previous array to the current one, the previous
+   array is released when it is empty and no reader can access it anymore.
+   Must be called with the write lock held, inside a write section.
+*/
+static void hashtable_oa_migrate (hash_table_oa_ts_t * const hashtblP, hash_size_t stepsP)
+{
+  hash_array_oa_t                        *old_array = hashtblP->old_array;
+  hash_slot_oa_t                          slot;
+
+  while ((old_array) && (stepsP--)) {
+    /*
+     * Removing a slot may shift the next element back in it
+     */
+    while (old_array->distances[hashtblP->old_index]) {
+      slot = old_array->slots[hashtblP->old_index];
+      hashtable_oa_array_remove (old_array, hashtblP->old_index);
+      hashtable_oa_array_insert (hashtblP->array, slot.key, slot.data, hashtable_oa_hash (hashtblP, slot.key));
+    }
+
+    if (++hashtblP->old_index == old_array->size) {
+      __atomic_store_n (&hashtblP->old_array, NULL, __ATOMIC_RELEASE);
+      epoch_defer_free (old_array, free_wrapper);
+      hashtblP->old_index = 0;
+      old_array = NULL;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Replace the current array with a new one of sizeP slots, the elements are
+   migrated incrementally unless migrate_allP.
+   Must be called with the write lock held, inside a write section.
+*/
+static hashtable_rc_t hashtable_oa_start_resize (hash_table_oa_ts_t * const hashtblP, const hash_size_t sizeP, bool migrate_allP)
+{
+  hash_array_oa_t                        *new_array = NULL;
+
+  /*
+   * Only one resize at a time
+   */
+  hashtable_oa_migrate (hashtblP, (hash_size_t)-1);
+
+  if (!(new_array = hashtable_oa_array_alloc (sizeP))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  hashtblP->old_index = 0;
+  __atomic_store_n (&hashtblP->old_array, hashtblP->array, __ATOMIC_RELEASE);
+  __atomic_store_n (&hashtblP->array, new_array, __ATOMIC_RELEASE);
+  PRINT_HASHTABLE (hashtblP, "%s(%s) resize %zu -> %zu slots\n", __FUNCTION__, bdata(hashtblP->name), hashtblP->old_array->size, sizeP);
+
+  if (migrate_allP) {
+    hashtable_oa_migrate (hashtblP, (hash_size_t)-1);
+  }
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Search a key in both arrays, returns the array holding it (NULL if not found)
+   and the slot index in slotP.
+*/
+static inline hash_array_oa_t * hashtable_oa_find (const hash_table_oa_ts_t * const hashtblP, const hash_key_t keyP, const hash_size_t hash, hash_size_t * const slotP)
+{
+  hash_array_oa_t                        *array = __atomic_load_n (&hashtblP->array, __ATOMIC_ACQUIRE);
+
+  if ((*slotP = hashtable_oa_array_find (array, keyP, hash)) != HASHTABLE_OA_NOT_FOUND) {
+    return array;
+  }
+
+  array = __atomic_load_n (&hashtblP->old_array, __ATOMIC_ACQUIRE);
+
+  if ((*slotP = hashtable_oa_array_find (array, keyP, hash)) != HASHTABLE_OA_NOT_FOUND) {
+    return array;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Insert or overwrite, overwritten data is returned in old_dataP.
+   Must be called with the write lock held.
+*/
+static hashtable_rc_t hashtable_oa_insert (hash_table_oa_ts_t * const hashtblP, const hash_key_t keyP, const uint64_t dataP, uint64_t * const old_dataP)
+{
+  hash_array_oa_t                        *array = NULL;
+  hash_size_t                             hash = hashtable_oa_hash (hashtblP, keyP);
+  hash_size_t                             i = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+
+  hashtable_oa_write_begin (hashtblP);
+  hashtable_oa_migrate (hashtblP, HASHTABLE_OA_MIGRATION_STEP);
+
+  if ((array = hashtable_oa_find (hashtblP, keyP, hash, &i))) {
+    *old_dataP = array->slots[i].data;
+    array->slots[i].data = dataP;
+
+    if (*old_dataP != dataP) {
+      rc = HASH_TABLE_INSERT_OVERWRITTEN_DATA;
+    }
+  } else if ((HASHTABLE_OA_IS_FULL (hashtblP->num_elements + 1, hashtblP->array->size)) &&
+             (hashtable_oa_start_resize (hashtblP, hashtblP->array->size << 1, false) != HASH_TABLE_OK)) {
+    rc = HASH_TABLE_SYSTEM_ERROR;
+  } else {
+    hashtable_oa_array_insert (hashtblP->array, keyP, dataP, hash);
+    hashtblP->num_elements++;
+  }
+  hashtable_oa_write_end (hashtblP);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Remove a key, its data is returned in dataP.
+   Must be called with the write lock held.
+*/
+static hashtable_rc_t hashtable_oa_remove (hash_table_oa_ts_t * const hashtblP, const hash_key_t keyP, uint64_t * const dataP)
+{
+  hash_array_oa_t                        *array = NULL;
+  hash_size_t                             i = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_KEY_NOT_EXISTS;
+
+  hashtable_oa_write_begin (hashtblP);
+  hashtable_oa_migrate (hashtblP, HASHTABLE_OA_MIGRATION_STEP);
+
+  if ((array = hashtable_oa_find (hashtblP, keyP, hashtable_oa_hash (hashtblP, keyP), &i))) {
+    *dataP = array->slots[i].data;
+    hashtable_oa_array_remove (array, i);
+    hashtblP->num_elements--;
+    rc = HASH_TABLE_OK;
+  }
+  hashtable_oa_write_end (hashtblP);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Lock-free lookup: the search is restarted if a writer modified the table
+   meanwhile, arrays read during the search cannot be released before the
+   end of the epoch read section.
+*/
+static hashtable_rc_t hashtable_oa_get (const hash_table_oa_ts_t * const hashtblP, const hash_key_t keyP, uint64_t * const dataP)
+{
+  hash_array_oa_t                        *array = NULL;
+  hash_size_t                             hash = hashtable_oa_hash (hashtblP, keyP);
+  hash_size_t                             i = 0;
+  uint64_t                                data = 0;
+  uint32_t                                seq = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_KEY_NOT_EXISTS;
+
+  epoch_read_lock ();
+
+  do {
+    seq = hashtable_oa_read_begin (hashtblP);
+    rc = HASH_TABLE_KEY_NOT_EXISTS;
+
+    if ((array = hashtable_oa_find (hashtblP, keyP, hash, &i))) {
+      data = __atomic_load_n (&array->slots[i].data, __ATOMIC_RELAXED);
+      rc = HASH_TABLE_OK;
+    }
+  } while (hashtable_oa_read_retry (hashtblP, seq));
+
+  epoch_read_unlock ();
+
+  if ((rc == HASH_TABLE_OK) && (dataP)) {
+    *dataP = data;
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Iterate over all elements, stop when func_cb returns true.
+   Must be called with the write lock held.
+*/
+typedef bool (*hashtable_oa_cb_t) (const hash_key_t keyP, const uint64_t dataP, void *func_cb, void *parameterP, void **resultP);
+
+static void hashtable_oa_for_each_locked (hash_table_oa_ts_t * const hashtblP, hashtable_oa_cb_t iter_cb, void *func_cb, void *parameterP, void **resultP)
+{
+  hash_array_oa_t                        *arrays[2] = {hashtblP->array, hashtblP->old_array};
+  hash_size_t                             i = 0;
+  int                                     a = 0;
+
+  for (a = 0; a < 2; a++) {
+    for (i = 0; (arrays[a]) && (i < arrays[a]->size); i++) {
+      if (arrays[a]->distances[i]) {
+        if (iter_cb (arrays[a]->slots[i].key, arrays[a]->slots[i].data, func_cb, parameterP, resultP)) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+/*
+   Iterate over all elements, writers are blocked (not readers).
+*/
+static void hashtable_oa_for_each (hash_table_oa_ts_t * const hashtblP, hashtable_oa_cb_t iter_cb, void *func_cb, void *parameterP, void **resultP)
+{
+  pthread_mutex_lock (&hashtblP->lock);
+  hashtable_oa_for_each_locked (hashtblP, iter_cb, func_cb, parameterP, resultP);
+  pthread_mutex_unlock (&hashtblP->lock);
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_oa_get_key_cb (const hash_key_t keyP, const uint64_t dataP, void *func_cb, void *parameterP, void **resultP)
+{
+  hashtable_key_array_t                  *ka = (hashtable_key_array_t *)parameterP;
+
+  ka->keys[ka->num_keys++] = keyP;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_oa_get_element_cb (const hash_key_t keyP, const uint64_t dataP, void *func_cb, void *parameterP, void **resultP)
+{
+  hashtable_element_array_t              *ea = (hashtable_element_array_t *)parameterP;
+
+  ea->elements[ea->num_elements++] = (void *)(uintptr_t)dataP;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_uint64_oa_get_element_cb (const hash_key_t keyP, const uint64_t dataP, void *func_cb, void *parameterP, void **resultP)
+{
+  hashtable_uint64_element_array_t       *ea = (hashtable_uint64_element_array_t *)parameterP;
+
+  ea->elements[ea->num_elements++] = dataP;
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_oa_apply_cb (const hash_key_t keyP, const uint64_t dataP, void *func_cb, void *parameterP, void **resultP)
+{
+  bool (*cb) (const hash_key_t, void * const, void *, void **) = func_cb;
+
+  return cb (keyP, (void *)(uintptr_t)dataP, parameterP, resultP);
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_uint64_oa_apply_cb (const hash_key_t keyP, const uint64_t dataP, void *func_cb, void *parameterP, void **resultP)
+{
+  bool (*cb) (const hash_key_t, const uint64_t, void *, void **) = func_cb;
+
+  return cb (keyP, dataP, parameterP, resultP);
+}
+
+//------------------------------------------------------------------------------
+static bool hashtable_oa_dump_cb (const hash_key_t keyP, const uint64_t dataP, void *func_cb, void *parameterP, void **resultP)
+{
+  bstring                                 str = (bstring)parameterP;
+  bstring                                 b0 = bformat ("Key 0x%"PRIx64" Element %"PRIx64"\n", keyP, dataP);
+
+  if (b0) {
+    bconcat(str, b0);
+    bdestroy_wrapper (&b0);
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static hashtable_rc_t hashtable_oa_init (hash_table_oa_ts_t * const hashtblP,
+    const hash_size_t sizeP,
+    hash_size_t (*hashfuncP) (const hash_key_t),
+    void (*freefuncP) (void **),
+    bstring display_name_pP)
+{
+  memset(hashtblP, 0, sizeof(*hashtblP));
+
+  /*
+   * sizeP is the expected number of elements, the table grows if needed
+   */
+  if (!(hashtblP->array = hashtable_oa_array_alloc (hashtable_oa_round_size (sizeP + (sizeP >> 2))))) {
+    return HASH_TABLE_SYSTEM_ERROR;
+  }
+  pthread_mutex_init (&hashtblP->lock, NULL);
+  hashtblP->hashfunc = hashfuncP;
+  hashtblP->freefunc = freefuncP;
+
+  if (display_name_pP) {
+    hashtblP->name = bstrcpy(display_name_pP);
+  } else {
+    hashtblP->name = bformat("hashtable@%p", hashtblP);
+  }
+  hashtblP->is_allocated_by_malloc = false;
+  hashtblP->log_enabled = true;
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+static hashtable_rc_t hashtable_oa_destroy (hash_table_oa_ts_t * const hashtblP)
+{
+  hash_array_oa_t                        *arrays[2] = {hashtblP->array, hashtblP->old_array};
+  hash_size_t                             i = 0;
+  int                                     a = 0;
+  void                                   *data = NULL;
+
+  /*
+   * No reader is expected anymore, everything is released at once
+   */
+  pthread_mutex_lock (&hashtblP->lock);
+
+  for (a = 0; (a < 2) && (arrays[a]); a++) {
+    if (hashtblP->freefunc) {
+      for (i = 0; i < arrays[a]->size; i++) {
+        if ((arrays[a]->distances[i]) && (arrays[a]->slots[i].data)) {
+          data = (void *)(uintptr_t)arrays[a]->slots[i].data;
+          hashtblP->freefunc (&data);
+        }
+      }
+    }
+    free_wrapper ((void**)&arrays[a]);
+  }
+  hashtblP->array = NULL;
+  hashtblP->old_array = NULL;
+  pthread_mutex_unlock (&hashtblP->lock);
+  pthread_mutex_destroy (&hashtblP->lock);
+  bdestroy_wrapper (&hashtblP->name);
+
+  if (hashtblP->is_allocated_by_malloc) {
+    free_wrapper ((void**)&hashtblP);
+  }
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+static hashtable_rc_t hashtable_oa_resize (hash_table_oa_ts_t * const hashtblP, const hash_size_t sizeP)
+{
+  hash_size_t                             size = 0;
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+
+  pthread_mutex_lock (&hashtblP->lock);
+  size = hashtable_oa_round_size (sizeP);
+
+  /*
+   * Never shrink below the load factor
+   */
+  while (HASHTABLE_OA_IS_FULL (hashtblP->num_elements + 1, size)) {
+    size <<= 1;
+  }
+
+  if (size != hashtblP->array->size) {
+    hashtable_oa_write_begin (hashtblP);
+    rc = hashtable_oa_start_resize (hashtblP, size, true);
+    hashtable_oa_write_end (hashtblP);
+  }
+  pthread_mutex_unlock (&hashtblP->lock);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Initialization
+   hashtable_oa_ts_init() sets up the initial structure of the thread safe hash table. The user specified size is the number of
+   elements expected, the slot array is sized for it and is grown when needed.
+   The user can also specify a hash function, its result is mixed again by the default hash function.
+   If an error occurred, NULL is returned. All other values in the returned hash_table_oa_ts_t pointer should be released with hashtable_oa_ts_destroy().
+*/
+hash_table_oa_ts_t * hashtable_oa_ts_init (hash_table_oa_ts_t * const hashtblP,
+    const hash_size_t sizeP,
+    hash_size_t (*hashfuncP) (const hash_key_t),
+    void (*freefuncP) (void **),
+    bstring display_name_pP)
+{
+  if (hashtable_oa_init (hashtblP, sizeP, hashfuncP, (freefuncP) ? freefuncP : free_wrapper, display_name_pP) != HASH_TABLE_OK) {
+    return NULL;
+  }
+  return hashtblP;
+}
+
+//------------------------------------------------------------------------------
+hash_table_oa_ts_t                     *
+hashtable_oa_ts_create (
+  const hash_size_t sizeP,
+  hash_size_t (*hashfuncP) (const hash_key_t),
+  void (*freefuncP) (void **),
+  bstring display_name_pP)
+{
+  hash_table_oa_ts_t                     *hashtbl = NULL;
+
+  if (!(hashtbl = calloc (1, sizeof (hash_table_oa_ts_t)))) {
+    return NULL;
+  }
+
+  if (!hashtable_oa_ts_init (hashtbl, sizeP, hashfuncP, freefuncP, display_name_pP)) {
+    free_wrapper ((void**)&hashtbl);
+    return NULL;
+  }
+  hashtbl->is_allocated_by_malloc = true;
+  return hashtbl;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_oa_ts_destroy (
+  hash_table_oa_ts_t * hashtblP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  return hashtable_oa_destroy (hashtblP);
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_oa_ts_is_key_exists (
+  const hash_table_oa_ts_t * const hashtblP,
+  const hash_key_t keyP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  return hashtable_oa_get (hashtblP, keyP, NULL);
+}
+
+//------------------------------------------------------------------------------
+// may cost a lot CPU...
+hashtable_key_array_t * hashtable_oa_ts_get_keys (hash_table_oa_ts_t * const hashtblP)
+{
+  hashtable_key_array_t                  *ka = NULL;
+
+  if ((!hashtblP) || !(hashtblP->num_elements)){
+    return NULL;
+  }
+  ka = calloc(1, sizeof(hashtable_key_array_t));
+  pthread_mutex_lock (&hashtblP->lock);
+  ka->keys = calloc(hashtblP->num_elements, sizeof(hash_key_t));
+  hashtable_oa_for_each_locked (hashtblP, hashtable_oa_get_key_cb, NULL, ka, NULL);
+  pthread_mutex_unlock (&hashtblP->lock);
+  return ka;
+}
+
+//------------------------------------------------------------------------------
+// may cost a lot CPU...
+hashtable_element_array_t * hashtable_oa_ts_get_elements (hash_table_oa_ts_t * const hashtblP)
+{
+  hashtable_element_array_t              *ea = NULL;
+
+  if ((!hashtblP) || !(hashtblP->num_elements)){
+    return NULL;
+  }
+  ea = calloc(1, sizeof(hashtable_element_array_t));
+  pthread_mutex_lock (&hashtblP->lock);
+  ea->elements = calloc(hashtblP->num_elements, sizeof(void*));
+  hashtable_oa_for_each_locked (hashtblP, hashtable_oa_get_element_cb, NULL, ea, NULL);
+  pthread_mutex_unlock (&hashtblP->lock);
+  return ea;
+}
+
+//------------------------------------------------------------------------------
+// may cost a lot CPU...
+// The callback is called with the table locked against writers, it must not modify the table
+hashtable_rc_t
+hashtable_oa_ts_apply_callback_on_elements (
+  hash_table_oa_ts_t * const hashtblP,
+  bool funct_cb (const hash_key_t keyP,
+               void * const dataP,
+               void *parameterP,
+               void ** resultP),
+  void *parameterP,
+  void** resultP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  hashtable_oa_for_each (hashtblP, hashtable_oa_apply_cb, funct_cb, parameterP, resultP);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_oa_ts_dump_content (
+  const hash_table_oa_ts_t * const hashtblP,
+  bstring str)
+{
+  if (!hashtblP) {
+    bcatcstr(str, "HASH_TABLE_BAD_PARAMETER_HASHTABLE");
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  hashtable_oa_for_each ((hash_table_oa_ts_t *)hashtblP, hashtable_oa_dump_cb, NULL, str, NULL);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Adding a new element, data of an existing key is overwritten (and freed when no reader can reference it).
+*/
+hashtable_rc_t
+hashtable_oa_ts_insert (
+  hash_table_oa_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  void *dataP)
+{
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  uint64_t                                old_data = 0;
+  void                                   *old_element = NULL;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  pthread_mutex_lock (&hashtblP->lock);
+  rc = hashtable_oa_insert (hashtblP, keyP, (uint64_t)(uintptr_t)dataP, &old_data);
+  pthread_mutex_unlock (&hashtblP->lock);
+
+  if ((rc == HASH_TABLE_INSERT_OVERWRITTEN_DATA) && (old_data)) {
+    old_element = (void *)(uintptr_t)old_data;
+    epoch_defer_free (old_element, hashtblP->freefunc);
+  }
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hashtable_rc_code2string(rc));
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Remove an element and free its data when no reader can reference it.
+*/
+hashtable_rc_t
+hashtable_oa_ts_free (
+  hash_table_oa_ts_t * const hashtblP,
+  const hash_key_t keyP)
+{
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  uint64_t                                data = 0;
+  void                                   *element = NULL;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  pthread_mutex_lock (&hashtblP->lock);
+  rc = hashtable_oa_remove (hashtblP, keyP, &data);
+  pthread_mutex_unlock (&hashtblP->lock);
+
+  if ((rc == HASH_TABLE_OK) && (data)) {
+    element = (void *)(uintptr_t)data;
+    epoch_defer_free (element, hashtblP->freefunc);
+  }
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, hashtable_rc_code2string(rc));
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Remove an element, its data is returned in dataP and not freed.
+*/
+hashtable_rc_t
+hashtable_oa_ts_remove (
+  hash_table_oa_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  void **dataP)
+{
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  uint64_t                                data = 0;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  pthread_mutex_lock (&hashtblP->lock);
+  rc = hashtable_oa_remove (hashtblP, keyP, &data);
+  pthread_mutex_unlock (&hashtblP->lock);
+
+  if (rc == HASH_TABLE_OK) {
+    *dataP = (void *)(uintptr_t)data;
+  }
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, hashtable_rc_code2string(rc));
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_oa_ts_get (
+  const hash_table_oa_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  void **dataP)
+{
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  uint64_t                                data = 0;
+
+  if (!hashtblP) {
+    *dataP = NULL;
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  rc = hashtable_oa_get (hashtblP, keyP, &data);
+  *dataP = (void *)(uintptr_t)data;
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %p) return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, *dataP, hashtable_rc_code2string(rc));
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+/*
+   Resizing
+   Elements are moved at once into an array able to hold sizeP elements (never smaller than the load factor allows).
+*/
+hashtable_rc_t
+hashtable_oa_ts_resize (
+  hash_table_oa_ts_t * const hashtblP,
+  const hash_size_t sizeP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  return hashtable_oa_resize (hashtblP, sizeP);
+}
+
+//------------------------------------------------------------------------------
+/*
+   Initialization
+   hashtable_uint64_oa_ts_init() sets up the initial structure of the thread safe hash table. The user specified size is the number of
+   elements expected, the slot array is sized for it and is grown when needed.
+   The user can also specify a hash function, its result is mixed again by the default hash function.
+   If an error occurred, NULL is returned. All other values in the returned hash_table_uint64_oa_ts_t pointer should be released with hashtable_uint64_oa_ts_destroy().
+*/
+hash_table_uint64_oa_ts_t * hashtable_uint64_oa_ts_init (hash_table_uint64_oa_ts_t * const hashtblP,
+    const hash_size_t sizeP,
+    hash_size_t (*hashfuncP) (const hash_key_t),
+    bstring display_name_pP)
+{
+  if (hashtable_oa_init (hashtblP, sizeP, hashfuncP, NULL, display_name_pP) != HASH_TABLE_OK) {
+    return NULL;
+  }
+  return hashtblP;
+}
+
+//------------------------------------------------------------------------------
+hash_table_uint64_oa_ts_t              *
+hashtable_uint64_oa_ts_create (
+  const hash_size_t sizeP,
+  hash_size_t (*hashfuncP) (const hash_key_t),
+  bstring display_name_pP)
+{
+  hash_table_uint64_oa_ts_t              *hashtbl = NULL;
+
+  if (!(hashtbl = calloc (1, sizeof (hash_table_uint64_oa_ts_t)))) {
+    return NULL;
+  }
+
+  if (!hashtable_uint64_oa_ts_init (hashtbl, sizeP, hashfuncP, display_name_pP)) {
+    free_wrapper ((void**)&hashtbl);
+    return NULL;
+  }
+  hashtbl->is_allocated_by_malloc = true;
+  return hashtbl;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_uint64_oa_ts_destroy (
+  hash_table_uint64_oa_ts_t * hashtblP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  return hashtable_oa_destroy (hashtblP);
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_uint64_oa_ts_is_key_exists (
+  const hash_table_uint64_oa_ts_t * const hashtblP,
+  const hash_key_t keyP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  return hashtable_oa_get (hashtblP, keyP, NULL);
+}
+
+//------------------------------------------------------------------------------
+// may cost a lot CPU...
+hashtable_key_array_t * hashtable_uint64_oa_ts_get_keys (hash_table_uint64_oa_ts_t * const hashtblP)
+{
+  return hashtable_oa_ts_get_keys (hashtblP);
+}
+
+//------------------------------------------------------------------------------
+// may cost a lot CPU...
+hashtable_uint64_element_array_t * hashtable_uint64_oa_ts_get_elements (hash_table_uint64_oa_ts_t * const hashtblP)
+{
+  hashtable_uint64_element_array_t       *ea = NULL;
+
+  if ((!hashtblP) || !(hashtblP->num_elements)){
+    return NULL;
+  }
+  ea = calloc(1, sizeof(hashtable_uint64_element_array_t));
+  pthread_mutex_lock (&hashtblP->lock);
+  ea->elements = calloc(hashtblP->num_elements, sizeof(uint64_t));
+  hashtable_oa_for_each_locked (hashtblP, hashtable_uint64_oa_get_element_cb, NULL, ea, NULL);
+  pthread_mutex_unlock (&hashtblP->lock);
+  return ea;
+}
+
+//------------------------------------------------------------------------------
+// may cost a lot CPU...
+// The callback is called with the table locked against writers, it must not modify the table
+hashtable_rc_t
+hashtable_uint64_oa_ts_apply_callback_on_elements (
+  hash_table_uint64_oa_ts_t * const hashtblP,
+  bool funct_cb (const hash_key_t keyP,
+               const uint64_t dataP,
+               void *parameterP,
+               void ** resultP),
+  void *parameterP,
+  void** resultP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  hashtable_oa_for_each (hashtblP, hashtable_uint64_oa_apply_cb, funct_cb, parameterP, resultP);
+  return HASH_TABLE_OK;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_uint64_oa_ts_dump_content (
+  const hash_table_uint64_oa_ts_t * const hashtblP,
+  bstring str)
+{
+  return hashtable_oa_ts_dump_content (hashtblP, str);
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_uint64_oa_ts_insert (
+  hash_table_uint64_oa_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  const uint64_t dataP)
+{
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  uint64_t                                old_data = 0;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  pthread_mutex_lock (&hashtblP->lock);
+  rc = hashtable_oa_insert (hashtblP, keyP, dataP, &old_data);
+  pthread_mutex_unlock (&hashtblP->lock);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64" data %"PRIx64") return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, dataP, hashtable_rc_code2string(rc));
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_uint64_oa_ts_free (
+  hash_table_uint64_oa_ts_t * const hashtblP,
+  const hash_key_t keyP)
+{
+  return hashtable_uint64_oa_ts_remove (hashtblP, keyP);
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_uint64_oa_ts_remove (
+  hash_table_uint64_oa_ts_t * const hashtblP,
+  const hash_key_t keyP)
+{
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+  uint64_t                                data = 0;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  pthread_mutex_lock (&hashtblP->lock);
+  rc = hashtable_oa_remove (hashtblP, keyP, &data);
+  pthread_mutex_unlock (&hashtblP->lock);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, hashtable_rc_code2string(rc));
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_uint64_oa_ts_get (
+  const hash_table_uint64_oa_ts_t * const hashtblP,
+  const hash_key_t keyP,
+  uint64_t * const dataP)
+{
+  hashtable_rc_t                          rc = HASH_TABLE_OK;
+
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+
+  rc = hashtable_oa_get (hashtblP, keyP, dataP);
+  PRINT_HASHTABLE (hashtblP, "%s(%s,key 0x%"PRIx64") return %s\n", __FUNCTION__, bdata(hashtblP->name), keyP, hashtable_rc_code2string(rc));
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+hashtable_rc_t
+hashtable_uint64_oa_ts_resize (
+  hash_table_uint64_oa_ts_t * const hashtblP,
+  const hash_size_t sizeP)
+{
+  if (!hashtblP) {
+    return HASH_TABLE_BAD_PARAMETER_HASHTABLE;
+  }
+  return hashtable_oa_resize (hashtblP, sizeP);
+}
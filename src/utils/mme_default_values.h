@@ -35,6 +35,12 @@
  ******************************************************************************/
 #define MME_STATISTIC_TIMER_S  (60)
 
+/*******************************************************************************
+ * MME_APP Constants
+ ******************************************************************************/
+#define MME_APP_NB_WORKERS_DEFAULT (1)     ///< MME_APP worker tasks
+#define MME_APP_NB_WORKERS_MAX     (8)     ///< Number of TASK_MME_APP_WORKER_x tasks defined in tasks_def.h
+
 /*******************************************************************************
  * GTPV1 User Plane Constants
  ******************************************************************************/
@@ -48,6 +54,8 @@
 #define S1AP_SCTP_PPID   (18)    ///< S1AP SCTP Payload Protocol Identifier (PPID)
 
 #define S1AP_OUTCOME_TIMER_DEFAULT (5)     ///< S1AP Outcome drop timer (s)
+#define S1AP_NB_WORKERS_DEFAULT    (1)     ///< S1AP worker tasks
+#define S1AP_NB_WORKERS_MAX        (8)     ///< Number of TASK_S1AP_WORKER_x tasks defined in tasks_def.h
 
 /*******************************************************************************
  * S6A Constants
@@ -55,6 +63,10 @@
 
 #define S6A_CONF_FILE "../S6A/freediameter/s6a.conf"
 
+#define S6A_AUTH_VECTORS_PER_REQUEST_DEFAULT    (4)    ///< E-UTRAN vectors requested in one AIR
+#define S6A_AUTH_VECTORS_LOW_WATER_MARK_DEFAULT (1)    ///< Cached vectors of an IMSI below which the cache is refilled
+#define S6A_AUTH_VECTORS_CACHE_TTL_DEFAULT      (3600) ///< Lifetime of a cached vector (s)
+
 /*******************************************************************************
  * SCTP Constants
  ******************************************************************************/
@@ -63,6 +75,7 @@
 #define SCTP_OUT_STREAMS      (32)
 #define SCTP_IN_STREAMS       (32)
 #define SCTP_MAX_ATTEMPTS     (5)
+#define SCTP_EPOLL_MAX_EVENTS (64)
 
 /*******************************************************************************
  * MME global definitions
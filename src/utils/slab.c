@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file slab.c
+  \brief Fixed size object allocator.
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "slab.h"
+
+/* First object of a chunk, the chunk header is padded to keep objects aligned */
+#define SLAB_CHUNK_HEADER_SIZE  SLAB_ALIGNMENT
+
+//------------------------------------------------------------------------------
+/*
+   Must be called with the slab lock held.
+*/
+static int slab_grow (slab_t * const slab)
+{
+  slab_chunk_t                           *chunk = NULL;
+  uint8_t                                *object = NULL;
+  uint32_t                                i = 0;
+
+  if (posix_memalign ((void **)&chunk, SLAB_ALIGNMENT, SLAB_CHUNK_HEADER_SIZE + slab->object_size * slab->objects_per_chunk)) {
+    return -1;
+  }
+  chunk->next = slab->chunks;
+  slab->chunks = chunk;
+  slab->nb_chunks++;
+
+  /*
+   * Thread the new objects on the free list, in address order
+   */
+  object = (uint8_t *)chunk + SLAB_CHUNK_HEADER_SIZE + slab->object_size * slab->objects_per_chunk;
+
+  for (i = 0; i < slab->objects_per_chunk; i++) {
+    object -= slab->object_size;
+    *(void **)object = slab->free_objects;
+    slab->free_objects = object;
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+slab_t *slab_create (const char * const name, const size_t object_size, const uint32_t objects_per_chunk)
+{
+  slab_t                                 *slab = calloc (1, sizeof (slab_t));
+
+  if (!slab) {
+    return NULL;
+  }
+  pthread_mutex_init (&slab->lock, NULL);
+  slab->object_size = (((object_size < sizeof (void *)) ? sizeof (void *) : object_size) + SLAB_ALIGNMENT - 1) & ~((size_t)SLAB_ALIGNMENT - 1);
+  slab->objects_per_chunk = (objects_per_chunk) ? objects_per_chunk : 1;
+  slab->name = bfromcstr ((name) ? name : "slab");
+
+  if (slab_grow (slab)) {
+    slab_destroy (&slab);
+    return NULL;
+  }
+  return slab;
+}
+
+//------------------------------------------------------------------------------
+void slab_destroy (slab_t ** const slab)
+{
+  slab_chunk_t                           *chunk = NULL;
+
+  if ((!slab) || (!*slab)) {
+    return;
+  }
+
+  while ((chunk = (*slab)->chunks)) {
+    (*slab)->chunks = chunk->next;
+    free (chunk);
+  }
+  pthread_mutex_destroy (&(*slab)->lock);
+  bdestroy_wrapper (&(*slab)->name);
+  free_wrapper ((void **)slab);
+}
+
+//------------------------------------------------------------------------------
+void *slab_alloc (slab_t * const slab)
+{
+  void                                   *object = NULL;
+
+  pthread_mutex_lock (&slab->lock);
+
+  if ((slab->free_objects) || (!slab_grow (slab))) {
+    object = slab->free_objects;
+    slab->free_objects = *(void **)object;
+    slab->nb_objects_in_use++;
+    slab->nb_allocations++;
+  }
+  pthread_mutex_unlock (&slab->lock);
+
+  if (object) {
+    memset (object, 0, slab->object_size);
+  }
+  return object;
+}
+
+//------------------------------------------------------------------------------
+void slab_free (slab_t * const slab, void * const object)
+{
+  if (!object) {
+    return;
+  }
+  pthread_mutex_lock (&slab->lock);
+  *(void **)object = slab->free_objects;
+  slab->free_objects = object;
+  slab->nb_objects_in_use--;
+  pthread_mutex_unlock (&slab->lock);
+}
+
+//------------------------------------------------------------------------------
+size_t slab_get_memory_size (const slab_t * const slab)
+{
+  return sizeof (slab_t) + (size_t)slab->nb_chunks * (SLAB_CHUNK_HEADER_SIZE + slab->object_size * slab->objects_per_chunk);
+}
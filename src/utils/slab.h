@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file slab.h
+  \brief Fixed size object allocator.
+
+  Objects are carved out of chunks allocated on demand and recycled through
+  a free list, chunks are only released when the slab is destroyed. Objects
+  are cache line aligned so that concurrently accessed objects never share
+  a cache line.
+*/
+#ifndef FILE_SLAB_SEEN
+#define FILE_SLAB_SEEN
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "bstrlib.h"
+
+#define SLAB_ALIGNMENT 64
+
+typedef struct slab_chunk_s {
+  struct slab_chunk_s     *next;
+} slab_chunk_t;
+
+typedef struct slab_s {
+  pthread_mutex_t          lock;
+  size_t                   object_size;          // rounded up to SLAB_ALIGNMENT
+  uint32_t                 objects_per_chunk;
+  slab_chunk_t            *chunks;
+  void                    *free_objects;         // free objects are linked through their first word
+  uint32_t                 nb_chunks;
+  uint64_t                 nb_objects_in_use;
+  uint64_t                 nb_allocations;
+  bstring                  name;
+} slab_t;
+
+/*
+ * Returns NULL if the first chunk cannot be allocated.
+ */
+slab_t *slab_create(const char * const name, const size_t object_size, const uint32_t objects_per_chunk);
+
+/*
+ * Release all chunks, objects still in use are released too.
+ */
+void slab_destroy(slab_t ** const slab);
+
+/*
+ * Returns a zeroed object, NULL if a new chunk is needed and cannot be allocated.
+ */
+void *slab_alloc(slab_t * const slab);
+
+void slab_free(slab_t * const slab, void * const object);
+
+/*
+ * Memory footprint of the slab, in bytes.
+ */
+size_t slab_get_memory_size(const slab_t * const slab);
+
+#endif /* FILE_SLAB_SEEN */